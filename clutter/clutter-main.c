@@ -105,6 +105,7 @@
 #include "clutter-feature.h"
 #include "clutter-actor.h"
 #include "clutter-stage.h"
+#include "clutter-stage-manager.h"
 #include "clutter-private.h"
 #include "clutter-debug.h"
 #include "clutter-version.h" 	/* For flavour define */
@@ -133,6 +134,8 @@ static gboolean clutter_use_fuzzy_picking    = FALSE;
 static gboolean clutter_enable_accessibility = TRUE;
 
 static guint clutter_default_fps             = 60;
+static guint clutter_texture_upload_budget   = 5;
+static guint clutter_texture_cache_size      = 16;
 
 static PangoDirection clutter_text_direction = CLUTTER_TEXT_DIRECTION_LTR;
 
@@ -699,6 +702,39 @@ result:
   return actor;
 }
 
+/* Repaint function uploading the glyphs that have been rasterized
+   in a thread since the last frame */
+static gboolean
+clutter_upload_pending_glyphs (gpointer data)
+{
+  CoglPangoFontMap *font_map = data;
+
+  if (cogl_pango_font_map_upload_pending_glyphs (font_map))
+    {
+      ClutterStageManager *stage_manager;
+      const GSList *l;
+
+      /* The glyphs have only been drawn blank so far so any text on
+         screen needs repainting */
+      stage_manager = clutter_stage_manager_get_default ();
+      for (l = clutter_stage_manager_peek_stages (stage_manager);
+           l != NULL;
+           l = l->next)
+        clutter_actor_queue_redraw (l->data);
+    }
+
+  /* Keep the master clock running until the threads are done */
+  if (cogl_pango_font_map_has_pending_glyphs (font_map))
+    {
+      ClutterMasterClock *master_clock;
+
+      master_clock = _clutter_master_clock_get_default ();
+      _clutter_master_clock_ensure_next_iteration (master_clock);
+    }
+
+  return TRUE;
+}
+
 CoglPangoFontMap *
 _clutter_context_get_pango_fontmap (ClutterMainContext *self)
 {
@@ -717,6 +753,10 @@ _clutter_context_get_pango_fontmap (ClutterMainContext *self)
   use_mipmapping = !clutter_disable_mipmap_text;
   cogl_pango_font_map_set_use_mipmapping (font_map, use_mipmapping);
 
+  clutter_threads_add_repaint_func (clutter_upload_pending_glyphs,
+                                    font_map,
+                                    NULL);
+
   self->font_map = font_map;
 
   return self->font_map;
@@ -1736,6 +1776,22 @@ pre_parse_hook (GOptionContext  *context,
       clutter_default_fps = CLAMP (default_fps, 1, 1000);
     }
 
+  env_string = g_getenv ("CLUTTER_TEXTURE_UPLOAD_BUDGET");
+  if (env_string)
+    {
+      gint upload_budget = g_ascii_strtoll (env_string, NULL, 10);
+
+      clutter_texture_upload_budget = CLAMP (upload_budget, 1, 1000);
+    }
+
+  env_string = g_getenv ("CLUTTER_TEXTURE_CACHE_SIZE");
+  if (env_string)
+    {
+      gint cache_size = g_ascii_strtoll (env_string, NULL, 10);
+
+      clutter_texture_cache_size = CLAMP (cache_size, 0, 4096);
+    }
+
   env_string = g_getenv ("CLUTTER_DISABLE_MIPMAPPED_TEXT");
   if (env_string)
     clutter_disable_mipmap_text = TRUE;
@@ -1781,6 +1837,9 @@ post_parse_hook (GOptionContext  *context,
     }
 
   clutter_context->frame_rate = clutter_default_fps;
+  clutter_context->texture_upload_budget = clutter_texture_upload_budget;
+  clutter_context->texture_cache_size =
+    (gsize) clutter_texture_cache_size * 1024 * 1024;
   clutter_context->options_parsed = TRUE;
 
   /*
@@ -2906,6 +2965,42 @@ clutter_clear_glyph_cache (void)
   cogl_pango_font_map_clear_glyph_cache (font_map);
 }
 
+/**
+ * clutter_preload_glyph_cache:
+ * @font_name: a font name, as accepted by the #ClutterText:font-name
+ *   property
+ * @text: a UTF-8 string containing the characters to preload
+ *
+ * Makes sure that the glyphs needed to render @text with the font
+ * described by @font_name are in the internal glyph cache used by
+ * the Pango renderer.
+ *
+ * Applications can call this at startup for the fonts, sizes and
+ * character sets they are going to display so that screens
+ * introducing new text don't have to rasterize glyphs while
+ * painting. If %CLUTTER_FONT_ASYNC_RASTERIZATION is set then the
+ * glyphs are rasterized in worker threads and this function does not
+ * block.
+ *
+ * Since: 1.4
+ */
+void
+clutter_preload_glyph_cache (const gchar *font_name,
+                             const gchar *text)
+{
+  PangoContext *context;
+  PangoFontDescription *font_desc;
+
+  g_return_if_fail (font_name != NULL);
+  g_return_if_fail (text != NULL);
+
+  context = _clutter_context_get_pango_context (CLUTTER_CONTEXT ());
+
+  font_desc = pango_font_description_from_string (font_name);
+  cogl_pango_ensure_glyph_cache_for_text (context, font_desc, text);
+  pango_font_description_free (font_desc);
+}
+
 /**
  * clutter_set_font_flags:
  * @flags: The new flags
@@ -2930,6 +3025,7 @@ clutter_set_font_flags (ClutterFontFlags flags)
   const cairo_font_options_t *font_options;
   cairo_font_options_t *new_font_options;
   gboolean use_mipmapping;
+  gboolean use_async;
   ClutterBackend *backend;
 
   backend = clutter_get_default_backend ();
@@ -2937,6 +3033,8 @@ clutter_set_font_flags (ClutterFontFlags flags)
   font_map = _clutter_context_get_pango_fontmap (context);
   use_mipmapping = (flags & CLUTTER_FONT_MIPMAPPING) != 0;
   cogl_pango_font_map_set_use_mipmapping (font_map, use_mipmapping);
+  use_async = (flags & CLUTTER_FONT_ASYNC_RASTERIZATION) != 0;
+  cogl_pango_font_map_set_use_async_rasterization (font_map, use_async);
 
   old_flags = clutter_get_font_flags ();
 
@@ -2984,6 +3082,9 @@ clutter_get_font_flags (void)
   if (cogl_pango_font_map_get_use_mipmapping (font_map))
     flags |= CLUTTER_FONT_MIPMAPPING;
 
+  if (cogl_pango_font_map_get_use_async_rasterization (font_map))
+    flags |= CLUTTER_FONT_ASYNC_RASTERIZATION;
+
   font_options = clutter_backend_get_font_options (context->backend);
 
   if ((cairo_font_options_get_hint_style (font_options)
@@ -153,6 +153,8 @@ void             clutter_ungrab_keyboard             (void);
 ClutterActor *   clutter_get_keyboard_grab           (void);
 
 void             clutter_clear_glyph_cache           (void);
+void             clutter_preload_glyph_cache         (const gchar *font_name,
+                                                      const gchar *text);
 void             clutter_set_font_flags              (ClutterFontFlags flags);
 ClutterFontFlags clutter_get_font_flags              (void);
 
@@ -40,6 +40,13 @@
 #include "clutter-private.h"
 #include "clutter-profile.h"
 
+#include <cogl/cogl.h>
+
+/* The maximum number of textures moved by the atlas defragmenter
+ * after each frame
+ */
+#define CLUTTER_ATLAS_DEFRAG_TEXTURES_PER_FRAME 4
+
 #define CLUTTER_MASTER_CLOCK_CLASS(klass)       (G_TYPE_CHECK_CLASS_CAST ((klass), CLUTTER_TYPE_MASTER_CLOCK, ClutterMasterClockClass))
 #define CLUTTER_IS_MASTER_CLOCK_CLASS(klass)    (G_TYPE_CHECK_CLASS_TYPE ((klass), CLUTTER_TYPE_MASTER_CLOCK))
 #define CLUTTER_MASTER_CLASS_GET_CLASS(obj)     (G_TYPE_INSTANCE_GET_CLASS ((obj), CLUTTER_TYPE_MASTER_CLOCK, ClutterMasterClockClass))
@@ -358,6 +365,19 @@ clutter_clock_dispatch (GSource     *source,
 
   _clutter_run_repaint_functions ();
 
+  /* Paths that have been tesselated in a thread since the last frame
+   * have only been drawn with a fallback so far
+   */
+  if (_cogl_path_upload_pending_fills ())
+    {
+      for (l = stages; l != NULL; l = l->next)
+        clutter_actor_queue_redraw (l->data);
+    }
+
+  /* Keep the master clock running until the threads are done */
+  if (_cogl_path_has_pending_fills ())
+    master_clock->ensure_next_iteration = TRUE;
+
   /* Update any stage that needs redraw/relayout after the clock
    * is advanced.
    */
@@ -380,6 +400,13 @@ clutter_clock_dispatch (GSource     *source,
    * to polling for timeline progressions... */
   if (!stages_updated)
     master_clock->idle = TRUE;
+  else
+    {
+      /* ...otherwise spread the compaction of the texture atlas over
+       * the frames, while we know that the GL context is current
+       */
+      _cogl_atlas_texture_defragment (CLUTTER_ATLAS_DEFRAG_TEXTURES_PER_FRAME);
+    }
 
   g_slist_foreach (stages, (GFunc) g_object_unref, NULL);
   g_slist_free (stages);
@@ -161,6 +161,14 @@ struct _ClutterMainContext
                                         * and actors
                                         */
   guint            frame_rate;         /* Default FPS */
+  guint            texture_upload_budget; /* Time in ms to spend each
+                                           * frame uploading textures
+                                           * loaded asynchronously
+                                           */
+  gsize            texture_cache_size; /* Size in bytes of the unused
+                                        * textures kept in the texture
+                                        * cache
+                                        */
 
   ClutterActor    *pointer_grab_actor; /* The actor having the pointer grab
                                         * (or NULL if there is no pointer grab
@@ -252,6 +260,7 @@ void                _clutter_stage_maybe_setup_viewport (ClutterStage       *sta
 void                _clutter_stage_maybe_relayout       (ClutterActor       *stage);
 gboolean            _clutter_stage_needs_update         (ClutterStage       *stage);
 gboolean            _clutter_stage_do_update            (ClutterStage       *stage);
+void                _clutter_stage_do_paint             (ClutterStage       *stage);
 
 
 void     _clutter_stage_queue_event            (ClutterStage *stage,
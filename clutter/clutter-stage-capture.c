@@ -0,0 +1,637 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2010  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A capture continuously reads back what is painted on a stage. Each
+ * paint of the stage is read into one of a small ring of pixel arrays
+ * so that the GPU can carry on rendering the next frames while the
+ * reads complete. Only the bounding box of the redraw clips is read
+ * when the stage is painted with clipped redraws, and frames that are
+ * not painted at all are never captured.
+ *
+ * Once a read is complete its pixels are handed to a worker thread
+ * which patches them into a copy of the whole frame, scales and
+ * converts the damaged area to the format of the capture and then
+ * calls the consumer function.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "clutter-stage-capture.h"
+
+#include "clutter-actor.h"
+#include "clutter-debug.h"
+#include "clutter-main.h"
+#include "clutter-master-clock.h"
+#include "clutter-private.h"
+#include "clutter-profile.h"
+
+/* The number of frames that can be read back or processed at once
+   before frames start being dropped */
+#define CAPTURE_N_BUFFERS 3
+
+typedef enum
+{
+  CAPTURE_SLOT_FREE,
+  CAPTURE_SLOT_READING,
+  CAPTURE_SLOT_PROCESSING
+} CaptureSlotState;
+
+typedef struct _CaptureSlot
+{
+  ClutterStageCapture *capture;
+
+  /* Protected by the mutex of the capture */
+  CaptureSlotState state;
+
+  /* The array is big enough for the whole frame so that it can be
+     reused for any damaged rectangle */
+  CoglPixelArray *array;
+  guint8 *data;
+
+  /* The size of the stage and the rectangle of it that was read */
+  gint frame_width;
+  gint frame_height;
+  ClutterGeometry damage;
+} CaptureSlot;
+
+struct _ClutterStageCapture
+{
+  ClutterStage *stage;
+
+  CoglPixelFormat format;
+  /* The format the pixels are read in, which is premultiplied so
+     that they can be filtered when scaling */
+  CoglPixelFormat read_format;
+  gint bpp;
+
+  /* The requested size, or -1 for the size of the stage */
+  gint width;
+  gint height;
+
+  ClutterStageCaptureFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+
+  guint repaint_func;
+
+  CaptureSlot slots[CAPTURE_N_BUFFERS];
+  /* The slot the next paint is read into, and the oldest slot that
+     may still be reading */
+  gint next_slot;
+  gint next_poll;
+
+  /* The size of the stage when it was last painted */
+  gint stage_width;
+  gint stage_height;
+
+  /* Set when the frame kept by the worker is missing some damage,
+     for instance because a frame had to be dropped */
+  gboolean need_full;
+
+  GMutex *mutex;
+  GCond *cond;
+
+  /* Only used by the worker: the whole frame in the read format, and
+     the scaled frame in the capture format if it is scaled */
+  guint8 *frame;
+  gint frame_width;
+  gint frame_height;
+
+  guint8 *output;
+  gint output_width;
+  gint output_height;
+};
+
+static GThreadPool *capture_thread_pool = NULL;
+
+static gboolean
+clutter_stage_capture_format_is_supported (CoglPixelFormat format)
+{
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGB_888:
+    case COGL_PIXEL_FORMAT_BGR_888:
+      return (format & COGL_PREMULT_BIT) == 0;
+
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Averages the pixels of the frame covered by each pixel of @rect in
+   the output. The frame is premultiplied so the colors of transparent
+   pixels don't bleed into their neighbours */
+static void
+clutter_stage_capture_scale (ClutterStageCapture   *capture,
+                             const ClutterGeometry *rect)
+{
+  gint bpp = capture->bpp;
+  gint frame_rowstride = capture->frame_width * bpp;
+  gint output_rowstride = capture->output_width * bpp;
+  gint x, y, sx, sy, i;
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    {
+      gint sy0 = y * capture->frame_height / capture->output_height;
+      gint sy1 = (y + 1) * capture->frame_height / capture->output_height;
+      guint8 *dst = capture->output + y * output_rowstride + rect->x * bpp;
+
+      sy1 = MAX (sy1, sy0 + 1);
+
+      for (x = rect->x; x < rect->x + rect->width; x++, dst += bpp)
+        {
+          gint sx0 = x * capture->frame_width / capture->output_width;
+          gint sx1 = (x + 1) * capture->frame_width / capture->output_width;
+          guint sum[4] = { 0, 0, 0, 0 };
+          guint n;
+
+          sx1 = MAX (sx1, sx0 + 1);
+          n = (sx1 - sx0) * (sy1 - sy0);
+
+          for (sy = sy0; sy < sy1; sy++)
+            {
+              const guint8 *src = (capture->frame + sy * frame_rowstride
+                                   + sx0 * bpp);
+
+              for (sx = sx0; sx < sx1; sx++, src += bpp)
+                for (i = 0; i < bpp; i++)
+                  sum[i] += src[i];
+            }
+
+          for (i = 0; i < bpp; i++)
+            dst[i] = (sum[i] + n / 2) / n;
+        }
+    }
+}
+
+static void
+clutter_stage_capture_unpremultiply (ClutterStageCapture   *capture,
+                                     guint8                *data,
+                                     gint                   rowstride,
+                                     const ClutterGeometry *rect)
+{
+  gint alpha_offset, color_offset;
+  gint x, y, i;
+
+  if ((capture->format & COGL_AFIRST_BIT))
+    {
+      alpha_offset = 0;
+      color_offset = 1;
+    }
+  else
+    {
+      alpha_offset = 3;
+      color_offset = 0;
+    }
+
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    {
+      guint8 *p = data + y * rowstride + rect->x * 4;
+
+      for (x = 0; x < rect->width; x++, p += 4)
+        {
+          guint alpha = p[alpha_offset];
+
+          if (alpha == 0 || alpha == 255)
+            continue;
+
+          for (i = color_offset; i < color_offset + 3; i++)
+            p[i] = MIN (p[i] * 255 / alpha, 255);
+        }
+    }
+}
+
+static void
+clutter_stage_capture_process (gpointer data,
+                               gpointer user_data)
+{
+  CaptureSlot *slot = data;
+  ClutterStageCapture *capture = slot->capture;
+  ClutterGeometry *damage = &slot->damage;
+  ClutterGeometry output_damage;
+  const guint8 *pixels;
+  gint bpp = capture->bpp;
+  gint width, height, rowstride, y;
+
+  /* A new frame size always comes with a full frame of damage */
+  if (capture->frame_width != slot->frame_width ||
+      capture->frame_height != slot->frame_height)
+    {
+      capture->frame_width = slot->frame_width;
+      capture->frame_height = slot->frame_height;
+      capture->frame = g_realloc (capture->frame,
+                                  capture->frame_width *
+                                  capture->frame_height * bpp);
+    }
+
+  for (y = 0; y < damage->height; y++)
+    memcpy (capture->frame
+            + (damage->y + y) * capture->frame_width * bpp
+            + damage->x * bpp,
+            slot->data + y * damage->width * bpp,
+            damage->width * bpp);
+
+  /* The capture is only ever scaled down */
+  width = capture->width;
+  if (width < 0 || width > capture->frame_width)
+    width = capture->frame_width;
+
+  height = capture->height;
+  if (height < 0 || height > capture->frame_height)
+    height = capture->frame_height;
+
+  if (width != capture->frame_width || height != capture->frame_height)
+    {
+      if (capture->output == NULL ||
+          capture->output_width != width ||
+          capture->output_height != height)
+        {
+          g_free (capture->output);
+          capture->output = g_malloc (width * height * bpp);
+          capture->output_width = width;
+          capture->output_height = height;
+
+          output_damage.x = 0;
+          output_damage.y = 0;
+          output_damage.width = width;
+          output_damage.height = height;
+        }
+      else
+        {
+          gint x1 = ((damage->x + damage->width) * width
+                     + capture->frame_width - 1) / capture->frame_width;
+          gint y1 = ((damage->y + damage->height) * height
+                     + capture->frame_height - 1) / capture->frame_height;
+
+          output_damage.x = damage->x * width / capture->frame_width;
+          output_damage.y = damage->y * height / capture->frame_height;
+          output_damage.width = MIN (x1, width) - output_damage.x;
+          output_damage.height = MIN (y1, height) - output_damage.y;
+        }
+
+      clutter_stage_capture_scale (capture, &output_damage);
+
+      pixels = capture->output;
+    }
+  else
+    {
+      /* Nothing is read from the frame when it isn't scaled, so it
+         can be unpremultiplied in place */
+      output_damage = *damage;
+      pixels = capture->frame;
+    }
+
+  rowstride = width * bpp;
+
+  if ((capture->format & COGL_A_BIT) && !(capture->format & COGL_PREMULT_BIT))
+    clutter_stage_capture_unpremultiply (capture,
+                                         (guint8 *) pixels, rowstride,
+                                         &output_damage);
+
+  capture->func (capture->stage,
+                 pixels, width, height, rowstride,
+                 &output_damage,
+                 capture->user_data);
+
+  g_mutex_lock (capture->mutex);
+  slot->state = CAPTURE_SLOT_FREE;
+  g_cond_broadcast (capture->cond);
+  g_mutex_unlock (capture->mutex);
+}
+
+static CaptureSlotState
+clutter_stage_capture_get_slot_state (ClutterStageCapture *capture,
+                                      CaptureSlot         *slot)
+{
+  CaptureSlotState state;
+
+  g_mutex_lock (capture->mutex);
+  state = slot->state;
+  g_mutex_unlock (capture->mutex);
+
+  return state;
+}
+
+static void
+clutter_stage_capture_set_slot_state (ClutterStageCapture *capture,
+                                      CaptureSlot         *slot,
+                                      CaptureSlotState     state)
+{
+  g_mutex_lock (capture->mutex);
+  slot->state = state;
+  g_mutex_unlock (capture->mutex);
+}
+
+/* Hands the completed reads over to the worker, in the order they
+   were started so that the damage is applied in the right order */
+static gboolean
+clutter_stage_capture_repaint_func (gpointer user_data)
+{
+  ClutterStageCapture *capture = user_data;
+  gboolean in_flight = FALSE;
+  gint i;
+
+  CLUTTER_STATIC_TIMER (capture_timer,
+                        "Master Clock", /* parent */
+                        "Stage capture",
+                        "The time spent retrieving the pixels of "
+                        "stage captures",
+                        0 /* no application private data */);
+
+  for (i = 0; i < CAPTURE_N_BUFFERS; i++)
+    {
+      CaptureSlot *slot = capture->slots + capture->next_poll;
+
+      if (clutter_stage_capture_get_slot_state (capture, slot)
+          != CAPTURE_SLOT_READING)
+        break;
+
+      if (i == 0)
+        clutter_stage_ensure_current (capture->stage);
+
+      if (!cogl_pixel_array_is_read_complete (slot->array))
+        {
+          in_flight = TRUE;
+          break;
+        }
+
+      CLUTTER_TIMER_START (_clutter_uprof_context, capture_timer);
+
+      if (cogl_pixel_array_get_data (slot->array,
+                                     slot->damage.width * capture->bpp,
+                                     slot->data))
+        {
+          clutter_stage_capture_set_slot_state (capture, slot,
+                                                CAPTURE_SLOT_PROCESSING);
+
+          if (capture_thread_pool != NULL)
+            g_thread_pool_push (capture_thread_pool, slot, NULL);
+          else
+            clutter_stage_capture_process (slot, NULL);
+        }
+      else
+        {
+          clutter_stage_capture_set_slot_state (capture, slot,
+                                                CAPTURE_SLOT_FREE);
+          capture->need_full = TRUE;
+        }
+
+      CLUTTER_TIMER_STOP (_clutter_uprof_context, capture_timer);
+
+      capture->next_poll = (capture->next_poll + 1) % CAPTURE_N_BUFFERS;
+    }
+
+  /* Once a buffer is available again the whole stage is painted so
+     that the worker gets a complete frame */
+  if (capture->need_full)
+    {
+      CaptureSlot *slot = capture->slots + capture->next_slot;
+
+      if (clutter_stage_capture_get_slot_state (capture, slot)
+          == CAPTURE_SLOT_FREE)
+        clutter_actor_queue_redraw (CLUTTER_ACTOR (capture->stage));
+      else
+        in_flight = TRUE;
+    }
+
+  if (in_flight)
+    {
+      ClutterMasterClock *master_clock;
+
+      master_clock = _clutter_master_clock_get_default ();
+      _clutter_master_clock_ensure_next_iteration (master_clock);
+    }
+
+  return TRUE;
+}
+
+ClutterStageCapture *
+_clutter_stage_capture_new (ClutterStage            *stage,
+                            CoglPixelFormat          format,
+                            gint                     width,
+                            gint                     height,
+                            ClutterStageCaptureFunc  func,
+                            gpointer                 user_data,
+                            GDestroyNotify           notify)
+{
+  ClutterStageCapture *capture;
+  gint i;
+
+  if (!clutter_stage_capture_format_is_supported (format))
+    {
+      g_warning ("Unsupported pixel format 0x%x for stage capture",
+                 format);
+      return NULL;
+    }
+
+  capture = g_slice_new0 (ClutterStageCapture);
+
+  capture->stage = stage;
+  capture->format = format;
+  capture->bpp = (format & COGL_A_BIT) ? 4 : 3;
+  capture->read_format = format;
+  if ((format & COGL_A_BIT))
+    capture->read_format |= COGL_PREMULT_BIT;
+
+  capture->width = width;
+  capture->height = height;
+  capture->func = func;
+  capture->user_data = user_data;
+  capture->notify = notify;
+
+  for (i = 0; i < CAPTURE_N_BUFFERS; i++)
+    {
+      capture->slots[i].capture = capture;
+      capture->slots[i].state = CAPTURE_SLOT_FREE;
+    }
+
+  capture->need_full = TRUE;
+
+  /* g_mutex_new() returns NULL if threads aren't initialized, in
+     which case the locking is a no-op and the frames are processed
+     in the main loop */
+  capture->mutex = g_mutex_new ();
+  capture->cond = g_cond_new ();
+
+  if (g_thread_supported () && capture_thread_pool == NULL)
+    /* This apparently can't fail if exclusive == FALSE. A single
+       thread is shared by all of the captures so that the frames of
+       each are processed in order */
+    capture_thread_pool = g_thread_pool_new (clutter_stage_capture_process,
+                                             NULL, 1, FALSE, NULL);
+
+  capture->repaint_func =
+    clutter_threads_add_repaint_func (clutter_stage_capture_repaint_func,
+                                      capture,
+                                      NULL);
+
+  /* The first frame needs the whole stage */
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return capture;
+}
+
+void
+_clutter_stage_capture_free (ClutterStageCapture *capture)
+{
+  gint i;
+
+  clutter_threads_remove_repaint_func (capture->repaint_func);
+
+  /* Wait for the worker to be done with the frames it has been
+     given, as they point to the capture */
+  g_mutex_lock (capture->mutex);
+
+  for (i = 0; i < CAPTURE_N_BUFFERS; i++)
+    while (capture->slots[i].state == CAPTURE_SLOT_PROCESSING)
+      g_cond_wait (capture->cond, capture->mutex);
+
+  g_mutex_unlock (capture->mutex);
+
+  for (i = 0; i < CAPTURE_N_BUFFERS; i++)
+    {
+      if (capture->slots[i].array != NULL)
+        cogl_handle_unref (capture->slots[i].array);
+
+      g_free (capture->slots[i].data);
+    }
+
+  g_free (capture->frame);
+  g_free (capture->output);
+
+  if (capture->mutex != NULL)
+    g_mutex_free (capture->mutex);
+
+  if (capture->cond != NULL)
+    g_cond_free (capture->cond);
+
+  if (capture->notify != NULL)
+    capture->notify (capture->user_data);
+
+  g_slice_free (ClutterStageCapture, capture);
+}
+
+/* Starts reading the frame that has just been painted. @stage_clip is
+   the area of the stage that was painted, or NULL if the whole stage
+   was painted */
+void
+_clutter_stage_capture_paint (ClutterStageCapture   *capture,
+                              const ClutterGeometry *stage_clip)
+{
+  CaptureSlot *slot = capture->slots + capture->next_slot;
+  ClutterMasterClock *master_clock;
+  ClutterGeometry damage;
+  float viewport[4];
+  gint width, height;
+
+  cogl_get_viewport (viewport);
+  width = viewport[2];
+  height = viewport[3];
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  if (width != capture->stage_width || height != capture->stage_height)
+    {
+      capture->stage_width = width;
+      capture->stage_height = height;
+      capture->need_full = TRUE;
+    }
+
+  if (stage_clip != NULL)
+    {
+      /* The repaint function queues a full redraw for this */
+      if (capture->need_full)
+        return;
+
+      damage.x = MAX (stage_clip->x, 0);
+      damage.y = MAX (stage_clip->y, 0);
+      damage.width =
+        MIN (stage_clip->x + (gint) stage_clip->width, width) - damage.x;
+      damage.height =
+        MIN (stage_clip->y + (gint) stage_clip->height, height) - damage.y;
+
+      if ((gint) damage.width <= 0 || (gint) damage.height <= 0)
+        return;
+    }
+  else
+    {
+      damage.x = 0;
+      damage.y = 0;
+      damage.width = width;
+      damage.height = height;
+    }
+
+  /* The consumer is lagging behind, so the frame is dropped */
+  if (clutter_stage_capture_get_slot_state (capture, slot)
+      != CAPTURE_SLOT_FREE)
+    {
+      CLUTTER_NOTE (MISC, "Dropping a frame of the stage capture");
+      capture->need_full = TRUE;
+      return;
+    }
+
+  if (slot->array == NULL ||
+      slot->frame_width != width ||
+      slot->frame_height != height)
+    {
+      if (slot->array != NULL)
+        cogl_handle_unref (slot->array);
+
+      slot->array = cogl_pixel_array_new_with_size (width, height,
+                                                    capture->read_format,
+                                                    NULL);
+      slot->data = g_realloc (slot->data, width * height * capture->bpp);
+      slot->frame_width = width;
+      slot->frame_height = height;
+    }
+
+  if (slot->array == NULL ||
+      !cogl_pixel_array_read_pixels (slot->array,
+                                     damage.x, damage.y,
+                                     damage.width, damage.height))
+    {
+      capture->need_full = TRUE;
+      return;
+    }
+
+  slot->damage = damage;
+  clutter_stage_capture_set_slot_state (capture, slot, CAPTURE_SLOT_READING);
+
+  capture->next_slot = (capture->next_slot + 1) % CAPTURE_N_BUFFERS;
+
+  if (stage_clip == NULL)
+    capture->need_full = FALSE;
+
+  /* Make sure the read gets polled even if nothing else is painted */
+  master_clock = _clutter_master_clock_get_default ();
+  _clutter_master_clock_ensure_next_iteration (master_clock);
+}
@@ -0,0 +1,47 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2010  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_STAGE_CAPTURE_H__
+#define __CLUTTER_STAGE_CAPTURE_H__
+
+#include <glib.h>
+#include <cogl/cogl.h>
+
+#include "clutter-stage.h"
+
+G_BEGIN_DECLS
+
+typedef struct _ClutterStageCapture ClutterStageCapture;
+
+ClutterStageCapture *_clutter_stage_capture_new   (ClutterStage            *stage,
+                                                   CoglPixelFormat          format,
+                                                   gint                     width,
+                                                   gint                     height,
+                                                   ClutterStageCaptureFunc  func,
+                                                   gpointer                 user_data,
+                                                   GDestroyNotify           notify);
+void                 _clutter_stage_capture_free  (ClutterStageCapture     *capture);
+void                 _clutter_stage_capture_paint (ClutterStageCapture     *capture,
+                                                   const ClutterGeometry   *stage_clip);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_STAGE_CAPTURE_H__ */
@@ -167,3 +167,21 @@ _clutter_stage_window_ignoring_redraw_clips (ClutterStageWindow *window)
   return TRUE;
 }
 
+/* Retrieves the bounding box of the redraw clips the stage is being
+ * painted with, in stage coordinates. Returns FALSE if the whole stage
+ * is painted. This is only meaningful while the stage is painted. */
+gboolean
+_clutter_stage_window_get_redraw_clip_bounds (ClutterStageWindow *window,
+                                              ClutterGeometry    *stage_clip)
+{
+  ClutterStageWindowIface *iface;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE_WINDOW (window), FALSE);
+
+  iface = CLUTTER_STAGE_WINDOW_GET_IFACE (window);
+  if (iface->get_redraw_clip_bounds)
+    return iface->get_redraw_clip_bounds (window, stage_clip);
+
+  return FALSE;
+}
+
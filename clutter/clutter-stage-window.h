@@ -47,6 +47,8 @@ struct _ClutterStageWindowIface
                                            ClutterGeometry    *stage_rectangle);
   gboolean      (* has_redraw_clips)      (ClutterStageWindow *stage_window);
   gboolean      (* ignoring_redraw_clips) (ClutterStageWindow *stage_window);
+  gboolean      (* get_redraw_clip_bounds) (ClutterStageWindow *stage_window,
+                                            ClutterGeometry    *stage_clip);
 };
 
 GType clutter_stage_window_get_type (void) G_GNUC_CONST;
@@ -80,6 +82,8 @@ void          _clutter_stage_window_add_redraw_clip       (ClutterStageWindow *w
                                                            ClutterGeometry    *stage_clip);
 gboolean      _clutter_stage_window_has_redraw_clips      (ClutterStageWindow *window);
 gboolean      _clutter_stage_window_ignoring_redraw_clips (ClutterStageWindow *window);
+gboolean      _clutter_stage_window_get_redraw_clip_bounds (ClutterStageWindow *window,
+                                                            ClutterGeometry    *stage_clip);
 
 G_END_DECLS
 
@@ -64,6 +64,7 @@
 #include "clutter-enum-types.h"
 #include "clutter-private.h"
 #include "clutter-debug.h"
+#include "clutter-stage-capture.h"
 #include "clutter-stage-manager.h"
 #include "clutter-stage-window.h"
 #include "clutter-version.h" 	/* For flavour */
@@ -114,6 +115,21 @@ struct _ClutterStagePrivate
 
   ClutterStageHint    stage_hints;
 
+  /* Reads requested with clutter_stage_read_pixels_async() that
+     haven't been delivered yet, oldest first */
+  GList              *pending_reads;
+  guint               read_pixels_func;
+
+  /* The pixel array of the last delivered read, kept for the next
+     read of the same size */
+  CoglPixelArray     *spare_read_array;
+  gint                spare_read_width;
+  gint                spare_read_height;
+
+  /* Captures added with clutter_stage_add_capture(), by id */
+  GHashTable         *captures;
+  guint               last_capture_id;
+
   guint redraw_pending         : 1;
   guint is_fullscreen          : 1;
   guint is_cursor_visible      : 1;
@@ -157,6 +173,8 @@ static guint stage_signals[LAST_SIGNAL] = { 0, };
 
 static const ClutterColor default_stage_color = { 255, 255, 255, 255 };
 
+static void clutter_stage_cancel_reads (ClutterStage *stage);
+
 static void
 clutter_stage_get_preferred_width (ClutterActor *self,
                                    gfloat        for_height,
@@ -956,6 +974,14 @@ clutter_stage_dispose (GObject *object)
         }
     }
 
+  clutter_stage_cancel_reads (stage);
+
+  if (priv->captures != NULL)
+    {
+      g_hash_table_destroy (priv->captures);
+      priv->captures = NULL;
+    }
+
   if (priv->impl != NULL)
     {
       CLUTTER_NOTE (BACKEND, "Disposing of the stage implementation");
@@ -1738,6 +1764,619 @@ clutter_stage_read_pixels (ClutterStage *stage,
   return pixels;
 }
 
+typedef struct _ClutterStageReadPixels
+{
+  gint x;
+  gint y;
+  gint width;
+  gint height;
+
+  ClutterStageReadPixelsFunc func;
+  gpointer user_data;
+  GDestroyNotify notify;
+
+  /* The array the pixels are read into, or NULL if the read hasn't
+     been started yet */
+  CoglPixelArray *array;
+} ClutterStageReadPixels;
+
+static void
+clutter_stage_read_pixels_free (ClutterStageReadPixels *read)
+{
+  if (read->array != NULL)
+    cogl_handle_unref (read->array);
+
+  if (read->notify != NULL)
+    read->notify (read->user_data);
+
+  g_slice_free (ClutterStageReadPixels, read);
+}
+
+static void
+clutter_stage_deliver_read (ClutterStage           *stage,
+                            ClutterStageReadPixels *read)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  guchar *pixels;
+  gboolean res;
+
+  CLUTTER_STATIC_TIMER (read_pixels_timer,
+                        "Master Clock", /* parent */
+                        "Asynchronous read pixels",
+                        "The time spent retrieving the pixels of "
+                        "asynchronous reads",
+                        0 /* no application private data */);
+
+  CLUTTER_TIMER_START (_clutter_uprof_context, read_pixels_timer);
+
+  pixels = g_malloc (read->width * read->height * 4);
+  res = cogl_pixel_array_get_data (read->array, read->width * 4, pixels);
+
+  CLUTTER_TIMER_STOP (_clutter_uprof_context, read_pixels_timer);
+
+  /* Keep the array around, as continuous captures will most likely
+     read a rectangle of the same size again. This is done before
+     calling the function so that the array is released by
+     clutter_stage_cancel_reads() if the function destroys the stage */
+  if (priv->spare_read_array != NULL)
+    cogl_handle_unref (priv->spare_read_array);
+
+  priv->spare_read_array = read->array;
+  priv->spare_read_width = read->width;
+  priv->spare_read_height = read->height;
+  read->array = NULL;
+
+  if (res)
+    read->func (stage, pixels, read->width, read->height, read->user_data);
+
+  g_free (pixels);
+
+  clutter_stage_read_pixels_free (read);
+}
+
+static gboolean
+clutter_stage_read_pixels_repaint_func (gpointer user_data)
+{
+  ClutterStage *stage = user_data;
+  ClutterStagePrivate *priv = stage->priv;
+  GList *l, *next, *completed = NULL;
+  gboolean in_flight = FALSE;
+
+  clutter_stage_ensure_current (stage);
+
+  for (l = priv->pending_reads; l != NULL; l = next)
+    {
+      ClutterStageReadPixels *read = l->data;
+
+      next = l->next;
+
+      if (read->array == NULL)
+        continue;
+
+      if (!cogl_pixel_array_is_read_complete (read->array))
+        {
+          in_flight = TRUE;
+          continue;
+        }
+
+      priv->pending_reads = g_list_remove_link (priv->pending_reads, l);
+      completed = g_list_concat (completed, l);
+    }
+
+  /* The callbacks may request more reads or destroy the stage */
+  g_object_ref (stage);
+
+  for (l = completed; l != NULL; l = l->next)
+    {
+      if (priv->read_pixels_func != 0)
+        clutter_stage_deliver_read (stage, l->data);
+      else
+        clutter_stage_read_pixels_free (l->data);
+    }
+
+  g_list_free (completed);
+
+  g_object_unref (stage);
+
+  /* The function is removed by clutter_stage_cancel_reads() when the
+     stage is disposed */
+  if (priv->read_pixels_func == 0)
+    return FALSE;
+
+  if (priv->pending_reads == NULL)
+    {
+      priv->read_pixels_func = 0;
+      return FALSE;
+    }
+
+  /* Reads that haven't been started are waiting for the redraw they
+     queued; the ones being read have to be polled again */
+  if (in_flight)
+    {
+      ClutterMasterClock *master_clock;
+
+      master_clock = _clutter_master_clock_get_default ();
+      _clutter_master_clock_ensure_next_iteration (master_clock);
+    }
+
+  return TRUE;
+}
+
+/* Starts the reads requested since the last paint of the stage. This
+   is called once the whole stage has been painted, but before the
+   buffers are swapped */
+static void
+clutter_stage_start_reads (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = stage->priv;
+  ClutterMasterClock *master_clock;
+  gint stage_width, stage_height;
+  float viewport[4];
+  GList *l, *next;
+
+  if (priv->pending_reads == NULL)
+    return;
+
+  cogl_get_viewport (viewport);
+  stage_width = viewport[2];
+  stage_height = viewport[3];
+
+  for (l = priv->pending_reads; l != NULL; l = next)
+    {
+      ClutterStageReadPixels *read = l->data;
+
+      next = l->next;
+
+      if (read->array != NULL)
+        continue;
+
+      /* Reads that start outside of the stage fail */
+      if (read->x >= stage_width || read->y >= stage_height)
+        {
+          priv->pending_reads = g_list_delete_link (priv->pending_reads, l);
+          clutter_stage_read_pixels_free (read);
+          continue;
+        }
+
+      /* Clip the rectangle to the stage */
+      if (read->width < 0 || read->width > stage_width - read->x)
+        read->width = stage_width - read->x;
+
+      if (read->height < 0 || read->height > stage_height - read->y)
+        read->height = stage_height - read->y;
+
+      if (priv->spare_read_array != NULL &&
+          priv->spare_read_width == read->width &&
+          priv->spare_read_height == read->height)
+        {
+          read->array = priv->spare_read_array;
+          priv->spare_read_array = NULL;
+        }
+      else
+        read->array =
+          cogl_pixel_array_new_with_size (read->width, read->height,
+                                          COGL_PIXEL_FORMAT_RGBA_8888,
+                                          NULL);
+
+      if (read->array == NULL)
+        continue;
+
+      cogl_pixel_array_read_pixels (read->array,
+                                    read->x, read->y,
+                                    read->width, read->height);
+    }
+
+  if (priv->read_pixels_func == 0)
+    {
+      priv->read_pixels_func =
+        clutter_threads_add_repaint_func (clutter_stage_read_pixels_repaint_func,
+                                          stage,
+                                          NULL);
+    }
+
+  /* Make sure the reads get polled even if nothing else is painted */
+  master_clock = _clutter_master_clock_get_default ();
+  _clutter_master_clock_ensure_next_iteration (master_clock);
+}
+
+static void
+clutter_stage_cancel_reads (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = stage->priv;
+
+  if (priv->read_pixels_func != 0)
+    {
+      clutter_threads_remove_repaint_func (priv->read_pixels_func);
+      priv->read_pixels_func = 0;
+    }
+
+  g_list_foreach (priv->pending_reads,
+                  (GFunc) clutter_stage_read_pixels_free,
+                  NULL);
+  g_list_free (priv->pending_reads);
+  priv->pending_reads = NULL;
+
+  if (priv->spare_read_array != NULL)
+    {
+      cogl_handle_unref (priv->spare_read_array);
+      priv->spare_read_array = NULL;
+    }
+}
+
+/**
+ * clutter_stage_read_pixels_async:
+ * @stage: A #ClutterStage
+ * @x: x coordinate of the first pixel that is read from stage
+ * @y: y coordinate of the first pixel that is read from stage
+ * @width: Width dimention of pixels to be read, or -1 for the
+ *   entire stage width
+ * @height: Height dimention of pixels to be read, or -1 for the
+ *   entire stage height
+ * @func: the function to call with the pixels
+ * @user_data: data to pass to @func
+ * @notify: function to call when @user_data is not needed anymore,
+ *   or %NULL
+ *
+ * Asynchronous version of clutter_stage_read_pixels(). Instead of
+ * painting the stage and waiting for the GPU to render it, this
+ * queues a redraw of the stage and starts reading the pixels back
+ * once the stage has been painted. The pixels are passed to @func
+ * when the read is complete, usually one or two frames later,
+ * without blocking the frames in between.
+ *
+ * This is meant for capturing the stage continuously, for instance to
+ * make thumbnails of it. If the driver doesn't support pixel buffer
+ * objects the pixels are read when the stage is painted, as
+ * clutter_stage_read_pixels() does.
+ *
+ * The rectangle is clipped to the size of the stage and @func is
+ * given the clipped size. @func is not called if the read fails, if
+ * the rectangle starts outside of the stage or if the stage is
+ * destroyed before the read is complete; @notify is always called.
+ *
+ * Since: 1.4
+ */
+void
+clutter_stage_read_pixels_async (ClutterStage               *stage,
+                                 gint                        x,
+                                 gint                        y,
+                                 gint                        width,
+                                 gint                        height,
+                                 ClutterStageReadPixelsFunc  func,
+                                 gpointer                    user_data,
+                                 GDestroyNotify              notify)
+{
+  ClutterStagePrivate *priv;
+  ClutterStageReadPixels *read;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+  g_return_if_fail (x >= 0 && y >= 0);
+  g_return_if_fail (func != NULL);
+
+  priv = stage->priv;
+
+  read = g_slice_new (ClutterStageReadPixels);
+  read->x = x;
+  read->y = y;
+  read->width = width;
+  read->height = height;
+  read->func = func;
+  read->user_data = user_data;
+  read->notify = notify;
+  read->array = NULL;
+
+  priv->pending_reads = g_list_append (priv->pending_reads, read);
+
+  /* Clipped redraws would leave stale contents outside of the clip
+     in the back buffer, so the whole stage is redrawn */
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+}
+
+/**
+ * clutter_stage_add_capture:
+ * @stage: A #ClutterStage
+ * @format: the #CoglPixelFormat of the captured frames. Only the 24
+ *   and 32 bit RGB formats are supported
+ * @width: the width of the captured frames, or -1 for the width of
+ *   the stage
+ * @height: the height of the captured frames, or -1 for the height
+ *   of the stage
+ * @func: the function to call with each captured frame
+ * @user_data: data to pass to @func
+ * @notify: function to call when the capture is removed, or %NULL
+ *
+ * Continuously captures the contents of @stage, for instance to
+ * record it or to compare it against reference images.
+ *
+ * Every time @stage is painted the painted area is read back
+ * asynchronously into one of a small set of recycled buffers, so
+ * that capturing doesn't stall the rendering of the next frames.
+ * Frames in which nothing is painted are not captured, and only the
+ * bounding box of the redraw clips is read back when the stage is
+ * painted with clipped redraws. The frames are then converted to
+ * @format and scaled down to @width by @height in a separate thread.
+ *
+ * @func is called from that thread with the whole frame and the
+ * rectangle of it that changed since the previous call, so it must
+ * not call any Clutter function. If the captured frames are not
+ * consumed fast enough some of them are dropped, and the next one
+ * captures the whole stage.
+ *
+ * Return value: an id for the capture, to be passed to
+ *   clutter_stage_remove_capture(), or 0 on failure
+ *
+ * Since: 1.4
+ */
+guint
+clutter_stage_add_capture (ClutterStage            *stage,
+                           CoglPixelFormat          format,
+                           gint                     width,
+                           gint                     height,
+                           ClutterStageCaptureFunc  func,
+                           gpointer                 user_data,
+                           GDestroyNotify           notify)
+{
+  ClutterStagePrivate *priv;
+  ClutterStageCapture *capture;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), 0);
+  g_return_val_if_fail (width != 0 && height != 0, 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  priv = stage->priv;
+
+  capture = _clutter_stage_capture_new (stage, format, width, height,
+                                        func, user_data, notify);
+  if (capture == NULL)
+    return 0;
+
+  if (priv->captures == NULL)
+    priv->captures =
+      g_hash_table_new_full (NULL, NULL,
+                             NULL,
+                             (GDestroyNotify) _clutter_stage_capture_free);
+
+  priv->last_capture_id += 1;
+  g_hash_table_insert (priv->captures,
+                       GUINT_TO_POINTER (priv->last_capture_id),
+                       capture);
+
+  return priv->last_capture_id;
+}
+
+/**
+ * clutter_stage_remove_capture:
+ * @stage: A #ClutterStage
+ * @capture_id: the id returned by clutter_stage_add_capture()
+ *
+ * Stops a capture added with clutter_stage_add_capture(). This waits
+ * for the frame being processed, if any, so the capture function is
+ * not called anymore once this function returns.
+ *
+ * Since: 1.4
+ */
+void
+clutter_stage_remove_capture (ClutterStage *stage,
+                              guint         capture_id)
+{
+  ClutterStagePrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_STAGE (stage));
+  g_return_if_fail (capture_id > 0);
+
+  priv = stage->priv;
+
+  if (priv->captures == NULL ||
+      !g_hash_table_remove (priv->captures, GUINT_TO_POINTER (capture_id)))
+    g_warning ("No capture with id %u found on the stage", capture_id);
+}
+
+static void
+clutter_stage_paint_capture (gpointer key,
+                             gpointer value,
+                             gpointer user_data)
+{
+  _clutter_stage_capture_paint (value, user_data);
+}
+
+/*
+ * _clutter_stage_do_paint:
+ * @stage: A #ClutterStage
+ *
+ * Paints @stage. This should be used by the backends instead of
+ * clutter_actor_paint() so that the pending asynchronous reads and
+ * the captures are started before the buffers are swapped.
+ */
+void
+_clutter_stage_do_paint (ClutterStage *stage)
+{
+  ClutterStagePrivate *priv = stage->priv;
+
+  clutter_actor_paint (CLUTTER_ACTOR (stage));
+
+  clutter_stage_start_reads (stage);
+
+  if (priv->captures != NULL && g_hash_table_size (priv->captures) > 0)
+    {
+      ClutterGeometry stage_clip;
+      gboolean clipped = FALSE;
+
+      if (priv->impl != NULL)
+        clipped = _clutter_stage_window_get_redraw_clip_bounds (priv->impl,
+                                                               &stage_clip);
+
+      g_hash_table_foreach (priv->captures,
+                            clutter_stage_paint_capture,
+                            clipped ? &stage_clip : NULL);
+    }
+}
+
+/**
+ * clutter_stage_warm_up:
+ * @stage: a #ClutterStage
+ * @actor: (allow-none): the actor to warm up, or %NULL for the
+ *   whole stage
+ * @build_times: (out) (allow-none) (element-type double): return
+ *   location for an array with the time in seconds taken to build
+ *   each program, or %NULL
+ *
+ * Paints @actor into an invisible offscreen buffer so that the GL
+ * programs needed by its materials, and by any #ClutterEffect
+ * applied to it or to its children, are built before the first frame
+ * that shows them. This can be used behind a splash screen to avoid
+ * stalls the first time a scene is displayed.
+ *
+ * @actor can either be a child of @stage or an actor without a
+ * parent, for instance one built from a #ClutterScript definition;
+ * in the latter case it is added to @stage for the duration of the
+ * call. Only the actors that would be painted are warmed up, so
+ * hidden actors are skipped, and the #ClutterActor::paint signal is
+ * emitted as normal. @stage needs to be mapped.
+ *
+ * If @build_times is not %NULL it is set to a newly allocated
+ * #GArray of doubles that should be freed with g_array_free(). There
+ * is one entry for each program that was linked and it includes the
+ * time taken to compile the program's shaders.
+ *
+ * Return value: the number of programs that were built
+ *
+ * Since: 1.4
+ */
+guint
+clutter_stage_warm_up (ClutterStage  *stage,
+                       ClutterActor  *actor,
+                       GArray       **build_times)
+{
+  ClutterActor *stage_actor;
+  ClutterActor *parent;
+  ClutterPerspective perspective;
+  gfloat stage_width, stage_height;
+  CoglHandle texture, offscreen;
+  gboolean was_added = FALSE;
+  gboolean was_floating = FALSE;
+  gboolean was_visible = FALSE;
+  GArray *log;
+  guint n_programs, i;
+
+  g_return_val_if_fail (CLUTTER_IS_STAGE (stage), 0);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), 0);
+
+  stage_actor = CLUTTER_ACTOR (stage);
+
+  if (build_times != NULL)
+    *build_times = NULL;
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (stage_actor))
+    {
+      g_warning ("%s: The stage must be mapped to be warmed up", G_STRLOC);
+      return 0;
+    }
+
+  if (actor == NULL)
+    actor = stage_actor;
+
+  parent = clutter_actor_get_parent (actor);
+
+  if (actor != stage_actor && parent == NULL)
+    {
+      /* Temporarily add the actor to the stage, keeping whatever
+       * reference the caller had on it */
+      was_floating = g_object_is_floating (actor);
+      was_visible = CLUTTER_ACTOR_IS_VISIBLE (actor);
+
+      g_object_ref_sink (actor);
+      clutter_container_add_actor (CLUTTER_CONTAINER (stage), actor);
+      clutter_actor_show (actor);
+
+      parent = stage_actor;
+      was_added = TRUE;
+    }
+  else if (actor != stage_actor &&
+           clutter_actor_get_stage (actor) != stage_actor)
+    {
+      g_warning ("%s: The actor of type '%s' is not on the stage",
+                 G_STRLOC,
+                 G_OBJECT_TYPE_NAME (actor));
+      return 0;
+    }
+
+  clutter_stage_ensure_current (stage);
+  _clutter_stage_maybe_relayout (stage_actor);
+
+  /* The contents of the offscreen buffer are never used so the
+   * smallest possible texture is enough */
+  texture = cogl_texture_new_with_size (1, 1,
+                                        COGL_TEXTURE_NO_SLICING,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  offscreen = cogl_offscreen_new_to_texture (texture);
+  if (offscreen == COGL_INVALID_HANDLE)
+    {
+      g_warning ("%s: Unable to create an Offscreen buffer", G_STRLOC);
+      n_programs = 0;
+      goto out;
+    }
+
+  _cogl_begin_program_build_log ();
+
+  cogl_push_framebuffer (offscreen);
+
+  /* Use the same projection and modelview matrices as the stage so
+   * that the actors are painted the same way as they normally are */
+  clutter_stage_get_perspective (stage, &perspective);
+  clutter_actor_get_size (stage_actor, &stage_width, &stage_height);
+
+  _cogl_setup_viewport (stage_width, stage_height,
+                        perspective.fovy,
+                        perspective.aspect,
+                        perspective.z_near,
+                        perspective.z_far);
+
+  if (actor != stage_actor)
+    _clutter_actor_apply_modelview_transform_recursive (parent, NULL);
+
+  clutter_actor_paint (actor);
+
+  /* Flush the journal so that the programs for the last batch of
+   * primitives are built as well */
+  cogl_flush ();
+
+  cogl_pop_framebuffer ();
+
+  log = _cogl_end_program_build_log ();
+  n_programs = log->len;
+
+  CLUTTER_NOTE (PAINT, "Warming up the stage built %u programs",
+                n_programs);
+  for (i = 0; i < n_programs; i++)
+    CLUTTER_NOTE (PAINT, "  program %u: %.3f ms",
+                  i, g_array_index (log, double, i) * 1000.0);
+
+  if (build_times != NULL)
+    *build_times = log;
+  else
+    g_array_free (log, TRUE);
+
+  cogl_handle_unref (offscreen);
+
+out:
+  cogl_handle_unref (texture);
+
+  if (was_added)
+    {
+      clutter_container_remove_actor (CLUTTER_CONTAINER (stage), actor);
+
+      if (!was_visible)
+        clutter_actor_hide (actor);
+
+      if (was_floating)
+        g_object_force_floating (G_OBJECT (actor));
+      else
+        g_object_unref (actor);
+    }
+
+  return n_programs;
+}
+
 /**
  * clutter_stage_get_actor_at_pos:
  * @stage: a #ClutterStage
@@ -32,6 +32,7 @@
 #include <clutter/clutter-group.h>
 #include <clutter/clutter-color.h>
 #include <clutter/clutter-event.h>
+#include <cogl/cogl.h>
 
 G_BEGIN_DECLS
 
@@ -93,6 +94,51 @@ typedef struct _ClutterFog          ClutterFog;
 typedef struct _ClutterStageClass   ClutterStageClass;
 typedef struct _ClutterStagePrivate ClutterStagePrivate;
 
+/**
+ * ClutterStageReadPixelsFunc:
+ * @stage: the #ClutterStage the pixels were read from
+ * @pixels: the pixels in RGBA 8bit data, with @width * 4 as rowstride
+ * @width: the width of the rectangle that was read
+ * @height: the height of the rectangle that was read
+ * @user_data: the data passed to clutter_stage_read_pixels_async()
+ *
+ * The function called when the pixels read by
+ * clutter_stage_read_pixels_async() are available. The @pixels are
+ * owned by Clutter and are only valid until the function returns.
+ *
+ * Since: 1.4
+ */
+typedef void (* ClutterStageReadPixelsFunc) (ClutterStage *stage,
+                                             const guchar *pixels,
+                                             gint          width,
+                                             gint          height,
+                                             gpointer      user_data);
+
+/**
+ * ClutterStageCaptureFunc:
+ * @stage: the #ClutterStage being captured
+ * @pixels: the captured frame, in the format of the capture
+ * @width: the width of the frame
+ * @height: the height of the frame
+ * @rowstride: the rowstride of @pixels in bytes
+ * @damage: the rectangle of the frame that changed since the
+ *   previous call
+ * @user_data: the data passed to clutter_stage_add_capture()
+ *
+ * The function called with each frame captured by
+ * clutter_stage_add_capture(). It is called from a separate thread,
+ * and the @pixels are only valid until the function returns.
+ *
+ * Since: 1.4
+ */
+typedef void (* ClutterStageCaptureFunc) (ClutterStage          *stage,
+                                          const guchar          *pixels,
+                                          gint                   width,
+                                          gint                   height,
+                                          gint                   rowstride,
+                                          const ClutterGeometry *damage,
+                                          gpointer               user_data);
+
 /**
  * ClutterStage:
  *
@@ -213,6 +259,26 @@ guchar *      clutter_stage_read_pixels       (ClutterStage       *stage,
                                                gint                y,
                                                gint                width,
                                                gint                height);
+void          clutter_stage_read_pixels_async (ClutterStage       *stage,
+                                               gint                x,
+                                               gint                y,
+                                               gint                width,
+                                               gint                height,
+                                               ClutterStageReadPixelsFunc func,
+                                               gpointer            user_data,
+                                               GDestroyNotify      notify);
+guint         clutter_stage_add_capture       (ClutterStage       *stage,
+                                               CoglPixelFormat     format,
+                                               gint                width,
+                                               gint                height,
+                                               ClutterStageCaptureFunc func,
+                                               gpointer            user_data,
+                                               GDestroyNotify      notify);
+void          clutter_stage_remove_capture    (ClutterStage       *stage,
+                                               guint               capture_id);
+guint         clutter_stage_warm_up           (ClutterStage       *stage,
+                                               ClutterActor       *actor,
+                                               GArray            **build_times);
 gboolean      clutter_stage_event             (ClutterStage       *stage,
                                                ClutterEvent       *event);
 
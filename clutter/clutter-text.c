@@ -54,6 +54,7 @@
 #include "clutter-keysyms.h"
 #include "clutter-main.h"
 #include "clutter-marshal.h"
+#include "clutter-master-clock.h"
 #include "clutter-private.h"    /* includes pango/cogl-pango.h */
 #include "clutter-profile.h"
 #include "clutter-units.h"
@@ -73,9 +74,25 @@
  */
 #define N_CACHED_LAYOUTS        6
 
+/* Pango can only be used from more than one thread at the same time,
+ * even through separate contexts, starting from version 1.32
+ */
+#if PANGO_VERSION_CHECK (1, 32, 0)
+#define HAVE_ASYNC_LAYOUT       1
+#endif
+
+/* maximum number of threads shaping layouts for all the ClutterText
+ * actors using the :layout-async property
+ */
+#define N_LAYOUT_THREADS        2
+
+/* number of characters between two checkpoints of the offset index */
+#define OFFSET_INDEX_STRIDE     64
+
 #define CLUTTER_TEXT_GET_PRIVATE(obj)   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_TEXT, ClutterTextPrivate))
 
 typedef struct _LayoutCache     LayoutCache;
+typedef struct _LayoutJob       LayoutJob;
 
 static const ClutterColor default_cursor_color    = {   0,   0,   0, 255 };
 static const ClutterColor default_selection_color = {   0,   0,   0, 255 };
@@ -97,6 +114,37 @@ struct _LayoutCache
   guint age;
 };
 
+struct _LayoutJob
+{
+  /* The actor that requested the layout; this is only ever set to
+   * NULL by the main thread, while holding layout_jobs_mutex, when
+   * the request is cancelled
+   */
+  ClutterText *text;
+
+  /* The context is created by the main thread but after the job has
+   * been pushed to the pool it is only used by the worker shaping the
+   * layout, so it is effectively private to that thread
+   */
+  PangoContext *context;
+
+  gchar *contents;
+  PangoAttrList *attrs;
+  PangoFontDescription *font_desc;
+
+  PangoAlignment alignment;
+  PangoWrapMode wrap_mode;
+  PangoEllipsizeMode ellipsize;
+  guint single_line_mode : 1;
+  guint justify          : 1;
+
+  gint width;
+  gint height;
+
+  /* the result of the job, set by the worker thread */
+  PangoLayout *layout;
+};
+
 struct _ClutterTextPrivate
 {
   PangoFontDescription *font_desc;
@@ -110,6 +158,9 @@ struct _ClutterTextPrivate
   LayoutCache cached_layouts[N_CACHED_LAYOUTS];
   guint cache_age;
 
+  /* layouts requested to the worker threads and not yet delivered */
+  GSList *layout_jobs;
+
   /* These are the attributes set by the attributes property */
   PangoAttrList *attrs;
   /* These are the attributes derived from the text when the
@@ -141,6 +192,7 @@ struct _ClutterTextPrivate
   guint cursor_color_set    : 1;
   guint preedit_set         : 1;
   guint is_default_font     : 1;
+  guint layout_async        : 1;
 
   /* current cursor position */
   gint position;
@@ -165,6 +217,11 @@ struct _ClutterTextPrivate
   /* the length of the text, in characters */
   gint n_chars;
 
+  /* byte offsets of every OFFSET_INDEX_STRIDE-th character of the
+   * text, filled lazily; see clutter_text_offset_to_bytes()
+   */
+  GArray *offset_index;
+
   /* Where to draw the cursor */
   ClutterGeometry cursor_pos;
   ClutterColor cursor_color;
@@ -214,7 +271,8 @@ enum
   PROP_ACTIVATABLE,
   PROP_PASSWORD_CHAR,
   PROP_MAX_LENGTH,
-  PROP_SINGLE_LINE_MODE
+  PROP_SINGLE_LINE_MODE,
+  PROP_LAYOUT_ASYNC
 };
 
 enum
@@ -230,9 +288,11 @@ enum
 
 static guint text_signals[LAST_SIGNAL] = { 0, };
 
-static void clutter_text_font_changed_cb (ClutterText *text);
+static GThreadPool *layout_thread_pool = NULL;
+static GStaticMutex layout_jobs_mutex = G_STATIC_MUTEX_INIT;
+static GSList *finished_layout_jobs = NULL;
 
-#define offset_real(t,p)        ((p) == -1 ? g_utf8_strlen ((t), -1) : (p))
+static void clutter_text_font_changed_cb (ClutterText *text);
 
 static gint
 offset_to_bytes (const gchar *text,
@@ -252,6 +312,169 @@ offset_to_bytes (const gchar *text,
 
 #define bytes_to_offset(t,p)    (g_utf8_pointer_to_offset ((t), (t) + (p)))
 
+/*
+ * clutter_text_ensure_offset_index:
+ * @self: a #ClutterText
+ * @position: a position in characters, or -1
+ * @index_: a position in bytes, or -1
+ *
+ * Extends the offset index of @self until it contains a checkpoint
+ * for the character at @position and a checkpoint past the byte at
+ * @index_, or until it covers the whole text.
+ */
+static void
+clutter_text_ensure_offset_index (ClutterText *self,
+                                  gint         position,
+                                  gint         index_)
+{
+  ClutterTextPrivate *priv = self->priv;
+  GArray *offset_index = priv->offset_index;
+  gint last, next_checkpoint;
+
+  if (offset_index->len == 0)
+    {
+      last = 0;
+      g_array_append_val (offset_index, last);
+    }
+
+  last = g_array_index (offset_index, gint, offset_index->len - 1);
+  next_checkpoint = offset_index->len * OFFSET_INDEX_STRIDE;
+
+  while (next_checkpoint <= priv->n_chars &&
+         (next_checkpoint <= position || last <= index_))
+    {
+      const gchar *p;
+
+      p = g_utf8_offset_to_pointer (priv->text + last, OFFSET_INDEX_STRIDE);
+      last = p - priv->text;
+
+      g_array_append_val (offset_index, last);
+      next_checkpoint += OFFSET_INDEX_STRIDE;
+    }
+}
+
+/*
+ * clutter_text_update_offset_index:
+ * @self: a #ClutterText
+ * @new_text: the string about to replace the contents of @self
+ *
+ * Drops the checkpoints of the offset index of @self that are not
+ * valid for @new_text. Checkpoints inside the prefix shared by the
+ * current and the new contents are kept, so that editing near the
+ * end of a long text does not throw the whole index away.
+ */
+static void
+clutter_text_update_offset_index (ClutterText *self,
+                                  const gchar *new_text)
+{
+  ClutterTextPrivate *priv = self->priv;
+  GArray *offset_index = priv->offset_index;
+  const gchar *old_text = priv->text;
+  gint last, prefix = 0;
+  guint len;
+
+  if (offset_index->len == 0)
+    return;
+
+  if (old_text == NULL || new_text == NULL)
+    {
+      g_array_set_size (offset_index, 0);
+      return;
+    }
+
+  /* only the part of the text covered by the index is compared */
+  last = g_array_index (offset_index, gint, offset_index->len - 1);
+  while (prefix < last &&
+         old_text[prefix] != '\0' &&
+         old_text[prefix] == new_text[prefix])
+    prefix++;
+
+  len = offset_index->len;
+  while (len > 0 && g_array_index (offset_index, gint, len - 1) > prefix)
+    len--;
+
+  g_array_set_size (offset_index, len);
+}
+
+/*
+ * clutter_text_offset_to_bytes:
+ * @self: a #ClutterText
+ * @pos: a position in characters inside the contents of @self, or -1
+ *
+ * Like offset_to_bytes() for the contents of @self, but it only walks
+ * the characters following the closest checkpoint of the offset index
+ * instead of the whole text.
+ *
+ * Return value: the position in bytes
+ */
+static gint
+clutter_text_offset_to_bytes (ClutterText *self,
+                              gint         pos)
+{
+  ClutterTextPrivate *priv = self->priv;
+  const gchar *p;
+  gint checkpoint;
+
+  if (pos < 0 || pos >= priv->n_chars)
+    return priv->n_bytes;
+
+  checkpoint = pos / OFFSET_INDEX_STRIDE;
+
+  clutter_text_ensure_offset_index (self, pos, -1);
+
+  p = priv->text + g_array_index (priv->offset_index, gint, checkpoint);
+  p = g_utf8_offset_to_pointer (p, pos % OFFSET_INDEX_STRIDE);
+
+  return p - priv->text;
+}
+
+/*
+ * clutter_text_bytes_to_offset:
+ * @self: a #ClutterText
+ * @index_: a position in bytes inside the contents of @self
+ *
+ * Like bytes_to_offset() for the contents of @self, using a binary
+ * search in the offset index to find where to start counting.
+ *
+ * Return value: the position in characters
+ */
+static gint
+clutter_text_bytes_to_offset (ClutterText *self,
+                              gint         index_)
+{
+  ClutterTextPrivate *priv = self->priv;
+  GArray *offset_index = priv->offset_index;
+  guint lo, hi;
+  gint checkpoint_bytes;
+
+  if (index_ <= 0)
+    return 0;
+
+  if (index_ >= priv->n_bytes)
+    return priv->n_chars;
+
+  clutter_text_ensure_offset_index (self, -1, index_);
+
+  /* find the last checkpoint before index_ */
+  lo = 0;
+  hi = offset_index->len;
+  while (hi - lo > 1)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (g_array_index (offset_index, gint, mid) <= index_)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  checkpoint_bytes = g_array_index (offset_index, gint, lo);
+
+  return lo * OFFSET_INDEX_STRIDE
+       + g_utf8_pointer_to_offset (priv->text + checkpoint_bytes,
+                                   priv->text + index_);
+}
+
 static inline void
 clutter_text_clear_selection (ClutterText *self)
 {
@@ -425,12 +648,275 @@ clutter_text_create_layout_no_cache (ClutterText       *text,
   return layout;
 }
 
+static void
+layout_job_free (LayoutJob *job)
+{
+  /* This function should only be called from the main thread once
+     the job has been handed back by the worker thread */
+
+  if (job->layout)
+    g_object_unref (job->layout);
+
+  if (job->attrs)
+    pango_attr_list_unref (job->attrs);
+
+  pango_font_description_free (job->font_desc);
+  g_object_unref (job->context);
+  g_free (job->contents);
+
+  g_slice_free (LayoutJob, job);
+}
+
+static void
+layout_thread_func (gpointer user_data,
+                    gpointer pool_data)
+{
+  LayoutJob *job = user_data;
+  PangoRectangle logical_rect;
+  gboolean cancelled;
+
+  /* Don't bother shaping the text if the actor has lost interest in
+     the layout before the thread had a chance to run */
+  g_static_mutex_lock (&layout_jobs_mutex);
+  cancelled = (job->text == NULL);
+  g_static_mutex_unlock (&layout_jobs_mutex);
+
+  if (!cancelled)
+    {
+      job->layout = pango_layout_new (job->context);
+
+      pango_layout_set_font_description (job->layout, job->font_desc);
+      pango_layout_set_text (job->layout, job->contents, -1);
+
+      if (job->attrs)
+        pango_layout_set_attributes (job->layout, job->attrs);
+
+      pango_layout_set_alignment (job->layout, job->alignment);
+      pango_layout_set_single_paragraph_mode (job->layout,
+                                              job->single_line_mode);
+      pango_layout_set_justify (job->layout, job->justify);
+      pango_layout_set_wrap (job->layout, job->wrap_mode);
+
+      pango_layout_set_ellipsize (job->layout, job->ellipsize);
+      pango_layout_set_width (job->layout, job->width);
+      pango_layout_set_height (job->layout, job->height);
+
+      /* Querying the extents makes Pango itemize, shape and break the
+         text into lines, which is the expensive part we want to keep
+         out of the main thread */
+      pango_layout_get_extents (job->layout, NULL, &logical_rect);
+    }
+
+  /* The job is always handed back to the main thread, which is the
+     only one allowed to free it */
+  g_static_mutex_lock (&layout_jobs_mutex);
+  finished_layout_jobs = g_slist_prepend (finished_layout_jobs, job);
+  g_static_mutex_unlock (&layout_jobs_mutex);
+
+  if (!cancelled)
+    {
+      ClutterMasterClock *master_clock = _clutter_master_clock_get_default ();
+
+      _clutter_master_clock_ensure_next_iteration (master_clock);
+    }
+}
+
+static void
+clutter_text_complete_layout_job (ClutterText *text,
+                                  LayoutJob   *job)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutCache *oldest_cache = priv->cached_layouts;
+  int i;
+
+  priv->layout_jobs = g_slist_remove (priv->layout_jobs, job);
+
+  /* Replace a free slot if there is one or the least recently
+     created layout otherwise */
+  for (i = 0; i < N_CACHED_LAYOUTS; i++)
+    {
+      if (priv->cached_layouts[i].layout == NULL)
+        {
+          oldest_cache = priv->cached_layouts + i;
+          break;
+        }
+
+      if (priv->cached_layouts[i].age < oldest_cache->age)
+        oldest_cache = priv->cached_layouts + i;
+    }
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: async layout for width %d ready",
+                text,
+                job->width);
+
+  if (oldest_cache->layout)
+    g_object_unref (oldest_cache->layout);
+
+  /* steal the layout from the job */
+  oldest_cache->layout = job->layout;
+  job->layout = NULL;
+
+  cogl_pango_ensure_glyph_cache_for_layout (oldest_cache->layout);
+
+  oldest_cache->age = priv->cache_age++;
+
+  clutter_actor_queue_relayout (CLUTTER_ACTOR (text));
+}
+
+static gboolean
+layout_repaint_func (gpointer user_data)
+{
+  GSList *jobs, *l;
+
+  g_static_mutex_lock (&layout_jobs_mutex);
+  jobs = g_slist_reverse (finished_layout_jobs);
+  finished_layout_jobs = NULL;
+  g_static_mutex_unlock (&layout_jobs_mutex);
+
+  for (l = jobs; l != NULL; l = l->next)
+    {
+      LayoutJob *job = l->data;
+
+      /* The text pointer is only ever changed by this thread so it is
+         safe to read it without holding the lock */
+      if (job->text != NULL)
+        clutter_text_complete_layout_job (job->text, job);
+
+      layout_job_free (job);
+    }
+
+  g_slist_free (jobs);
+
+  return TRUE;
+}
+
+static inline gboolean
+clutter_text_use_async_layout (ClutterText *text)
+{
+#ifdef HAVE_ASYNC_LAYOUT
+  ClutterTextPrivate *priv = text->priv;
+
+  /* editable actors need an up to date layout to position the cursor,
+   * and shaping an empty string is not worth a round trip to a thread
+   */
+  return priv->layout_async &&
+         !priv->editable &&
+         priv->n_bytes > 0 &&
+         g_thread_supported ();
+#else
+  return FALSE;
+#endif
+}
+
+/*
+ * clutter_text_queue_layout_job:
+ * @text: a #ClutterText
+ * @width: the width of the layout, in Pango units
+ * @height: the height of the layout, in Pango units
+ * @ellipsize: the ellipsization mode of the layout
+ *
+ * Asks a worker thread to create a layout with the given parameters
+ * and the current contents of @text. Once the layout is ready it
+ * will be added to the layouts cache and a relayout of @text will
+ * be queued.
+ */
+static void
+clutter_text_queue_layout_job (ClutterText        *text,
+                               gint                width,
+                               gint                height,
+                               PangoEllipsizeMode  ellipsize)
+{
+  ClutterTextPrivate *priv = text->priv;
+  LayoutJob *job;
+  GSList *l;
+
+  for (l = priv->layout_jobs; l != NULL; l = l->next)
+    {
+      job = l->data;
+
+      if (job->width == width &&
+          job->height == height &&
+          job->ellipsize == ellipsize)
+        return;
+    }
+
+  CLUTTER_NOTE (ACTOR, "ClutterText: %p: queueing async layout for width %d",
+                text,
+                width);
+
+  job = g_slice_new0 (LayoutJob);
+
+  job->text = text;
+  job->context = clutter_actor_create_pango_context (CLUTTER_ACTOR (text));
+
+  job->contents = clutter_text_get_display_text (text);
+  job->font_desc = pango_font_description_copy (priv->font_desc);
+
+  /* the attributes are copied so that the worker thread never touches
+     the reference count of a list owned by the actor */
+  clutter_text_ensure_effective_attributes (text);
+  if (priv->effective_attrs)
+    job->attrs = pango_attr_list_copy (priv->effective_attrs);
+
+  job->alignment = priv->alignment;
+  job->wrap_mode = priv->wrap_mode;
+  job->ellipsize = ellipsize;
+  job->single_line_mode = priv->single_line_mode;
+  job->justify = priv->justify;
+  job->width = width;
+  job->height = height;
+
+  if (layout_thread_pool == NULL)
+    {
+      /* This apparently can't fail if exclusive == FALSE */
+      layout_thread_pool = g_thread_pool_new (layout_thread_func, NULL,
+                                              N_LAYOUT_THREADS,
+                                              FALSE,
+                                              NULL);
+
+      clutter_threads_add_repaint_func (layout_repaint_func, NULL, NULL);
+    }
+
+  priv->layout_jobs = g_slist_prepend (priv->layout_jobs, job);
+
+  g_thread_pool_push (layout_thread_pool, job, NULL);
+}
+
+static void
+clutter_text_cancel_layout_jobs (ClutterText *text)
+{
+  ClutterTextPrivate *priv = text->priv;
+  GSList *l;
+
+  if (priv->layout_jobs == NULL)
+    return;
+
+  /* The jobs are disowned here and freed by the repaint function once
+     the worker threads hand them back */
+  g_static_mutex_lock (&layout_jobs_mutex);
+
+  for (l = priv->layout_jobs; l != NULL; l = l->next)
+    {
+      LayoutJob *job = l->data;
+
+      job->text = NULL;
+    }
+
+  g_static_mutex_unlock (&layout_jobs_mutex);
+
+  g_slist_free (priv->layout_jobs);
+  priv->layout_jobs = NULL;
+}
+
 static void
 clutter_text_dirty_cache (ClutterText *text)
 {
   ClutterTextPrivate *priv = text->priv;
   int i;
 
+  /* Any layout still being created uses stale contents */
+  clutter_text_cancel_layout_jobs (text);
+
   /* Delete the cached layouts so they will be recreated the next time
      they are needed */
   for (i = 0; i < N_CACHED_LAYOUTS; i++)
@@ -512,20 +998,26 @@ clutter_text_direction_changed_cb (GObject    *gobject,
 }
 
 /*
- * clutter_text_create_layout:
+ * clutter_text_create_layout_full:
  * @text: a #ClutterText
  * @allocation_width: the allocation width
  * @allocation_height: the allocation height
+ * @allow_async: whether the layout can be created by a worker thread
  *
  * Like clutter_text_create_layout_no_cache(), but will also ensure
  * the glyphs cache. If a previously cached layout generated using the
  * same width is available then that will be used instead of
  * generating a new one.
+ *
+ * If @allow_async is %TRUE and the #ClutterText:layout-async property
+ * is set, a missing layout will be requested to a worker thread
+ * instead and %NULL will be returned.
  */
 static PangoLayout *
-clutter_text_create_layout (ClutterText *text,
-                            gfloat       allocation_width,
-                            gfloat       allocation_height)
+clutter_text_create_layout_full (ClutterText *text,
+                                 gfloat       allocation_width,
+                                 gfloat       allocation_height,
+                                 gboolean     allow_async)
 {
   ClutterTextPrivate *priv = text->priv;
   LayoutCache *oldest_cache = priv->cached_layouts;
@@ -694,6 +1186,12 @@ clutter_text_create_layout (ClutterText *text,
 
   CLUTTER_COUNTER_INC (_clutter_uprof_context, text_cache_miss_counter);
 
+  if (allow_async && clutter_text_use_async_layout (text))
+    {
+      clutter_text_queue_layout_job (text, width, height, ellipsize);
+      return NULL;
+    }
+
   /* If we make it here then we didn't have a cached version so we
      need to recreate the layout */
   if (oldest_cache->layout)
@@ -709,6 +1207,70 @@ clutter_text_create_layout (ClutterText *text,
   return oldest_cache->layout;
 }
 
+static inline PangoLayout *
+clutter_text_create_layout (ClutterText *text,
+                            gfloat       allocation_width,
+                            gfloat       allocation_height)
+{
+  return clutter_text_create_layout_full (text,
+                                          allocation_width,
+                                          allocation_height,
+                                          FALSE);
+}
+
+/*
+ * clutter_text_estimate_size:
+ * @text: a #ClutterText
+ * @for_width: the width available to the text, or -1
+ * @width_p: return location for the estimated width
+ * @height_p: return location for the estimated height
+ *
+ * Guesses the size of the contents of @text from the font size alone,
+ * without creating a layout. This is used to answer size requests
+ * while the real layout is being created by a worker thread.
+ */
+static void
+clutter_text_estimate_size (ClutterText *text,
+                            gfloat       for_width,
+                            gfloat      *width_p,
+                            gfloat      *height_p)
+{
+  ClutterTextPrivate *priv = text->priv;
+  gfloat font_size, width;
+  gint n_lines = 1;
+
+  font_size = (gfloat) pango_font_description_get_size (priv->font_desc)
+            / PANGO_SCALE;
+
+  if (!pango_font_description_get_size_is_absolute (priv->font_desc))
+    {
+      ClutterBackend *backend = clutter_get_default_backend ();
+      gdouble resolution = clutter_backend_get_resolution (backend);
+
+      if (resolution < 0)
+        resolution = 96.0;
+
+      font_size = font_size * resolution / 72.0;
+    }
+
+  /* assume an average advance of half an em per character and a line
+   * spacing of 1.2 ems
+   */
+  width = priv->n_chars * font_size * 0.5f;
+
+  if (for_width > 0 && width > for_width && priv->wrap)
+    {
+      n_lines = ceilf (width / for_width);
+      width = for_width;
+    }
+
+  if (width_p)
+    *width_p = MAX (width, 1);
+
+  if (height_p)
+    *height_p = ceilf (n_lines * font_size * 1.2f);
+}
+
 static gint
 clutter_text_coords_to_position (ClutterText *text,
                                  gfloat       x,
@@ -791,24 +1353,34 @@ clutter_text_position_to_coords (ClutterText *self,
     {
       index_ = 0;
     }
+  else if (priv->password_char != 0)
+    {
+      index_ = position * password_char_bytes;
+    }
+  else if (priv->preedit_str == NULL)
+    {
+      index_ = clutter_text_offset_to_bytes (self, position);
+    }
   else
     {
-      gchar *text = clutter_text_get_display_text (self);
-      GString *tmp = g_string_new (text);
-      gint cursor_index;
-
-      cursor_index = offset_to_bytes (text, priv->position);
+      gint cursor_pos;
 
-      if (priv->preedit_str != NULL)
-        g_string_insert (tmp, cursor_index, priv->preedit_str);
-
-      if (priv->password_char == 0)
-        index_ = offset_to_bytes (tmp->str, position);
+      /* the pre-edit string is displayed at the cursor position */
+      if (priv->position < 0 || priv->position > priv->n_chars)
+        cursor_pos = priv->n_chars;
       else
-        index_ = position * password_char_bytes;
+        cursor_pos = priv->position;
 
-      g_free (text);
-      g_string_free (tmp, TRUE);
+      if (position <= cursor_pos)
+        index_ = clutter_text_offset_to_bytes (self, position);
+      else if (position <= cursor_pos + priv->preedit_n_chars)
+        index_ = clutter_text_offset_to_bytes (self, cursor_pos)
+               + offset_to_bytes (priv->preedit_str, position - cursor_pos);
+      else
+        index_ = clutter_text_offset_to_bytes (self,
+                                               position
+                                               - priv->preedit_n_chars)
+               + strlen (priv->preedit_str);
     }
 
   pango_layout_get_cursor_pos (clutter_text_get_layout (self),
@@ -908,8 +1480,10 @@ clutter_text_delete_selection (ClutterText *self)
   if (!priv->text)
     return TRUE;
 
-  start_index = offset_real (priv->text, priv->position);
-  end_index = offset_real (priv->text, priv->selection_bound);
+  start_index = priv->position == -1 ? priv->n_chars : priv->position;
+  end_index = priv->selection_bound == -1
+            ? priv->n_chars
+            : priv->selection_bound;
 
   if (end_index == start_index)
     return FALSE;
@@ -968,6 +1542,7 @@ clutter_text_set_text_internal (ClutterText *self,
 
       if (len < priv->max_length)
         {
+           clutter_text_update_offset_index (self, text);
            g_free (priv->text);
 
            priv->text = g_strdup (text);
@@ -979,10 +1554,11 @@ clutter_text_set_text_internal (ClutterText *self,
           gchar *p = g_utf8_offset_to_pointer (text, priv->max_length);
           gchar *n = g_malloc0 ((p - text) + 1);
 
-          g_free (priv->text);
-
           g_utf8_strncpy (n, text, priv->max_length);
 
+          clutter_text_update_offset_index (self, n);
+          g_free (priv->text);
+
           priv->text = n;
           priv->n_bytes = strlen (n);
           priv->n_chars = priv->max_length;
@@ -990,6 +1566,7 @@ clutter_text_set_text_internal (ClutterText *self,
     }
   else
     {
+      clutter_text_update_offset_index (self, text);
       g_free (priv->text);
 
       priv->text = g_strdup (text);
@@ -1170,6 +1747,10 @@ clutter_text_set_property (GObject      *gobject,
       clutter_text_set_single_line_mode (self, g_value_get_boolean (value));
       break;
 
+    case PROP_LAYOUT_ASYNC:
+      clutter_text_set_layout_async (self, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
     }
@@ -1261,6 +1842,10 @@ clutter_text_get_property (GObject    *gobject,
       g_value_set_boolean (value, priv->single_line_mode);
       break;
 
+    case PROP_LAYOUT_ASYNC:
+      g_value_set_boolean (value, priv->layout_async);
+      break;
+
     case PROP_ELLIPSIZE:
       g_value_set_enum (value, priv->ellipsize);
       break;
@@ -1333,6 +1918,8 @@ clutter_text_finalize (GObject *gobject)
   if (priv->preedit_attrs)
     pango_attr_list_unref (priv->preedit_attrs);
 
+  g_array_free (priv->offset_index, TRUE);
+
   g_free (priv->text);
   g_free (priv->font_name);
 
@@ -1536,7 +2123,7 @@ clutter_text_move_line_start (ClutterText *self,
   if (start == 0)
     index_ = 0;
   else
-    index_ = offset_to_bytes (priv->text, start);
+    index_ = clutter_text_offset_to_bytes (self, start);
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -1548,7 +2135,7 @@ clutter_text_move_line_start (ClutterText *self,
 
   pango_layout_line_x_to_index (layout_line, 0, &index_, NULL);
 
-  position = bytes_to_offset (priv->text, index_);
+  position = clutter_text_bytes_to_offset (self, index_);
 
   return position;
 }
@@ -1570,7 +2157,7 @@ clutter_text_move_line_end (ClutterText *self,
   if (start == 0)
     index_ = 0;
   else
-    index_ = offset_to_bytes (priv->text, priv->position);
+    index_ = clutter_text_offset_to_bytes (self, priv->position);
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -1583,7 +2170,7 @@ clutter_text_move_line_end (ClutterText *self,
   pango_layout_line_x_to_index (layout_line, G_MAXINT, &index_, &trailing);
   index_ += trailing;
 
-  position = bytes_to_offset (priv->text, index_);
+  position = clutter_text_bytes_to_offset (self, index_);
 
   return position;
 }
@@ -1654,7 +2241,7 @@ clutter_text_button_press (ClutterActor       *actor,
       gint offset;
 
       index_ = clutter_text_coords_to_position (self, x, y);
-      offset = bytes_to_offset (priv->text, index_);
+      offset = clutter_text_bytes_to_offset (self, index_);
 
       /* what we select depends on the number of button clicks we
        * receive:
@@ -1704,7 +2291,7 @@ clutter_text_motion (ClutterActor       *actor,
     return FALSE;
 
   index_ = clutter_text_coords_to_position (self, x, y);
-  offset = bytes_to_offset (priv->text, index_);
+  offset = clutter_text_bytes_to_offset (self, index_);
 
   if (priv->selectable)
     clutter_text_set_cursor_position (self, offset);
@@ -1823,9 +2410,16 @@ clutter_text_paint (ClutterActor *self)
   if (priv->editable && priv->single_line_mode)
     layout = clutter_text_create_layout (text, -1, -1);
   else
-    layout = clutter_text_create_layout (text,
-                                         alloc.x2 - alloc.x1,
-                                         alloc.y2 - alloc.y1);
+    layout = clutter_text_create_layout_full (text,
+                                              alloc.x2 - alloc.x1,
+                                              alloc.y2 - alloc.y1,
+                                              TRUE);
+
+  /* the layout is still being created by a worker thread; a relayout
+   * will be queued as soon as it is ready
+   */
+  if (layout == NULL)
+    return;
 
   if (priv->editable && priv->cursor_visible)
     clutter_text_ensure_cursor_position (text);
@@ -1917,19 +2511,24 @@ clutter_text_get_preferred_width (ClutterActor *self,
   gint logical_width;
   gfloat layout_width;
 
-  layout = clutter_text_create_layout (text, -1, -1);
+  layout = clutter_text_create_layout_full (text, -1, -1, TRUE);
 
-  pango_layout_get_extents (layout, NULL, &logical_rect);
+  if (layout != NULL)
+    {
+      pango_layout_get_extents (layout, NULL, &logical_rect);
 
-  /* the X coordinate of the logical rectangle might be non-zero
-   * according to the Pango documentation; hence, we need to offset
-   * the width accordingly
-   */
-  logical_width = logical_rect.x + logical_rect.width;
+      /* the X coordinate of the logical rectangle might be non-zero
+       * according to the Pango documentation; hence, we need to offset
+       * the width accordingly
+       */
+      logical_width = logical_rect.x + logical_rect.width;
 
-  layout_width = logical_width > 0
-    ? (logical_width / 1024.0f)
-    : 1;
+      layout_width = logical_width > 0
+        ? (logical_width / 1024.0f)
+        : 1;
+    }
+  else
+    clutter_text_estimate_size (text, -1, &layout_width, NULL);
 
   if (min_width_p)
     {
@@ -1971,8 +2570,24 @@ clutter_text_get_preferred_height (ClutterActor *self,
       gint logical_height;
       gfloat layout_height;
 
-      layout = clutter_text_create_layout (CLUTTER_TEXT (self),
-                                           for_width, -1);
+      layout = clutter_text_create_layout_full (CLUTTER_TEXT (self),
+                                                for_width, -1,
+                                                TRUE);
+
+      if (layout == NULL)
+        {
+          clutter_text_estimate_size (CLUTTER_TEXT (self), for_width,
+                                      NULL,
+                                      &layout_height);
+
+          if (min_height_p)
+            *min_height_p = layout_height;
+
+          if (natural_height_p)
+            *natural_height_p = layout_height;
+
+          return;
+        }
 
       pango_layout_get_extents (layout, NULL, &logical_rect);
 
@@ -2028,9 +2643,10 @@ clutter_text_allocate (ClutterActor           *self,
   if (text->priv->editable && text->priv->single_line_mode)
     clutter_text_create_layout (text, -1, -1);
   else
-    clutter_text_create_layout (text,
-                                box->x2 - box->x1,
-                                box->y2 - box->y1);
+    clutter_text_create_layout_full (text,
+                                     box->x2 - box->x1,
+                                     box->y2 - box->y1,
+                                     TRUE);
 
   parent_class = CLUTTER_ACTOR_CLASS (clutter_text_parent_class);
   parent_class->allocate (self, box, flags);
@@ -2135,7 +2751,7 @@ clutter_text_real_move_up (ClutterText         *self,
   if (priv->position == 0)
     index_ = 0;
   else
-    index_ = offset_to_bytes (priv->text, priv->position);
+    index_ = clutter_text_offset_to_bytes (self, priv->position);
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -2156,7 +2772,7 @@ clutter_text_real_move_up (ClutterText         *self,
 
   g_object_freeze_notify (G_OBJECT (self));
 
-  pos = bytes_to_offset (priv->text, index_);
+  pos = clutter_text_bytes_to_offset (self, index_);
   clutter_text_set_cursor_position (self, pos + trailing);
 
   /* Store the target x position to avoid drifting left and right when
@@ -2190,7 +2806,7 @@ clutter_text_real_move_down (ClutterText         *self,
   if (priv->position == 0)
     index_ = 0;
   else
-    index_ = offset_to_bytes (priv->text, priv->position);
+    index_ = clutter_text_offset_to_bytes (self, priv->position);
 
   pango_layout_index_to_line_x (layout, index_,
                                 0,
@@ -2207,7 +2823,7 @@ clutter_text_real_move_down (ClutterText         *self,
 
   g_object_freeze_notify (G_OBJECT (self));
 
-  pos = bytes_to_offset (priv->text, index_);
+  pos = clutter_text_bytes_to_offset (self, index_);
   clutter_text_set_cursor_position (self, pos + trailing);
 
   /* Store the target x position to avoid drifting left and right when
@@ -2868,6 +3484,28 @@ clutter_text_class_init (ClutterTextClass *klass)
                                 CLUTTER_PARAM_READWRITE);
   g_object_class_install_property (gobject_class, PROP_SINGLE_LINE_MODE, pspec);
 
+  /**
+   * ClutterText:layout-async:
+   *
+   * Whether the #ClutterText actor should shape its contents using
+   * a worker thread. While the layout is being created the actor
+   * will report a size estimated from the font size, and it will
+   * queue a relayout once the layout is ready.
+   *
+   * This property only has effect if threading has been initialized,
+   * if Clutter was built against Pango 1.32 or later and if the
+   * #ClutterText:editable property is set to %FALSE.
+   *
+   * Since: 1.4
+   */
+  pspec = g_param_spec_boolean ("layout-async",
+                                P_("Layout Asynchronously"),
+                                P_("Whether the text should be shaped "
+                                   "in a separate thread"),
+                                FALSE,
+                                CLUTTER_PARAM_READWRITE);
+  g_object_class_install_property (gobject_class, PROP_LAYOUT_ASYNC, pspec);
+
   /**
    * ClutterText::text-changed:
    * @self: the #ClutterText that emitted the signal
@@ -3083,6 +3721,8 @@ clutter_text_init (ClutterText *self)
   for (i = 0; i < N_CACHED_LAYOUTS; i++)
     priv->cached_layouts[i].layout = NULL;
 
+  priv->offset_index = g_array_new (FALSE, FALSE, sizeof (gint));
+
   /* default to "" so that clutter_text_get_text() will
    * return a valid string and we can safely call strlen()
    * or strcmp() on it
@@ -3581,8 +4221,8 @@ clutter_text_get_selection (ClutterText *self)
       end_index = temp;
     }
 
-  start_offset = offset_to_bytes (priv->text, start_index);
-  end_offset = offset_to_bytes (priv->text, end_index);
+  start_offset = clutter_text_offset_to_bytes (self, start_index);
+  end_offset = clutter_text_offset_to_bytes (self, end_index);
   len = end_offset - start_offset;
 
   str = g_malloc (len + 1);
@@ -4650,7 +5290,7 @@ clutter_text_insert_unichar (ClutterText *self,
   new = g_string_new (priv->text);
 
   if (priv->text)
-    pos = offset_to_bytes (priv->text, priv->position);
+    pos = clutter_text_offset_to_bytes (self, priv->position);
   else
     pos = 0;
 
@@ -4697,7 +5337,7 @@ clutter_text_insert_text (ClutterText *self,
 
   priv = self->priv;
 
-  pos_bytes = offset_to_bytes (priv->text, position);
+  pos_bytes = clutter_text_offset_to_bytes (self, position);
 
   new = g_string_new (priv->text);
   new = g_string_insert (new, pos_bytes, text);
@@ -4753,12 +5393,12 @@ clutter_text_delete_text (ClutterText *self,
   if (start_pos == 0)
     start_bytes = 0;
   else
-    start_bytes = offset_to_bytes (priv->text, start_pos);
+    start_bytes = clutter_text_offset_to_bytes (self, start_pos);
 
   if (end_pos == -1)
-    end_bytes = offset_to_bytes (priv->text, priv->n_chars);
+    end_bytes = clutter_text_offset_to_bytes (self, priv->n_chars);
   else
-    end_bytes = offset_to_bytes (priv->text, end_pos);
+    end_bytes = clutter_text_offset_to_bytes (self, end_pos);
 
   new = g_string_new (priv->text);
   new = g_string_erase (new, start_bytes, end_bytes - start_bytes);
@@ -4801,13 +5441,13 @@ clutter_text_delete_chars (ClutterText *self,
 
   if (priv->position == -1)
     {
-      num_pos = offset_to_bytes (priv->text, priv->n_chars - n_chars);
+      num_pos = clutter_text_offset_to_bytes (self, priv->n_chars - n_chars);
       new = g_string_erase (new, num_pos, -1);
     }
   else
     {
-      pos = offset_to_bytes (priv->text, priv->position - n_chars);
-      num_pos = offset_to_bytes (priv->text, priv->position);
+      pos = clutter_text_offset_to_bytes (self, priv->position - n_chars);
+      num_pos = clutter_text_offset_to_bytes (self, priv->position);
       new = g_string_erase (new, pos, num_pos - pos);
     }
 
@@ -4860,10 +5500,8 @@ clutter_text_get_chars (ClutterText *self,
   start_pos = MIN (priv->n_chars, start_pos);
   end_pos = MIN (priv->n_chars, end_pos);
 
-  start_index = g_utf8_offset_to_pointer (priv->text, start_pos)
-              - priv->text;
-  end_index   = g_utf8_offset_to_pointer (priv->text, end_pos)
-              - priv->text;
+  start_index = clutter_text_offset_to_bytes (self, start_pos);
+  end_index   = clutter_text_offset_to_bytes (self, end_pos);
 
   return g_strndup (priv->text + start_index, end_index - start_index);
 }
@@ -4939,6 +5577,65 @@ clutter_text_get_single_line_mode (ClutterText *self)
   return self->priv->single_line_mode;
 }
 
+/**
+ * clutter_text_set_layout_async:
+ * @self: a #ClutterText
+ * @layout_async: whether the text should be shaped in a separate thread
+ *
+ * Sets whether the contents of a #ClutterText actor should be shaped
+ * by a worker thread instead of blocking the main loop, which can be
+ * expensive for long texts or for complex scripts.
+ *
+ * Until the layout is ready the size of @self will be estimated
+ * from the font size, and the text will not be painted.
+ *
+ * Since: 1.4
+ */
+void
+clutter_text_set_layout_async (ClutterText *self,
+                               gboolean     layout_async)
+{
+  ClutterTextPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_TEXT (self));
+
+  priv = self->priv;
+
+  layout_async = !!layout_async;
+
+  if (priv->layout_async != layout_async)
+    {
+      priv->layout_async = layout_async;
+
+      if (!priv->layout_async)
+        {
+          clutter_text_cancel_layout_jobs (self);
+          clutter_actor_queue_relayout (CLUTTER_ACTOR (self));
+        }
+
+      g_object_notify (G_OBJECT (self), "layout-async");
+    }
+}
+
+/**
+ * clutter_text_get_layout_async:
+ * @self: a #ClutterText
+ *
+ * Retrieves whether the contents of the #ClutterText actor are
+ * shaped by a worker thread.
+ *
+ * Return value: %TRUE if the layout is created asynchronously
+ *
+ * Since: 1.4
+ */
+gboolean
+clutter_text_get_layout_async (ClutterText *self)
+{
+  g_return_val_if_fail (CLUTTER_IS_TEXT (self), FALSE);
+
+  return self->priv->layout_async;
+}
+
 /**
  * clutter_text_set_preedit_string:
  * @self: a #ClutterText
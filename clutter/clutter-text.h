@@ -199,6 +199,9 @@ gint                  clutter_text_get_max_length       (ClutterText          *s
 void                  clutter_text_set_single_line_mode (ClutterText          *self,
                                                          gboolean              single_line);
 gboolean              clutter_text_get_single_line_mode (ClutterText          *self);
+void                  clutter_text_set_layout_async     (ClutterText          *self,
+                                                         gboolean              layout_async);
+gboolean              clutter_text_get_layout_async     (ClutterText          *self);
 
 gboolean              clutter_text_activate             (ClutterText          *self);
 gboolean              clutter_text_position_to_coords   (ClutterText          *self,
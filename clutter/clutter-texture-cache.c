@@ -0,0 +1,417 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2010  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* This file contains a process-wide cache of the textures loaded
+   from image files, so that actors showing the same file share a
+   single copy of the decoded image in texture memory.
+
+   Each entry counts the number of users holding the texture. Entries
+   that are no longer used are kept in a least-recently-used queue so
+   that a file loaded again shortly after is not decoded twice; they
+   are evicted once their total size goes over the size of the cache
+   set with CLUTTER_TEXTURE_CACHE_SIZE.
+
+   The cache must only be used from the main thread. */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "clutter-texture-cache.h"
+#include "clutter-debug.h"
+#include "clutter-private.h"
+#include "clutter-profile.h"
+
+typedef struct _ClutterTextureCacheEntry ClutterTextureCacheEntry;
+
+struct _ClutterTextureCacheEntry
+{
+  gchar *key;
+  /* The name the file was first loaded with, for the debug notes */
+  gchar *filename;
+
+  CoglHandle texture;
+
+  /* Size of the texture data, in bytes */
+  gsize size;
+
+  /* Number of users of the texture. When it drops to zero the entry
+     is linked in the unused queue */
+  guint use_count;
+  GList *unused_link;
+};
+
+/* key → entry */
+static GHashTable *cache_entries = NULL;
+/* texture → entry */
+static GHashTable *cache_textures = NULL;
+
+/* Entries which are not used by any texture, oldest first */
+static GQueue unused_entries = G_QUEUE_INIT;
+static gsize unused_size = 0;
+
+static guint n_hits = 0;
+static guint n_misses = 0;
+
+static void
+clutter_texture_cache_ensure (void)
+{
+  if (G_LIKELY (cache_entries != NULL))
+    return;
+
+  cache_entries = g_hash_table_new (g_str_hash, g_str_equal);
+  cache_textures = g_hash_table_new (NULL, NULL);
+}
+
+/* Returns an absolute version of @filename without any "." or ".."
+   components or repeated separators so that different spellings of
+   the same path give the same key */
+static gchar *
+clutter_texture_cache_canonicalize_path (const gchar *filename)
+{
+  const gchar *rest;
+  gchar *path, **parts;
+  GPtrArray *components;
+  GString *result;
+  gint i;
+
+  if (g_path_is_absolute (filename))
+    path = g_strdup (filename);
+  else
+    {
+      gchar *cwd = g_get_current_dir ();
+
+      path = g_build_filename (cwd, filename, NULL);
+      g_free (cwd);
+    }
+
+  rest = g_path_skip_root (path);
+  parts = g_strsplit_set (rest, G_DIR_SEPARATOR_S "/", -1);
+  components = g_ptr_array_new ();
+
+  for (i = 0; parts[i] != NULL; i++)
+    {
+      if (parts[i][0] == '\0' || strcmp (parts[i], ".") == 0)
+        continue;
+
+      if (strcmp (parts[i], "..") == 0)
+        {
+          if (components->len > 0)
+            g_ptr_array_remove_index (components, components->len - 1);
+        }
+      else
+        g_ptr_array_add (components, parts[i]);
+    }
+
+  result = g_string_new_len (path, rest - path);
+
+  for (i = 0; i < components->len; i++)
+    {
+      if (i > 0)
+        g_string_append_c (result, G_DIR_SEPARATOR);
+      g_string_append (result, g_ptr_array_index (components, i));
+    }
+
+  g_ptr_array_free (components, TRUE);
+  g_strfreev (parts);
+  g_free (path);
+
+  return g_string_free (result, FALSE);
+}
+
+/* The key identifies the file together with the parameters the
+   texture was created with. Where the file system gives us an inode
+   number the file is identified by its device and inode so that
+   paths reached through symbolic links or hard links share the same
+   entry; otherwise the canonical absolute path is used. The
+   modification time and size are included so that a file changed on
+   disk is loaded again. Returns NULL if the file can't be found */
+static gchar *
+clutter_texture_cache_make_key (const gchar      *filename,
+                                CoglTextureFlags  flags,
+                                CoglPixelFormat   internal_format)
+{
+  struct stat stat_buf;
+  gchar *file_id, *key;
+
+  if (g_stat (filename, &stat_buf) != 0)
+    return NULL;
+
+  if (stat_buf.st_ino != 0)
+    file_id = g_strdup_printf ("%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT,
+                               (guint64) stat_buf.st_dev,
+                               (guint64) stat_buf.st_ino);
+  else
+    file_id = clutter_texture_cache_canonicalize_path (filename);
+
+  key = g_strdup_printf ("%s:%lu:%" G_GUINT64_FORMAT ":%x:%x",
+                         file_id,
+                         (gulong) stat_buf.st_mtime,
+                         (guint64) stat_buf.st_size,
+                         (guint) flags,
+                         (guint) internal_format);
+
+  g_free (file_id);
+
+  return key;
+}
+
+static void
+clutter_texture_cache_entry_free (ClutterTextureCacheEntry *entry)
+{
+  g_hash_table_remove (cache_entries, entry->key);
+  g_hash_table_remove (cache_textures, entry->texture);
+
+  cogl_handle_unref (entry->texture);
+  g_free (entry->key);
+  g_free (entry->filename);
+
+  g_slice_free (ClutterTextureCacheEntry, entry);
+}
+
+static void
+clutter_texture_cache_evict (void)
+{
+  ClutterMainContext *context = _clutter_context_get_default ();
+
+  while (unused_size > context->texture_cache_size)
+    {
+      ClutterTextureCacheEntry *entry = g_queue_pop_head (&unused_entries);
+
+      CLUTTER_NOTE (TEXTURE, "Evicting '%s' from the texture cache",
+                    entry->filename);
+
+      unused_size -= entry->size;
+
+      clutter_texture_cache_entry_free (entry);
+    }
+}
+
+static CoglHandle
+clutter_texture_cache_entry_use (ClutterTextureCacheEntry *entry)
+{
+  if (entry->use_count++ == 0)
+    {
+      g_queue_delete_link (&unused_entries, entry->unused_link);
+      entry->unused_link = NULL;
+      unused_size -= entry->size;
+    }
+
+  return cogl_handle_ref (entry->texture);
+}
+
+/*
+ * _clutter_texture_cache_lookup:
+ * @filename: the name of an image file
+ * @flags: the flags the texture should be created with
+ * @internal_format: the format the texture should be created with
+ *
+ * Looks up a texture previously loaded from @filename with the same
+ * parameters. The texture must be released with
+ * _clutter_texture_cache_release() once it isn't used anymore.
+ *
+ * Return value: a new reference on the cached texture, or
+ *   %COGL_INVALID_HANDLE if there isn't one
+ */
+CoglHandle
+_clutter_texture_cache_lookup (const gchar      *filename,
+                               CoglTextureFlags  flags,
+                               CoglPixelFormat   internal_format)
+{
+  ClutterTextureCacheEntry *entry = NULL;
+  gchar *key;
+
+  CLUTTER_STATIC_COUNTER (texture_cache_hit_counter,
+                          "Texture cache hits",
+                          "Increments for each image file loaded "
+                          "from the texture cache",
+                          0);
+  CLUTTER_STATIC_COUNTER (texture_cache_miss_counter,
+                          "Texture cache misses",
+                          "Increments for each image file that needed "
+                          "to be decoded",
+                          0);
+
+  clutter_texture_cache_ensure ();
+
+  key = clutter_texture_cache_make_key (filename, flags, internal_format);
+  if (key != NULL)
+    entry = g_hash_table_lookup (cache_entries, key);
+
+  g_free (key);
+
+  if (entry == NULL)
+    {
+      n_misses++;
+      CLUTTER_COUNTER_INC (_clutter_uprof_context,
+                           texture_cache_miss_counter);
+
+      CLUTTER_NOTE (TEXTURE, "Texture cache miss for '%s' "
+                    "(%u hits, %u misses)",
+                    filename, n_hits, n_misses);
+
+      return COGL_INVALID_HANDLE;
+    }
+
+  n_hits++;
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, texture_cache_hit_counter);
+
+  CLUTTER_NOTE (TEXTURE, "Texture cache hit for '%s' (%u hits, %u misses)",
+                filename, n_hits, n_misses);
+
+  return clutter_texture_cache_entry_use (entry);
+}
+
+/*
+ * _clutter_texture_cache_insert:
+ * @filename: the name of the image file @texture was loaded from
+ * @flags: the flags @texture was created with
+ * @internal_format: the format @texture was created with
+ * @texture: a #CoglHandle for a texture
+ *
+ * Adds @texture to the cache and marks it as used. If another texture
+ * has been loaded from the same file in the meantime that texture is
+ * used instead, so the caller should always use the returned texture
+ * and release it with _clutter_texture_cache_release().
+ *
+ * Return value: a new reference on the cached texture
+ */
+CoglHandle
+_clutter_texture_cache_insert (const gchar      *filename,
+                               CoglTextureFlags  flags,
+                               CoglPixelFormat   internal_format,
+                               CoglHandle        texture)
+{
+  ClutterTextureCacheEntry *entry;
+  gchar *key;
+
+  g_return_val_if_fail (cogl_is_texture (texture), COGL_INVALID_HANDLE);
+
+  clutter_texture_cache_ensure ();
+
+  key = clutter_texture_cache_make_key (filename, flags, internal_format);
+
+  /* The file is gone; the texture can still be used but it can't be
+     shared */
+  if (key == NULL)
+    return cogl_handle_ref (texture);
+
+  entry = g_hash_table_lookup (cache_entries, key);
+  if (entry != NULL)
+    {
+      g_free (key);
+
+      return clutter_texture_cache_entry_use (entry);
+    }
+
+  entry = g_slice_new (ClutterTextureCacheEntry);
+  entry->key = key;
+  entry->filename = g_strdup (filename);
+  entry->texture = cogl_handle_ref (texture);
+  entry->size = cogl_texture_get_data (texture,
+                                       cogl_texture_get_format (texture),
+                                       0, NULL);
+  entry->use_count = 1;
+  entry->unused_link = NULL;
+
+  g_hash_table_insert (cache_entries, entry->key, entry);
+  g_hash_table_insert (cache_textures, entry->texture, entry);
+
+  return cogl_handle_ref (entry->texture);
+}
+
+/*
+ * _clutter_texture_cache_load:
+ * @filename: the name of an image file
+ * @flags: the flags the texture should be created with
+ * @internal_format: the format the texture should be created with
+ * @error: return location for a #GError or %NULL
+ *
+ * Wrapper around cogl_texture_new_from_file() which first looks for
+ * the texture in the cache, and adds it to the cache once loaded.
+ *
+ * Return value: a new reference on the texture, which must be
+ *   released with _clutter_texture_cache_release(), or
+ *   %COGL_INVALID_HANDLE on failure
+ */
+CoglHandle
+_clutter_texture_cache_load (const gchar      *filename,
+                             CoglTextureFlags  flags,
+                             CoglPixelFormat   internal_format,
+                             GError          **error)
+{
+  CoglHandle texture, retval;
+
+  texture = _clutter_texture_cache_lookup (filename, flags, internal_format);
+  if (texture != COGL_INVALID_HANDLE)
+    return texture;
+
+  texture = cogl_texture_new_from_file (filename,
+                                        flags,
+                                        internal_format,
+                                        error);
+  if (texture == COGL_INVALID_HANDLE)
+    return COGL_INVALID_HANDLE;
+
+  retval = _clutter_texture_cache_insert (filename,
+                                          flags,
+                                          internal_format,
+                                          texture);
+  cogl_handle_unref (texture);
+
+  return retval;
+}
+
+/*
+ * _clutter_texture_cache_release:
+ * @texture: a texture returned by the cache
+ *
+ * Releases a texture returned by _clutter_texture_cache_lookup(),
+ * _clutter_texture_cache_insert() or _clutter_texture_cache_load().
+ * The texture is kept in the cache until it's evicted to make room
+ * for other textures.
+ */
+void
+_clutter_texture_cache_release (CoglHandle texture)
+{
+  ClutterTextureCacheEntry *entry;
+
+  entry = cache_textures != NULL
+        ? g_hash_table_lookup (cache_textures, texture)
+        : NULL;
+
+  if (entry != NULL && --entry->use_count == 0)
+    {
+      g_queue_push_tail (&unused_entries, entry);
+      entry->unused_link = unused_entries.tail;
+      unused_size += entry->size;
+    }
+
+  cogl_handle_unref (texture);
+
+  if (entry != NULL)
+    clutter_texture_cache_evict ();
+}
@@ -0,0 +1,45 @@
+/*
+ * Clutter.
+ *
+ * An OpenGL based 'interactive canvas' library.
+ *
+ * Copyright (C) 2010  Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CLUTTER_TEXTURE_CACHE_H__
+#define __CLUTTER_TEXTURE_CACHE_H__
+
+#include <glib.h>
+#include <cogl/cogl.h>
+
+G_BEGIN_DECLS
+
+CoglHandle _clutter_texture_cache_lookup      (const gchar      *filename,
+                                               CoglTextureFlags  flags,
+                                               CoglPixelFormat   internal_format);
+CoglHandle _clutter_texture_cache_insert      (const gchar      *filename,
+                                               CoglTextureFlags  flags,
+                                               CoglPixelFormat   internal_format,
+                                               CoglHandle        texture);
+CoglHandle _clutter_texture_cache_load        (const gchar      *filename,
+                                               CoglTextureFlags  flags,
+                                               CoglPixelFormat   internal_format,
+                                               GError          **error);
+void       _clutter_texture_cache_release     (CoglHandle        texture);
+
+G_END_DECLS
+
+#endif /* __CLUTTER_TEXTURE_CACHE_H__ */
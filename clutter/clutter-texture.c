@@ -50,10 +50,12 @@
 #include "clutter-feature.h"
 #include "clutter-util.h"
 #include "clutter-private.h"
+#include "clutter-profile.h"
 #include "clutter-scriptable.h"
 #include "clutter-debug.h"
 #include "clutter-fixed.h"
 #include "clutter-enum-types.h"
+#include "clutter-texture-cache.h"
 
 #include "cogl/cogl.h"
 
@@ -68,6 +70,18 @@ G_DEFINE_TYPE_WITH_CODE (ClutterTexture,
 #define CLUTTER_TEXTURE_GET_PRIVATE(obj)        (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_TEXTURE, ClutterTexturePrivate))
 
 typedef struct _ClutterTextureAsyncData ClutterTextureAsyncData;
+typedef struct _ClutterTextureStrip     ClutterTextureStrip;
+
+/* Loaded images bigger than this, in bytes, are uploaded in chunks of
+ * rows which can be spread over several frames
+ */
+#define UPLOAD_CHUNK_SIZE       (256 * 1024)
+
+/* Maximum size of the decoded strips waiting to be uploaded for an
+ * image decoded progressively; the load thread waits when the upload
+ * falls behind
+ */
+#define STRIP_QUEUE_SIZE        (4 * UPLOAD_CHUNK_SIZE)
 
 struct _ClutterTexturePrivate
 {
@@ -81,6 +95,10 @@ struct _ClutterTexturePrivate
 
   CoglHandle pick_material;
 
+  /* Set when the texture was loaded from a file through the texture
+     cache, in which case it may be shared with other actors */
+  CoglHandle cached_texture;
+
   ClutterTextureAsyncData *async_data;
 
   guint no_slice : 1;
@@ -124,6 +142,54 @@ struct _ClutterTextureAsyncData
   gchar          *load_filename;
   CoglHandle      load_bitmap;
   GError         *load_error;
+
+  /* Texture found in the texture cache, in which case the file does
+     not need to be loaded at all */
+  CoglHandle      cached_texture;
+
+  /* Texture being filled in chunks for images that are too big to be
+     uploaded at once, and the next row of the image to upload */
+  CoglHandle      upload_texture;
+  gint            upload_row;
+
+  /* Set for big images loaded in a thread, which are decoded
+     progressively. The load thread queues strips of decoded rows
+     which are uploaded to upload_texture as they arrive; upload_row
+     then tracks how much of the texture has been cleared */
+  gboolean        progressive;
+
+  /* The fields below are protected by the mutex. The size and format
+     are set when the first strip is queued */
+  GQueue          strips;
+  gsize           strips_size;
+  gint            load_width;
+  gint            load_height;
+  CoglPixelFormat load_format;
+
+  /* Signalled when strips are taken off the queue or the load is
+     aborted, to wake up the load thread if the queue was full */
+  GCond          *strips_cond;
+
+  /* Set by the load thread once it has queued all of the strips.
+     The thread doesn't touch the data after setting it */
+  gboolean        decode_finished;
+
+  /* Whether upload_texture has been set on the actor */
+  gboolean        upload_shown;
+
+  /* Set for textures with the high filter quality, in which case the
+     load thread also computes the mipmap levels. mipmap_bitmap holds
+     them once the whole image is decoded, which for progressive loads
+     is protected by the mutex like decode_finished */
+  gboolean        generate_mipmaps;
+  CoglHandle      mipmap_bitmap;
+};
+
+struct _ClutterTextureStrip
+{
+  CoglHandle bitmap;
+  gint       first_row;
+  gsize      size;
 };
 
 enum
@@ -151,6 +217,7 @@ enum
   PIXBUF_CHANGE,
   LOAD_SUCCESS,
   LOAD_FINISHED,
+  LOAD_PROGRESS,
   LAST_SIGNAL
 };
 
@@ -213,6 +280,12 @@ texture_free_gl_resources (ClutterTexture *texture)
        remain but we want to free its resources so we clear the
        texture handle */
     cogl_material_set_layer (priv->material, 0, COGL_INVALID_HANDLE);
+
+  if (priv->cached_texture != COGL_INVALID_HANDLE)
+    {
+      _clutter_texture_cache_release (priv->cached_texture);
+      priv->cached_texture = COGL_INVALID_HANDLE;
+    }
 }
 
 static void
@@ -650,9 +723,19 @@ clutter_texture_paint (ClutterActor *self)
   gen_texcoords_and_draw_cogl_rectangle (self);
 }
 
+static void
+clutter_texture_strip_free (ClutterTextureStrip *strip)
+{
+  cogl_handle_unref (strip->bitmap);
+
+  g_slice_free (ClutterTextureStrip, strip);
+}
+
 static void
 clutter_texture_async_data_free (ClutterTextureAsyncData *data)
 {
+  ClutterTextureStrip *strip;
+
   /* This function should only be called either from the main thread
      once it is known that the load thread has completed or from the
      load thread/upload function itself if the abort flag is true (in
@@ -667,6 +750,23 @@ clutter_texture_async_data_free (ClutterTextureAsyncData *data)
   if (data->load_error)
     g_error_free (data->load_error);
 
+  if (data->upload_texture)
+    cogl_handle_unref (data->upload_texture);
+
+  if (data->mipmap_bitmap)
+    cogl_handle_unref (data->mipmap_bitmap);
+
+  while ((strip = g_queue_pop_head (&data->strips)))
+    clutter_texture_strip_free (strip);
+
+  if (data->strips_cond)
+    g_cond_free (data->strips_cond);
+
+  /* Loads using a cached texture are never run in a thread so this is
+     always called from the main thread */
+  if (data->cached_texture)
+    _clutter_texture_cache_release (data->cached_texture);
+
   if (data->mutex)
     g_mutex_free (data->mutex);
 
@@ -714,6 +814,11 @@ clutter_texture_async_load_cancel (ClutterTexture *texture)
              is now waiting for a master clock iteration to be repainted */
           priv->async_data->abort = TRUE;
 
+          /* Wake up the load thread if it is waiting for strips to be
+             uploaded */
+          if (priv->async_data->strips_cond)
+            g_cond_broadcast (priv->async_data->strips_cond);
+
           if (mutex)
             g_mutex_unlock (mutex);
         }
@@ -1027,6 +1132,11 @@ clutter_texture_class_init (ClutterTextureClass *klass)
    * it must be performed from within the same thread that called
    * clutter_main().
    *
+   * When threading is enabled, big images are decoded progressively: the
+   * texture is set as soon as the first rows are decoded and
+   * #ClutterTexture::load-progress is emitted as the rest of the image
+   * comes in.
+   *
    * Since: 1.0
    */
   pspec = g_param_spec_boolean ("load-async",
@@ -1133,6 +1243,34 @@ clutter_texture_class_init (ClutterTextureClass *klass)
 		  G_TYPE_NONE,
 		  1,
                   G_TYPE_POINTER);
+  /**
+   * ClutterTexture::load-progress:
+   * @texture: the texture which received the signal
+   * @y: the first row of the image that was updated
+   * @height: the number of rows that were updated
+   *
+   * The ::load-progress signal is emitted while a big image is
+   * loaded asynchronously, each time decoded rows of the image have
+   * been uploaded to the texture. The texture is set on the actor,
+   * showing the rows decoded so far, before the first emission.
+   * Interlaced and progressive images update the same rows several
+   * times.
+   *
+   * The ::load-finished signal is emitted once the whole image has
+   * been loaded, or if the load fails part of the way through.
+   *
+   * Since: 1.4
+   */
+  texture_signals[LOAD_PROGRESS] =
+    g_signal_new (I_("load-progress"),
+		  G_TYPE_FROM_CLASS (gobject_class),
+		  G_SIGNAL_RUN_LAST,
+		  0,
+		  NULL, NULL,
+		  _clutter_marshal_VOID__INT_INT,
+		  G_TYPE_NONE, 2,
+                  G_TYPE_INT,
+                  G_TYPE_INT);
 }
 
 static ClutterScriptableIface *parent_scriptable_iface = NULL;
@@ -1202,6 +1340,7 @@ clutter_texture_init (ClutterTexture *self)
   priv->material          = cogl_material_new ();
   priv->fbo_handle        = COGL_INVALID_HANDLE;
   priv->pick_material     = COGL_INVALID_HANDLE;
+  priv->cached_texture    = COGL_INVALID_HANDLE;
   priv->keep_aspect_ratio = FALSE;
   priv->pick_with_alpha   = FALSE;
   priv->pick_with_alpha_supported = TRUE;
@@ -1563,23 +1702,31 @@ clutter_texture_set_from_yuv_data (ClutterTexture     *texture,
 
 /*
  * clutter_texture_async_load_complete:
- * @self: a #ClutterTexture
- * @bitmap: a handle to a CoglBitmap
+ * @data: the data of the asynchronous load
  * @error: load error
  *
- * If @error is %NULL, loads @bitmap into a #CoglTexture.
+ * If @error is %NULL, sets the texture found in the texture cache
+ * when the load was started, or the texture already filled with the
+ * loaded bitmap, or otherwise loads the bitmap into a new #CoglTexture.
+ * Loaded textures are added to the texture cache.
  *
- * This function emits the ::load-finished signal on @self.
+ * This function emits the ::load-finished signal on the texture.
  */
 static void
-clutter_texture_async_load_complete (ClutterTexture *self,
-                                     CoglHandle      bitmap,
-                                     const GError   *error)
+clutter_texture_async_load_complete (ClutterTextureAsyncData *data,
+                                     const GError            *error)
 {
+  ClutterTexture *self = data->texture;
   ClutterTexturePrivate *priv = self->priv;
-  CoglHandle handle;
+  CoglHandle handle, texture;
   CoglTextureFlags flags = COGL_TEXTURE_NONE;
 
+  CLUTTER_STATIC_COUNTER (texture_upload_counter,
+                          "Texture uploads counter",
+                          "Increments for each asynchronously loaded "
+                          "texture uploaded",
+                          0);
+
   priv->async_data = NULL;
 
   if (error == NULL)
@@ -1587,19 +1734,57 @@ clutter_texture_async_load_complete (ClutterTexture *self,
       if (priv->no_slice)
         flags |= COGL_TEXTURE_NO_SLICING;
 
-      handle = cogl_texture_new_from_bitmap (bitmap,
-                                             flags,
-                                             COGL_PIXEL_FORMAT_ANY);
-      clutter_texture_set_cogl_texture (self, handle);
-
-      if (priv->load_size_async)
+      if (data->cached_texture != COGL_INVALID_HANDLE)
         {
-          g_signal_emit (self, texture_signals[SIZE_CHANGE], 0,
-                         cogl_texture_get_width (handle),
-                         cogl_texture_get_height (handle));
+          /* Hand our use of the cached texture over to the actor */
+          handle = data->cached_texture;
+          data->cached_texture = COGL_INVALID_HANDLE;
         }
+      else
+        {
+          if (data->upload_texture != COGL_INVALID_HANDLE)
+            {
+              texture = cogl_handle_ref (data->upload_texture);
+
+              /* The levels computed by the load thread can only be
+                 given once the whole image has been uploaded */
+              if (data->mipmap_bitmap != COGL_INVALID_HANDLE)
+                cogl_texture_set_mipmaps_from_bitmap (texture,
+                                                      data->mipmap_bitmap);
+            }
+          else if (data->load_bitmap != COGL_INVALID_HANDLE)
+            texture = cogl_texture_new_from_bitmap (data->load_bitmap,
+                                                    flags,
+                                                    COGL_PIXEL_FORMAT_ANY);
+          else
+            texture = COGL_INVALID_HANDLE;
+
+          CLUTTER_COUNTER_INC (_clutter_uprof_context, texture_upload_counter);
 
-      cogl_handle_unref (handle);
+          if (texture != COGL_INVALID_HANDLE)
+            {
+              handle = _clutter_texture_cache_insert (data->load_filename,
+                                                      flags,
+                                                      COGL_PIXEL_FORMAT_ANY,
+                                                      texture);
+              cogl_handle_unref (texture);
+            }
+          else
+            handle = COGL_INVALID_HANDLE;
+        }
+
+      if (handle != COGL_INVALID_HANDLE)
+        {
+          clutter_texture_set_cogl_texture (self, handle);
+          priv->cached_texture = handle;
+
+          if (priv->load_size_async)
+            {
+              g_signal_emit (self, texture_signals[SIZE_CHANGE], 0,
+                             cogl_texture_get_width (handle),
+                             cogl_texture_get_height (handle));
+            }
+        }
     }
 
   g_signal_emit (self, texture_signals[LOAD_FINISHED], 0, error);
@@ -1623,40 +1808,375 @@ clutter_texture_thread_idle_func (gpointer user_data)
     }
   g_mutex_unlock (data->mutex);
 
-  clutter_texture_async_load_complete (data->texture, data->load_bitmap,
-                                       data->load_error);
+  clutter_texture_async_load_complete (data, data->load_error);
 
   clutter_texture_async_data_free (data);
 
   return FALSE;
 }
 
+/*
+ * clutter_texture_async_clear:
+ * @data: the data of a progressive load
+ * @end_time: the time at which the uploads for the current frame
+ *   should stop
+ *
+ * Creates the texture for a progressively decoded image and clears
+ * it, so that the rows which haven't been decoded yet don't show
+ * garbage once the texture is set on the actor.
+ *
+ * Return value: %TRUE once the texture is ready for the strips
+ */
+static gboolean
+clutter_texture_async_clear (ClutterTextureAsyncData *data,
+                             gulong                   end_time)
+{
+  gint width, height, rows_per_chunk;
+  guint8 *zeros;
+
+  /* The size can be read without locking the mutex because it was
+     set before the first strip was queued */
+  width = data->load_width;
+  height = data->load_height;
+
+  if (data->upload_row >= height)
+    return TRUE;
+
+  if (data->upload_texture == COGL_INVALID_HANDLE)
+    {
+      CoglTextureFlags flags = COGL_TEXTURE_NONE;
+
+      if (data->texture->priv->no_slice)
+        flags |= COGL_TEXTURE_NO_SLICING;
+
+      data->upload_texture = cogl_texture_new_with_size (width, height,
+                                                         flags,
+                                                         data->load_format);
+
+      /* the strips will be dropped if the texture can't be created */
+      if (data->upload_texture == COGL_INVALID_HANDLE)
+        {
+          data->upload_row = height;
+          return TRUE;
+        }
+
+      CLUTTER_NOTE (TEXTURE, "Decoding '%s' (%dx%d) progressively",
+                    data->load_filename,
+                    width, height);
+    }
+
+  rows_per_chunk = MAX (1, UPLOAD_CHUNK_SIZE / (width * 4));
+  zeros = g_malloc0 (rows_per_chunk * width * 4);
+
+  do
+    {
+      gint n_rows = MIN (rows_per_chunk, height - data->upload_row);
+
+      cogl_texture_set_region (data->upload_texture,
+                               0, 0,
+                               0, data->upload_row,
+                               width, n_rows,
+                               width, n_rows,
+                               COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                               width * 4,
+                               zeros);
+
+      data->upload_row += n_rows;
+    }
+  while (data->upload_row < height && clutter_get_timestamp () < end_time);
+
+  g_free (zeros);
+
+  return data->upload_row >= height;
+}
+
+static void
+clutter_texture_async_upload_strip (ClutterTextureAsyncData *data,
+                                    ClutterTextureStrip     *strip)
+{
+  ClutterTexture *self = data->texture;
+  gint n_rows;
+
+  CLUTTER_STATIC_COUNTER (texture_upload_strip_counter,
+                          "Texture upload strips counter",
+                          "Increments for each strip of rows uploaded "
+                          "for a progressively decoded texture",
+                          0);
+
+  if (data->upload_texture == COGL_INVALID_HANDLE)
+    return;
+
+  n_rows = cogl_bitmap_get_height (strip->bitmap);
+
+  cogl_texture_set_region_from_bitmap (data->upload_texture,
+                                       0, 0,
+                                       0, strip->first_row,
+                                       cogl_bitmap_get_width (strip->bitmap),
+                                       n_rows,
+                                       strip->bitmap);
+
+  CLUTTER_COUNTER_INC (_clutter_uprof_context, texture_upload_strip_counter);
+
+  /* Show the image as soon as the first rows are in */
+  if (!data->upload_shown)
+    {
+      data->upload_shown = TRUE;
+      clutter_texture_set_cogl_texture (self, data->upload_texture);
+    }
+  else
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (self));
+
+  g_signal_emit (self, texture_signals[LOAD_PROGRESS], 0,
+                 strip->first_row,
+                 n_rows);
+}
+
+/*
+ * clutter_texture_async_upload_progressive:
+ * @data: the data of a progressive load
+ * @end_time: the time at which the uploads for the current frame
+ *   should stop
+ *
+ * Uploads the strips queued by the load thread until @end_time is
+ * reached.
+ *
+ * Return value: %TRUE once the load thread has finished and all of
+ *   the strips have been uploaded, or the thread has finished after
+ *   the load was aborted
+ */
+static gboolean
+clutter_texture_async_upload_progressive (ClutterTextureAsyncData *data,
+                                          gulong                   end_time)
+{
+  ClutterTextureStrip *strip;
+  gboolean finished;
+
+  g_mutex_lock (data->mutex);
+  finished = data->decode_finished;
+  g_mutex_unlock (data->mutex);
+
+  /* The abort flag is only set by the main thread. Aborted loads
+     have to wait for the thread to stop before they can be freed */
+  if (data->abort)
+    return finished;
+
+  if (data->load_height > 0 && !clutter_texture_async_clear (data, end_time))
+    return FALSE;
+
+  do
+    {
+      g_mutex_lock (data->mutex);
+
+      if ((strip = g_queue_pop_head (&data->strips)) != NULL)
+        {
+          data->strips_size -= strip->size;
+          g_cond_signal (data->strips_cond);
+        }
+      else
+        finished = data->decode_finished;
+
+      g_mutex_unlock (data->mutex);
+
+      if (strip == NULL)
+        return finished;
+
+      /* The upload is done without holding the mutex so that the
+         thread can keep decoding in the meantime */
+      clutter_texture_async_upload_strip (data, strip);
+      clutter_texture_strip_free (strip);
+
+      /* a handler of ::load-progress may have cancelled the load */
+      if (data->abort)
+        return FALSE;
+    }
+  while (clutter_get_timestamp () < end_time);
+
+  return FALSE;
+}
+
+/*
+ * clutter_texture_async_upload_is_ready:
+ * @data: the data of an asynchronous load in the upload list
+ *
+ * Checks whether clutter_texture_async_upload() has anything to do
+ * for @data; progressive loads may be waiting for the thread.
+ */
+static gboolean
+clutter_texture_async_upload_is_ready (ClutterTextureAsyncData *data)
+{
+  gboolean ready;
+
+  if (!data->progressive)
+    return TRUE;
+
+  g_mutex_lock (data->mutex);
+  ready = (data->decode_finished ||
+           (!data->abort && !g_queue_is_empty (&data->strips)));
+  g_mutex_unlock (data->mutex);
+
+  return ready;
+}
+
+/*
+ * clutter_texture_async_upload:
+ * @data: the data of a finished asynchronous load
+ * @end_time: the time, as returned by clutter_get_timestamp(), at
+ *   which the uploads for the current frame should stop
+ *
+ * Uploads chunks of rows of the image loaded in @data, if it is big
+ * enough to need it, until @end_time is reached.
+ *
+ * Return value: %TRUE if the texture is ready to be created with
+ *   clutter_texture_thread_idle_func(), and %FALSE if there are rows
+ *   still left to upload
+ */
+static gboolean
+clutter_texture_async_upload (ClutterTextureAsyncData *data,
+                              gulong                   end_time)
+{
+  CoglHandle bitmap = data->load_bitmap;
+  gint width, height, rows_per_chunk;
+
+  CLUTTER_STATIC_COUNTER (texture_upload_chunk_counter,
+                          "Texture upload chunks counter",
+                          "Increments for each chunk of rows uploaded "
+                          "for a big texture",
+                          0);
+
+  if (data->progressive)
+    return clutter_texture_async_upload_progressive (data, end_time);
+
+  /* Aborted loads are freed by clutter_texture_thread_idle_func() */
+  if (data->abort || data->load_error != NULL || bitmap == NULL)
+    return TRUE;
+
+  width = cogl_bitmap_get_width (bitmap);
+  height = cogl_bitmap_get_height (bitmap);
+
+  /* assume 4 bytes per pixel, which is what most images end up
+     being converted to */
+  rows_per_chunk = MAX (1, UPLOAD_CHUNK_SIZE / (MAX (width, 1) * 4));
+
+  /* small images are uploaded in one go when creating the texture */
+  if (data->upload_texture == COGL_INVALID_HANDLE)
+    {
+      CoglTextureFlags flags = COGL_TEXTURE_NONE;
+
+      if (height <= rows_per_chunk)
+        return TRUE;
+
+      if (data->texture->priv->no_slice)
+        flags |= COGL_TEXTURE_NO_SLICING;
+
+      data->upload_texture =
+        cogl_texture_new_with_size (width, height,
+                                    flags,
+                                    cogl_bitmap_get_format (bitmap));
+
+      /* fall back to a single upload if we can't create the texture */
+      if (data->upload_texture == COGL_INVALID_HANDLE)
+        return TRUE;
+
+      data->upload_row = 0;
+
+      CLUTTER_NOTE (TEXTURE, "Uploading '%s' (%dx%d) in chunks of %d rows",
+                    data->load_filename,
+                    width, height,
+                    rows_per_chunk);
+    }
+
+  do
+    {
+      gint n_rows = MIN (rows_per_chunk, height - data->upload_row);
+
+      cogl_texture_set_region_from_bitmap (data->upload_texture,
+                                           0, data->upload_row,
+                                           0, data->upload_row,
+                                           width, n_rows,
+                                           bitmap);
+
+      data->upload_row += n_rows;
+
+      CLUTTER_COUNTER_INC (_clutter_uprof_context,
+                           texture_upload_chunk_counter);
+    }
+  while (data->upload_row < height && clutter_get_timestamp () < end_time);
+
+  return data->upload_row >= height;
+}
+
+/*
+ * texture_upload_list_get_next:
+ *
+ * Retrieves the next texture to upload from the upload list, giving
+ * priority to the textures that will be painted in the next frame.
+ * Progressive loads waiting for the load thread are skipped. The
+ * upload_list_mutex must be held when calling this function.
+ *
+ * Return value: the link of the next texture, or %NULL if there is
+ *   nothing to upload
+ */
+static GList *
+texture_upload_list_get_next (void)
+{
+  GList *l, *first_ready = NULL;
+
+  for (l = upload_list; l != NULL; l = l->next)
+    {
+      ClutterTextureAsyncData *data = l->data;
+
+      if (!clutter_texture_async_upload_is_ready (data))
+        continue;
+
+      /* The abort flag is only set by the main thread so it can be
+         read without locking the mutex of the data */
+      if (!data->abort && CLUTTER_ACTOR_IS_MAPPED (data->texture))
+        return l;
+
+      if (first_ready == NULL)
+        first_ready = l;
+    }
+
+  return first_ready;
+}
+
 static gboolean
 texture_repaint_upload_func (gpointer user_data)
 {
-  gulong start_time;
+  ClutterMainContext *context = _clutter_context_get_default ();
+  GList *next;
+  gulong end_time;
 
   g_static_mutex_lock (&upload_list_mutex);
 
-  if (upload_list)
+  if ((next = texture_upload_list_get_next ()) != NULL)
     {
-      start_time = clutter_get_timestamp ();
+      end_time = clutter_get_timestamp ()
+               + context->texture_upload_budget * 1000;
 
-      /* continue uploading textures as long as we havent spent more
-       * then 5ms doing so this stage redraw cycle.
+      /* continue uploading textures as long as we haven't spent more
+       * than the budget for this stage redraw cycle. Big textures are
+       * uploaded in chunks so that they can be spread across cycles
        */
       do
         {
-          ClutterTextureAsyncData *data = upload_list->data;
+          ClutterTextureAsyncData *data = next->data;
 
-          clutter_texture_thread_idle_func (data);
+          if (clutter_texture_async_upload (data, end_time))
+            {
+              upload_list = g_list_delete_link (upload_list, next);
 
-          upload_list = g_list_remove (upload_list, data);
+              clutter_texture_thread_idle_func (data);
+            }
         }
-      while (upload_list && clutter_get_timestamp () < start_time + 5 * 1000);
+      while (clutter_get_timestamp () < end_time &&
+             (next = texture_upload_list_get_next ()) != NULL);
     }
 
-  if (upload_list)
+  /* Progressive loads which are waiting for the thread don't need
+     another iteration; the thread asks for one when it queues more
+     strips */
+  if (texture_upload_list_get_next () != NULL)
     {
       ClutterMasterClock *master_clock;
 
@@ -1669,6 +2189,161 @@ texture_repaint_upload_func (gpointer user_data)
   return TRUE;
 }
 
+/*
+ * clutter_texture_thread_queue_strips:
+ * @data: the data of a progressive load
+ * @loader: the loader decoding the image
+ *
+ * Converts the rows decoded by @loader so far and queues them for the
+ * upload function, waiting if too many strips are already queued.
+ *
+ * Return value: %FALSE if the load has been aborted
+ */
+static gboolean
+clutter_texture_thread_queue_strips (ClutterTextureAsyncData *data,
+                                     CoglBitmapLoader        *loader)
+{
+  ClutterMasterClock *master_clock = _clutter_master_clock_get_default ();
+  CoglBitmap *rows, *converted;
+  gboolean aborted;
+  gint first_row;
+
+  g_mutex_lock (data->mutex);
+  aborted = data->abort;
+  g_mutex_unlock (data->mutex);
+
+  while (!aborted && (rows = cogl_bitmap_loader_get_rows (loader, &first_row)))
+    {
+      ClutterTextureStrip *strip;
+
+      /* Converting each strip on its own avoids keeping a converted
+         copy of the whole image */
+      converted = cogl_bitmap_convert_for_upload (rows, COGL_PIXEL_FORMAT_ANY);
+
+      if (converted)
+        {
+          cogl_handle_unref (rows);
+          rows = converted;
+        }
+
+      strip = g_slice_new (ClutterTextureStrip);
+      strip->bitmap = rows;
+      strip->first_row = first_row;
+      strip->size = cogl_bitmap_get_width (rows)
+                  * cogl_bitmap_get_height (rows) * 4;
+
+      g_mutex_lock (data->mutex);
+
+      while (!data->abort && data->strips_size >= STRIP_QUEUE_SIZE)
+        g_cond_wait (data->strips_cond, data->mutex);
+
+      if (data->abort)
+        {
+          aborted = TRUE;
+          clutter_texture_strip_free (strip);
+        }
+      else
+        {
+          if (data->load_height == 0)
+            {
+              cogl_bitmap_loader_get_size (loader,
+                                           &data->load_width,
+                                           &data->load_height);
+              data->load_format = cogl_bitmap_get_format (rows);
+            }
+
+          g_queue_push_tail (&data->strips, strip);
+          data->strips_size += strip->size;
+        }
+
+      g_mutex_unlock (data->mutex);
+
+      /* The main loop may be idle, and this thread will wait for it
+         once the queue is full */
+      _clutter_master_clock_ensure_next_iteration (master_clock);
+      g_main_context_wakeup (NULL);
+    }
+
+  return !aborted;
+}
+
+/*
+ * clutter_texture_thread_load_progressive:
+ * @data: the data of a progressive load
+ *
+ * Decodes the image of @data in the load thread a part at a time,
+ * queuing the decoded rows so that they can be uploaded while the
+ * rest of the image is decoded.
+ */
+static void
+clutter_texture_thread_load_progressive (ClutterTextureAsyncData *data)
+{
+  ClutterMasterClock *master_clock = _clutter_master_clock_get_default ();
+  CoglBitmapLoader *loader;
+  CoglBitmap *mipmap_bitmap = NULL;
+  GError *error = NULL;
+
+  /* The data is put in the upload list straight away. From now on it
+     is freed by the upload function once decode_finished is set */
+  g_static_mutex_lock (&upload_list_mutex);
+
+  if (repaint_upload_func == 0)
+    {
+      repaint_upload_func =
+        clutter_threads_add_repaint_func (texture_repaint_upload_func,
+                                          NULL, NULL);
+    }
+
+  upload_list = g_list_append (upload_list, data);
+  data->upload_queued = TRUE;
+
+  g_static_mutex_unlock (&upload_list_mutex);
+
+  loader = cogl_bitmap_loader_new (data->load_filename, &error);
+
+  if (loader != NULL)
+    {
+      while (clutter_texture_thread_queue_strips (data, loader) &&
+             !cogl_bitmap_loader_is_finished (loader) &&
+             cogl_bitmap_loader_load_more (loader, &error))
+        ;
+
+      /* The strips are already queued so the levels are computed
+         while the main thread uploads them */
+      if (data->generate_mipmaps && error == NULL)
+        {
+          gboolean should_abort;
+
+          g_mutex_lock (data->mutex);
+          should_abort = data->abort;
+          g_mutex_unlock (data->mutex);
+
+          if (!should_abort)
+            mipmap_bitmap = cogl_bitmap_loader_get_bitmap (loader);
+
+          if (mipmap_bitmap != NULL &&
+              !cogl_bitmap_generate_mipmaps (mipmap_bitmap,
+                                             COGL_BITMAP_FILTER_LANCZOS))
+            {
+              cogl_handle_unref (mipmap_bitmap);
+              mipmap_bitmap = NULL;
+            }
+        }
+
+      cogl_handle_unref (loader);
+    }
+
+  g_mutex_lock (data->mutex);
+  data->load_error = error;
+  data->mipmap_bitmap = mipmap_bitmap;
+  data->decode_finished = TRUE;
+  g_mutex_unlock (data->mutex);
+
+  /* The data may be freed by the main thread as soon as the mutex is
+     unlocked so it can't be used anymore */
+  _clutter_master_clock_ensure_next_iteration (master_clock);
+}
+
 static void
 clutter_texture_thread_func (gpointer user_data, gpointer pool_data)
 {
@@ -1689,9 +2364,39 @@ clutter_texture_thread_func (gpointer user_data, gpointer pool_data)
       return;
     }
 
+  if (data->progressive)
+    {
+      clutter_texture_thread_load_progressive (data);
+      return;
+    }
+
   data->load_bitmap = cogl_bitmap_new_from_file (data->load_filename,
                                                  &data->load_error);
 
+  /* Convert and premultiply the data in this thread as well so that
+     creating the texture in the main thread only has to upload it */
+  if (data->load_bitmap)
+    {
+      CoglBitmap *converted;
+
+      converted = cogl_bitmap_convert_for_upload (data->load_bitmap,
+                                                  COGL_PIXEL_FORMAT_ANY);
+
+      if (converted)
+        {
+          cogl_handle_unref (data->load_bitmap);
+          data->load_bitmap = converted;
+        }
+
+      /* The levels are attached to the bitmap so they are used
+         directly by cogl_texture_new_from_bitmap(). Big images
+         uploaded in chunks are given them once complete */
+      if (data->generate_mipmaps &&
+          cogl_bitmap_generate_mipmaps (data->load_bitmap,
+                                        COGL_BITMAP_FILTER_LANCZOS))
+        data->mipmap_bitmap = cogl_handle_ref (data->load_bitmap);
+    }
+
   /* Check again if we've been told to abort */
   g_mutex_lock (data->mutex);
 
@@ -1735,16 +2440,12 @@ static gboolean
 clutter_texture_idle_func (gpointer user_data)
 {
   ClutterTextureAsyncData *data = user_data;
-  GError *internal_error = NULL;
-
-  data->load_bitmap = cogl_bitmap_new_from_file (data->load_filename,
-                                                 &internal_error);
 
-  clutter_texture_async_load_complete (data->texture, data->load_bitmap,
-                                       internal_error);
+  if (data->cached_texture == COGL_INVALID_HANDLE)
+    data->load_bitmap = cogl_bitmap_new_from_file (data->load_filename,
+                                                   &data->load_error);
 
-  if (internal_error)
-    g_error_free (internal_error);
+  clutter_texture_async_load_complete (data, data->load_error);
 
   clutter_texture_async_data_free (data);
 
@@ -1766,7 +2467,9 @@ clutter_texture_idle_func (gpointer user_data)
  * The I/O is the only bit done in a thread -- uploading the
  * texture data to the GL pipeline must be done from within the
  * same thread that called clutter_main(). Threaded upload should
- * be part of the GL implementation.
+ * be part of the GL implementation. Big images are decoded
+ * progressively, the thread queuing strips of decoded rows for the
+ * upload function as it goes.
  *
  * This function will block until we get a size from the file
  * so that we can effectively get the size the texture actor after
@@ -1782,6 +2485,7 @@ clutter_texture_async_load (ClutterTexture *self,
 {
   ClutterTexturePrivate *priv = self->priv;
   ClutterTextureAsyncData *data;
+  CoglTextureFlags flags = COGL_TEXTURE_NONE;
   gint width, height;
   gboolean res;
 
@@ -1824,13 +2528,45 @@ clutter_texture_async_load (ClutterTexture *self,
   data->load_filename = g_strdup (filename);
   data->load_bitmap = NULL;
   data->load_error = NULL;
+  data->upload_texture = COGL_INVALID_HANDLE;
+  data->upload_row = 0;
+  data->progressive = FALSE;
+  g_queue_init (&data->strips);
+  data->strips_size = 0;
+  data->load_width = 0;
+  data->load_height = 0;
+  data->load_format = COGL_PIXEL_FORMAT_ANY;
+  data->strips_cond = NULL;
+  data->decode_finished = FALSE;
+  data->upload_shown = FALSE;
+  data->generate_mipmaps =
+    clutter_texture_get_filter_quality (self) == CLUTTER_TEXTURE_QUALITY_HIGH;
+  data->mipmap_bitmap = COGL_INVALID_HANDLE;
+
+  if (priv->no_slice)
+    flags |= COGL_TEXTURE_NO_SLICING;
+
+  data->cached_texture = _clutter_texture_cache_lookup (filename,
+                                                        flags,
+                                                        COGL_PIXEL_FORMAT_ANY);
 
   priv->async_data = data;
 
-  if (g_thread_supported ())
+  /* A texture found in the cache doesn't need any I/O so it is set
+     from an idle handler without involving a thread */
+  if (g_thread_supported () && data->cached_texture == COGL_INVALID_HANDLE)
     {
       data->mutex = g_mutex_new ();
 
+      /* Images that would be uploaded in chunks anyway are decoded
+         progressively so that they start showing up sooner */
+      if (priv->load_size_async ||
+          (gsize) width * height * 4 > UPLOAD_CHUNK_SIZE)
+        {
+          data->progressive = TRUE;
+          data->strips_cond = g_cond_new ();
+        }
+
       if (async_thread_pool == NULL)
         /* This apparently can't fail if exclusive == FALSE */
         async_thread_pool
@@ -1866,6 +2602,13 @@ clutter_texture_async_load (ClutterTexture *self,
  * #ClutterTexture::load-finished will be emitted when the image has been
  * loaded or if an error occurred.
  *
+ * Textures loaded from the same file with the same #ClutterTexture:no-slice
+ * setting share the same #CoglTexture, which is kept in a cache for a
+ * while after it stops being used. The #CoglTexture returned by
+ * clutter_texture_get_cogl_texture() should therefore not be modified
+ * directly; clutter_texture_set_area_from_rgb_data() makes a copy of
+ * the image before changing it.
+ *
  * Return value: %TRUE if the image was successfully loaded and set
  *
  * Since: 0.8
@@ -1890,10 +2633,10 @@ clutter_texture_set_from_file (ClutterTexture *texture,
   if (priv->no_slice)
     flags |= COGL_TEXTURE_NO_SLICING;
 
-  new_texture = cogl_texture_new_from_file (filename,
-                                            flags,
-                                            COGL_PIXEL_FORMAT_ANY,
-                                            &internal_error);
+  new_texture = _clutter_texture_cache_load (filename,
+                                             flags,
+                                             COGL_PIXEL_FORMAT_ANY,
+                                             &internal_error);
 
   /* If COGL didn't give an error then make one up */
   if (internal_error == NULL && new_texture == COGL_INVALID_HANDLE)
@@ -1915,7 +2658,8 @@ clutter_texture_set_from_file (ClutterTexture *texture,
 
   clutter_texture_set_cogl_texture (texture, new_texture);
 
-  cogl_handle_unref (new_texture);
+  /* The reference is released when the texture is replaced */
+  priv->cached_texture = new_texture;
 
   g_signal_emit (texture, texture_signals[LOAD_FINISHED], 0, NULL);
 
@@ -2104,6 +2848,53 @@ clutter_texture_get_base_size (ClutterTexture *texture,
     *height = texture->priv->image_height;
 }
 
+/* Replaces the texture loaded through the texture cache with a copy
+   that is not shared with any other actor */
+static CoglHandle
+clutter_texture_copy_cached_texture (ClutterTexture *texture)
+{
+  ClutterTexturePrivate *priv = texture->priv;
+  CoglHandle copy = COGL_INVALID_HANDLE;
+  CoglTextureFlags flags = COGL_TEXTURE_NONE;
+  CoglPixelFormat format;
+  gint width, height, rowstride, size;
+  guchar *data;
+
+  format = cogl_texture_get_format (priv->cached_texture);
+  width = cogl_texture_get_width (priv->cached_texture);
+  height = cogl_texture_get_height (priv->cached_texture);
+  rowstride = cogl_texture_get_rowstride (priv->cached_texture);
+
+  size = cogl_texture_get_data (priv->cached_texture, format, 0, NULL);
+  data = g_try_malloc (size);
+  if (data == NULL)
+    return COGL_INVALID_HANDLE;
+
+  cogl_texture_get_data (priv->cached_texture, format, rowstride, data);
+
+  if (priv->no_slice)
+    flags |= COGL_TEXTURE_NO_SLICING;
+
+  copy = cogl_texture_new_from_data (width, height,
+                                     flags,
+                                     format,
+                                     format,
+                                     rowstride,
+                                     data);
+  g_free (data);
+
+  if (copy == COGL_INVALID_HANDLE)
+    return COGL_INVALID_HANDLE;
+
+  CLUTTER_NOTE (TEXTURE, "Copying a shared texture before modifying it");
+
+  /* This releases the cached texture */
+  clutter_texture_set_cogl_texture (texture, copy);
+  cogl_handle_unref (copy);
+
+  return copy;
+}
+
 /**
  * clutter_texture_set_area_from_rgb_data:
  * @texture: A #ClutterTexture
@@ -2192,6 +2983,21 @@ clutter_texture_set_area_from_rgb_data (ClutterTexture     *texture,
       return FALSE;
     }
 
+  /* Textures loaded from files may be shared with other actors
+     through the texture cache so we need our own copy before
+     changing them */
+  if (texture->priv->cached_texture != COGL_INVALID_HANDLE)
+    {
+      cogl_texture = clutter_texture_copy_cached_texture (texture);
+      if (cogl_texture == COGL_INVALID_HANDLE)
+        {
+          g_set_error (error, CLUTTER_TEXTURE_ERROR,
+                       CLUTTER_TEXTURE_ERROR_BAD_FORMAT,
+                       "Failed to create COGL texture");
+          return FALSE;
+        }
+    }
+
   if (!cogl_texture_set_region (cogl_texture,
 				0, 0,
 				x, y, width, height,
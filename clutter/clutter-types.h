@@ -388,6 +388,10 @@ typedef enum {
  * ClutterFontFlags:
  * @CLUTTER_FONT_MIPMAPPING: Set to use mipmaps for the glyph cache textures.
  * @CLUTTER_FONT_HINTING: Set to enable hinting on the glyphs.
+ * @CLUTTER_FONT_ASYNC_RASTERIZATION: Set to rasterize missing glyphs in
+ *   worker threads and upload them at the start of the next frame
+ *   instead of on the paint path. Requires the GLib thread system to
+ *   be initialized. Since 1.4
  *
  * Runtime flags to change the font quality. To be used with
  * clutter_set_font_flags().
@@ -396,8 +400,9 @@ typedef enum {
  */
 typedef enum
 {
-  CLUTTER_FONT_MIPMAPPING = (1 << 0),
-  CLUTTER_FONT_HINTING    = (1 << 1),
+  CLUTTER_FONT_MIPMAPPING           = (1 << 0),
+  CLUTTER_FONT_HINTING              = (1 << 1),
+  CLUTTER_FONT_ASYNC_RASTERIZATION  = (1 << 2)
 } ClutterFontFlags;
 
 /**
@@ -30,7 +30,30 @@
 
 #define COGL_ATLAS_TEXTURE(tex) ((CoglAtlasTexture *) tex)
 
-typedef struct _CoglAtlasTexture CoglAtlasTexture;
+typedef struct _CoglAtlasTexture     CoglAtlasTexture;
+typedef struct _CoglAtlasTexturePage CoglAtlasTexturePage;
+
+/* The atlas is made of a list of fixed-size pages. New textures are
+   put in the first page of the right format with enough room and a
+   new page is added when none has, so existing textures never need
+   to be moved */
+struct _CoglAtlasTexturePage
+{
+  /* Either COGL_PIXEL_FORMAT_RGB_888 or COGL_PIXEL_FORMAT_RGBA_8888.
+     The premult bit is ignored so both kinds share the same pages */
+  CoglPixelFormat    format;
+
+  CoglAtlas         *atlas;
+  CoglHandle         texture;
+
+  /* Set while the textures of the page are being moved to the other
+     pages by _cogl_atlas_texture_defragment(). No new textures are
+     added to the page meanwhile */
+  gboolean           evacuating;
+  /* Set if the other pages didn't have room for the textures of the
+     page, cleared again when a texture leaves the atlas */
+  gboolean           defrag_failed;
+};
 
 struct _CoglAtlasTexture
 {
@@ -49,6 +72,9 @@ struct _CoglAtlasTexture
      be set to TRUE and sub_texture will actually be a real texture */
   gboolean           in_atlas;
 
+  /* The page containing the texture while it is in the atlas */
+  CoglAtlasTexturePage *page;
+
   /* A CoglSubTexture representing the region for easy rendering */
   CoglHandle         sub_texture;
 };
@@ -61,4 +87,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
                                      CoglTextureFlags flags,
                                      CoglPixelFormat  internal_format);
 
+void
+_cogl_atlas_texture_free_pages (void);
+
 #endif /* __COGL_ATLAS_TEXTURE_H */
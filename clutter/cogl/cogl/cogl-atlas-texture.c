@@ -71,6 +71,14 @@
 #define GL_FRAMEBUFFER_COMPLETE 0x8CD5
 #endif
 
+/* The size of each page of the atlas. This is clamped to the maximum
+   texture size */
+#define COGL_ATLAS_TEXTURE_PAGE_SIZE 512
+
+/* Pages with at least this percentage of free space are emptied by
+   the defragmenter if the other pages have room for their textures */
+#define COGL_ATLAS_TEXTURE_DEFRAG_WASTE 50
+
 static void _cogl_atlas_texture_free (CoglAtlasTexture *sub_tex);
 
 COGL_TEXTURE_INTERNAL_DEFINE (AtlasTexture, atlas_texture);
@@ -246,27 +254,119 @@ _cogl_atlas_texture_set_wrap_mode_parameters (CoglTexture *tex,
                                           wrap_mode_p);
 }
 
+static unsigned int
+_cogl_atlas_texture_page_get_waste (CoglAtlasTexturePage *page)
+{
+  return (_cogl_atlas_get_remaining_space (page->atlas) * 100 /
+          (_cogl_atlas_get_width (page->atlas) *
+           _cogl_atlas_get_height (page->atlas)));
+}
+
+static void
+_cogl_atlas_texture_page_note (CoglAtlasTexturePage *page)
+{
+#ifdef COGL_ENABLE_DEBUG
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_ATLAS))
+    {
+      unsigned int remaining = _cogl_atlas_get_remaining_space (page->atlas);
+      unsigned int fragmentation = 0;
+
+      /* The fragmentation is the part of the free space that isn't in
+         the biggest free rectangle */
+      if (remaining > 0)
+        fragmentation =
+          100 - (_cogl_atlas_get_largest_free_area (page->atlas) * 100 /
+                 remaining);
+
+      COGL_NOTE (ATLAS, "Atlas page %p is %ix%i, has %i textures, "
+                 "is %i%% waste and %i%% fragmented",
+                 page,
+                 _cogl_atlas_get_width (page->atlas),
+                 _cogl_atlas_get_height (page->atlas),
+                 _cogl_atlas_get_n_rectangles (page->atlas),
+                 _cogl_atlas_texture_page_get_waste (page),
+                 fragmentation);
+    }
+#endif
+}
+
+static void
+_cogl_atlas_texture_page_free (CoglAtlasTexturePage *page)
+{
+  _cogl_atlas_free (page->atlas);
+  cogl_handle_unref (page->texture);
+  g_slice_free (CoglAtlasTexturePage, page);
+}
+
+static void
+_cogl_atlas_texture_page_remove_rectangle (CoglAtlasTexturePage     *page,
+                                           const CoglAtlasRectangle *rectangle)
+{
+  GSList *l;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  _cogl_atlas_remove_rectangle (page->atlas, rectangle);
+
+  COGL_NOTE (ATLAS, "Removed rectangle sized %ix%i",
+             rectangle->width, rectangle->height);
+  _cogl_atlas_texture_page_note (page);
+
+  if (_cogl_atlas_get_n_rectangles (page->atlas) > 0)
+    return;
+
+  /* Reclaim the empty page unless it is the last one of its format,
+     which is kept so that adding and removing a single texture
+     doesn't reallocate a page each time. The sub textures of any
+     migrated texture keep their own reference on the GL texture */
+  for (l = ctx->atlas_pages; l; l = l->next)
+    {
+      CoglAtlasTexturePage *other = l->data;
+
+      if (other != page && other->format == page->format)
+        {
+          COGL_NOTE (ATLAS, "Freeing empty atlas page %p", page);
+
+          ctx->atlas_pages = g_slist_remove (ctx->atlas_pages, page);
+          _cogl_atlas_texture_page_free (page);
+
+          return;
+        }
+    }
+}
+
+void
+_cogl_atlas_texture_free_pages (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  g_slist_foreach (ctx->atlas_pages, (GFunc) _cogl_atlas_texture_page_free,
+                   NULL);
+  g_slist_free (ctx->atlas_pages);
+  ctx->atlas_pages = NULL;
+}
+
 static void
 _cogl_atlas_texture_remove_from_atlas (CoglAtlasTexture *atlas_tex)
 {
   if (atlas_tex->in_atlas)
     {
+      GSList *l;
+
       _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-      _cogl_atlas_remove_rectangle (ctx->atlas, &atlas_tex->rectangle);
+      _cogl_atlas_texture_page_remove_rectangle (atlas_tex->page,
+                                                 &atlas_tex->rectangle);
 
-      COGL_NOTE (ATLAS, "Removed rectangle sized %ix%i",
-                 atlas_tex->rectangle.width,
-                 atlas_tex->rectangle.height);
-      COGL_NOTE (ATLAS, "Atlas is %ix%i, has %i textures and is %i%% waste",
-                 _cogl_atlas_get_width (ctx->atlas),
-                 _cogl_atlas_get_height (ctx->atlas),
-                 _cogl_atlas_get_n_rectangles (ctx->atlas),
-                 _cogl_atlas_get_remaining_space (ctx->atlas) * 100 /
-                 (_cogl_atlas_get_width (ctx->atlas) *
-                  _cogl_atlas_get_height (ctx->atlas)));
+      /* The new space might let the defragmenter empty pages that it
+         couldn't before. This isn't done for the textures moved by
+         the defragmenter itself so that it can't keep moving textures
+         back and forth */
+      for (l = ctx->atlas_pages; l; l = l->next)
+        ((CoglAtlasTexturePage *) l->data)->defrag_failed = FALSE;
 
       atlas_tex->in_atlas = FALSE;
+      atlas_tex->page = NULL;
     }
 }
 
@@ -362,8 +462,6 @@ _cogl_atlas_texture_migrate_out_of_atlas (CoglAtlasTexture *atlas_tex)
     {
       CoglAtlasTextureBlitData blit_data;
 
-      _COGL_GET_CONTEXT (ctx, NO_RETVAL);
-
       COGL_NOTE (ATLAS, "Migrating texture out of the atlas");
 
       /* We don't know if any materials may currently be referenced in
@@ -394,7 +492,7 @@ _cogl_atlas_texture_migrate_out_of_atlas (CoglAtlasTexture *atlas_tex)
          aren't available this will end up having to copy the entire
          atlas texture */
       _cogl_atlas_texture_blit_begin (&blit_data, atlas_tex->sub_texture,
-                                      ctx->atlas_texture);
+                                      atlas_tex->page->texture);
       _cogl_atlas_texture_blit (&blit_data,
                                 atlas_tex->rectangle.x + 1,
                                 atlas_tex->rectangle.y + 1,
@@ -444,10 +542,10 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
                                             unsigned int    dst_height,
                                             CoglBitmap     *bmp)
 {
-  _COGL_GET_CONTEXT (ctx, FALSE);
+  CoglHandle page_texture = atlas_tex->page->texture;
 
   /* Copy the central data */
-  if (!_cogl_texture_set_region_from_bitmap (ctx->atlas_texture,
+  if (!_cogl_texture_set_region_from_bitmap (page_texture,
                                              src_x, src_y,
                                              dst_x + atlas_tex->rectangle.x + 1,
                                              dst_y + atlas_tex->rectangle.y + 1,
@@ -458,7 +556,7 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
 
   /* Update the left edge pixels */
   if (dst_x == 0 &&
-      !_cogl_texture_set_region_from_bitmap (ctx->atlas_texture,
+      !_cogl_texture_set_region_from_bitmap (page_texture,
                                              src_x, src_y,
                                              atlas_tex->rectangle.x,
                                              dst_y + atlas_tex->rectangle.y + 1,
@@ -467,7 +565,7 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
     return FALSE;
   /* Update the right edge pixels */
   if (dst_x + dst_width == atlas_tex->rectangle.width - 2 &&
-      !_cogl_texture_set_region_from_bitmap (ctx->atlas_texture,
+      !_cogl_texture_set_region_from_bitmap (page_texture,
                                              src_x + dst_width - 1, src_y,
                                              atlas_tex->rectangle.x +
                                              atlas_tex->rectangle.width - 1,
@@ -477,7 +575,7 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
     return FALSE;
   /* Update the top edge pixels */
   if (dst_y == 0 &&
-      !_cogl_texture_set_region_from_bitmap (ctx->atlas_texture,
+      !_cogl_texture_set_region_from_bitmap (page_texture,
                                              src_x, src_y,
                                              dst_x + atlas_tex->rectangle.x + 1,
                                              atlas_tex->rectangle.y,
@@ -486,7 +584,7 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
     return FALSE;
   /* Update the bottom edge pixels */
   if (dst_y + dst_height == atlas_tex->rectangle.height - 2 &&
-      !_cogl_texture_set_region_from_bitmap (ctx->atlas_texture,
+      !_cogl_texture_set_region_from_bitmap (page_texture,
                                              src_x, src_y + dst_height - 1,
                                              dst_x + atlas_tex->rectangle.x + 1,
                                              atlas_tex->rectangle.y +
@@ -609,295 +707,297 @@ _cogl_atlas_texture_create_sub_texture (CoglHandle full_texture,
                                 rectangle->height - 2);
 }
 
-typedef struct _CoglAtlasTextureRepositionData
+static unsigned int
+_cogl_atlas_texture_get_page_size (void)
 {
-  /* The current texture which already has a position */
-  CoglAtlasTexture *texture;
-  /* The new position of the texture */
-  CoglAtlasRectangle new_position;
-} CoglAtlasTextureRepositionData;
+  GLint max_texture_size = COGL_ATLAS_TEXTURE_PAGE_SIZE;
 
-static void
-_cogl_atlas_texture_migrate (unsigned int                    n_textures,
-                             CoglAtlasTextureRepositionData *textures,
-                             CoglHandle                      old_texture,
-                             CoglHandle                      new_texture,
-                             CoglAtlasTexture               *skip_texture)
+  GE( glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max_texture_size) );
+
+  return MIN (max_texture_size, COGL_ATLAS_TEXTURE_PAGE_SIZE);
+}
+
+static CoglAtlasTexturePage *
+_cogl_atlas_texture_page_new (CoglPixelFormat format)
 {
-  unsigned int i;
-  CoglAtlasTextureBlitData blit_data;
+  CoglAtlasTexturePage *page;
+  unsigned int page_size = _cogl_atlas_texture_get_page_size ();
+  CoglHandle texture;
+
+  if ((texture = _cogl_texture_2d_new_with_size (page_size, page_size,
+                                                 COGL_TEXTURE_NONE,
+                                                 format)) ==
+      COGL_INVALID_HANDLE)
+    {
+      COGL_NOTE (ATLAS, "Could not create a CoglTexture2D");
+      return NULL;
+    }
 
-  /* We don't know if any materials may currently be referenced in the
-   * journal that depend on the current underlying GL texture storage
-   * so we flush the journal before migrating.
-   *
-   * We are assuming that texture atlas migration never happens during
-   * a flush so we don't have to consider recursion here.
-   */
-  _cogl_journal_flush ();
+  page = g_slice_new (CoglAtlasTexturePage);
+  page->format = format;
+  page->atlas = _cogl_atlas_new (page_size, page_size, NULL);
+  page->texture = texture;
+  page->evacuating = FALSE;
+  page->defrag_failed = FALSE;
+
+  COGL_NOTE (ATLAS, "New atlas page %p with size %ix%i",
+             page, page_size, page_size);
+
+  return page;
+}
 
-  _cogl_atlas_texture_blit_begin (&blit_data, new_texture, old_texture);
+static gboolean
+_cogl_atlas_texture_reserve_space (CoglAtlasTexture    *new_sub_tex,
+                                   CoglPixelFormat      page_format,
+                                   unsigned int         width,
+                                   unsigned int         height)
+{
+  CoglAtlasTexturePage *page;
+  unsigned int page_size;
+  GSList *l;
 
-  for (i = 0; i < n_textures; i++)
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  /* Use the first page of the right format with enough room */
+  for (l = ctx->atlas_pages; l; l = l->next)
     {
-      /* Notify cogl-material.c that the texture's underlying GL texture
-       * storage is changing so it knows it may need to bind a new texture
-       * if the CoglTexture is reused with the same texture unit. */
-      _cogl_material_texture_storage_change_notify (textures[i].texture);
+      page = l->data;
 
-      /* Skip the texture that is being added because it doesn't contain
-         any data yet */
-      if (textures[i].texture != skip_texture)
+      if (page->format == page_format &&
+          !page->evacuating &&
+          _cogl_atlas_add_rectangle (page->atlas, width, height,
+                                     new_sub_tex,
+                                     &new_sub_tex->rectangle))
         {
-          _cogl_atlas_texture_blit (&blit_data,
-                                    textures[i].texture->rectangle.x,
-                                    textures[i].texture->rectangle.y,
-                                    textures[i].new_position.x,
-                                    textures[i].new_position.y,
-                                    textures[i].new_position.width,
-                                    textures[i].new_position.height);
-          /* Update the sub texture */
-          cogl_handle_unref (textures[i].texture->sub_texture);
-          textures[i].texture->sub_texture =
-            _cogl_atlas_texture_create_sub_texture (new_texture,
-                                                    &textures[i].new_position);
+          new_sub_tex->page = page;
+          _cogl_atlas_texture_page_note (page);
+
+          return TRUE;
         }
+    }
 
-      /* Update the texture position */
-      textures[i].texture->rectangle = textures[i].new_position;
+  /* Textures that wouldn't fit in an empty page are left out of the
+     atlas */
+  page_size = _cogl_atlas_texture_get_page_size ();
+  if (width > page_size || height > page_size)
+    {
+      COGL_NOTE (ATLAS, "Could not fit texture in the atlas");
+      return FALSE;
     }
 
-  _cogl_atlas_texture_blit_end (&blit_data);
-}
+  /* Otherwise add a new page. This doesn't touch the existing
+     pages so none of the textures need to be moved */
+  if ((page = _cogl_atlas_texture_page_new (page_format)) == NULL)
+    return FALSE;
 
-typedef struct _CoglAtlasTextureGetRectanglesData
-{
-  CoglAtlasTextureRepositionData *textures;
-  /* Number of textures found so far */
-  unsigned int n_textures;
-} CoglAtlasTextureGetRectanglesData;
+  if (!_cogl_atlas_add_rectangle (page->atlas, width, height,
+                                  new_sub_tex,
+                                  &new_sub_tex->rectangle))
+    {
+      _cogl_atlas_texture_page_free (page);
+      return FALSE;
+    }
 
-static void
-_cogl_atlas_texture_get_rectangles_cb (const CoglAtlasRectangle *rectangle,
-                                       gpointer                  rectangle_data,
-                                       gpointer                  user_data)
-{
-  CoglAtlasTextureGetRectanglesData *data = user_data;
+  ctx->atlas_pages = g_slist_append (ctx->atlas_pages, page);
+  new_sub_tex->page = page;
+  _cogl_atlas_texture_page_note (page);
 
-  data->textures[data->n_textures++].texture = rectangle_data;
+  return TRUE;
 }
 
-static void
-_cogl_atlas_texture_get_next_size (unsigned int *atlas_width,
-                                   unsigned int *atlas_height)
+/* Moves @atlas_tex from its page to the first other page with room.
+   The journal must have been flushed before calling this */
+static gboolean
+_cogl_atlas_texture_move_to_other_page (CoglAtlasTexture *atlas_tex)
 {
-  /* Double the size of the texture by increasing whichever dimension
-     is smaller */
-  if (*atlas_width < *atlas_height)
-    *atlas_width <<= 1;
-  else
-    *atlas_height <<= 1;
+  CoglAtlasTexturePage *src_page = atlas_tex->page, *dst_page = NULL;
+  CoglAtlasTextureBlitData blit_data;
+  CoglAtlasRectangle new_position;
+  GSList *l;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  for (l = ctx->atlas_pages; l; l = l->next)
+    {
+      CoglAtlasTexturePage *page = l->data;
+
+      if (page != src_page &&
+          page->format == src_page->format &&
+          !page->evacuating &&
+          _cogl_atlas_add_rectangle (page->atlas,
+                                     atlas_tex->rectangle.width,
+                                     atlas_tex->rectangle.height,
+                                     atlas_tex,
+                                     &new_position))
+        {
+          dst_page = page;
+          break;
+        }
+    }
+
+  if (dst_page == NULL)
+    return FALSE;
+
+  /* Notify cogl-material.c that the texture's underlying GL texture
+   * storage is changing so it knows it may need to bind a new texture
+   * if the CoglTexture is reused with the same texture unit. */
+  _cogl_material_texture_storage_change_notify (atlas_tex);
+
+  /* Copy the texture including its border */
+  _cogl_atlas_texture_blit_begin (&blit_data,
+                                  dst_page->texture,
+                                  src_page->texture);
+  _cogl_atlas_texture_blit (&blit_data,
+                            atlas_tex->rectangle.x,
+                            atlas_tex->rectangle.y,
+                            new_position.x,
+                            new_position.y,
+                            new_position.width,
+                            new_position.height);
+  _cogl_atlas_texture_blit_end (&blit_data);
+
+  cogl_handle_unref (atlas_tex->sub_texture);
+  atlas_tex->sub_texture =
+    _cogl_atlas_texture_create_sub_texture (dst_page->texture,
+                                            &new_position);
+
+  /* This may free the source page if it is now empty */
+  _cogl_atlas_texture_page_remove_rectangle (src_page,
+                                             &atlas_tex->rectangle);
+
+  atlas_tex->rectangle = new_position;
+  atlas_tex->page = dst_page;
+
+  return TRUE;
 }
 
-static CoglAtlas *
-_cogl_atlas_texture_create_atlas (unsigned int                    atlas_width,
-                                  unsigned int                    atlas_height,
-                                  unsigned int                    n_textures,
-                                  CoglAtlasTextureRepositionData *textures)
+/* Picks the page to empty next. This is the page with the most waste
+   whose textures could fit in the free space of the other pages */
+static CoglAtlasTexturePage *
+_cogl_atlas_texture_find_page_to_evacuate (void)
 {
-  GLint max_texture_size = 1024;
-
-  GE( glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max_texture_size) );
+  CoglAtlasTexturePage *best_page = NULL;
+  unsigned int best_waste = 0;
+  GSList *l, *o;
 
-  /* Sanity check that we're not going to get stuck in an infinite
-     loop if the maximum texture size has the high bit set */
-  if ((max_texture_size & (1 << (sizeof (GLint) * 8 - 2))))
-    max_texture_size >>= 1;
+  _COGL_GET_CONTEXT (ctx, NULL);
 
-  /* Keep trying increasingly larger atlases until we can fit all of
-     the textures */
-  while (atlas_width < max_texture_size && atlas_height < max_texture_size)
+  for (l = ctx->atlas_pages; l; l = l->next)
     {
-      CoglAtlas *new_atlas = _cogl_atlas_new (atlas_width, atlas_height, NULL);
-      unsigned int i;
-
-      /* Add all of the textures and keep track of the new position */
-      for (i = 0; i < n_textures; i++)
-        if (!_cogl_atlas_add_rectangle (new_atlas,
-                                        textures[i].texture->rectangle.width,
-                                        textures[i].texture->rectangle.height,
-                                        textures[i].texture,
-                                        &textures[i].new_position))
-          break;
+      CoglAtlasTexturePage *page = l->data;
+      unsigned int waste, used, free_elsewhere = 0;
+
+      if (page->evacuating)
+        return page;
+
+      if (page->defrag_failed ||
+          _cogl_atlas_get_n_rectangles (page->atlas) == 0)
+        continue;
+
+      waste = _cogl_atlas_texture_page_get_waste (page);
+
+      if (waste < COGL_ATLAS_TEXTURE_DEFRAG_WASTE || waste <= best_waste)
+        continue;
 
-      /* If the atlas can contain all of the textures then we have a
-         winner */
-      if (i >= n_textures)
-        return new_atlas;
+      used = (_cogl_atlas_get_width (page->atlas) *
+              _cogl_atlas_get_height (page->atlas) -
+              _cogl_atlas_get_remaining_space (page->atlas));
 
-      _cogl_atlas_free (new_atlas);
-      _cogl_atlas_texture_get_next_size (&atlas_width, &atlas_height);
+      for (o = ctx->atlas_pages; o; o = o->next)
+        {
+          CoglAtlasTexturePage *other = o->data;
+
+          if (other != page && other->format == page->format)
+            free_elsewhere += _cogl_atlas_get_remaining_space (other->atlas);
+        }
+
+      if (used <= free_elsewhere)
+        {
+          best_page = page;
+          best_waste = waste;
+        }
     }
 
-  /* If we get here then there's no atlas that can accommodate all of
-     the rectangles */
+  return best_page;
+}
 
-  return NULL;
+static void
+_cogl_atlas_texture_get_textures_cb (const CoglAtlasRectangle *rectangle,
+                                     gpointer                  rectangle_data,
+                                     gpointer                  user_data)
+{
+  g_ptr_array_add (user_data, rectangle_data);
 }
 
 static int
 _cogl_atlas_texture_compare_size_cb (const void *a,
                                      const void *b)
 {
-  const CoglAtlasTextureRepositionData *ta = a;
-  const CoglAtlasTextureRepositionData *tb = b;
+  const CoglAtlasTexture *ta = *(CoglAtlasTexture * const *) a;
+  const CoglAtlasTexture *tb = *(CoglAtlasTexture * const *) b;
   unsigned int a_size, b_size;
 
-  a_size = ta->texture->rectangle.width * ta->texture->rectangle.height;
-  b_size = tb->texture->rectangle.width * tb->texture->rectangle.height;
+  a_size = ta->rectangle.width * ta->rectangle.height;
+  b_size = tb->rectangle.width * tb->rectangle.height;
 
   return a_size < b_size ? 1 : a_size > b_size ? -1 : 0;
 }
 
-static gboolean
-_cogl_atlas_texture_reserve_space (CoglAtlasTexture    *new_sub_tex,
-                                   unsigned int         width,
-                                   unsigned int         height)
+gboolean
+_cogl_atlas_texture_defragment (int max_textures)
 {
-  CoglAtlasTextureGetRectanglesData data;
-  CoglAtlas *new_atlas;
-  CoglHandle new_tex;
-  unsigned int atlas_width, atlas_height;
+  CoglAtlasTexturePage *page;
+  GPtrArray *textures;
+  int i, n_moved = 0;
   gboolean ret;
 
-  _COGL_GET_CONTEXT (ctx, FALSE);
-
-  /* Check if we can fit the rectangle into the existing atlas */
-  if (ctx->atlas && _cogl_atlas_add_rectangle (ctx->atlas, width, height,
-                                              new_sub_tex,
-                                              &new_sub_tex->rectangle))
-    {
-      COGL_NOTE (ATLAS, "Atlas is %ix%i, has %i textures and is %i%% waste",
-                 _cogl_atlas_get_width (ctx->atlas),
-                 _cogl_atlas_get_height (ctx->atlas),
-                 _cogl_atlas_get_n_rectangles (ctx->atlas),
-                 _cogl_atlas_get_remaining_space (ctx->atlas) * 100 /
-                 (_cogl_atlas_get_width (ctx->atlas) *
-                  _cogl_atlas_get_height (ctx->atlas)));
-
-      return TRUE;
-    }
+  if ((page = _cogl_atlas_texture_find_page_to_evacuate ()) == NULL)
+    return FALSE;
 
-  /* We need to reorganise the atlas so we'll get an array of all the
-     textures currently in the atlas. */
-  data.n_textures = 0;
-  if (ctx->atlas == NULL)
-    data.textures = g_malloc (sizeof (CoglAtlasTextureRepositionData));
-  else
+  if (!page->evacuating)
     {
-      data.textures =
-        g_malloc (sizeof (CoglAtlasTextureRepositionData) *
-                  (_cogl_atlas_get_n_rectangles (ctx->atlas) + 1));
-      _cogl_atlas_foreach (ctx->atlas, _cogl_atlas_texture_get_rectangles_cb,
-                           &data);
+      COGL_NOTE (ATLAS, "Emptying atlas page %p", page);
+      _cogl_atlas_texture_page_note (page);
+      page->evacuating = TRUE;
     }
 
-  /* Add the new rectangle as a dummy texture so that it can be
-     positioned with the rest */
-  data.textures[data.n_textures++].texture = new_sub_tex;
-
-  /* The atlasing algorithm works a lot better if the rectangles are
-     added in decreasing order of size so we'll first sort the
-     array */
-  qsort (data.textures, data.n_textures,
-         sizeof (CoglAtlasTextureRepositionData),
+  /* The textures are moved biggest first because they are the
+     hardest to fit */
+  textures = g_ptr_array_new ();
+  _cogl_atlas_foreach (page->atlas, _cogl_atlas_texture_get_textures_cb,
+                       textures);
+  qsort (textures->pdata, textures->len, sizeof (gpointer),
          _cogl_atlas_texture_compare_size_cb);
 
-  /* Try to create a new atlas that can contain all of the textures */
-  if (ctx->atlas)
-    {
-      atlas_width = _cogl_atlas_get_width (ctx->atlas);
-      atlas_height = _cogl_atlas_get_height (ctx->atlas);
-
-      /* If there is enough space in the existing for the new
-         rectangle in the existing atlas we'll start with the same
-         size, otherwise we'll immediately double it */
-      if (_cogl_atlas_get_remaining_space (ctx->atlas) < width * height)
-        _cogl_atlas_texture_get_next_size (&atlas_width, &atlas_height);
-    }
-  else
-    {
-      /* Start with an initial size of 256x256 */
-      atlas_width = 256;
-      atlas_height = 256;
-    }
-
-  new_atlas = _cogl_atlas_texture_create_atlas (atlas_width, atlas_height,
-                                                data.n_textures, data.textures);
+  /* We don't know if any materials may currently be referenced in the
+   * journal that depend on the current underlying GL texture storage
+   * so we flush the journal before moving the textures.
+   *
+   * We are assuming that this never happens during a flush so we
+   * don't have to consider recursion here.
+   */
+  _cogl_journal_flush ();
 
-  /* If we can't create an atlas with the texture then give up */
-  if (new_atlas == NULL)
+  for (i = 0; i < textures->len && n_moved < max_textures; i++)
     {
-      COGL_NOTE (ATLAS, "Could not fit texture in the atlas");
-      ret = FALSE;
-    }
-  /* We need to migrate the existing textures into a new texture */
-  else if ((new_tex =
-            _cogl_texture_2d_new_with_size (_cogl_atlas_get_width (new_atlas),
-                                            _cogl_atlas_get_height (new_atlas),
-                                            COGL_TEXTURE_NONE,
-                                            COGL_PIXEL_FORMAT_RGBA_8888)) ==
-           COGL_INVALID_HANDLE)
-    {
-      COGL_NOTE (ATLAS, "Could not create a CoglTexture2D");
-      _cogl_atlas_free (new_atlas);
-      ret = FALSE;
-    }
-  else
-    {
-      COGL_NOTE (ATLAS,
-                 "Atlas %s with size %ix%i",
-                 ctx->atlas == NULL ||
-                 _cogl_atlas_get_width (ctx->atlas) !=
-                 _cogl_atlas_get_width (new_atlas) ||
-                 _cogl_atlas_get_height (ctx->atlas) !=
-                 _cogl_atlas_get_height (new_atlas) ?
-                 "resized" : "reorganized",
-                 _cogl_atlas_get_width (new_atlas),
-                 _cogl_atlas_get_height (new_atlas));
-
-      if (ctx->atlas)
+      if (!_cogl_atlas_texture_move_to_other_page (textures->pdata[i]))
         {
-          /* Move all the textures to the right position in the new
-             texture. This will also update the texture's rectangle */
-          _cogl_atlas_texture_migrate (data.n_textures,
-                                       data.textures,
-                                       ctx->atlas_texture,
-                                       new_tex,
-                                       new_sub_tex);
-          _cogl_atlas_free (ctx->atlas);
-          cogl_handle_unref (ctx->atlas_texture);
+          /* The other pages are too fragmented for this texture so
+             give up on the page until some space is freed */
+          COGL_NOTE (ATLAS, "Could not empty atlas page %p", page);
+          page->evacuating = FALSE;
+          page->defrag_failed = TRUE;
+          break;
         }
-      else
-        /* We know there's only one texture so we can just directly
-           update the rectangle from its new position */
-        data.textures[0].texture->rectangle = data.textures[0].new_position;
-
-      ctx->atlas = new_atlas;
-      ctx->atlas_texture = new_tex;
-
-      COGL_NOTE (ATLAS, "Atlas is %ix%i, has %i textures and is %i%% waste",
-                 _cogl_atlas_get_width (ctx->atlas),
-                 _cogl_atlas_get_height (ctx->atlas),
-                 _cogl_atlas_get_n_rectangles (ctx->atlas),
-                 _cogl_atlas_get_remaining_space (ctx->atlas) * 100 /
-                 (_cogl_atlas_get_width (ctx->atlas) *
-                  _cogl_atlas_get_height (ctx->atlas)));
-
-      ret = TRUE;
+
+      n_moved++;
     }
 
-  g_free (data.textures);
+  /* The page may have been freed by now. If anything was moved there
+     may be more to do, which the next call will find out */
+  ret = n_moved > 0;
+
+  g_ptr_array_free (textures, TRUE);
 
   return ret;
 }
@@ -916,8 +1016,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
   int               bmp_width;
   int               bmp_height;
   CoglPixelFormat   bmp_format;
-
-  _COGL_GET_CONTEXT (ctx, COGL_INVALID_HANDLE);
+  CoglPixelFormat   page_format;
 
   g_return_val_if_fail (cogl_is_bitmap (bmp), COGL_INVALID_HANDLE);
 
@@ -963,6 +1062,13 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
       return COGL_INVALID_HANDLE;
     }
 
+  /* Opaque textures are kept in separate pages so that they don't
+     waste memory for an alpha channel */
+  if (internal_format == COGL_PIXEL_FORMAT_RGB_888)
+    page_format = COGL_PIXEL_FORMAT_RGB_888;
+  else
+    page_format = COGL_PIXEL_FORMAT_RGBA_8888;
+
   /* We need to allocate the texture now because we need the pointer
      to set as the data for the rectangle in the atlas */
   atlas_tex = g_new (CoglAtlasTexture, 1);
@@ -973,6 +1079,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
 
   /* Try to make some space in the atlas for the texture */
   if (!_cogl_atlas_texture_reserve_space (atlas_tex,
+                                          page_format,
                                           atlas_tex->rectangle.width,
                                           atlas_tex->rectangle.height))
     {
@@ -989,7 +1096,8 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
 
   if (dst_bmp == NULL)
     {
-      _cogl_atlas_remove_rectangle (ctx->atlas, &atlas_tex->rectangle);
+      _cogl_atlas_texture_page_remove_rectangle (atlas_tex->page,
+                                                 &atlas_tex->rectangle);
       g_free (atlas_tex);
       return COGL_INVALID_HANDLE;
     }
@@ -998,7 +1106,7 @@ _cogl_atlas_texture_new_from_bitmap (CoglBitmap      *bmp,
   atlas_tex->format = internal_format;
   atlas_tex->in_atlas = TRUE;
   atlas_tex->sub_texture =
-    _cogl_atlas_texture_create_sub_texture (ctx->atlas_texture,
+    _cogl_atlas_texture_create_sub_texture (atlas_tex->page->texture,
                                             &atlas_tex->rectangle);
 
   /* Make another bitmap so that we can override the format */
@@ -496,6 +496,27 @@ _cogl_atlas_internal_foreach (CoglAtlas *atlas,
   g_assert (node_stack == NULL);
 }
 
+static void
+_cogl_atlas_largest_free_area_cb (CoglAtlasNode *node, gpointer data)
+{
+  unsigned int *largest_area = data;
+
+  if (node->type == COGL_ATLAS_EMPTY_LEAF &&
+      node->rectangle.width * node->rectangle.height > *largest_area)
+    *largest_area = node->rectangle.width * node->rectangle.height;
+}
+
+unsigned int
+_cogl_atlas_get_largest_free_area (CoglAtlas *atlas)
+{
+  unsigned int largest_area = 0;
+
+  _cogl_atlas_internal_foreach (atlas, _cogl_atlas_largest_free_area_cb,
+                                &largest_area);
+
+  return largest_area;
+}
+
 typedef struct _CoglAtlasForeachClosure
 {
   CoglAtlasCallback callback;
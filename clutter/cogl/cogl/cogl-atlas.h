@@ -67,6 +67,11 @@ _cogl_atlas_get_remaining_space (CoglAtlas *atlas);
 unsigned int
 _cogl_atlas_get_n_rectangles (CoglAtlas *atlas);
 
+/* Returns the area of the biggest empty rectangle. Comparing it with
+   the remaining space gives an idea of how fragmented the atlas is */
+unsigned int
+_cogl_atlas_get_largest_free_area (CoglAtlas *atlas);
+
 void
 _cogl_atlas_foreach (CoglAtlas *atlas,
                      CoglAtlasCallback callback,
@@ -30,121 +30,213 @@
 #include "cogl-bitmap-private.h"
 
 #include <string.h>
+#include <stdlib.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
-/* TO rgba */
+/* Conversions between the 8-bit per component formats are done a row
+   at a time by moving each component of the source pixels to its
+   position in the destination. The position of each component in a
+   format is described by a CoglComponentOffsets */
 
-inline static void
-_cogl_g_to_rgba (const guint8 *src, guint8 *dst)
+typedef struct _CoglComponentOffsets
 {
-  dst[0] = src[0];
-  dst[1] = src[0];
-  dst[2] = src[0];
-  dst[3] = 255;
-}
-
-inline static void
-_cogl_rgb_to_rgba (const guint8 *src, guint8 *dst)
+  int bpp;
+  /* Offsets of the red, green, blue and alpha components, or -1 for
+     the alpha of formats without one */
+  int offsets[4];
+} CoglComponentOffsets;
+
+static void
+_cogl_get_component_offsets (CoglPixelFormat       format,
+                             CoglComponentOffsets *components)
 {
-  dst[0] = src[0];
-  dst[1] = src[1];
-  dst[2] = src[2];
-  dst[3] = 255;
-}
+  int base;
 
-inline static void
-_cogl_bgr_to_rgba (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[2];
-  dst[1] = src[1];
-  dst[2] = src[0];
-  dst[3] = 255;
-}
+  if ((format & COGL_UNPREMULT_MASK) == COGL_PIXEL_FORMAT_G_8)
+    {
+      /* Luminance is expanded to all three color components */
+      components->bpp = 1;
+      components->offsets[0] = 0;
+      components->offsets[1] = 0;
+      components->offsets[2] = 0;
+      components->offsets[3] = -1;
+      return;
+    }
 
-inline static void
-_cogl_bgra_to_rgba (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[2];
-  dst[1] = src[1];
-  dst[2] = src[0];
-  dst[3] = src[3];
-}
+  components->bpp = _cogl_get_format_bpp (format);
 
-inline static void
-_cogl_argb_to_rgba (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[1];
-  dst[1] = src[2];
-  dst[2] = src[3];
-  dst[3] = src[0];
-}
+  base = (format & COGL_AFIRST_BIT) ? 1 : 0;
 
-inline static void
-_cogl_abgr_to_rgba (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[3];
-  dst[1] = src[2];
-  dst[2] = src[1];
-  dst[3] = src[0];
-}
+  if ((format & COGL_BGR_BIT))
+    {
+      components->offsets[0] = base + 2;
+      components->offsets[2] = base;
+    }
+  else
+    {
+      components->offsets[0] = base;
+      components->offsets[2] = base + 2;
+    }
+  components->offsets[1] = base + 1;
 
-inline static void
-_cogl_rgba_to_rgba (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[0];
-  dst[1] = src[1];
-  dst[2] = src[2];
-  dst[3] = src[3];
+  if ((format & COGL_A_BIT))
+    components->offsets[3] = (format & COGL_AFIRST_BIT) ? 0 : 3;
+  else
+    components->offsets[3] = -1;
 }
 
-/* FROM rgba */
+/* Use SSSE3 to convert four pixels at once with a byte shuffle when
+   it is available */
+#if defined(__SSSE3__) && defined(__GNUC__) \
+  && (defined(__x86_64) || defined(__i386))
+#define COGL_USE_CONVERT_SSSE3
+#endif
 
-inline static void
-_cogl_rgba_to_g (const guint8 *src, guint8 *dst)
-{
-  dst[0] = (src[0] + src[1] + src[2]) / 3;
-}
+#ifdef COGL_USE_CONVERT_SSSE3
 
 inline static void
-_cogl_rgba_to_rgb (const guint8 *src, guint8 *dst)
+_cogl_convert_four_pixels_ssse3 (const guint8 *src,
+                                 guint8       *dst,
+                                 const guint8 *shuffle,
+                                 const guint8 *fill)
 {
-  dst[0] = src[0];
-  dst[1] = src[1];
-  dst[2] = src[2];
+  asm (/* Load sixteen bytes of source pixels into xmm0 */
+       "movdqu (%0), %%xmm0\n"
+       /* Move the components of the four pixels into place. Bytes
+          that are filled in below are cleared by the shuffle */
+       "movdqu (%2), %%xmm1\n"
+       "pshufb %%xmm1, %%xmm0\n"
+       /* Set the alpha of formats without one to 255 */
+       "movdqu (%3), %%xmm1\n"
+       "por %%xmm1, %%xmm0\n"
+       /* Write the four pixels to memory */
+       "movdqu %%xmm0, (%1)\n"
+       : /* no outputs */
+       : "r" (src), "r" (dst), "r" (shuffle), "r" (fill)
+       : "xmm0", "xmm1", "memory");
 }
 
-inline static void
-_cogl_rgba_to_bgr (const guint8 *src, guint8 *dst)
-{
-  dst[0] = src[2];
-  dst[1] = src[1];
-  dst[2] = src[0];
-}
+#endif /* COGL_USE_CONVERT_SSSE3 */
 
-inline static void
-_cogl_rgba_to_bgra (const guint8 *src, guint8 *dst)
+static void
+_cogl_convert_row_to_4 (const guint8               *src,
+                        guint8                     *dst,
+                        int                         width,
+                        const CoglComponentOffsets *src_components,
+                        const CoglComponentOffsets *dst_components)
 {
-  dst[0] = src[2];
-  dst[1] = src[1];
-  dst[2] = src[0];
-  dst[3] = src[3];
+  int map[4] = { 0, 0, 0, 0 };
+  int fill = -1;
+  int src_bpp = src_components->bpp;
+  int i;
+
+  /* map[i] is the offset in the source pixel of destination byte i */
+  for (i = 0; i < 4; i++)
+    {
+      if (src_components->offsets[i] == -1)
+        fill = dst_components->offsets[i];
+      else
+        map[dst_components->offsets[i]] = src_components->offsets[i];
+    }
+
+#ifdef COGL_USE_CONVERT_SSSE3
+  {
+    guint8 shuffle[16], fill_bytes[16];
+    /* The shuffle reads sixteen bytes of the source so there needs
+       to be enough pixels left in the row */
+    int min_width = (16 + src_bpp - 1) / src_bpp;
+    int j;
+
+    for (i = 0; i < 4; i++)
+      for (j = 0; j < 4; j++)
+        {
+          if (j == fill)
+            {
+              shuffle[i * 4 + j] = 0x80;
+              fill_bytes[i * 4 + j] = 0xff;
+            }
+          else
+            {
+              shuffle[i * 4 + j] = i * src_bpp + map[j];
+              fill_bytes[i * 4 + j] = 0x00;
+            }
+        }
+
+    while (width >= min_width)
+      {
+        _cogl_convert_four_pixels_ssse3 (src, dst, shuffle, fill_bytes);
+        src += 4 * src_bpp;
+        dst += 4 * 4;
+        width -= 4;
+      }
+  }
+#endif /* COGL_USE_CONVERT_SSSE3 */
+
+  if (fill == -1)
+    for (; width > 0; width--)
+      {
+        dst[0] = src[map[0]];
+        dst[1] = src[map[1]];
+        dst[2] = src[map[2]];
+        dst[3] = src[map[3]];
+        src += src_bpp;
+        dst += 4;
+      }
+  else
+    for (; width > 0; width--)
+      {
+        dst[0] = src[map[0]];
+        dst[1] = src[map[1]];
+        dst[2] = src[map[2]];
+        dst[3] = src[map[3]];
+        dst[fill] = 255;
+        src += src_bpp;
+        dst += 4;
+      }
 }
 
-inline static void
-_cogl_rgba_to_argb (const guint8 *src, guint8 *dst)
+static void
+_cogl_convert_row_to_3 (const guint8               *src,
+                        guint8                     *dst,
+                        int                         width,
+                        const CoglComponentOffsets *src_components,
+                        const CoglComponentOffsets *dst_components)
 {
-  dst[0] = src[3];
-  dst[1] = src[0];
-  dst[2] = src[1];
-  dst[3] = src[2];
+  int map[3];
+  int src_bpp = src_components->bpp;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    map[dst_components->offsets[i]] = src_components->offsets[i];
+
+  for (; width > 0; width--)
+    {
+      dst[0] = src[map[0]];
+      dst[1] = src[map[1]];
+      dst[2] = src[map[2]];
+      src += src_bpp;
+      dst += 3;
+    }
 }
 
-inline static void
-_cogl_rgba_to_abgr (const guint8 *src, guint8 *dst)
+static void
+_cogl_convert_row_to_g (const guint8               *src,
+                        guint8                     *dst,
+                        int                         width,
+                        const CoglComponentOffsets *src_components)
 {
-  dst[0] = src[3];
-  dst[1] = src[2];
-  dst[2] = src[1];
-  dst[3] = src[0];
+  int r = src_components->offsets[0];
+  int g = src_components->offsets[1];
+  int b = src_components->offsets[2];
+  int src_bpp = src_components->bpp;
+
+  for (; width > 0; width--)
+    {
+      *(dst++) = (src[r] + src[g] + src[b]) / 3;
+      src += src_bpp;
+    }
 }
 
 /* (Un)Premultiplication */
@@ -158,26 +250,56 @@ _cogl_unpremult_alpha_0 (guint8 *dst)
   dst[3] = 0;
 }
 
+/* Table of 2^24 / alpha rounded up, used to replace the division by
+   alpha in the unpremultiplication with a multiplication. For any
+   numerator up to 255 * 255 the error of the multiplication is less
+   than 1 / 256 which is always less than the distance between the
+   exact result and the next integer, so this gives exactly the same
+   results as the division */
+static const guint32 *
+_cogl_get_unpremult_table (void)
+{
+  static gsize initialized = 0;
+  static guint32 table[256];
+
+  if (g_once_init_enter (&initialized))
+    {
+      int alpha;
+
+      table[0] = 0;
+      for (alpha = 1; alpha < 256; alpha++)
+        table[alpha] = ((1 << 24) + alpha - 1) / alpha;
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return table;
+}
+
+#define DIVIDE(c,r) (((guint64) ((c) * 255) * (r)) >> 24)
+
 inline static void
-_cogl_unpremult_alpha_last (guint8 *dst)
+_cogl_unpremult_alpha_last (guint8 *dst, const guint32 *table)
 {
-  guint8 alpha = dst[3];
+  guint32 reciprocal = table[dst[3]];
 
-  dst[0] = (dst[0] * 255) / alpha;
-  dst[1] = (dst[1] * 255) / alpha;
-  dst[2] = (dst[2] * 255) / alpha;
+  dst[0] = DIVIDE (dst[0], reciprocal);
+  dst[1] = DIVIDE (dst[1], reciprocal);
+  dst[2] = DIVIDE (dst[2], reciprocal);
 }
 
 inline static void
-_cogl_unpremult_alpha_first (guint8 *dst)
+_cogl_unpremult_alpha_first (guint8 *dst, const guint32 *table)
 {
-  guint8 alpha = dst[0];
+  guint32 reciprocal = table[dst[0]];
 
-  dst[1] = (dst[1] * 255) / alpha;
-  dst[2] = (dst[2] * 255) / alpha;
-  dst[3] = (dst[3] * 255) / alpha;
+  dst[1] = DIVIDE (dst[1], reciprocal);
+  dst[2] = DIVIDE (dst[2], reciprocal);
+  dst[3] = DIVIDE (dst[3], reciprocal);
 }
 
+#undef DIVIDE
+
 /* No division form of floor((c*a + 128)/255) (I first encountered
  * this in the RENDER implementation in the X server.) Being exact
  * is important for a == 255 - we want to get exactly c.
@@ -298,8 +420,231 @@ _cogl_premult_alpha_last_four_pixels_sse2 (guint8 *p)
        : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5");
 }
 
+/* This is the same as the above except that the alpha is the first
+   component of each pixel */
+inline static void
+_cogl_premult_alpha_first_four_pixels_sse2 (guint8 *p)
+{
+  static const gint16 eight_halves[8] __attribute__ ((aligned (16))) =
+    { 128, 128, 128, 128, 128, 128, 128, 128 };
+  /* Mask of the gba components of the four pixels */
+  static const gint8 just_gba[16] __attribute__ ((aligned (16))) =
+    { 0x00, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff,
+      0x00, 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff };
+
+  asm ("movdqa (%1), %%xmm5\n"
+       "pxor %%xmm3, %%xmm3\n"
+       "movlps (%0), %%xmm0\n"
+       "movlps 8(%0), %%xmm1\n"
+       "punpcklbw %%xmm3, %%xmm0\n"
+       "punpcklbw %%xmm3, %%xmm1\n"
+       /* Copy the alpha value, which is now the first word of each
+          pixel, to all of the components */
+       "pshuflw $0, %%xmm0, %%xmm2\n"
+       "pshuflw $0, %%xmm1, %%xmm3\n"
+       "pshufhw $0, %%xmm2, %%xmm2\n"
+       "pshufhw $0, %%xmm3, %%xmm3\n"
+       "pmullw %%xmm2, %%xmm0\n"
+       "pmullw %%xmm3, %%xmm1\n"
+       "paddw %%xmm5, %%xmm0\n"
+       "paddw %%xmm5, %%xmm1\n"
+       "movdqa %%xmm0, %%xmm4\n"
+       "movdqa %%xmm1, %%xmm5\n"
+       "psrlw $8, %%xmm0\n"
+       "psrlw $8, %%xmm1\n"
+       "paddw %%xmm4, %%xmm0\n"
+       "paddw %%xmm5, %%xmm1\n"
+       "psrlw $8, %%xmm0\n"
+       "psrlw $8, %%xmm1\n"
+       "packuswb %%xmm1, %%xmm0\n"
+       "movdqa (%2), %%xmm3\n"
+       "movups (%0), %%xmm2\n"
+       "andps %%xmm3, %%xmm0\n"
+       "andnps %%xmm2, %%xmm3\n"
+       "orps %%xmm3, %%xmm0\n"
+       "movdqu %%xmm0, (%0)\n"
+       : /* no outputs */
+       : "r" (p), "r" (eight_halves), "r" (just_gba)
+       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "memory");
+}
+
 #endif /* COGL_USE_PREMULT_SSE2 */
 
+/* Bitmaps with at least this many pixels are split into bands of
+   rows which are processed in parallel by a pool of threads shared by
+   all of the bitmap functions. Every pixel is converted independently
+   of the others so the result doesn't depend on how the bitmap is
+   split */
+#define COGL_BITMAP_PARALLEL_MIN_PIXELS (512 * 512)
+/* Number of pixels in each band, which is rounded to whole rows */
+#define COGL_BITMAP_BAND_PIXELS         (64 * 1024)
+/* Upper limit for COGL_BITMAP_THREADS */
+#define COGL_BITMAP_MAX_THREADS         16
+
+typedef void (* CoglBitmapRowsFunc) (int      first_row,
+                                     int      n_rows,
+                                     gpointer user_data);
+
+typedef struct _CoglBitmapRowsJob
+{
+  /* One reference for the caller and one for each task pushed to the
+     pool. The tasks may only start running once the caller has
+     returned so the job can't live on its stack */
+  volatile int ref_count;
+
+  CoglBitmapRowsFunc func;
+  gpointer user_data;
+
+  int n_rows;
+  int band_rows;
+  int n_bands;
+
+  /* Index of the next band to process, taken by the threads with an
+     atomic increment */
+  volatile int next_band;
+  /* Protected by _cogl_bitmap_thread_mutex */
+  int n_bands_done;
+} CoglBitmapRowsJob;
+
+static GThreadPool *_cogl_bitmap_thread_pool = NULL;
+static GMutex *_cogl_bitmap_thread_mutex = NULL;
+static GCond *_cogl_bitmap_thread_cond = NULL;
+
+static void
+_cogl_bitmap_rows_job_unref (CoglBitmapRowsJob *job)
+{
+  if (g_atomic_int_dec_and_test (&job->ref_count))
+    g_slice_free (CoglBitmapRowsJob, job);
+}
+
+static void
+_cogl_bitmap_rows_job_run (CoglBitmapRowsJob *job)
+{
+  int band;
+
+  while ((band = g_atomic_int_exchange_and_add (&job->next_band, 1))
+         < job->n_bands)
+    {
+      int first_row = band * job->band_rows;
+
+      job->func (first_row,
+                 MIN (job->band_rows, job->n_rows - first_row),
+                 job->user_data);
+
+      g_mutex_lock (_cogl_bitmap_thread_mutex);
+      if (++job->n_bands_done == job->n_bands)
+        g_cond_broadcast (_cogl_bitmap_thread_cond);
+      g_mutex_unlock (_cogl_bitmap_thread_mutex);
+    }
+}
+
+static void
+_cogl_bitmap_thread_func (gpointer data,
+                          gpointer user_data)
+{
+  CoglBitmapRowsJob *job = data;
+
+  _cogl_bitmap_rows_job_run (job);
+  _cogl_bitmap_rows_job_unref (job);
+}
+
+/* Returns the number of threads to use for the large bitmaps,
+   including the calling thread, and creates the pool the first time
+   it's called. This is the number of processors unless it's
+   overridden with the COGL_BITMAP_THREADS environment variable. The
+   pool can only be used if g_thread_init() has been called */
+static int
+_cogl_bitmap_get_n_threads (void)
+{
+  static gsize initialized = 0;
+  static int n_threads = 1;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env_string;
+      int n = 1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+      n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+      if ((env_string = g_getenv ("COGL_BITMAP_THREADS")) != NULL)
+        n = atoi (env_string);
+
+      n = CLAMP (n, 1, COGL_BITMAP_MAX_THREADS);
+
+      if (n > 1 && g_thread_supported ())
+        {
+          _cogl_bitmap_thread_mutex = g_mutex_new ();
+          _cogl_bitmap_thread_cond = g_cond_new ();
+          _cogl_bitmap_thread_pool =
+            g_thread_pool_new (_cogl_bitmap_thread_func,
+                               NULL,
+                               n - 1,
+                               FALSE,
+                               NULL);
+
+          if (_cogl_bitmap_thread_pool != NULL)
+            n_threads = n;
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return n_threads;
+}
+
+/* Calls @func for all of the rows of a bitmap, splitting them across
+   the thread pool if the bitmap is big enough. Returns once all of
+   the rows have been processed */
+static void
+_cogl_bitmap_process_rows (int                width,
+                           int                height,
+                           CoglBitmapRowsFunc func,
+                           gpointer           user_data)
+{
+  CoglBitmapRowsJob *job;
+  int n_threads, n_workers, i;
+
+  if ((gsize) width * height < COGL_BITMAP_PARALLEL_MIN_PIXELS
+      || (n_threads = _cogl_bitmap_get_n_threads ()) < 2)
+    {
+      func (0, height, user_data);
+      return;
+    }
+
+  job = g_slice_new (CoglBitmapRowsJob);
+  job->ref_count = 1;
+  job->func = func;
+  job->user_data = user_data;
+  job->n_rows = height;
+  job->band_rows = MAX (1, COGL_BITMAP_BAND_PIXELS / width);
+  job->n_bands = (height + job->band_rows - 1) / job->band_rows;
+  job->next_band = 0;
+  job->n_bands_done = 0;
+
+  /* The calling thread processes bands as well so one less task is
+     needed */
+  n_workers = MIN (n_threads, job->n_bands) - 1;
+
+  for (i = 0; i < n_workers; i++)
+    {
+      g_atomic_int_inc (&job->ref_count);
+      g_thread_pool_push (_cogl_bitmap_thread_pool, job, NULL);
+    }
+
+  _cogl_bitmap_rows_job_run (job);
+
+  /* Wait for the bands taken by the other threads. Tasks which
+     haven't started yet will find that there's nothing left to do */
+  g_mutex_lock (_cogl_bitmap_thread_mutex);
+  while (job->n_bands_done < job->n_bands)
+    g_cond_wait (_cogl_bitmap_thread_cond, _cogl_bitmap_thread_mutex);
+  g_mutex_unlock (_cogl_bitmap_thread_mutex);
+
+  _cogl_bitmap_rows_job_unref (job);
+}
+
 gboolean
 _cogl_bitmap_fallback_can_convert (CoglPixelFormat src, CoglPixelFormat dst)
 {
@@ -337,25 +682,63 @@ _cogl_bitmap_fallback_can_premult (CoglPixelFormat format)
   return ((format & COGL_UNORDERED_MASK) == COGL_PIXEL_FORMAT_32);
 }
 
+typedef struct _CoglConvertRowsData
+{
+  const guint8 *src_data;
+  guint8 *dst_data;
+  int src_rowstride;
+  int dst_rowstride;
+  int width;
+  CoglComponentOffsets src_components;
+  CoglComponentOffsets dst_components;
+} CoglConvertRowsData;
+
+static void
+_cogl_convert_rows (int      first_row,
+                    int      n_rows,
+                    gpointer user_data)
+{
+  CoglConvertRowsData *data = user_data;
+  int y;
+
+  for (y = first_row; y < first_row + n_rows; y++)
+    {
+      const guint8 *src = data->src_data + y * data->src_rowstride;
+      guint8 *dst = data->dst_data + y * data->dst_rowstride;
+
+      switch (data->dst_components.bpp)
+        {
+        case 4:
+          _cogl_convert_row_to_4 (src, dst, data->width,
+                                  &data->src_components,
+                                  &data->dst_components);
+          break;
+        case 3:
+          _cogl_convert_row_to_3 (src, dst, data->width,
+                                  &data->src_components,
+                                  &data->dst_components);
+          break;
+        default:
+          _cogl_convert_row_to_g (src, dst, data->width,
+                                  &data->src_components);
+          break;
+        }
+    }
+}
+
 CoglBitmap *
 _cogl_bitmap_fallback_convert (CoglBitmap      *src_bmp,
                                CoglPixelFormat  dst_format)
 {
   guint8          *src_data;
   guint8          *dst_data;
-  guint8          *src;
-  guint8          *dst;
-  int              src_bpp;
   int              dst_bpp;
-  int              src_rowstride;
   int              dst_rowstride;
-  int              x,y;
-  guint8           temp_rgba[4] = {0,0,0,0};
   int              width, height;
   CoglPixelFormat  src_format;
+  CoglConvertRowsData rows_data;
 
   src_format = _cogl_bitmap_get_format (src_bmp);
-  src_rowstride = _cogl_bitmap_get_rowstride (src_bmp);
   width = _cogl_bitmap_get_width (src_bmp);
   height = _cogl_bitmap_get_height (src_bmp);
 
@@ -367,8 +750,9 @@ _cogl_bitmap_fallback_convert (CoglBitmap      *src_bmp,
   if (src_data == NULL)
     return NULL;
 
-  src_bpp = _cogl_get_format_bpp (src_format);
-  dst_bpp = _cogl_get_format_bpp (dst_format);
+  _cogl_get_component_offsets (src_format, &rows_data.src_components);
+  _cogl_get_component_offsets (dst_format, &rows_data.dst_components);
+  dst_bpp = rows_data.dst_components.bpp;
 
   /* Initialize destination bitmap */
   dst_rowstride = sizeof(guint8) * dst_bpp * width;
@@ -380,61 +764,13 @@ _cogl_bitmap_fallback_convert (CoglBitmap      *src_bmp,
   /* Allocate a new buffer to hold converted data */
   dst_data = g_malloc (height * dst_rowstride);
 
-  /* FIXME: Optimize */
-  for (y = 0; y < height; y++)
-    {
-      src = src_data + y * src_rowstride;
-      dst = dst_data + y * dst_rowstride;
-
-      for (x = 0; x < width; x++)
-	{
-	  /* FIXME: Would be nice to at least remove this inner
-           * branching, but not sure it can be done without
-           * rewriting of the whole loop */
-          switch (src_format & COGL_UNPREMULT_MASK)
-	    {
-	    case COGL_PIXEL_FORMAT_G_8:
-	      _cogl_g_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_RGB_888:
-	      _cogl_rgb_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_BGR_888:
-	      _cogl_bgr_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_RGBA_8888:
-	      _cogl_rgba_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_BGRA_8888:
-	      _cogl_bgra_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_ARGB_8888:
-	      _cogl_argb_to_rgba (src, temp_rgba); break;
-	    case COGL_PIXEL_FORMAT_ABGR_8888:
-	      _cogl_abgr_to_rgba (src, temp_rgba); break;
-	    default:
-	      break;
-	    }
-
-	  switch (dst_format & COGL_UNPREMULT_MASK)
-	    {
-	    case COGL_PIXEL_FORMAT_G_8:
-	      _cogl_rgba_to_g (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_RGB_888:
-	      _cogl_rgba_to_rgb (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_BGR_888:
-	      _cogl_rgba_to_bgr (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_RGBA_8888:
-	      _cogl_rgba_to_rgba (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_BGRA_8888:
-	      _cogl_rgba_to_bgra (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_ARGB_8888:
-	      _cogl_rgba_to_argb (temp_rgba, dst); break;
-	    case COGL_PIXEL_FORMAT_ABGR_8888:
-	      _cogl_rgba_to_abgr (temp_rgba, dst); break;
-	    default:
-	      break;
-	    }
-
-	  src += src_bpp;
-	  dst += dst_bpp;
-	}
-    }
+  rows_data.src_data = src_data;
+  rows_data.dst_data = dst_data;
+  rows_data.src_rowstride = _cogl_bitmap_get_rowstride (src_bmp);
+  rows_data.dst_rowstride = dst_rowstride;
+  rows_data.width = width;
+
+  _cogl_bitmap_process_rows (width, height, _cogl_convert_rows, &rows_data);
 
   _cogl_bitmap_unmap (src_bmp);
 
@@ -445,81 +781,68 @@ _cogl_bitmap_fallback_convert (CoglBitmap      *src_bmp,
                                      NULL);
 }
 
-gboolean
-_cogl_bitmap_fallback_unpremult (CoglBitmap *bmp)
+typedef struct _CoglPremultRowsData
 {
-  guint8          *p, *data;
-  int              x,y;
-  CoglPixelFormat  format;
-  int              width, height;
-  int              rowstride;
-
-  format = _cogl_bitmap_get_format (bmp);
-  width = _cogl_bitmap_get_width (bmp);
-  height = _cogl_bitmap_get_height (bmp);
-  rowstride = _cogl_bitmap_get_rowstride (bmp);
-
-  /* Make sure format supported for un-premultiplication */
-  if (!_cogl_bitmap_fallback_can_unpremult (format))
-    return FALSE;
-
-  if ((data = _cogl_bitmap_map (bmp,
-                                COGL_BUFFER_ACCESS_READ |
-                                COGL_BUFFER_ACCESS_WRITE,
-                                0)) == NULL)
-    return FALSE;
+  guint8 *data;
+  int rowstride;
+  int width;
+  CoglPixelFormat format;
+  const guint32 *unpremult_table;
+} CoglPremultRowsData;
+
+static void
+_cogl_unpremult_rows (int      first_row,
+                      int      n_rows,
+                      gpointer user_data)
+{
+  CoglPremultRowsData *data = user_data;
+  const guint32 *table = data->unpremult_table;
+  guint8 *p;
+  int x, y;
 
-  for (y = 0; y < height; y++)
+  for (y = first_row; y < first_row + n_rows; y++)
     {
-      p = (guint8*) data + y * rowstride;
+      p = data->data + y * data->rowstride;
 
-      if (format & COGL_AFIRST_BIT)
+      if (data->format & COGL_AFIRST_BIT)
         {
-          for (x = 0; x < width; x++)
+          for (x = 0; x < data->width; x++)
             {
               if (p[0] == 0)
                 _cogl_unpremult_alpha_0 (p);
-              else
-                _cogl_unpremult_alpha_first (p);
+              else if (p[0] != 255)
+                _cogl_unpremult_alpha_first (p, table);
               p += 4;
             }
         }
       else
         {
-          for (x = 0; x < width; x++)
+          for (x = 0; x < data->width; x++)
             {
               if (p[3] == 0)
                 _cogl_unpremult_alpha_0 (p);
-              else
-                _cogl_unpremult_alpha_last (p);
+              else if (p[3] != 255)
+                _cogl_unpremult_alpha_last (p, table);
               p += 4;
             }
         }
     }
-
-  _cogl_bitmap_unmap (bmp);
-
-  _cogl_bitmap_set_format (bmp, format & ~COGL_PREMULT_BIT);
-
-  return TRUE;
 }
 
 gboolean
-_cogl_bitmap_fallback_premult (CoglBitmap *bmp)
+_cogl_bitmap_fallback_unpremult (CoglBitmap *bmp)
 {
-  guint8          *p, *data;
-  int              x,y;
+  guint8          *data;
   CoglPixelFormat  format;
   int              width, height;
-  int              rowstride;
+  CoglPremultRowsData rows_data;
 
   format = _cogl_bitmap_get_format (bmp);
   width = _cogl_bitmap_get_width (bmp);
   height = _cogl_bitmap_get_height (bmp);
-  rowstride = _cogl_bitmap_get_rowstride (bmp);
 
   /* Make sure format supported for un-premultiplication */
-  if (!_cogl_bitmap_fallback_can_premult (format))
+  if (!_cogl_bitmap_fallback_can_unpremult (format))
     return FALSE;
 
   if ((data = _cogl_bitmap_map (bmp,
@@ -528,13 +851,50 @@ _cogl_bitmap_fallback_premult (CoglBitmap *bmp)
                                 0)) == NULL)
     return FALSE;
 
-  for (y = 0; y < height; y++)
+  rows_data.data = data;
+  rows_data.rowstride = _cogl_bitmap_get_rowstride (bmp);
+  rows_data.width = width;
+  rows_data.format = format;
+  rows_data.unpremult_table = _cogl_get_unpremult_table ();
+
+  _cogl_bitmap_process_rows (width, height, _cogl_unpremult_rows, &rows_data);
+
+  _cogl_bitmap_unmap (bmp);
+
+  _cogl_bitmap_set_format (bmp, format & ~COGL_PREMULT_BIT);
+
+  return TRUE;
+}
+
+static void
+_cogl_premult_rows (int      first_row,
+                    int      n_rows,
+                    gpointer user_data)
+{
+  CoglPremultRowsData *data = user_data;
+  guint8 *p;
+  int x, y;
+
+  for (y = first_row; y < first_row + n_rows; y++)
     {
-      p = (guint8*) data + y * rowstride;
+      p = data->data + y * data->rowstride;
+
+      x = data->width;
 
-      if (format & COGL_AFIRST_BIT)
+      if (data->format & COGL_AFIRST_BIT)
         {
-          for (x = 0; x < width; x++)
+#ifdef COGL_USE_PREMULT_SSE2
+
+          while (x >= 4)
+            {
+              _cogl_premult_alpha_first_four_pixels_sse2 (p);
+              p += 4 * 4;
+              x -= 4;
+            }
+
+#endif /* COGL_USE_PREMULT_SSE2 */
+
+          while (x-- > 0)
             {
               _cogl_premult_alpha_first (p);
               p += 4;
@@ -542,7 +902,6 @@ _cogl_bitmap_fallback_premult (CoglBitmap *bmp)
         }
       else
         {
-          x = width;
 
 #ifdef COGL_USE_PREMULT_SSE2
 
@@ -566,6 +925,37 @@ _cogl_bitmap_fallback_premult (CoglBitmap *bmp)
             }
         }
     }
+}
+
+gboolean
+_cogl_bitmap_fallback_premult (CoglBitmap *bmp)
+{
+  guint8          *data;
+  CoglPixelFormat  format;
+  int              width, height;
+  CoglPremultRowsData rows_data;
+
+  format = _cogl_bitmap_get_format (bmp);
+  width = _cogl_bitmap_get_width (bmp);
+  height = _cogl_bitmap_get_height (bmp);
+
+  /* Make sure format supported for un-premultiplication */
+  if (!_cogl_bitmap_fallback_can_premult (format))
+    return FALSE;
+
+  if ((data = _cogl_bitmap_map (bmp,
+                                COGL_BUFFER_ACCESS_READ |
+                                COGL_BUFFER_ACCESS_WRITE,
+                                0)) == NULL)
+    return FALSE;
+
+  rows_data.data = data;
+  rows_data.rowstride = _cogl_bitmap_get_rowstride (bmp);
+  rows_data.width = width;
+  rows_data.format = format;
+  rows_data.unpremult_table = NULL;
+
+  _cogl_bitmap_process_rows (width, height, _cogl_premult_rows, &rows_data);
 
   _cogl_bitmap_unmap (bmp);
 
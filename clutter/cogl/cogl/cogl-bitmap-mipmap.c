@@ -0,0 +1,422 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl.h"
+#include "cogl-internal.h"
+#include "cogl-bitmap-private.h"
+
+#include <string.h>
+#include <math.h>
+
+/* Each level is computed from the previous one. The components are
+   filtered independently so any format with 8 bits per component
+   works. Formats with an alpha channel are filtered premultiplied so
+   that the color of transparent pixels doesn't bleed into their
+   neighbours */
+
+/* Precision of the Lanczos weights */
+#define COGL_MIPMAP_WEIGHT_BITS 14
+
+typedef struct _CoglMipmapLevel
+{
+  const guint8 *data;
+  int           width;
+  int           height;
+  int           rowstride;
+  int           bpp;
+  /* The offset of the alpha component if the level has to be
+     premultiplied while it is read, or -1 */
+  int           premult_alpha;
+} CoglMipmapLevel;
+
+/* The taps of the Lanczos filter for one row or column of the
+   destination */
+typedef struct _CoglMipmapTaps
+{
+  int  first;
+  int  n_taps;
+  int *weights;
+} CoglMipmapTaps;
+
+/* Same rounding as the premultiplication of cogl-bitmap-fallback.c */
+static inline guint8
+_cogl_mipmap_premult (guint8 c, guint8 a)
+{
+  unsigned int t = c * a + 128;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+/* Returns row @y of @src, premultiplied into @buf if needed */
+static const guint8 *
+_cogl_mipmap_get_row (const CoglMipmapLevel *src,
+                      int                    y,
+                      guint8                *buf)
+{
+  const guint8 *row = src->data + y * src->rowstride;
+  guint8 *p = buf;
+  int a = src->premult_alpha, x, i;
+
+  if (a == -1)
+    return row;
+
+  for (x = 0; x < src->width; x++, row += 4, p += 4)
+    for (i = 0; i < 4; i++)
+      p[i] = i == a ? row[a] : _cogl_mipmap_premult (row[i], row[a]);
+
+  return buf;
+}
+
+static void
+_cogl_mipmap_box (const CoglMipmapLevel *src,
+                  guint8                *dst,
+                  int                    dst_width,
+                  int                    dst_height,
+                  int                    dst_rowstride)
+{
+  int bpp = src->bpp;
+  guint8 *buf0 = g_malloc (src->width * bpp);
+  guint8 *buf1 = g_malloc (src->width * bpp);
+  int x, y, i;
+
+  for (y = 0; y < dst_height; y++)
+    {
+      const guint8 *row0, *row1;
+      guint8 *d = dst + y * dst_rowstride;
+
+      row0 = _cogl_mipmap_get_row (src, MIN (y * 2, src->height - 1), buf0);
+      row1 = _cogl_mipmap_get_row (src, MIN (y * 2 + 1, src->height - 1),
+                                   buf1);
+
+      for (x = 0; x < dst_width; x++)
+        {
+          int x0 = MIN (x * 2, src->width - 1) * bpp;
+          int x1 = MIN (x * 2 + 1, src->width - 1) * bpp;
+
+          for (i = 0; i < bpp; i++)
+            *(d++) = (row0[x0 + i] + row0[x1 + i] +
+                      row1[x0 + i] + row1[x1 + i] + 2) >> 2;
+        }
+    }
+
+  g_free (buf0);
+  g_free (buf1);
+}
+
+static double
+_cogl_mipmap_lanczos2 (double t)
+{
+  if (t == 0.0)
+    return 1.0;
+  if (t <= -2.0 || t >= 2.0)
+    return 0.0;
+
+  return (2.0 * sin (G_PI * t) * sin (G_PI * t / 2.0)) / (G_PI * G_PI * t * t);
+}
+
+/* Computes the taps used to sample a size of @src_size down to
+   @dst_size with a Lanczos filter of 2 lobes. The weights of each
+   destination pixel add up to exactly 1 << COGL_MIPMAP_WEIGHT_BITS */
+static CoglMipmapTaps *
+_cogl_mipmap_make_taps (int src_size,
+                        int dst_size)
+{
+  CoglMipmapTaps *taps = g_new (CoglMipmapTaps, dst_size);
+  double scale = (double) src_size / dst_size;
+  double radius = 2.0 * scale;
+  int i, j;
+
+  for (i = 0; i < dst_size; i++)
+    {
+      double center = (i + 0.5) * scale - 0.5;
+      double sum = 0.0, *fweights;
+      int total = 0, biggest = 0;
+
+      taps[i].first = (int) floor (center - radius) + 1;
+      taps[i].n_taps = (int) floor (center + radius) - taps[i].first + 1;
+      taps[i].weights = g_new (int, taps[i].n_taps);
+
+      fweights = g_new (double, taps[i].n_taps);
+
+      for (j = 0; j < taps[i].n_taps; j++)
+        {
+          fweights[j] =
+            _cogl_mipmap_lanczos2 ((taps[i].first + j - center) / scale);
+          sum += fweights[j];
+        }
+
+      for (j = 0; j < taps[i].n_taps; j++)
+        {
+          taps[i].weights[j] = (int) floor (fweights[j] / sum *
+                                            (1 << COGL_MIPMAP_WEIGHT_BITS)
+                                            + 0.5);
+          total += taps[i].weights[j];
+
+          if (taps[i].weights[j] > taps[i].weights[biggest])
+            biggest = j;
+        }
+
+      /* Give the rounding error to the biggest tap so that flat areas
+         keep their exact value */
+      taps[i].weights[biggest] += (1 << COGL_MIPMAP_WEIGHT_BITS) - total;
+
+      g_free (fweights);
+    }
+
+  return taps;
+}
+
+static void
+_cogl_mipmap_free_taps (CoglMipmapTaps *taps,
+                        int             size)
+{
+  int i;
+
+  for (i = 0; i < size; i++)
+    g_free (taps[i].weights);
+
+  g_free (taps);
+}
+
+/* Filters row @y of @src horizontally into @out, keeping the
+   precision of the weights */
+static void
+_cogl_mipmap_lanczos_row (const CoglMipmapLevel *src,
+                          int                    y,
+                          const CoglMipmapTaps  *taps,
+                          int                    dst_width,
+                          guint8                *buf,
+                          int                   *out)
+{
+  const guint8 *row = _cogl_mipmap_get_row (src, y, buf);
+  int bpp = src->bpp;
+  int x, j, i;
+
+  for (x = 0; x < dst_width; x++)
+    {
+      int sum[4] = { 0, 0, 0, 0 };
+
+      for (j = 0; j < taps[x].n_taps; j++)
+        {
+          int sx = CLAMP (taps[x].first + j, 0, src->width - 1);
+          const guint8 *p = row + sx * bpp;
+
+          for (i = 0; i < bpp; i++)
+            sum[i] += p[i] * taps[x].weights[j];
+        }
+
+      for (i = 0; i < bpp; i++)
+        *(out++) = sum[i];
+    }
+}
+
+static void
+_cogl_mipmap_lanczos (const CoglMipmapLevel *src,
+                      guint8                *dst,
+                      int                    dst_width,
+                      int                    dst_height,
+                      int                    dst_rowstride,
+                      int                    alpha)
+{
+  CoglMipmapTaps *x_taps = _cogl_mipmap_make_taps (src->width, dst_width);
+  CoglMipmapTaps *y_taps = _cogl_mipmap_make_taps (src->height, dst_height);
+  int bpp = src->bpp;
+  int row_size = dst_width * bpp;
+  int ring_size = 0;
+  int *ring, *ring_rows;
+  guint8 *buf;
+  int x, y, i, j;
+
+  /* The rows filtered horizontally are kept in a ring big enough for
+     the taps of one destination row, as the taps of consecutive rows
+     overlap */
+  for (y = 0; y < dst_height; y++)
+    ring_size = MAX (ring_size, y_taps[y].n_taps);
+
+  ring = g_new (int, ring_size * row_size);
+  ring_rows = g_new (int, ring_size);
+  for (i = 0; i < ring_size; i++)
+    ring_rows[i] = -1;
+
+  buf = g_malloc (src->width * bpp);
+
+  for (y = 0; y < dst_height; y++)
+    {
+      guint8 *d = dst + y * dst_rowstride;
+      const int *rows[16], **taps_rows = rows;
+
+      if (y_taps[y].n_taps > G_N_ELEMENTS (rows))
+        taps_rows = g_new (const int *, y_taps[y].n_taps);
+
+      for (j = 0; j < y_taps[y].n_taps; j++)
+        {
+          int sy = CLAMP (y_taps[y].first + j, 0, src->height - 1);
+          int slot = sy % ring_size;
+
+          if (ring_rows[slot] != sy)
+            {
+              _cogl_mipmap_lanczos_row (src, sy, x_taps, dst_width, buf,
+                                        ring + slot * row_size);
+              ring_rows[slot] = sy;
+            }
+
+          taps_rows[j] = ring + slot * row_size;
+        }
+
+      for (x = 0; x < row_size; x += bpp)
+        {
+          gint64 sum[4] = { 0, 0, 0, 0 };
+
+          for (j = 0; j < y_taps[y].n_taps; j++)
+            for (i = 0; i < bpp; i++)
+              sum[i] += (gint64) taps_rows[j][x + i] * y_taps[y].weights[j];
+
+          for (i = 0; i < bpp; i++)
+            {
+              gint64 v = ((sum[i] + (G_GINT64_CONSTANT (1)
+                                     << (COGL_MIPMAP_WEIGHT_BITS * 2 - 1)))
+                          >> (COGL_MIPMAP_WEIGHT_BITS * 2));
+
+              d[i] = CLAMP (v, 0, 255);
+            }
+
+          /* The lobes of the filter can push the components of
+             premultiplied pixels over their alpha */
+          if (alpha != -1)
+            for (i = 0; i < bpp; i++)
+              d[i] = MIN (d[i], d[alpha]);
+
+          d += bpp;
+        }
+
+      if (taps_rows != rows)
+        g_free (taps_rows);
+    }
+
+  g_free (buf);
+  g_free (ring_rows);
+  g_free (ring);
+
+  _cogl_mipmap_free_taps (x_taps, dst_width);
+  _cogl_mipmap_free_taps (y_taps, dst_height);
+}
+
+gboolean
+cogl_bitmap_generate_mipmaps (CoglBitmap       *bitmap,
+                              CoglBitmapFilter  filter)
+{
+  CoglPixelFormat format, level_format;
+  CoglMipmapLevel src;
+  GPtrArray *levels;
+  guint8 *data;
+  int alpha = -1;
+
+  g_return_val_if_fail (cogl_is_bitmap (bitmap), FALSE);
+
+  format = _cogl_bitmap_get_format (bitmap);
+
+  switch (format & COGL_UNPREMULT_MASK)
+    {
+    case COGL_PIXEL_FORMAT_A_8:
+    case COGL_PIXEL_FORMAT_G_8:
+    case COGL_PIXEL_FORMAT_RGB_888:
+    case COGL_PIXEL_FORMAT_BGR_888:
+      break;
+
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+      alpha = (format & COGL_AFIRST_BIT) ? 0 : 3;
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  if ((data = _cogl_bitmap_map (bitmap, COGL_BUFFER_ACCESS_READ, 0)) == NULL)
+    return FALSE;
+
+  src.data = data;
+  src.width = _cogl_bitmap_get_width (bitmap);
+  src.height = _cogl_bitmap_get_height (bitmap);
+  src.rowstride = _cogl_bitmap_get_rowstride (bitmap);
+  src.bpp = _cogl_get_format_bpp (format);
+  src.premult_alpha = -1;
+
+  /* The levels are always premultiplied */
+  level_format = format;
+  if (alpha != -1)
+    {
+      level_format |= COGL_PREMULT_BIT;
+
+      if (!(format & COGL_PREMULT_BIT))
+        src.premult_alpha = alpha;
+    }
+
+  levels = g_ptr_array_new ();
+
+  while (src.width > 1 || src.height > 1)
+    {
+      int width = MAX (src.width >> 1, 1);
+      int height = MAX (src.height >> 1, 1);
+      int rowstride = (width * src.bpp + 3) & ~3;
+      guint8 *level_data = g_malloc (rowstride * height);
+
+      if (filter == COGL_BITMAP_FILTER_LANCZOS)
+        _cogl_mipmap_lanczos (&src, level_data, width, height, rowstride,
+                              alpha);
+      else
+        _cogl_mipmap_box (&src, level_data, width, height, rowstride);
+
+      g_ptr_array_add (levels,
+                       _cogl_bitmap_new_from_data (level_data,
+                                                   level_format,
+                                                   width,
+                                                   height,
+                                                   rowstride,
+                                                   (CoglBitmapDestroyNotify)
+                                                   g_free,
+                                                   NULL));
+
+      src.data = level_data;
+      src.width = width;
+      src.height = height;
+      src.rowstride = rowstride;
+      src.premult_alpha = -1;
+    }
+
+  _cogl_bitmap_unmap (bitmap);
+
+  _cogl_bitmap_set_mipmaps (bitmap,
+                            (CoglBitmap **) levels->pdata,
+                            levels->len);
+
+  g_ptr_array_free (levels, FALSE);
+
+  return TRUE;
+}
@@ -165,6 +165,34 @@ _cogl_bitmap_from_file (const char  *filename,
                                      NULL);
 }
 
+/* Images are always decoded in one go by this backend */
+
+void
+_cogl_bitmap_loader_backend_init (CoglBitmapLoader *loader)
+{
+}
+
+gboolean
+_cogl_bitmap_loader_backend_write (CoglBitmapLoader  *loader,
+                                   const guint8      *buffer,
+                                   gsize              count,
+                                   GError           **error)
+{
+  return FALSE;
+}
+
+gboolean
+_cogl_bitmap_loader_backend_close (CoglBitmapLoader  *loader,
+                                   GError           **error)
+{
+  return FALSE;
+}
+
+void
+_cogl_bitmap_loader_backend_destroy (CoglBitmapLoader *loader)
+{
+}
+
 #elif defined(USE_GDKPIXBUF)
 
 gboolean
@@ -298,6 +326,145 @@ _cogl_bitmap_from_file (const char   *filename,
                                      NULL);
 }
 
+typedef struct _CoglBitmapPixbufLoader
+{
+  GdkPixbufLoader *pixbuf_loader;
+  gboolean         closed;
+  /* Set when the decoded image isn't in a format we can use */
+  gboolean         unsupported;
+} CoglBitmapPixbufLoader;
+
+static gboolean
+_cogl_bitmap_loader_check_supported (CoglBitmapLoader  *loader,
+                                     GError           **error)
+{
+  CoglBitmapPixbufLoader *data = loader->backend_data;
+
+  if (data->unsupported)
+    {
+      g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                   "Only images with 8-bit RGB samples are supported");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+_cogl_bitmap_loader_area_prepared_cb (GdkPixbufLoader  *pixbuf_loader,
+                                      CoglBitmapLoader *loader)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf (pixbuf_loader);
+  CoglBitmapPixbufLoader *data = loader->backend_data;
+  CoglPixelFormat pixel_format;
+
+  /* Same restrictions as _cogl_bitmap_from_file(). The next write or
+     the close will fail if they aren't met */
+  if (gdk_pixbuf_get_colorspace (pixbuf) != GDK_COLORSPACE_RGB ||
+      gdk_pixbuf_get_bits_per_sample (pixbuf) != 8)
+    {
+      data->unsupported = TRUE;
+      return;
+    }
+
+  pixel_format = gdk_pixbuf_get_has_alpha (pixbuf) ?
+    COGL_PIXEL_FORMAT_RGBA_8888 :
+    COGL_PIXEL_FORMAT_RGB_888;
+
+  /* The pixbuf keeps being written to as the image is decoded. Only
+     the rows reported by area-updated are read from it, and they are
+     copied by cogl_bitmap_loader_get_rows() one at a time so the
+     short last row of a pixbuf is not a problem here */
+  loader->bitmap =
+    _cogl_bitmap_new_from_data (gdk_pixbuf_get_pixels (pixbuf),
+                                pixel_format,
+                                gdk_pixbuf_get_width (pixbuf),
+                                gdk_pixbuf_get_height (pixbuf),
+                                gdk_pixbuf_get_rowstride (pixbuf),
+                                _cogl_bitmap_unref_pixbuf,
+                                g_object_ref (pixbuf));
+}
+
+static void
+_cogl_bitmap_loader_area_updated_cb (GdkPixbufLoader  *pixbuf_loader,
+                                     int               x,
+                                     int               y,
+                                     int               width,
+                                     int               height,
+                                     CoglBitmapLoader *loader)
+{
+  if (loader->bitmap)
+    _cogl_bitmap_loader_update_rows (loader, y, height);
+}
+
+void
+_cogl_bitmap_loader_backend_init (CoglBitmapLoader *loader)
+{
+  CoglBitmapPixbufLoader *data = g_slice_new (CoglBitmapPixbufLoader);
+
+  data->pixbuf_loader = gdk_pixbuf_loader_new ();
+  data->closed = FALSE;
+  data->unsupported = FALSE;
+
+  g_signal_connect (data->pixbuf_loader, "area-prepared",
+                    G_CALLBACK (_cogl_bitmap_loader_area_prepared_cb),
+                    loader);
+  g_signal_connect (data->pixbuf_loader, "area-updated",
+                    G_CALLBACK (_cogl_bitmap_loader_area_updated_cb),
+                    loader);
+
+  loader->backend_data = data;
+}
+
+gboolean
+_cogl_bitmap_loader_backend_write (CoglBitmapLoader  *loader,
+                                   const guint8      *buffer,
+                                   gsize              count,
+                                   GError           **error)
+{
+  CoglBitmapPixbufLoader *data = loader->backend_data;
+
+  if (gdk_pixbuf_loader_write (data->pixbuf_loader, buffer, count, error))
+    return _cogl_bitmap_loader_check_supported (loader, error);
+
+  /* GdkPixbufLoader closes itself when a write fails */
+  data->closed = TRUE;
+
+  return FALSE;
+}
+
+gboolean
+_cogl_bitmap_loader_backend_close (CoglBitmapLoader  *loader,
+                                   GError           **error)
+{
+  CoglBitmapPixbufLoader *data = loader->backend_data;
+
+  data->closed = TRUE;
+
+  if (!gdk_pixbuf_loader_close (data->pixbuf_loader, error))
+    return FALSE;
+
+  return _cogl_bitmap_loader_check_supported (loader, error);
+}
+
+void
+_cogl_bitmap_loader_backend_destroy (CoglBitmapLoader *loader)
+{
+  CoglBitmapPixbufLoader *data = loader->backend_data;
+
+  g_signal_handlers_disconnect_matched (data->pixbuf_loader,
+                                        G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL,
+                                        loader);
+
+  if (!data->closed)
+    gdk_pixbuf_loader_close (data->pixbuf_loader, NULL);
+
+  g_object_unref (data->pixbuf_loader);
+
+  g_slice_free (CoglBitmapPixbufLoader, data);
+}
+
 #else
 
 #include "stb_image.c"
@@ -347,4 +514,33 @@ _cogl_bitmap_from_file (const char  *filename,
 
   return bmp;
 }
+
+/* Images are always decoded in one go by this backend */
+
+void
+_cogl_bitmap_loader_backend_init (CoglBitmapLoader *loader)
+{
+}
+
+gboolean
+_cogl_bitmap_loader_backend_write (CoglBitmapLoader  *loader,
+                                   const guint8      *buffer,
+                                   gsize              count,
+                                   GError           **error)
+{
+  return FALSE;
+}
+
+gboolean
+_cogl_bitmap_loader_backend_close (CoglBitmapLoader  *loader,
+                                   GError           **error)
+{
+  return FALSE;
+}
+
+void
+_cogl_bitmap_loader_backend_destroy (CoglBitmapLoader *loader)
+{
+}
+
 #endif
@@ -27,6 +27,7 @@
 #define __COGL_BITMAP_H
 
 #include <glib.h>
+#include <stdio.h>
 
 #include "cogl-handle.h"
 #include "cogl-buffer.h"
@@ -160,6 +161,11 @@ _cogl_bitmap_get_size_from_file (const char *filename,
                                  int        *width,
                                  int        *height);
 
+/* Returns whether the data of the bitmap is mapped from a read-only
+   cache file, in which case it can't be converted in place */
+gboolean
+_cogl_bitmap_is_read_only (CoglBitmap *bitmap);
+
 CoglPixelFormat
 _cogl_bitmap_get_format (CoglBitmap *bitmap);
 
@@ -176,6 +182,21 @@ _cogl_bitmap_get_height (CoglBitmap *bitmap);
 int
 _cogl_bitmap_get_rowstride (CoglBitmap *bitmap);
 
+/* Replaces the mipmap levels attached to the bitmap, taking ownership
+   of the array and of the references to the levels in it. The first
+   element is level 1 */
+void
+_cogl_bitmap_set_mipmaps (CoglBitmap  *bitmap,
+                          CoglBitmap **mipmaps,
+                          int          n_mipmaps);
+
+int
+_cogl_bitmap_get_n_mipmaps (CoglBitmap *bitmap);
+
+CoglBitmap *
+_cogl_bitmap_get_mipmap (CoglBitmap *bitmap,
+                         int         level);
+
 guint8 *
 _cogl_bitmap_map (CoglBitmap *bitmap,
                   CoglBufferAccess access,
@@ -198,4 +219,54 @@ _cogl_bitmap_bind (CoglBitmap *bitmap,
 void
 _cogl_bitmap_unbind (CoglBitmap *bitmap);
 
+struct _CoglBitmapLoader
+{
+  CoglHandleObject  _parent;
+
+  char             *filename;
+  FILE             *file;
+
+  /* The image being decoded, or NULL until the image backend knows
+     its size. The backend keeps writing to its data while decoding */
+  CoglBitmap       *bitmap;
+
+  /* Range of rows of the bitmap written since the last call to
+     cogl_bitmap_loader_get_rows() */
+  int               dirty_start;
+  int               dirty_end;
+
+  gboolean          finished;
+
+  /* Data of the image backend, or NULL if the backend can't decode
+     images incrementally, in which case the whole file is decoded in
+     one go */
+  void             *backend_data;
+};
+
+/* Called by the image backends when rows of the bitmap of @loader
+   have been decoded */
+void
+_cogl_bitmap_loader_update_rows (CoglBitmapLoader *loader,
+                                 int               first_row,
+                                 int               n_rows);
+
+/* Incremental decoding implemented by the image backends. init sets
+   the backend_data of the loader, or leaves it NULL if incremental
+   decoding isn't supported */
+void
+_cogl_bitmap_loader_backend_init (CoglBitmapLoader *loader);
+
+gboolean
+_cogl_bitmap_loader_backend_write (CoglBitmapLoader  *loader,
+                                   const guint8      *buffer,
+                                   gsize              count,
+                                   GError           **error);
+
+gboolean
+_cogl_bitmap_loader_backend_close (CoglBitmapLoader  *loader,
+                                   GError           **error);
+
+void
+_cogl_bitmap_loader_backend_destroy (CoglBitmapLoader *loader);
+
 #endif /* __COGL_BITMAP_H */
@@ -29,8 +29,14 @@
 #include "cogl-internal.h"
 #include "cogl-bitmap-private.h"
 #include "cogl-buffer-private.h"
+#include "cogl-texture-private.h"
+#include "cogl-texture-driver.h"
 
 #include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
 
 struct _CoglBitmap
 {
@@ -54,8 +60,37 @@ struct _CoglBitmap
   /* If this is non-null then 'data' is treated as an offset into the
      buffer and map will divert to mapping the buffer */
   CoglBuffer              *buffer;
+
+  /* Mipmap levels generated by cogl_bitmap_generate_mipmaps(),
+     starting with level 1 */
+  CoglBitmap             **mipmaps;
+  int                      n_mipmaps;
 };
 
+/* Pre-decoded images are stored next to the source image in a file
+   with this suffix. The file contains a CoglBitmapCacheHeader followed
+   by the pixel data, already in the format of the texture */
+#define COGL_BITMAP_CACHE_SUFFIX  ".cogl-bitmap"
+#define COGL_BITMAP_CACHE_MAGIC   "CoglBmp"
+/* The version is also used to detect files written with a different
+   byte order */
+#define COGL_BITMAP_CACHE_VERSION 1
+
+typedef struct _CoglBitmapCacheHeader
+{
+  char    magic[8];
+  guint32 version;
+  guint32 format;
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+  guint32 data_offset;
+  /* Modification time and size of the source image, used to
+     invalidate the cache when it changes */
+  guint64 source_mtime;
+  guint64 source_size;
+} CoglBitmapCacheHeader;
+
 static void _cogl_bitmap_free (CoglBitmap *bmp);
 
 COGL_OBJECT_DEFINE (Bitmap, bitmap);
@@ -75,6 +110,8 @@ _cogl_bitmap_free (CoglBitmap *bmp)
   if (bmp->buffer)
     cogl_object_unref (bmp->buffer);
 
+  _cogl_bitmap_set_mipmaps (bmp, NULL, 0);
+
   g_slice_free (CoglBitmap, bmp);
 }
 
@@ -220,11 +257,139 @@ _cogl_bitmap_copy_subregion (CoglBitmap *src,
     }
 }
 
+/* Only the formats that cogl_bitmap_convert_for_upload() can return
+   are accepted from a cache file. Anything else means the file is
+   corrupt and its format can't be trusted to look up the number of
+   bytes per pixel */
+static gboolean
+_cogl_bitmap_cache_format_is_valid (guint32 format)
+{
+  switch (format)
+    {
+    case COGL_PIXEL_FORMAT_A_8:
+    case COGL_PIXEL_FORMAT_G_8:
+    case COGL_PIXEL_FORMAT_RGB_565:
+    case COGL_PIXEL_FORMAT_RGBA_4444:
+    case COGL_PIXEL_FORMAT_RGBA_5551:
+    case COGL_PIXEL_FORMAT_RGBA_4444_PRE:
+    case COGL_PIXEL_FORMAT_RGBA_5551_PRE:
+    case COGL_PIXEL_FORMAT_RGB_888:
+    case COGL_PIXEL_FORMAT_BGR_888:
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+    case COGL_PIXEL_FORMAT_RGBA_8888_PRE:
+    case COGL_PIXEL_FORMAT_BGRA_8888_PRE:
+    case COGL_PIXEL_FORMAT_ARGB_8888_PRE:
+    case COGL_PIXEL_FORMAT_ABGR_8888_PRE:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* The rows are always written tightly packed but aligned to 4 bytes,
+   which is the default unpack alignment of GL */
+static guint64
+_cogl_bitmap_cache_rowstride (guint32 format,
+                              guint32 width)
+{
+  return ((guint64) width * _cogl_get_format_bpp (format) + 3) & ~(guint64) 3;
+}
+
+/* Checks that @header describes a file for the current version of
+   @filename whose data fits in @length bytes */
+static gboolean
+_cogl_bitmap_cache_header_is_valid (const CoglBitmapCacheHeader *header,
+                                    const char                  *filename,
+                                    guint64                      length)
+{
+  struct stat stat_buf;
+
+  if (length < sizeof (CoglBitmapCacheHeader) ||
+      memcmp (header->magic, COGL_BITMAP_CACHE_MAGIC,
+              sizeof (header->magic)) != 0 ||
+      header->version != COGL_BITMAP_CACHE_VERSION)
+    return FALSE;
+
+  if (g_stat (filename, &stat_buf) != 0 ||
+      header->source_mtime != (guint64) stat_buf.st_mtime ||
+      header->source_size != (guint64) stat_buf.st_size)
+    return FALSE;
+
+  if (!_cogl_bitmap_cache_format_is_valid (header->format) ||
+      header->width == 0 || header->height == 0 ||
+      header->width > G_MAXINT || header->height > G_MAXINT ||
+      header->rowstride != _cogl_bitmap_cache_rowstride (header->format,
+                                                         header->width) ||
+      header->data_offset < sizeof (CoglBitmapCacheHeader) ||
+      length < header->data_offset +
+               (guint64) header->rowstride * header->height)
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+_cogl_bitmap_get_size_from_cache_file (const char *filename,
+                                       int        *width,
+                                       int        *height)
+{
+  CoglBitmapCacheHeader header;
+  struct stat stat_buf;
+  gchar *cache_filename;
+  gboolean ret = FALSE;
+  FILE *file;
+
+  cache_filename = g_strconcat (filename, COGL_BITMAP_CACHE_SUFFIX, NULL);
+  file = g_fopen (cache_filename, "rb");
+
+  if (file == NULL)
+    {
+      g_free (cache_filename);
+      return FALSE;
+    }
+
+  /* Only the header is read but it is checked against the size of
+     the whole file so that we don't report the size of an image
+     that can't be loaded */
+  if (fstat (fileno (file), &stat_buf) == 0 &&
+      fread (&header, sizeof (header), 1, file) == 1 &&
+      _cogl_bitmap_cache_header_is_valid (&header, filename,
+                                          stat_buf.st_size))
+    {
+      if (width)
+        *width = header.width;
+      if (height)
+        *height = header.height;
+
+      ret = TRUE;
+    }
+
+  fclose (file);
+
+  /* A cache file that doesn't match its image is left alone; it may
+     belong to another machine sharing the directory. It is replaced
+     the next time cogl_bitmap_write_cache_file() is called */
+  if (!ret)
+    COGL_NOTE (BITMAP, "Ignoring invalid bitmap cache file '%s'",
+               cache_filename);
+
+  g_free (cache_filename);
+
+  return ret;
+}
+
 gboolean
 cogl_bitmap_get_size_from_file (const char *filename,
                                 int        *width,
                                 int        *height)
 {
+  if (_cogl_bitmap_get_size_from_cache_file (filename, width, height))
+    return TRUE;
+
   return _cogl_bitmap_get_size_from_file (filename, width, height);
 }
 
@@ -250,6 +415,8 @@ _cogl_bitmap_new_from_data (guint8                  *data,
   bmp->bound = FALSE;
   bmp->shared_bmp = NULL;
   bmp->buffer = NULL;
+  bmp->mipmaps = NULL;
+  bmp->n_mipmaps = 0;
 
   return _cogl_bitmap_object_new (bmp);
 }
@@ -274,13 +441,74 @@ _cogl_bitmap_new_shared (CoglBitmap              *shared_bmp,
   return bmp;
 }
 
-CoglBitmap *
-cogl_bitmap_new_from_file (const char  *filename,
-                           GError     **error)
+static void
+_cogl_bitmap_unmap_cache_file (guint8 *data,
+                               void   *mapped_file)
 {
-  CoglBitmap *bmp;
+#if GLIB_CHECK_VERSION (2, 22, 0)
+  g_mapped_file_unref (mapped_file);
+#else
+  g_mapped_file_free (mapped_file);
+#endif
+}
 
-  g_return_val_if_fail (error == NULL || *error == NULL, COGL_INVALID_HANDLE);
+static CoglBitmap *
+_cogl_bitmap_from_cache_file (const char *filename)
+{
+  const CoglBitmapCacheHeader *header;
+  GMappedFile *mapped_file;
+  gchar *cache_filename;
+  guint8 *contents;
+
+  cache_filename = g_strconcat (filename, COGL_BITMAP_CACHE_SUFFIX, NULL);
+
+  /* The file is mapped read-only so that it can be shared with other
+     processes loading the same image; see _cogl_bitmap_is_read_only() */
+  mapped_file = g_mapped_file_new (cache_filename, FALSE, NULL);
+
+  if (mapped_file == NULL)
+    {
+      g_free (cache_filename);
+      return NULL;
+    }
+
+  contents = (guint8 *) g_mapped_file_get_contents (mapped_file);
+  header = (const CoglBitmapCacheHeader *) contents;
+
+  if (contents == NULL ||
+      !_cogl_bitmap_cache_header_is_valid (header, filename,
+                                           g_mapped_file_get_length
+                                                         (mapped_file)))
+    {
+      _cogl_bitmap_unmap_cache_file (NULL, mapped_file);
+      COGL_NOTE (BITMAP, "Ignoring invalid bitmap cache file '%s'",
+                 cache_filename);
+      g_free (cache_filename);
+      return NULL;
+    }
+
+  g_free (cache_filename);
+
+  return _cogl_bitmap_new_from_data (contents + header->data_offset,
+                                     header->format,
+                                     header->width,
+                                     header->height,
+                                     header->rowstride,
+                                     _cogl_bitmap_unmap_cache_file,
+                                     mapped_file);
+}
+
+gboolean
+_cogl_bitmap_is_read_only (CoglBitmap *bitmap)
+{
+  return bitmap->destroy_fn == _cogl_bitmap_unmap_cache_file;
+}
+
+static CoglBitmap *
+_cogl_bitmap_decode_file (const char  *filename,
+                          GError     **error)
+{
+  CoglBitmap *bmp;
 
   if ((bmp = _cogl_bitmap_from_file (filename, error)) == NULL)
     {
@@ -296,6 +524,366 @@ cogl_bitmap_new_from_file (const char  *filename,
   return bmp;
 }
 
+CoglBitmap *
+cogl_bitmap_new_from_file (const char  *filename,
+                           GError     **error)
+{
+  CoglBitmap *bmp;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, COGL_INVALID_HANDLE);
+
+  if ((bmp = _cogl_bitmap_from_cache_file (filename)))
+    return bmp;
+
+  return _cogl_bitmap_decode_file (filename, error);
+}
+
+gboolean
+cogl_bitmap_write_cache_file (const char  *filename,
+                              GError     **error)
+{
+  CoglBitmapCacheHeader header;
+  CoglBitmap *bmp, *converted;
+  struct stat stat_buf;
+  gchar *cache_filename, *contents;
+  gsize data_size;
+  guint8 *data;
+  guint row;
+  gboolean ret;
+
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (g_stat (filename, &stat_buf) != 0)
+    {
+      g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_FAILED,
+                   "Failed to stat '%s'", filename);
+      return FALSE;
+    }
+
+  if ((bmp = _cogl_bitmap_decode_file (filename, error)) == NULL)
+    return FALSE;
+
+  converted = cogl_bitmap_convert_for_upload (bmp, COGL_PIXEL_FORMAT_ANY);
+  cogl_object_unref (bmp);
+
+  if (converted == NULL)
+    {
+      g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_FAILED,
+                   "Failed to convert '%s'", filename);
+      return FALSE;
+    }
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, COGL_BITMAP_CACHE_MAGIC, sizeof (header.magic));
+  header.version = COGL_BITMAP_CACHE_VERSION;
+  header.format = converted->format;
+  header.width = converted->width;
+  header.height = converted->height;
+  header.rowstride = _cogl_bitmap_cache_rowstride (header.format,
+                                                   header.width);
+  header.data_offset = sizeof (header);
+  header.source_mtime = stat_buf.st_mtime;
+  header.source_size = stat_buf.st_size;
+
+  data_size = header.rowstride * header.height;
+  contents = g_malloc0 (header.data_offset + data_size);
+  memcpy (contents, &header, sizeof (header));
+
+  if ((data = _cogl_bitmap_map (converted, COGL_BUFFER_ACCESS_READ, 0)) == NULL)
+    {
+      g_free (contents);
+      cogl_object_unref (converted);
+      g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_FAILED,
+                   "Failed to map the bitmap for '%s'", filename);
+      return FALSE;
+    }
+
+  for (row = 0; row < header.height; row++)
+    memcpy (contents + header.data_offset + row * header.rowstride,
+            data + row * converted->rowstride,
+            header.width * _cogl_get_format_bpp (header.format));
+
+  _cogl_bitmap_unmap (converted);
+  cogl_object_unref (converted);
+
+  cache_filename = g_strconcat (filename, COGL_BITMAP_CACHE_SUFFIX, NULL);
+  ret = g_file_set_contents (cache_filename,
+                             contents,
+                             header.data_offset + data_size,
+                             error);
+  g_free (cache_filename);
+  g_free (contents);
+
+  return ret;
+}
+
+CoglBitmap *
+cogl_bitmap_convert_for_upload (CoglBitmap      *bitmap,
+                                CoglPixelFormat  internal_format)
+{
+  CoglPixelFormat src_format, dst_format;
+
+  g_return_val_if_fail (cogl_is_bitmap (bitmap), NULL);
+
+  src_format = _cogl_bitmap_get_format (bitmap);
+  dst_format = _cogl_texture_determine_internal_format (src_format,
+                                                        internal_format);
+
+#ifndef HAVE_COGL_GL
+  /* GLES can't convert the data while uploading it so the texture will
+     be created with the closest format supported by the driver; see
+     _cogl_texture_prepare_for_upload() */
+  dst_format = _cogl_pixel_format_to_gl (dst_format, NULL, NULL, NULL);
+#endif
+
+  if (dst_format == src_format)
+    return cogl_object_ref (bitmap);
+
+  return _cogl_bitmap_convert_format_and_premult (bitmap, dst_format);
+}
+
+/* Incremental decoding */
+
+/* Amount of the file read and decoded by each call to
+   cogl_bitmap_loader_load_more() */
+#define COGL_BITMAP_LOADER_CHUNK_SIZE (16 * 1024)
+/* Maximum size of the bitmaps returned by cogl_bitmap_loader_get_rows() */
+#define COGL_BITMAP_LOADER_ROWS_SIZE  (256 * 1024)
+
+static void _cogl_bitmap_loader_free (CoglBitmapLoader *loader);
+
+COGL_OBJECT_DEFINE (BitmapLoader, bitmap_loader);
+
+static void
+_cogl_bitmap_loader_free (CoglBitmapLoader *loader)
+{
+  if (loader->backend_data)
+    _cogl_bitmap_loader_backend_destroy (loader);
+
+  if (loader->file)
+    fclose (loader->file);
+
+  if (loader->bitmap)
+    cogl_object_unref (loader->bitmap);
+
+  g_free (loader->filename);
+
+  g_slice_free (CoglBitmapLoader, loader);
+}
+
+/* Used when the image is not decoded incrementally. Takes ownership
+   of @bmp */
+static void
+_cogl_bitmap_loader_set_bitmap (CoglBitmapLoader *loader,
+                                CoglBitmap       *bmp)
+{
+  loader->bitmap = bmp;
+  loader->dirty_start = 0;
+  loader->dirty_end = bmp->height;
+  loader->finished = TRUE;
+}
+
+void
+_cogl_bitmap_loader_update_rows (CoglBitmapLoader *loader,
+                                 int               first_row,
+                                 int               n_rows)
+{
+  if (loader->dirty_start >= loader->dirty_end)
+    {
+      loader->dirty_start = first_row;
+      loader->dirty_end = first_row + n_rows;
+    }
+  else
+    {
+      loader->dirty_start = MIN (loader->dirty_start, first_row);
+      loader->dirty_end = MAX (loader->dirty_end, first_row + n_rows);
+    }
+}
+
+CoglBitmapLoader *
+cogl_bitmap_loader_new (const char  *filename,
+                        GError     **error)
+{
+  CoglBitmapLoader *loader;
+  CoglBitmap *bmp;
+  FILE *file = NULL;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if ((bmp = _cogl_bitmap_from_cache_file (filename)) == NULL &&
+      (file = g_fopen (filename, "rb")) == NULL)
+    {
+      g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_FAILED,
+                   "%s", g_strerror (errno));
+      return NULL;
+    }
+
+  loader = g_slice_new0 (CoglBitmapLoader);
+  loader->filename = g_strdup (filename);
+  loader->file = file;
+
+  if (bmp)
+    _cogl_bitmap_loader_set_bitmap (loader, bmp);
+  else
+    _cogl_bitmap_loader_backend_init (loader);
+
+  return _cogl_bitmap_loader_object_new (loader);
+}
+
+gboolean
+cogl_bitmap_loader_load_more (CoglBitmapLoader  *loader,
+                              GError           **error)
+{
+  guint8 buffer[COGL_BITMAP_LOADER_CHUNK_SIZE];
+  gsize count;
+
+  g_return_val_if_fail (cogl_is_bitmap_loader (loader), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (loader->finished)
+    return TRUE;
+
+  /* The image backend can't decode incrementally so the whole image
+     is decoded in one go */
+  if (loader->backend_data == NULL)
+    {
+      CoglBitmap *bmp;
+
+      fclose (loader->file);
+      loader->file = NULL;
+      loader->finished = TRUE;
+
+      if ((bmp = _cogl_bitmap_decode_file (loader->filename, error)) == NULL)
+        return FALSE;
+
+      _cogl_bitmap_loader_set_bitmap (loader, bmp);
+
+      return TRUE;
+    }
+
+  count = fread (buffer, 1, sizeof (buffer), loader->file);
+
+  if (count > 0 &&
+      !_cogl_bitmap_loader_backend_write (loader, buffer, count, error))
+    {
+      loader->finished = TRUE;
+      return FALSE;
+    }
+
+  if (count < sizeof (buffer))
+    {
+      loader->finished = TRUE;
+
+      if (ferror (loader->file))
+        {
+          g_set_error (error, COGL_BITMAP_ERROR, COGL_BITMAP_ERROR_FAILED,
+                       "Failed to read '%s'", loader->filename);
+          return FALSE;
+        }
+
+      if (!_cogl_bitmap_loader_backend_close (loader, error))
+        return FALSE;
+
+      if (loader->bitmap == NULL)
+        {
+          g_set_error (error, COGL_BITMAP_ERROR,
+                       COGL_BITMAP_ERROR_CORRUPT_IMAGE,
+                       "Image has zero width or height");
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+gboolean
+cogl_bitmap_loader_is_finished (CoglBitmapLoader *loader)
+{
+  g_return_val_if_fail (cogl_is_bitmap_loader (loader), TRUE);
+
+  return loader->finished;
+}
+
+gboolean
+cogl_bitmap_loader_get_size (CoglBitmapLoader *loader,
+                             int              *width,
+                             int              *height)
+{
+  g_return_val_if_fail (cogl_is_bitmap_loader (loader), FALSE);
+
+  if (loader->bitmap == NULL)
+    return FALSE;
+
+  if (width)
+    *width = loader->bitmap->width;
+  if (height)
+    *height = loader->bitmap->height;
+
+  return TRUE;
+}
+
+CoglBitmap *
+cogl_bitmap_loader_get_bitmap (CoglBitmapLoader *loader)
+{
+  g_return_val_if_fail (cogl_is_bitmap_loader (loader), NULL);
+
+  if (!loader->finished || loader->bitmap == NULL)
+    return NULL;
+
+  return cogl_object_ref (loader->bitmap);
+}
+
+CoglBitmap *
+cogl_bitmap_loader_get_rows (CoglBitmapLoader *loader,
+                             int              *first_row)
+{
+  CoglBitmap *src_bmp;
+  guint8 *src_data, *dst_data;
+  int bpp, width, dst_rowstride, n_rows, y;
+
+  g_return_val_if_fail (cogl_is_bitmap_loader (loader), NULL);
+
+  src_bmp = loader->bitmap;
+
+  if (src_bmp == NULL || loader->dirty_start >= loader->dirty_end)
+    return NULL;
+
+  bpp = _cogl_get_format_bpp (src_bmp->format);
+  width = src_bmp->width;
+  /* Pack the rows but keep them aligned to 4 bytes */
+  dst_rowstride = (width * bpp + 3) & ~3;
+
+  n_rows = MAX (1, COGL_BITMAP_LOADER_ROWS_SIZE / dst_rowstride);
+  n_rows = MIN (n_rows, loader->dirty_end - loader->dirty_start);
+
+  if ((src_data = _cogl_bitmap_map (src_bmp, COGL_BUFFER_ACCESS_READ, 0))
+      == NULL)
+    return NULL;
+
+  dst_data = g_malloc (n_rows * dst_rowstride);
+
+  for (y = 0; y < n_rows; y++)
+    memcpy (dst_data + y * dst_rowstride,
+            src_data + (loader->dirty_start + y) * src_bmp->rowstride,
+            width * bpp);
+
+  _cogl_bitmap_unmap (src_bmp);
+
+  if (first_row)
+    *first_row = loader->dirty_start;
+
+  loader->dirty_start += n_rows;
+
+  return _cogl_bitmap_new_from_data (dst_data,
+                                     src_bmp->format,
+                                     width,
+                                     n_rows,
+                                     dst_rowstride,
+                                     (CoglBitmapDestroyNotify) g_free,
+                                     NULL);
+}
+
 CoglBitmap *
 _cogl_bitmap_new_from_buffer (CoglBuffer      *buffer,
                               CoglPixelFormat  format,
@@ -328,6 +916,30 @@ _cogl_bitmap_get_format (CoglBitmap *bitmap)
   return bitmap->format;
 }
 
+CoglPixelFormat
+cogl_bitmap_get_format (CoglBitmap *bitmap)
+{
+  g_return_val_if_fail (cogl_is_bitmap (bitmap), COGL_PIXEL_FORMAT_ANY);
+
+  return bitmap->format;
+}
+
+int
+cogl_bitmap_get_width (CoglBitmap *bitmap)
+{
+  g_return_val_if_fail (cogl_is_bitmap (bitmap), 0);
+
+  return bitmap->width;
+}
+
+int
+cogl_bitmap_get_height (CoglBitmap *bitmap)
+{
+  g_return_val_if_fail (cogl_is_bitmap (bitmap), 0);
+
+  return bitmap->height;
+}
+
 void
 _cogl_bitmap_set_format (CoglBitmap *bitmap,
                          CoglPixelFormat format)
@@ -353,6 +965,36 @@ _cogl_bitmap_get_height (CoglBitmap *bitmap)
   return bitmap->height;
 }
 
+void
+_cogl_bitmap_set_mipmaps (CoglBitmap  *bitmap,
+                          CoglBitmap **mipmaps,
+                          int          n_mipmaps)
+{
+  int i;
+
+  for (i = 0; i < bitmap->n_mipmaps; i++)
+    cogl_object_unref (bitmap->mipmaps[i]);
+  g_free (bitmap->mipmaps);
+
+  bitmap->mipmaps = mipmaps;
+  bitmap->n_mipmaps = n_mipmaps;
+}
+
+int
+_cogl_bitmap_get_n_mipmaps (CoglBitmap *bitmap)
+{
+  return bitmap->n_mipmaps;
+}
+
+CoglBitmap *
+_cogl_bitmap_get_mipmap (CoglBitmap *bitmap,
+                         int         level)
+{
+  g_return_val_if_fail (level >= 1 && level <= bitmap->n_mipmaps, NULL);
+
+  return bitmap->mipmaps[level - 1];
+}
+
 int
 _cogl_bitmap_get_rowstride (CoglBitmap *bitmap)
 {
@@ -33,6 +33,7 @@
 G_BEGIN_DECLS
 
 typedef struct _CoglBitmap CoglBitmap;
+typedef struct _CoglBitmapLoader CoglBitmapLoader;
 
 /**
  * SECTION:cogl-bitmap
@@ -53,6 +54,11 @@ typedef struct _CoglBitmap CoglBitmap;
  * Loads an image file from disk. This function can be safely called from
  * within a thread.
  *
+ * If an up to date cache file written by cogl_bitmap_write_cache_file()
+ * exists next to @filename, its pre-decoded data is mapped into memory
+ * instead. A cache file that is out of date or doesn't look valid is
+ * ignored and the image is decoded as normal.
+ *
  * Return value: a #CoglBitmap to the new loaded image data, or
  *   %NULL if loading the image failed.
  *
@@ -80,6 +86,263 @@ cogl_bitmap_get_size_from_file (const char *filename,
                                 int *width,
                                 int *height);
 
+/**
+ * cogl_bitmap_get_format:
+ * @bitmap: a #CoglBitmap
+ *
+ * Return value: the #CoglPixelFormat that the data for the bitmap is
+ *   stored in
+ *
+ * Since: 1.4
+ */
+CoglPixelFormat
+cogl_bitmap_get_format (CoglBitmap *bitmap);
+
+/**
+ * cogl_bitmap_get_width:
+ * @bitmap: a #CoglBitmap
+ *
+ * Return value: the width of the bitmap, in pixels
+ *
+ * Since: 1.4
+ */
+int
+cogl_bitmap_get_width (CoglBitmap *bitmap);
+
+/**
+ * cogl_bitmap_get_height:
+ * @bitmap: a #CoglBitmap
+ *
+ * Return value: the height of the bitmap, in pixels
+ *
+ * Since: 1.4
+ */
+int
+cogl_bitmap_get_height (CoglBitmap *bitmap);
+
+/**
+ * cogl_bitmap_convert_for_upload:
+ * @bitmap: a #CoglBitmap
+ * @internal_format: the format of the texture that will be created
+ *   from the bitmap, or %COGL_PIXEL_FORMAT_ANY
+ *
+ * Converts @bitmap to the pixel format that a texture created from it
+ * with cogl_texture_new_from_bitmap() using @internal_format will
+ * store, premultiplying the data if needed. Creating the texture from
+ * the returned bitmap will then only need to copy the data to the
+ * GPU.
+ *
+ * This function does not use the GL context so it can be safely
+ * called from within a thread, for instance after loading a bitmap
+ * with cogl_bitmap_new_from_file().
+ *
+ * Return value: a new reference to @bitmap if it is already in the
+ *   right format, a newly created #CoglBitmap with the converted data
+ *   or %NULL if the conversion failed
+ *
+ * Since: 1.4
+ */
+CoglBitmap *
+cogl_bitmap_convert_for_upload (CoglBitmap      *bitmap,
+                                CoglPixelFormat  internal_format);
+
+/**
+ * cogl_bitmap_write_cache_file:
+ * @filename: the image file to create a cache file for
+ * @error: a #GError or %NULL
+ *
+ * Decodes the image in @filename, converts it to the format that
+ * cogl_texture_new_from_file() would store it in with
+ * %COGL_PIXEL_FORMAT_ANY and writes the result to a cache file next to
+ * @filename, named after it with a ".cogl-bitmap" suffix.
+ *
+ * As long as @filename is not modified, cogl_bitmap_new_from_file()
+ * will then map the cache file instead of decoding the image again, so
+ * the texture can be created without any decoding or conversion.
+ * Cache files are specific to the byte order of the machine writing
+ * them and are ignored on other machines.
+ *
+ * This function does not use the GL context.
+ *
+ * Return value: %TRUE if the cache file was written, %FALSE otherwise
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_bitmap_write_cache_file (const char  *filename,
+                              GError     **error);
+
+/**
+ * cogl_bitmap_loader_new:
+ * @filename: the file to load
+ * @error: a #GError or %NULL
+ *
+ * Opens @filename to decode it incrementally with
+ * cogl_bitmap_loader_load_more(). The rows of the image can be
+ * retrieved with cogl_bitmap_loader_get_rows() as soon as they are
+ * decoded, which lets a texture show a large image before all of it
+ * has been decoded. Interlaced and progressive images are decoded in
+ * several passes, each updating all of the rows of the image.
+ *
+ * If the image backend can't decode the image incrementally then it
+ * is decoded in one go. If there is a cache file for @filename, see
+ * cogl_bitmap_write_cache_file(), the loader maps it instead and all
+ * of the rows are available straight away.
+ *
+ * This function and the other loader functions do not use the GL
+ * context so the image can be decoded within a thread. The loader
+ * must be freed with cogl_object_unref().
+ *
+ * Return value: a new #CoglBitmapLoader or %NULL if @filename can't
+ *   be opened
+ *
+ * Since: 1.4
+ */
+CoglBitmapLoader *
+cogl_bitmap_loader_new (const char  *filename,
+                        GError     **error);
+
+/**
+ * cogl_bitmap_loader_load_more:
+ * @loader: a #CoglBitmapLoader
+ * @error: a #GError or %NULL
+ *
+ * Reads and decodes the next part of the file of @loader. This
+ * should be called until cogl_bitmap_loader_is_finished() returns
+ * %TRUE.
+ *
+ * Return value: %FALSE if the image could not be decoded
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_bitmap_loader_load_more (CoglBitmapLoader  *loader,
+                              GError           **error);
+
+/**
+ * cogl_bitmap_loader_is_finished:
+ * @loader: a #CoglBitmapLoader
+ *
+ * Return value: %TRUE if all of the file of @loader has been decoded
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_bitmap_loader_is_finished (CoglBitmapLoader *loader);
+
+/**
+ * cogl_bitmap_loader_get_size:
+ * @loader: a #CoglBitmapLoader
+ * @width: (out): return location for the width of the image, or %NULL
+ * @height: (out): return location for the height of the image, or %NULL
+ *
+ * Retrieves the size of the image being decoded by @loader, which is
+ * known once enough of the file has been decoded.
+ *
+ * Return value: %TRUE if the size of the image is known
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_bitmap_loader_get_size (CoglBitmapLoader *loader,
+                             int              *width,
+                             int              *height);
+
+/**
+ * cogl_bitmap_loader_get_rows:
+ * @loader: a #CoglBitmapLoader
+ * @first_row: (out): return location for the row of the image
+ *   where the returned bitmap starts
+ *
+ * Copies rows of the image decoded since the last call to this
+ * function into a new bitmap with the width of the image. At most
+ * about 256KB of rows are returned at once so this should be called
+ * until it returns %NULL. Only the rows are copied so the caller only
+ * needs memory for the strip of the image it is working on; it can
+ * be converted with cogl_bitmap_convert_for_upload() and uploaded
+ * with cogl_texture_set_region_from_bitmap().
+ *
+ * Return value: a new #CoglBitmap or %NULL if there are no decoded
+ *   rows left to return
+ *
+ * Since: 1.4
+ */
+CoglBitmap *
+cogl_bitmap_loader_get_rows (CoglBitmapLoader *loader,
+                             int              *first_row);
+
+/**
+ * cogl_bitmap_loader_get_bitmap:
+ * @loader: a #CoglBitmapLoader
+ *
+ * Retrieves the whole image decoded by @loader. This can only be
+ * done once cogl_bitmap_loader_is_finished() returns %TRUE.
+ *
+ * Return value: a new reference to the decoded #CoglBitmap or %NULL
+ *   if @loader hasn't finished
+ *
+ * Since: 1.4
+ */
+CoglBitmap *
+cogl_bitmap_loader_get_bitmap (CoglBitmapLoader *loader);
+
+/**
+ * cogl_is_bitmap_loader:
+ * @handle: a #CoglHandle
+ *
+ * Checks whether @handle is a #CoglBitmapLoader
+ *
+ * Return value: %TRUE if the passed handle represents a bitmap
+ *   loader, and %FALSE otherwise
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_is_bitmap_loader (CoglHandle handle);
+
+/**
+ * CoglBitmapFilter:
+ * @COGL_BITMAP_FILTER_BOX: Averages each 2x2 block of pixels. This
+ *   is fast but the smaller levels can look blurry or aliased.
+ * @COGL_BITMAP_FILTER_LANCZOS: Uses a 2-lobe Lanczos filter. This is
+ *   slower but keeps the smaller levels sharper.
+ *
+ * The filter used by cogl_bitmap_generate_mipmaps() to compute each
+ * level from the previous one.
+ *
+ * Since: 1.4
+ */
+typedef enum {
+  COGL_BITMAP_FILTER_BOX,
+  COGL_BITMAP_FILTER_LANCZOS
+} CoglBitmapFilter;
+
+/**
+ * cogl_bitmap_generate_mipmaps:
+ * @bitmap: a #CoglBitmap
+ * @filter: the #CoglBitmapFilter to use
+ *
+ * Computes all of the mipmap levels of @bitmap down to 1x1 and
+ * attaches them to the bitmap. A texture created from @bitmap with
+ * cogl_texture_new_from_bitmap() or given the levels with
+ * cogl_texture_set_mipmaps_from_bitmap() will then use these levels
+ * instead of generating them with the GPU.
+ *
+ * Only formats with 8 bits per component are supported. The levels
+ * of formats with an alpha channel are stored premultiplied.
+ *
+ * This function does not use the GL context so it can be called
+ * from a thread.
+ *
+ * Return value: %TRUE if the levels were generated, or %FALSE if
+ *   the format of @bitmap is not supported
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_bitmap_generate_mipmaps (CoglBitmap       *bitmap,
+                              CoglBitmapFilter  filter);
+
 /**
  * cogl_is_bitmap:
  * @handle: a #CoglHandle for a bitmap
@@ -44,6 +44,7 @@
 #include "cogl-context.h"
 #include "cogl-handle.h"
 #include "cogl-pixel-array-private.h"
+#include "cogl-gl-state-private.h"
 
 /*
  * GL/GLES compatibility defines for the buffer API:
@@ -52,7 +53,6 @@
 #if defined (HAVE_COGL_GL)
 
 #define glGenBuffers ctx->drv.pf_glGenBuffers
-#define glBindBuffer ctx->drv.pf_glBindBuffer
 #define glBufferData ctx->drv.pf_glBufferData
 #define glBufferSubData ctx->drv.pf_glBufferSubData
 #define glGetBufferSubData ctx->drv.pf_glGetBufferSubData
@@ -372,7 +372,7 @@ _cogl_buffer_bind (CoglBuffer *buffer, CoglBufferBindTarget target)
   if (COGL_BUFFER_FLAG_IS_SET (buffer, BUFFER_OBJECT))
     {
       GLenum gl_target = convert_bind_target_to_gl_target (buffer->last_target);
-      GE( glBindBuffer (gl_target, buffer->gl_handle) );
+      _cogl_gl_state_bind_buffer (gl_target, buffer->gl_handle);
     }
 
   ctx->current_buffer[target] = buffer;
@@ -391,7 +391,7 @@ _cogl_buffer_unbind (CoglBuffer *buffer)
   if (COGL_BUFFER_FLAG_IS_SET (buffer, BUFFER_OBJECT))
     {
       GLenum gl_target = convert_bind_target_to_gl_target (buffer->last_target);
-      GE( glBindBuffer (gl_target, 0) );
+      _cogl_gl_state_bind_buffer (gl_target, 0);
     }
 
   ctx->current_buffer[buffer->last_target] = NULL;
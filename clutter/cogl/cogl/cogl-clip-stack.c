@@ -40,6 +40,7 @@
 #include "cogl-util.h"
 #include "cogl-path-private.h"
 #include "cogl-matrix-private.h"
+#include "cogl-gl-state-private.h"
 
 typedef struct _CoglClipStackEntry CoglClipStackEntry;
 typedef struct _CoglClipStackEntryRect CoglClipStackEntryRect;
@@ -98,6 +99,13 @@ struct _CoglClipStack
   CoglObject _parent;
 
   CoglClipStackEntry *stack_top;
+
+  /* The result of _cogl_clip_stack_get_scissor() is cached until an
+     entry is pushed or popped. The journal asks for it every time a
+     quad is logged while it is clipping in software */
+  gboolean            scissor_valid;
+  gboolean            scissor_only;
+  int                 scissor[4];
 };
 
 struct _CoglClipStackEntry
@@ -315,15 +323,15 @@ add_stencil_clip_rectangle (float x_1,
 
   if (first)
     {
-      GE( glEnable (GL_STENCIL_TEST) );
+      _cogl_gl_state_set_enabled (GL_STENCIL_TEST, TRUE);
 
       /* Initially disallow everything */
       GE( glClearStencil (0) );
       GE( glClear (GL_STENCIL_BUFFER_BIT) );
 
       /* Punch out a hole to allow the rectangle */
-      GE( glStencilFunc (GL_NEVER, 0x1, 0x1) );
-      GE( glStencilOp (GL_REPLACE, GL_REPLACE, GL_REPLACE) );
+      _cogl_gl_state_stencil_func (GL_NEVER, 0x1, 0x1);
+      _cogl_gl_state_stencil_op (GL_REPLACE, GL_REPLACE, GL_REPLACE);
 
       cogl_rectangle (x_1, y_1, x_2, y_2);
     }
@@ -336,8 +344,8 @@ add_stencil_clip_rectangle (float x_1,
 
       /* Add one to every pixel of the stencil buffer in the
 	 rectangle */
-      GE( glStencilFunc (GL_NEVER, 0x1, 0x3) );
-      GE( glStencilOp (GL_INCR, GL_INCR, GL_INCR) );
+      _cogl_gl_state_stencil_func (GL_NEVER, 0x1, 0x3);
+      _cogl_gl_state_stencil_op (GL_INCR, GL_INCR, GL_INCR);
       cogl_rectangle (x_1, y_1, x_2, y_2);
 
       /* make sure our rectangle hits the stencil buffer before we
@@ -347,7 +355,7 @@ add_stencil_clip_rectangle (float x_1,
       /* Subtract one from all pixels in the stencil buffer so that
 	 only pixels where both the original stencil buffer and the
 	 rectangle are set will be valid */
-      GE( glStencilOp (GL_DECR, GL_DECR, GL_DECR) );
+      _cogl_gl_state_stencil_op (GL_DECR, GL_DECR, GL_DECR);
 
       _cogl_matrix_stack_push (projection_stack);
       _cogl_matrix_stack_load_identity (projection_stack);
@@ -366,8 +374,8 @@ add_stencil_clip_rectangle (float x_1,
   _cogl_journal_flush ();
 
   /* Restore the stencil mode */
-  GE( glStencilFunc (GL_EQUAL, 0x1, 0x1) );
-  GE( glStencilOp (GL_KEEP, GL_KEEP, GL_KEEP) );
+  _cogl_gl_state_stencil_func (GL_EQUAL, 0x1, 0x1);
+  _cogl_gl_state_stencil_op (GL_KEEP, GL_KEEP, GL_KEEP);
 
   /* restore the original source material */
   cogl_set_source (current_source);
@@ -377,25 +385,25 @@ add_stencil_clip_rectangle (float x_1,
 static void
 disable_stencil_buffer (void)
 {
-  GE( glDisable (GL_STENCIL_TEST) );
+  _cogl_gl_state_set_enabled (GL_STENCIL_TEST, FALSE);
 }
 
 static void
 enable_clip_planes (void)
 {
-  GE( glEnable (GL_CLIP_PLANE0) );
-  GE( glEnable (GL_CLIP_PLANE1) );
-  GE( glEnable (GL_CLIP_PLANE2) );
-  GE( glEnable (GL_CLIP_PLANE3) );
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE0, TRUE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE1, TRUE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE2, TRUE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE3, TRUE);
 }
 
 static void
 disable_clip_planes (void)
 {
-  GE( glDisable (GL_CLIP_PLANE3) );
-  GE( glDisable (GL_CLIP_PLANE2) );
-  GE( glDisable (GL_CLIP_PLANE1) );
-  GE( glDisable (GL_CLIP_PLANE0) );
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE3, FALSE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE2, FALSE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE1, FALSE);
+  _cogl_gl_state_set_enabled (GL_CLIP_PLANE0, FALSE);
 }
 
 static gpointer
@@ -411,6 +419,7 @@ _cogl_clip_stack_push_entry (CoglClipStack *clip_stack,
   entry->type = type;
   entry->parent = clip_stack->stack_top;
   clip_stack->stack_top = entry;
+  clip_stack->scissor_valid = FALSE;
 
   /* We don't need to take a reference to the parent from the entry
      because the clip_stack would have had to reference the top of
@@ -580,6 +589,7 @@ _cogl_clip_stack_pop (CoglClipStack *stack)
      parent. */
   entry = stack->stack_top;
   stack->stack_top = entry->parent;
+  stack->scissor_valid = FALSE;
   if (stack->stack_top)
     stack->stack_top->ref_count++;
   _cogl_clip_stack_entry_unref (entry);
@@ -611,7 +621,7 @@ _cogl_clip_stack_flush (CoglClipStack *stack,
   if (stack->stack_top == NULL)
     {
       *stencil_used_p = FALSE;
-      GE (glDisable (GL_SCISSOR_TEST));
+      _cogl_gl_state_set_enabled (GL_SCISSOR_TEST, FALSE);
       return;
     }
 
@@ -655,10 +665,10 @@ _cogl_clip_stack_flush (CoglClipStack *stack,
         }
     }
 
-  GE (glEnable (GL_SCISSOR_TEST));
-  GE (glScissor (scissor_x0, scissor_y_start,
-                 scissor_x1 - scissor_x0,
-                 scissor_y1 - scissor_y0));
+  _cogl_gl_state_set_enabled (GL_SCISSOR_TEST, TRUE);
+  _cogl_gl_state_scissor (scissor_x0, scissor_y_start,
+                          scissor_x1 - scissor_x0,
+                          scissor_y1 - scissor_y0);
 
   /* Add all of the entries. This will end up adding them in the
      reverse order that they were specified but as all of the clips
@@ -725,6 +735,111 @@ _cogl_clip_stack_flush (CoglClipStack *stack,
   *stencil_used_p = using_stencil_buffer;
 }
 
+gboolean
+_cogl_clip_stack_get_scissor (CoglClipStack *stack,
+                              int *x0,
+                              int *y0,
+                              int *x1,
+                              int *y1)
+{
+  CoglClipStackEntry *entry;
+
+  if (!stack->scissor_valid)
+    {
+      int *box = stack->scissor;
+
+      box[0] = 0;
+      box[1] = 0;
+      box[2] = G_MAXINT;
+      box[3] = G_MAXINT;
+      stack->scissor_only = TRUE;
+
+      for (entry = stack->stack_top; entry; entry = entry->parent)
+        {
+          if (entry->type != COGL_CLIP_STACK_WINDOW_RECT)
+            {
+              stack->scissor_only = FALSE;
+              break;
+            }
+
+          box[0] = MAX (box[0], entry->bounds_x0);
+          box[1] = MAX (box[1], entry->bounds_y0);
+          box[2] = MIN (box[2], entry->bounds_x1);
+          box[3] = MIN (box[3], entry->bounds_y1);
+        }
+
+      stack->scissor_valid = TRUE;
+    }
+
+  *x0 = stack->scissor[0];
+  *y0 = stack->scissor[1];
+  *x1 = stack->scissor[2];
+  *y1 = stack->scissor[3];
+
+  return stack->scissor_only;
+}
+
+gboolean
+_cogl_clip_stack_equal (CoglClipStack *stack0,
+                        CoglClipStack *stack1)
+{
+  CoglClipStackEntry *entry0, *entry1;
+  int box0[4], box1[4];
+
+  /* Stacks that only contain window rectangles are equal if they
+     result in the same scissor, regardless of how it was built */
+  if (_cogl_clip_stack_get_scissor (stack0,
+                                    box0, box0 + 1, box0 + 2, box0 + 3) &&
+      _cogl_clip_stack_get_scissor (stack1,
+                                    box1, box1 + 1, box1 + 2, box1 + 3))
+    return memcmp (box0, box1, sizeof (box0)) == 0;
+
+  for (entry0 = stack0->stack_top, entry1 = stack1->stack_top;
+       entry0 && entry1;
+       entry0 = entry0->parent, entry1 = entry1->parent)
+    {
+      /* The entries are immutable so if both stacks share an entry
+         then the rest of the stacks are the same too */
+      if (entry0 == entry1)
+        return TRUE;
+
+      if (entry0->type != entry1->type)
+        return FALSE;
+
+      switch (entry0->type)
+        {
+        case COGL_CLIP_STACK_WINDOW_RECT:
+          if (entry0->bounds_x0 != entry1->bounds_x0 ||
+              entry0->bounds_y0 != entry1->bounds_y0 ||
+              entry0->bounds_x1 != entry1->bounds_x1 ||
+              entry0->bounds_y1 != entry1->bounds_y1)
+            return FALSE;
+          break;
+
+        case COGL_CLIP_STACK_RECT:
+          {
+            CoglClipStackEntryRect *rect0 = (CoglClipStackEntryRect *) entry0;
+            CoglClipStackEntryRect *rect1 = (CoglClipStackEntryRect *) entry1;
+
+            if (rect0->x0 != rect1->x0 ||
+                rect0->y0 != rect1->y0 ||
+                rect0->x1 != rect1->x1 ||
+                rect0->y1 != rect1->y1 ||
+                !cogl_matrix_equal (&rect0->matrix, &rect1->matrix))
+              return FALSE;
+          }
+          break;
+
+        case COGL_CLIP_STACK_PATH:
+          /* Paths are copied when they are pushed so there's no cheap
+             way to compare them */
+          return FALSE;
+        }
+    }
+
+  return entry0 == entry1;
+}
+
 CoglClipStack *
 _cogl_clip_stack_new (void)
 {
@@ -732,6 +847,7 @@ _cogl_clip_stack_new (void)
 
   stack = g_slice_new (CoglClipStack);
   stack->stack_top = NULL;
+  stack->scissor_valid = FALSE;
 
   return _cogl_clip_stack_object_new (stack);
 }
@@ -766,5 +882,9 @@ _cogl_clip_stack_copy (CoglClipStack *old_stack)
   if (new_stack->stack_top)
     new_stack->stack_top->ref_count++;
 
+  new_stack->scissor_valid = old_stack->scissor_valid;
+  new_stack->scissor_only = old_stack->scissor_only;
+  memcpy (new_stack->scissor, old_stack->scissor, sizeof (old_stack->scissor));
+
   return new_stack;
 }
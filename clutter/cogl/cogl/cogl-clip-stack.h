@@ -55,6 +55,44 @@ void
 _cogl_clip_stack_flush (CoglClipStack *stack,
                         gboolean *stencil_used_p);
 
+/*
+ * _cogl_clip_stack_get_scissor:
+ * @stack: A #CoglClipStack
+ * @x0: return location for the left edge of the scissor
+ * @y0: return location for the top edge of the scissor
+ * @x1: return location for the right edge of the scissor
+ * @y1: return location for the bottom edge of the scissor
+ *
+ * Gets the intersection of all of the window rectangles in @stack in
+ * Cogl's window coordinates. An empty stack results in an unbounded
+ * rectangle.
+ *
+ * Return value: %TRUE if the stack only contains window rectangles
+ *   so that the scissor is all that is needed to clip, %FALSE
+ *   otherwise in which case the returned rectangle is undefined
+ */
+gboolean
+_cogl_clip_stack_get_scissor (CoglClipStack *stack,
+                              int *x0,
+                              int *y0,
+                              int *x1,
+                              int *y1);
+
+/*
+ * _cogl_clip_stack_equal:
+ * @stack0: A #CoglClipStack
+ * @stack1: Another #CoglClipStack
+ *
+ * Checks whether flushing the two stacks would result in the same
+ * clip. This can return %FALSE for equivalent stacks if comparing
+ * them would be too expensive.
+ *
+ * Return value: %TRUE if the stacks clip the same area
+ */
+gboolean
+_cogl_clip_stack_equal (CoglClipStack *stack0,
+                        CoglClipStack *stack1);
+
 
 /* TODO: we may want to make this function public because it can be
  * used to implement a better API than cogl_clip_stack_save() and
@@ -52,10 +52,6 @@ cogl_clip_push_window_rectangle (int x_offset,
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   framebuffer = _cogl_get_framebuffer ();
   clip_state = _cogl_framebuffer_get_clip_state (framebuffer);
 
@@ -88,37 +84,39 @@ try_pushing_rect_as_window_rect (float x_1,
   CoglMatrix matrix;
   CoglMatrix matrix_p;
   float v[4];
+  float verts[4 * 2] = { x_1, y_1, x_2, y_1, x_2, y_2, x_1, y_2 };
+  int i;
 
   cogl_get_modelview_matrix (&matrix);
-
-  /* If the modelview meets these constraints then a transformed rectangle
-   * should still be a rectangle when it reaches screen coordinates.
-   *
-   * FIXME: we are are making certain assumptions about the projection
-   * matrix a.t.m and should really be looking at the combined modelview
-   * and projection matrix.
-   * FIXME: we don't consider rotations that are a multiple of 90 degrees
-   * which could be quite common.
-   */
-  if (matrix.xy != 0 || matrix.xz != 0 ||
-      matrix.yx != 0 || matrix.yz != 0 ||
-      matrix.zx != 0 || matrix.zy != 0)
-    return FALSE;
-
   cogl_get_projection_matrix (&matrix_p);
   cogl_get_viewport (v);
 
-  _cogl_transform_point (&matrix, &matrix_p, v, &x_1, &y_1);
-  _cogl_transform_point (&matrix, &matrix_p, v, &x_2, &y_2);
+  /* Project all four corners with the combined modelview and
+   * projection matrix. If they still form a rectangle aligned to the
+   * window then the scissor is all that's needed. This also catches
+   * rotations that are a multiple of 90 degrees. */
+  for (i = 0; i < 4; i++)
+    _cogl_transform_point (&matrix, &matrix_p, v,
+                           verts + i * 2, verts + i * 2 + 1);
+
+  if (!(/* the first edge is horizontal */
+        (COGL_UTIL_WINDOW_ALIGNED (verts[1], verts[3]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[2], verts[4]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[5], verts[7]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[6], verts[0])) ||
+        /* the first edge is vertical */
+        (COGL_UTIL_WINDOW_ALIGNED (verts[0], verts[2]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[3], verts[5]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[4], verts[6]) &&
+         COGL_UTIL_WINDOW_ALIGNED (verts[7], verts[1]))))
+    return FALSE;
 
-  /* Consider that the modelview matrix may flip the rectangle
-   * along the x or y axis... */
-#define SWAP(A,B) do { float tmp = B; B = A; A = tmp; } while (0)
-  if (x_1 > x_2)
-    SWAP (x_1, x_2);
-  if (y_1 > y_2)
-    SWAP (y_1, y_2);
-#undef SWAP
+  /* Consider that the transformation may flip the rectangle along
+   * the x or y axis... */
+  x_1 = MIN (verts[0], verts[4]);
+  x_2 = MAX (verts[0], verts[4]);
+  y_1 = MIN (verts[1], verts[5]);
+  y_2 = MAX (verts[1], verts[5]);
 
   cogl_clip_push_window_rectangle (COGL_UTIL_NEARBYINT (x_1),
                                    COGL_UTIL_NEARBYINT (y_1),
@@ -140,10 +138,6 @@ cogl_clip_push_rectangle (float x_1,
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   /* Try and catch window space rectangles so we can redirect to
    * cogl_clip_push_window_rect which will use scissoring. */
   if (try_pushing_rect_as_window_rect (x_1, y_1, x_2, y_2))
@@ -185,10 +179,6 @@ cogl_clip_push_from_path_preserve (void)
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   framebuffer = _cogl_get_framebuffer ();
   clip_state = _cogl_framebuffer_get_clip_state (framebuffer);
 
@@ -215,10 +205,6 @@ _cogl_clip_pop_real (CoglClipState *clip_state)
 {
   CoglHandle stack;
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   stack = clip_state->stacks->data;
 
   _cogl_clip_stack_pop (stack);
@@ -240,6 +226,16 @@ cogl_clip_pop (void)
   _cogl_clip_pop_real (clip_state);
 }
 
+static void
+_cogl_clip_state_set_flushed_stack (CoglClipState *clip_state,
+                                    CoglHandle stack)
+{
+  if (clip_state->flushed_stack)
+    cogl_handle_unref (clip_state->flushed_stack);
+
+  clip_state->flushed_stack = stack;
+}
+
 void
 _cogl_clip_state_flush (CoglClipState *clip_state)
 {
@@ -248,6 +244,19 @@ _cogl_clip_state_flush (CoglClipState *clip_state)
   if (!clip_state->stack_dirty)
     return;
 
+  stack = clip_state->stacks->data;
+
+  /* Pushing and popping the clip stack doesn't flush the journal so
+   * if the stack ends up the same as what GL already has, for example
+   * because sibling actors clip to the same box, then there's nothing
+   * to do and the journal can keep batching */
+  if (clip_state->flushed_stack &&
+      _cogl_clip_stack_equal (stack, clip_state->flushed_stack))
+    {
+      clip_state->stack_dirty = FALSE;
+      return;
+    }
+
   /* The current primitive journal does not support tracking changes to the
    * clip stack...  */
   _cogl_journal_flush ();
@@ -259,9 +268,22 @@ _cogl_clip_state_flush (CoglClipState *clip_state)
    */
   clip_state->stack_dirty = FALSE;
 
-  stack = clip_state->stacks->data;
+  _cogl_clip_stack_flush (stack, &clip_state->stencil_used);
+
+  _cogl_clip_state_set_flushed_stack (clip_state,
+                                      _cogl_clip_stack_copy (stack));
+}
+
+void
+_cogl_clip_state_disable_gl_clip (CoglClipState *clip_state)
+{
+  CoglHandle stack = _cogl_clip_stack_new ();
 
   _cogl_clip_stack_flush (stack, &clip_state->stencil_used);
+
+  _cogl_clip_state_set_flushed_stack (clip_state, stack);
+
+  clip_state->stack_dirty = TRUE;
 }
 
 /* XXX: This should never have been made public API! */
@@ -279,10 +301,6 @@ _cogl_clip_stack_save_real (CoglClipState *clip_state)
 {
   CoglHandle stack;
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   stack = _cogl_clip_stack_new ();
 
   clip_state->stacks = g_slist_prepend (clip_state->stacks, stack);
@@ -310,10 +328,6 @@ _cogl_clip_stack_restore_real (CoglClipState *clip_state)
 
   g_return_if_fail (clip_state->stacks != NULL);
 
-  /* We don't log clip stack changes in the journal so we must flush
-   * it before making modifications */
-  _cogl_journal_flush ();
-
   stack = clip_state->stacks->data;
 
   cogl_handle_unref (stack);
@@ -346,6 +360,7 @@ _cogl_clip_state_init (CoglClipState *clip_state)
 
   clip_state->stacks = NULL;
   clip_state->stack_dirty = TRUE;
+  clip_state->flushed_stack = NULL;
 
   /* Add an intial stack */
   _cogl_clip_stack_save_real (clip_state);
@@ -357,12 +372,17 @@ _cogl_clip_state_destroy (CoglClipState *clip_state)
   /* Destroy all of the stacks */
   while (clip_state->stacks)
     _cogl_clip_stack_restore_real (clip_state);
+
+  _cogl_clip_state_set_flushed_stack (clip_state, NULL);
 }
 
 void
 _cogl_clip_state_dirty (CoglClipState *clip_state)
 {
   clip_state->stack_dirty = TRUE;
+
+  /* The GL state can no longer be relied on */
+  _cogl_clip_state_set_flushed_stack (clip_state, NULL);
 }
 
 CoglHandle
@@ -397,4 +417,6 @@ _cogl_set_clip_stack (CoglHandle handle)
   cogl_handle_ref (handle);
   cogl_handle_unref (clip_state->stacks->data);
   clip_state->stacks->data = handle;
+
+  clip_state->stack_dirty = TRUE;
 }
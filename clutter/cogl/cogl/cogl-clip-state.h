@@ -33,6 +33,11 @@ struct _CoglClipState
 
   gboolean stack_dirty;
   gboolean stencil_used;
+
+  /* A copy of the stack that was last flushed to GL or NULL if the GL
+     state is unknown. This is used to avoid flushing the journal and
+     the clip when an equivalent stack is pushed */
+  CoglHandle flushed_stack;
 };
 
 void
@@ -47,6 +52,18 @@ _cogl_clip_state_dirty (CoglClipState *state);
 void
 _cogl_clip_state_flush (CoglClipState *clip_state);
 
+/*
+ * _cogl_clip_state_disable_gl_clip:
+ * @clip_state: A #CoglClipState
+ *
+ * Flushes an empty clip stack to GL without flushing the journal
+ * first. This is used by the journal when it has clipped all of the
+ * logged quads in software. The current stack is left dirty so that
+ * it will be flushed again before anything else relies on it.
+ */
+void
+_cogl_clip_state_disable_gl_clip (CoglClipState *clip_state);
+
 /* TODO: we may want to make these two functions public because they
  * can be used to implement a better API than cogl_clip_stack_save()
  * and cogl_clip_stack_restore().
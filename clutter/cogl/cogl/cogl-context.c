@@ -35,6 +35,11 @@
 #include "cogl-material-opengl-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-path-private.h"
+#include "cogl-atlas-texture-private.h"
+#include "cogl-program-cache-private.h"
+#ifdef COGL_MATERIAL_BACKEND_ARBFP
+#include "cogl-material-arbfp-private.h"
+#endif
 
 #include <string.h>
 
@@ -115,6 +120,17 @@ cogl_create_context (void)
   _context->simple_material = cogl_material_new ();
   _context->source_material = NULL;
   _context->arbfp_source_buffer = g_string_new ("");
+  _context->arbfp_programs = NULL;
+  _context->program_build_log = NULL;
+  _context->program_build_timer = NULL;
+  _context->program_build_shader_time = 0.0;
+
+  /* Prepare the programs that were used last time so that they don't
+     need to be compiled while the application is running */
+  _cogl_program_cache_init ();
+#ifdef COGL_MATERIAL_BACKEND_ARBFP
+  _cogl_material_backend_arbfp_init_programs ();
+#endif
 
   _context->legacy_state_set = 0;
 
@@ -123,6 +139,7 @@ cogl_create_context (void)
 
   _context->journal = g_array_new (FALSE, FALSE, sizeof (CoglJournalEntry));
   _context->logged_vertices = g_array_new (FALSE, FALSE, sizeof (GLfloat));
+  _context->journal_clip_in_software = FALSE;
 
   _context->current_material = NULL;
   _context->current_material_changes_since_flush = 0;
@@ -146,13 +163,7 @@ cogl_create_context (void)
   _context->current_use_program_type = COGL_MATERIAL_PROGRAM_TYPE_FIXED;
   _context->current_gl_program = 0;
 
-  _context->gl_blend_enable_cache = FALSE;
-
-  _context->depth_test_enabled_cache = FALSE;
-  _context->depth_test_function_cache = COGL_DEPTH_TEST_FUNCTION_LESS;
-  _context->depth_writing_enabled_cache = TRUE;
-  _context->depth_range_near_cache = 0;
-  _context->depth_range_far_cache = 1;
+  _cogl_gl_state_init (&_context->gl_state);
 
   _context->point_size_cache = 1.0f;
 
@@ -172,6 +183,7 @@ cogl_create_context (void)
   _context->dirty_bound_framebuffer = TRUE;
   _context->dirty_gl_viewport = TRUE;
 
+  _cogl_path_fill_cache_init ();
   _context->current_path = _cogl_path_new ();
   _context->stencil_material = cogl_material_new ();
 
@@ -214,8 +226,7 @@ cogl_create_context (void)
   _cogl_enable (enable_flags);
   _cogl_flush_face_winding ();
 
-  _context->atlas = NULL;
-  _context->atlas_texture = COGL_INVALID_HANDLE;
+  _context->atlas_pages = NULL;
 
   /* As far as I can tell, GL_POINT_SPRITE doesn't have any effect
      unless GL_COORD_REPLACE is enabled for an individual
@@ -245,6 +256,8 @@ _cogl_destroy_context (void)
   if (_context->current_path)
     cogl_handle_unref (_context->current_path);
 
+  _cogl_path_fill_cache_free ();
+
   if (_context->default_gl_texture_2d_tex)
     cogl_handle_unref (_context->default_gl_texture_2d_tex);
   if (_context->default_gl_texture_rect_tex)
@@ -273,10 +286,7 @@ _cogl_destroy_context (void)
   if (_context->default_layer_0)
     cogl_handle_unref (_context->default_layer_0);
 
-  if (_context->atlas)
-    _cogl_atlas_free (_context->atlas);
-  if (_context->atlas_texture)
-    cogl_handle_unref (_context->atlas_texture);
+  _cogl_atlas_texture_free_pages ();
 
   _cogl_bitmask_destroy (&_context->texcoord_arrays_enabled);
   _cogl_bitmask_destroy (&_context->temp_bitmask);
@@ -285,6 +295,11 @@ _cogl_destroy_context (void)
   g_slist_free (_context->texture_types);
   g_slist_free (_context->buffer_types);
 
+#ifdef COGL_MATERIAL_BACKEND_ARBFP
+  _cogl_material_backend_arbfp_free_programs ();
+#endif
+  _cogl_program_cache_free ();
+
   g_free (_context);
 }
 
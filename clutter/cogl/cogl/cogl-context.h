@@ -34,6 +34,7 @@
 #include "cogl-atlas.h"
 #include "cogl-buffer-private.h"
 #include "cogl-bitmask.h"
+#include "cogl-gl-state-private.h"
 
 typedef struct
 {
@@ -78,6 +79,19 @@ typedef struct
   CoglMaterial     *simple_material;
   CoglMaterial     *source_material;
   GString          *arbfp_source_buffer;
+  /* ARBfp programs shared between materials with the same source */
+  GHashTable       *arbfp_programs;
+
+  /* Programs read from the on-disk cache, see cogl-program-cache.c */
+  GHashTable       *program_cache;
+  char             *program_cache_dir;
+  /* Entries that haven't been written to the cache directory yet */
+  GSList           *program_cache_pending;
+  guint             program_cache_write_idle;
+  GArray           *program_build_log;
+  GTimer           *program_build_timer;
+  /* Time spent compiling shaders that haven't been linked yet */
+  double            program_build_shader_time;
 
   int               legacy_state_set;
 
@@ -91,6 +105,15 @@ typedef struct
    * can batch things together. */
   GArray           *journal;
   GArray           *logged_vertices;
+  /* TRUE when the logged quads are clipped in software to
+   * journal_clip_box so that GL's clip is disabled until the journal
+   * is flushed. The projection and viewport are the ones that were
+   * flushed when the journal was started, which are needed to clip in
+   * window coordinates. */
+  gboolean          journal_clip_in_software;
+  int               journal_clip_box[4];
+  CoglMatrix        journal_projection;
+  float             journal_viewport[4];
   GArray           *polygon_vertices;
 
   /* Some simple caching, to minimize state changes... */
@@ -109,13 +132,8 @@ typedef struct
   CoglBitmask       texcoord_arrays_to_disable;
   CoglBitmask       temp_bitmask;
 
-  gboolean          gl_blend_enable_cache;
-
-  gboolean              depth_test_enabled_cache;
-  CoglDepthTestFunction depth_test_function_cache;
-  gboolean              depth_writing_enabled_cache;
-  float                 depth_range_near_cache;
-  float                 depth_range_far_cache;
+  /* Shadow of the GL state used to filter out redundant changes */
+  CoglGLState       gl_state;
 
   gboolean              legacy_depth_test_enabled;
 
@@ -132,6 +150,12 @@ typedef struct
   /* Primitives */
   CoglHandle        current_path;
   CoglMaterial     *stencil_material;
+  /* Tesselated path fills keyed by the nodes of the path so that
+     paths that are rebuilt with the same geometry don't need to be
+     tesselated again. The queue is in least recently used order */
+  GHashTable       *path_fill_cache;
+  GQueue            path_fill_cache_lru;
+  gboolean          async_path_fill;
 
   /* Pre-generated VBOs containing indices to generate GL_TRIANGLES
      out of a vertex array of quads */
@@ -143,8 +167,8 @@ typedef struct
 
   CoglMaterial     *texture_download_material;
 
-  CoglAtlas        *atlas;
-  CoglHandle        atlas_texture;
+  /* List of CoglAtlasTexturePages */
+  GSList           *atlas_pages;
 
   /* This debugging variable is used to pick a colour for visually
      displaying the quad batches. It needs to be global so that it can
@@ -53,7 +53,8 @@ static const GDebugKey cogl_log_debug_keys[] = {
   { "show-source", COGL_DEBUG_SHOW_SOURCE},
   { "offscreen", COGL_DEBUG_OFFSCREEN },
   { "texture-pixmap", COGL_DEBUG_TEXTURE_PIXMAP },
-  { "bitmap", COGL_DEBUG_BITMAP }
+  { "bitmap", COGL_DEBUG_BITMAP },
+  { "gl-state", COGL_DEBUG_GL_STATE }
 };
 static const int n_cogl_log_debug_keys =
   G_N_ELEMENTS (cogl_log_debug_keys);
@@ -69,7 +70,9 @@ static const GDebugKey cogl_behavioural_debug_keys[] = {
   { "disable-texturing", COGL_DEBUG_DISABLE_TEXTURING},
   { "disable-arbfp", COGL_DEBUG_DISABLE_ARBFP},
   { "disable-glsl", COGL_DEBUG_DISABLE_GLSL},
-  { "disable-blending", COGL_DEBUG_DISABLE_BLENDING}
+  { "disable-blending", COGL_DEBUG_DISABLE_BLENDING},
+  { "disable-program-cache", COGL_DEBUG_DISABLE_PROGRAM_CACHE},
+  { "disable-software-clip", COGL_DEBUG_DISABLE_SOFTWARE_CLIP}
 };
 static const int n_cogl_behavioural_debug_keys =
   G_N_ELEMENTS (cogl_behavioural_debug_keys);
@@ -128,8 +131,14 @@ _cogl_parse_debug_string (const char *value,
       OPT ("disable-arbfp:", "disable use of ARBfp");
       OPT ("disable-glsl:", "disable use of GLSL");
       OPT ("disable-blending:", "disable use of blending");
+      OPT ("disable-program-cache:",
+           "disable the on-disk cache of generated programs");
+      OPT ("disable-software-clip:",
+           "always flush the journal when the clip changes");
       OPT ("show-source:", "show generated ARBfp/GLSL");
       OPT ("opengl:", "traces some select OpenGL calls");
+      OPT ("gl-state:", "count the GL state changes filtered each frame "
+           "and check the shadowed GL state in cogl_flush()");
       OPT ("offscreen:", "debug offscreen support");
       g_printerr ("\n%28s\n", "Special debug values:");
       OPT ("all:", "Enables all non-behavioural debug options");
@@ -53,7 +53,10 @@ typedef enum {
   COGL_DEBUG_SHOW_SOURCE      = 1 << 22,
   COGL_DEBUG_DISABLE_BLENDING = 1 << 23,
   COGL_DEBUG_TEXTURE_PIXMAP   = 1 << 24,
-  COGL_DEBUG_BITMAP           = 1 << 25
+  COGL_DEBUG_BITMAP           = 1 << 25,
+  COGL_DEBUG_GL_STATE         = 1 << 26,
+  COGL_DEBUG_DISABLE_PROGRAM_CACHE = 1 << 27,
+  COGL_DEBUG_DISABLE_SOFTWARE_CLIP = 1 << 28
 } CoglDebugFlags;
 
 #ifdef COGL_ENABLE_DEBUG
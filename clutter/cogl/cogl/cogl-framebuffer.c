@@ -35,6 +35,7 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-clip-stack.h"
 #include "cogl-journal-private.h"
+#include "cogl-gl-state-private.h"
 
 #ifdef HAVE_COGL_GLES2
 
@@ -755,16 +756,10 @@ _cogl_framebuffer_flush_state (CoglFramebuffer *framebuffer,
         gl_viewport_y = framebuffer->height -
           (framebuffer->viewport_y + framebuffer->viewport_height);
 
-      COGL_NOTE (OPENGL, "Calling glViewport(%d, %d, %d, %d)",
-                 framebuffer->viewport_x,
-                 gl_viewport_y,
-                 framebuffer->viewport_width,
-                 framebuffer->viewport_height);
-
-      GE (glViewport (framebuffer->viewport_x,
-                      gl_viewport_y,
-                      framebuffer->viewport_width,
-                      framebuffer->viewport_height));
+      _cogl_gl_state_viewport (framebuffer->viewport_x,
+                               gl_viewport_y,
+                               framebuffer->viewport_width,
+                               framebuffer->viewport_height);
       ctx->dirty_gl_viewport = FALSE;
     }
 
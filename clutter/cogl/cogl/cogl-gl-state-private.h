@@ -0,0 +1,198 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifndef __COGL_GL_STATE_PRIVATE_H
+#define __COGL_GL_STATE_PRIVATE_H
+
+#include "cogl.h"
+
+#include "cogl-matrix-stack.h"
+
+/*
+ * cogl-gl-state.c keeps a shadow copy of the global GL state that
+ * Cogl changes outside of a material (buffer bindings, enables,
+ * blend, depth and stencil state, the scissor, the viewport and the
+ * matrices) so that redundant GL calls can be filtered out. All of
+ * the code in Cogl that changes this state must go through these
+ * functions, otherwise the shadow state will become out of date.
+ *
+ * The texture units, the active texture unit and the current program
+ * are tracked in cogl-material-opengl.c but they also report to the
+ * statistics kept here.
+ */
+
+typedef enum
+{
+  COGL_GL_STATE_CALL_BIND_BUFFER,
+  COGL_GL_STATE_CALL_ENABLE,
+  COGL_GL_STATE_CALL_BLEND_FUNC,
+  COGL_GL_STATE_CALL_DEPTH,
+  COGL_GL_STATE_CALL_STENCIL,
+  COGL_GL_STATE_CALL_SCISSOR,
+  COGL_GL_STATE_CALL_VIEWPORT,
+  COGL_GL_STATE_CALL_MATRIX,
+  COGL_GL_STATE_CALL_ACTIVE_TEXTURE,
+  COGL_GL_STATE_CALL_PROGRAM,
+
+  COGL_GL_STATE_N_CALLS
+} CoglGLStateCall;
+
+typedef enum
+{
+  COGL_GL_STATE_BUFFER_ARRAY,
+  COGL_GL_STATE_BUFFER_ELEMENT_ARRAY,
+  COGL_GL_STATE_BUFFER_PIXEL_PACK,
+  COGL_GL_STATE_BUFFER_PIXEL_UNPACK,
+
+  COGL_GL_STATE_N_BUFFERS
+} CoglGLStateBuffer;
+
+/* The capabilities that are shadowed by _cogl_gl_state_set_enabled */
+typedef enum
+{
+  COGL_GL_STATE_CAP_BLEND        = 1 << 0,
+  COGL_GL_STATE_CAP_DEPTH_TEST   = 1 << 1,
+  COGL_GL_STATE_CAP_STENCIL_TEST = 1 << 2,
+  COGL_GL_STATE_CAP_SCISSOR_TEST = 1 << 3,
+  COGL_GL_STATE_CAP_CLIP_PLANE0  = 1 << 4,
+  COGL_GL_STATE_CAP_CLIP_PLANE1  = 1 << 5,
+  COGL_GL_STATE_CAP_CLIP_PLANE2  = 1 << 6,
+  COGL_GL_STATE_CAP_CLIP_PLANE3  = 1 << 7
+} CoglGLStateCap;
+
+typedef struct
+{
+  GLuint                buffers[COGL_GL_STATE_N_BUFFERS];
+
+  /* A mask of the CoglGLStateCaps that are enabled */
+  unsigned int          enabled_caps;
+
+  GLenum                blend_src_factor_rgb;
+  GLenum                blend_dst_factor_rgb;
+  GLenum                blend_src_factor_alpha;
+  GLenum                blend_dst_factor_alpha;
+
+  GLenum                depth_func;
+  gboolean              depth_mask;
+  float                 depth_range_near;
+  float                 depth_range_far;
+
+  GLenum                stencil_func;
+  GLint                 stencil_ref;
+  GLuint                stencil_value_mask;
+  GLenum                stencil_fail;
+  GLenum                stencil_zfail;
+  GLenum                stencil_zpass;
+  GLuint                stencil_write_mask;
+
+  /* The scissor and viewport don't have a useful default so they are
+   * always set the first time */
+  gboolean              scissor_valid;
+  GLint                 scissor[4];
+  gboolean              viewport_valid;
+  GLint                 viewport[4];
+
+  /* The last matrix loaded for the modelview and projection
+   * matrices. Texture matrices are per texture unit so they aren't
+   * tracked here */
+  gboolean              matrix_valid[2];
+  gboolean              matrix_is_identity[2];
+  CoglMatrix            matrix[2];
+
+  /* Statistics for the COGL_DEBUG=gl-state option. These are reset
+   * every time they are printed from cogl_clear() */
+  unsigned int          n_calls[COGL_GL_STATE_N_CALLS];
+  unsigned int          n_filtered_calls[COGL_GL_STATE_N_CALLS];
+} CoglGLState;
+
+void
+_cogl_gl_state_init (CoglGLState *state);
+
+void
+_cogl_gl_state_count (CoglGLStateCall call,
+                      gboolean filtered);
+
+void
+_cogl_gl_state_bind_buffer (GLenum gl_target,
+                            GLuint buffer);
+
+void
+_cogl_gl_state_forget_buffer (GLuint buffer);
+
+void
+_cogl_gl_state_set_enabled (GLenum cap,
+                            gboolean enabled);
+
+void
+_cogl_gl_state_blend_func (GLenum src_factor_rgb,
+                           GLenum dst_factor_rgb,
+                           GLenum src_factor_alpha,
+                           GLenum dst_factor_alpha);
+
+void
+_cogl_gl_state_depth_func (GLenum func);
+
+void
+_cogl_gl_state_depth_mask (gboolean enabled);
+
+void
+_cogl_gl_state_depth_range (float near_val,
+                            float far_val);
+
+void
+_cogl_gl_state_stencil_func (GLenum func,
+                             GLint ref,
+                             GLuint mask);
+
+void
+_cogl_gl_state_stencil_op (GLenum fail,
+                           GLenum zfail,
+                           GLenum zpass);
+
+void
+_cogl_gl_state_stencil_mask (GLuint mask);
+
+void
+_cogl_gl_state_scissor (GLint x,
+                        GLint y,
+                        GLsizei width,
+                        GLsizei height);
+
+void
+_cogl_gl_state_viewport (GLint x,
+                         GLint y,
+                         GLsizei width,
+                         GLsizei height);
+
+void
+_cogl_gl_state_load_matrix (CoglMatrixMode mode,
+                            const CoglMatrix *matrix);
+
+void
+_cogl_gl_state_dump_stats (void);
+
+gboolean
+_cogl_gl_state_verify (void);
+
+#endif /* __COGL_GL_STATE_PRIVATE_H */
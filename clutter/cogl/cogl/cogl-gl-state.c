@@ -0,0 +1,715 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl.h"
+#include "cogl-internal.h"
+#include "cogl-context.h"
+#include "cogl-gl-state-private.h"
+
+#include <string.h>
+
+#ifdef HAVE_COGL_GL
+
+#define glBindBuffer ctx->drv.pf_glBindBuffer
+#define glBlendFuncSeparate ctx->drv.pf_glBlendFuncSeparate
+
+#elif defined (HAVE_COGL_GLES2)
+
+#include "../gles/cogl-gles2-wrapper.h"
+
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_ARRAY_BUFFER_BINDING
+#define GL_ARRAY_BUFFER_BINDING 0x8894
+#endif
+#ifndef GL_ELEMENT_ARRAY_BUFFER_BINDING
+#define GL_ELEMENT_ARRAY_BUFFER_BINDING 0x8895
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER_BINDING
+#define GL_PIXEL_PACK_BUFFER_BINDING 0x88ED
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER_BINDING
+#define GL_PIXEL_UNPACK_BUFFER_BINDING 0x88EF
+#endif
+#ifndef GL_BLEND_DST_RGB
+#define GL_BLEND_DST_RGB 0x80C8
+#endif
+#ifndef GL_BLEND_SRC_RGB
+#define GL_BLEND_SRC_RGB 0x80C9
+#endif
+#ifndef GL_BLEND_DST_ALPHA
+#define GL_BLEND_DST_ALPHA 0x80CA
+#endif
+#ifndef GL_BLEND_SRC_ALPHA
+#define GL_BLEND_SRC_ALPHA 0x80CB
+#endif
+
+#ifdef COGL_ENABLE_DEBUG
+static const char * const _cogl_gl_state_call_names[] =
+  {
+    "buffer binds",
+    "enables",
+    "blend funcs",
+    "depth state",
+    "stencil state",
+    "scissors",
+    "viewports",
+    "matrix loads",
+    "active textures",
+    "programs"
+  };
+#endif
+
+void
+_cogl_gl_state_init (CoglGLState *state)
+{
+  memset (state, 0, sizeof (CoglGLState));
+
+  /* Everything else starts with the defaults defined by OpenGL */
+  state->blend_src_factor_rgb = GL_ONE;
+  state->blend_dst_factor_rgb = GL_ZERO;
+  state->blend_src_factor_alpha = GL_ONE;
+  state->blend_dst_factor_alpha = GL_ZERO;
+
+  state->depth_func = GL_LESS;
+  state->depth_mask = TRUE;
+  state->depth_range_near = 0;
+  state->depth_range_far = 1;
+
+  state->stencil_func = GL_ALWAYS;
+  state->stencil_ref = 0;
+  state->stencil_value_mask = ~(GLuint) 0;
+  state->stencil_fail = GL_KEEP;
+  state->stencil_zfail = GL_KEEP;
+  state->stencil_zpass = GL_KEEP;
+  state->stencil_write_mask = ~(GLuint) 0;
+}
+
+void
+_cogl_gl_state_count (CoglGLStateCall call,
+                      gboolean filtered)
+{
+#ifdef COGL_ENABLE_DEBUG
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_GL_STATE))
+    {
+      ctx->gl_state.n_calls[call]++;
+      if (filtered)
+        ctx->gl_state.n_filtered_calls[call]++;
+    }
+#endif
+}
+
+static int
+get_buffer_index (GLenum gl_target)
+{
+  switch (gl_target)
+    {
+    case GL_ARRAY_BUFFER:
+      return COGL_GL_STATE_BUFFER_ARRAY;
+    case GL_ELEMENT_ARRAY_BUFFER:
+      return COGL_GL_STATE_BUFFER_ELEMENT_ARRAY;
+    case GL_PIXEL_PACK_BUFFER:
+      return COGL_GL_STATE_BUFFER_PIXEL_PACK;
+    case GL_PIXEL_UNPACK_BUFFER:
+      return COGL_GL_STATE_BUFFER_PIXEL_UNPACK;
+    }
+
+  g_assert_not_reached ();
+
+  return 0;
+}
+
+void
+_cogl_gl_state_bind_buffer (GLenum gl_target,
+                            GLuint buffer)
+{
+  GLuint *bound;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  bound = ctx->gl_state.buffers + get_buffer_index (gl_target);
+
+  if (*bound == buffer)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_BIND_BUFFER, TRUE);
+      return;
+    }
+
+  GE (glBindBuffer (gl_target, buffer));
+  *bound = buffer;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_BIND_BUFFER, FALSE);
+}
+
+/* This should be called before a buffer is deleted. GL implicitly
+ * unbinds deleted buffers and the name may later be reused for a new
+ * buffer that will then need to be bound again. */
+void
+_cogl_gl_state_forget_buffer (GLuint buffer)
+{
+  int i;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  for (i = 0; i < COGL_GL_STATE_N_BUFFERS; i++)
+    if (ctx->gl_state.buffers[i] == buffer)
+      ctx->gl_state.buffers[i] = 0;
+}
+
+void
+_cogl_gl_state_set_enabled (GLenum cap,
+                            gboolean enabled)
+{
+  CoglGLStateCap cap_bit;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  switch (cap)
+    {
+    case GL_BLEND:
+      cap_bit = COGL_GL_STATE_CAP_BLEND;
+      break;
+    case GL_DEPTH_TEST:
+      cap_bit = COGL_GL_STATE_CAP_DEPTH_TEST;
+      break;
+    case GL_STENCIL_TEST:
+      cap_bit = COGL_GL_STATE_CAP_STENCIL_TEST;
+      break;
+    case GL_SCISSOR_TEST:
+      cap_bit = COGL_GL_STATE_CAP_SCISSOR_TEST;
+      break;
+    case GL_CLIP_PLANE0:
+      cap_bit = COGL_GL_STATE_CAP_CLIP_PLANE0;
+      break;
+    case GL_CLIP_PLANE1:
+      cap_bit = COGL_GL_STATE_CAP_CLIP_PLANE1;
+      break;
+    case GL_CLIP_PLANE2:
+      cap_bit = COGL_GL_STATE_CAP_CLIP_PLANE2;
+      break;
+    case GL_CLIP_PLANE3:
+      cap_bit = COGL_GL_STATE_CAP_CLIP_PLANE3;
+      break;
+    default:
+      g_return_if_reached ();
+    }
+
+  if (!!(ctx->gl_state.enabled_caps & cap_bit) == !!enabled)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_ENABLE, TRUE);
+      return;
+    }
+
+  if (enabled)
+    {
+      GE (glEnable (cap));
+      ctx->gl_state.enabled_caps |= cap_bit;
+    }
+  else
+    {
+      GE (glDisable (cap));
+      ctx->gl_state.enabled_caps &= ~cap_bit;
+    }
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_ENABLE, FALSE);
+}
+
+/* NB: The caller should pass the rgb factors again for the alpha
+ * factors if glBlendFuncSeparate isn't available */
+void
+_cogl_gl_state_blend_func (GLenum src_factor_rgb,
+                           GLenum dst_factor_rgb,
+                           GLenum src_factor_alpha,
+                           GLenum dst_factor_alpha)
+{
+  CoglGLState *state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  if (state->blend_src_factor_rgb == src_factor_rgb &&
+      state->blend_dst_factor_rgb == dst_factor_rgb &&
+      state->blend_src_factor_alpha == src_factor_alpha &&
+      state->blend_dst_factor_alpha == dst_factor_alpha)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_BLEND_FUNC, TRUE);
+      return;
+    }
+
+#ifndef HAVE_COGL_GLES /* GLES 1 only has glBlendFunc */
+  if (src_factor_rgb != src_factor_alpha ||
+      dst_factor_rgb != dst_factor_alpha)
+    GE (glBlendFuncSeparate (src_factor_rgb,
+                             dst_factor_rgb,
+                             src_factor_alpha,
+                             dst_factor_alpha));
+  else
+#endif
+    GE (glBlendFunc (src_factor_rgb, dst_factor_rgb));
+
+  state->blend_src_factor_rgb = src_factor_rgb;
+  state->blend_dst_factor_rgb = dst_factor_rgb;
+  state->blend_src_factor_alpha = src_factor_alpha;
+  state->blend_dst_factor_alpha = dst_factor_alpha;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_BLEND_FUNC, FALSE);
+}
+
+void
+_cogl_gl_state_depth_func (GLenum func)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->gl_state.depth_func == func)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, TRUE);
+      return;
+    }
+
+  GE (glDepthFunc (func));
+  ctx->gl_state.depth_func = func;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, FALSE);
+}
+
+void
+_cogl_gl_state_depth_mask (gboolean enabled)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  enabled = !!enabled;
+
+  if (ctx->gl_state.depth_mask == enabled)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, TRUE);
+      return;
+    }
+
+  GE (glDepthMask (enabled ? GL_TRUE : GL_FALSE));
+  ctx->gl_state.depth_mask = enabled;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, FALSE);
+}
+
+void
+_cogl_gl_state_depth_range (float near_val,
+                            float far_val)
+{
+#ifndef COGL_HAS_GLES
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->gl_state.depth_range_near == near_val &&
+      ctx->gl_state.depth_range_far == far_val)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, TRUE);
+      return;
+    }
+
+#ifdef COGL_HAS_GLES2
+  GE (glDepthRangef (near_val, far_val));
+#else
+  GE (glDepthRange (near_val, far_val));
+#endif
+  ctx->gl_state.depth_range_near = near_val;
+  ctx->gl_state.depth_range_far = far_val;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_DEPTH, FALSE);
+#endif /* COGL_HAS_GLES */
+}
+
+void
+_cogl_gl_state_stencil_func (GLenum func,
+                             GLint ref,
+                             GLuint mask)
+{
+  CoglGLState *state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  if (state->stencil_func == func &&
+      state->stencil_ref == ref &&
+      state->stencil_value_mask == mask)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, TRUE);
+      return;
+    }
+
+  GE (glStencilFunc (func, ref, mask));
+  state->stencil_func = func;
+  state->stencil_ref = ref;
+  state->stencil_value_mask = mask;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, FALSE);
+}
+
+void
+_cogl_gl_state_stencil_op (GLenum fail,
+                           GLenum zfail,
+                           GLenum zpass)
+{
+  CoglGLState *state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  if (state->stencil_fail == fail &&
+      state->stencil_zfail == zfail &&
+      state->stencil_zpass == zpass)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, TRUE);
+      return;
+    }
+
+  GE (glStencilOp (fail, zfail, zpass));
+  state->stencil_fail = fail;
+  state->stencil_zfail = zfail;
+  state->stencil_zpass = zpass;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, FALSE);
+}
+
+void
+_cogl_gl_state_stencil_mask (GLuint mask)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->gl_state.stencil_write_mask == mask)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, TRUE);
+      return;
+    }
+
+  GE (glStencilMask (mask));
+  ctx->gl_state.stencil_write_mask = mask;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_STENCIL, FALSE);
+}
+
+void
+_cogl_gl_state_scissor (GLint x,
+                        GLint y,
+                        GLsizei width,
+                        GLsizei height)
+{
+  CoglGLState *state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  if (state->scissor_valid &&
+      state->scissor[0] == x &&
+      state->scissor[1] == y &&
+      state->scissor[2] == width &&
+      state->scissor[3] == height)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_SCISSOR, TRUE);
+      return;
+    }
+
+  GE (glScissor (x, y, width, height));
+  state->scissor[0] = x;
+  state->scissor[1] = y;
+  state->scissor[2] = width;
+  state->scissor[3] = height;
+  state->scissor_valid = TRUE;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_SCISSOR, FALSE);
+}
+
+void
+_cogl_gl_state_viewport (GLint x,
+                         GLint y,
+                         GLsizei width,
+                         GLsizei height)
+{
+  CoglGLState *state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  if (state->viewport_valid &&
+      state->viewport[0] == x &&
+      state->viewport[1] == y &&
+      state->viewport[2] == width &&
+      state->viewport[3] == height)
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_VIEWPORT, TRUE);
+      return;
+    }
+
+  COGL_NOTE (OPENGL, "Calling glViewport(%d, %d, %d, %d)",
+             x, y, width, height);
+
+  GE (glViewport (x, y, width, height));
+  state->viewport[0] = x;
+  state->viewport[1] = y;
+  state->viewport[2] = width;
+  state->viewport[3] = height;
+  state->viewport_valid = TRUE;
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_VIEWPORT, FALSE);
+}
+
+/* Loads @matrix into the current GL matrix, which must already have
+ * been selected with glMatrixMode. A NULL matrix means the identity
+ * matrix. */
+void
+_cogl_gl_state_load_matrix (CoglMatrixMode mode,
+                            const CoglMatrix *matrix)
+{
+  CoglGLState *state;
+  int index;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state = &ctx->gl_state;
+
+  switch (mode)
+    {
+    case COGL_MATRIX_MODELVIEW:
+      index = 0;
+      break;
+
+    case COGL_MATRIX_PROJECTION:
+      index = 1;
+      break;
+
+    default:
+      index = -1;
+      break;
+    }
+
+  if (index != -1 && state->matrix_valid[index])
+    {
+      if (matrix == NULL
+          ? state->matrix_is_identity[index]
+          : (!state->matrix_is_identity[index] &&
+             memcmp (&state->matrix[index], matrix,
+                     sizeof (float) * 16) == 0))
+        {
+          _cogl_gl_state_count (COGL_GL_STATE_CALL_MATRIX, TRUE);
+          return;
+        }
+    }
+
+  if (matrix == NULL)
+    GE (glLoadIdentity ());
+  else
+    GE (glLoadMatrixf (cogl_matrix_get_array (matrix)));
+
+  if (index != -1)
+    {
+      state->matrix_valid[index] = TRUE;
+      state->matrix_is_identity[index] = matrix == NULL;
+      if (matrix)
+        state->matrix[index] = *matrix;
+    }
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_MATRIX, FALSE);
+}
+
+void
+_cogl_gl_state_dump_stats (void)
+{
+#ifdef COGL_ENABLE_DEBUG
+  int i;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  for (i = 0; i < COGL_GL_STATE_N_CALLS; i++)
+    {
+      if (ctx->gl_state.n_calls[i] == 0)
+        continue;
+
+      COGL_NOTE (GL_STATE, "%s: %u calls, %u filtered",
+                 _cogl_gl_state_call_names[i],
+                 ctx->gl_state.n_calls[i],
+                 ctx->gl_state.n_filtered_calls[i]);
+    }
+
+  memset (ctx->gl_state.n_calls, 0, sizeof (ctx->gl_state.n_calls));
+  memset (ctx->gl_state.n_filtered_calls, 0,
+          sizeof (ctx->gl_state.n_filtered_calls));
+#endif
+}
+
+static gboolean
+verify_integer (GLenum pname,
+                GLint expected,
+                const char *name)
+{
+  GLint value;
+
+  GE (glGetIntegerv (pname, &value));
+
+  if (value != expected)
+    {
+      g_warning ("The shadowed %s is 0x%x but GL has 0x%x",
+                 name, (unsigned int) expected, (unsigned int) value);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+verify_enabled (GLenum cap,
+                CoglGLStateCap cap_bit,
+                const char *name)
+{
+  gboolean shadowed, enabled;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  shadowed = (ctx->gl_state.enabled_caps & cap_bit) ? TRUE : FALSE;
+  enabled = glIsEnabled (cap) ? TRUE : FALSE;
+
+  if (shadowed != enabled)
+    {
+      g_warning ("%s is shadowed as %s but GL has it %s", name,
+                 shadowed ? "enabled" : "disabled",
+                 enabled ? "enabled" : "disabled");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Reads back the state from GL and compares it with the shadow
+ * state. A warning is printed for each difference and FALSE is
+ * returned if there were any. This is slow so it is only done from
+ * cogl_flush() when COGL_DEBUG=gl-state is used */
+gboolean
+_cogl_gl_state_verify (void)
+{
+  CoglGLState *state;
+  gboolean ret = TRUE;
+  GLboolean depth_mask;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  state = &ctx->gl_state;
+
+  ret &= verify_enabled (GL_BLEND, COGL_GL_STATE_CAP_BLEND,
+                         "GL_BLEND");
+  ret &= verify_enabled (GL_DEPTH_TEST, COGL_GL_STATE_CAP_DEPTH_TEST,
+                         "GL_DEPTH_TEST");
+  ret &= verify_enabled (GL_STENCIL_TEST, COGL_GL_STATE_CAP_STENCIL_TEST,
+                         "GL_STENCIL_TEST");
+  ret &= verify_enabled (GL_SCISSOR_TEST, COGL_GL_STATE_CAP_SCISSOR_TEST,
+                         "GL_SCISSOR_TEST");
+#ifndef HAVE_COGL_GLES2
+  /* The GLES2 wrapper emulates the clip planes in the shaders so GL
+   * doesn't know about them */
+  ret &= verify_enabled (GL_CLIP_PLANE0, COGL_GL_STATE_CAP_CLIP_PLANE0,
+                         "GL_CLIP_PLANE0");
+  ret &= verify_enabled (GL_CLIP_PLANE1, COGL_GL_STATE_CAP_CLIP_PLANE1,
+                         "GL_CLIP_PLANE1");
+  ret &= verify_enabled (GL_CLIP_PLANE2, COGL_GL_STATE_CAP_CLIP_PLANE2,
+                         "GL_CLIP_PLANE2");
+  ret &= verify_enabled (GL_CLIP_PLANE3, COGL_GL_STATE_CAP_CLIP_PLANE3,
+                         "GL_CLIP_PLANE3");
+#endif
+
+  ret &= verify_integer (GL_ARRAY_BUFFER_BINDING,
+                         state->buffers[COGL_GL_STATE_BUFFER_ARRAY],
+                         "array buffer binding");
+  ret &= verify_integer (GL_ELEMENT_ARRAY_BUFFER_BINDING,
+                         state->buffers[COGL_GL_STATE_BUFFER_ELEMENT_ARRAY],
+                         "element array buffer binding");
+  if (cogl_features_available (COGL_FEATURE_PBOS))
+    {
+      ret &= verify_integer (GL_PIXEL_PACK_BUFFER_BINDING,
+                             state->buffers[COGL_GL_STATE_BUFFER_PIXEL_PACK],
+                             "pixel pack buffer binding");
+      ret &= verify_integer (GL_PIXEL_UNPACK_BUFFER_BINDING,
+                             state->buffers[COGL_GL_STATE_BUFFER_PIXEL_UNPACK],
+                             "pixel unpack buffer binding");
+    }
+
+#ifdef HAVE_COGL_GLES
+  ret &= verify_integer (GL_BLEND_SRC, state->blend_src_factor_rgb,
+                         "blend source factor");
+  ret &= verify_integer (GL_BLEND_DST, state->blend_dst_factor_rgb,
+                         "blend destination factor");
+#else
+  ret &= verify_integer (GL_BLEND_SRC_RGB, state->blend_src_factor_rgb,
+                         "blend source RGB factor");
+  ret &= verify_integer (GL_BLEND_DST_RGB, state->blend_dst_factor_rgb,
+                         "blend destination RGB factor");
+  ret &= verify_integer (GL_BLEND_SRC_ALPHA, state->blend_src_factor_alpha,
+                         "blend source alpha factor");
+  ret &= verify_integer (GL_BLEND_DST_ALPHA, state->blend_dst_factor_alpha,
+                         "blend destination alpha factor");
+#endif
+
+  ret &= verify_integer (GL_DEPTH_FUNC, state->depth_func, "depth func");
+  GE (glGetBooleanv (GL_DEPTH_WRITEMASK, &depth_mask));
+  if (!!depth_mask != !!state->depth_mask)
+    {
+      g_warning ("The shadowed depth mask doesn't match GL");
+      ret = FALSE;
+    }
+
+  ret &= verify_integer (GL_STENCIL_FUNC, state->stencil_func,
+                         "stencil func");
+  ret &= verify_integer (GL_STENCIL_REF, state->stencil_ref,
+                         "stencil reference");
+
+  if (state->scissor_valid)
+    {
+      GLint scissor[4];
+
+      GE (glGetIntegerv (GL_SCISSOR_BOX, scissor));
+      if (memcmp (scissor, state->scissor, sizeof (scissor)))
+        {
+          g_warning ("The shadowed scissor is %i,%i %ix%i but GL has "
+                     "%i,%i %ix%i",
+                     state->scissor[0], state->scissor[1],
+                     state->scissor[2], state->scissor[3],
+                     scissor[0], scissor[1], scissor[2], scissor[3]);
+          ret = FALSE;
+        }
+    }
+
+  return ret;
+}
@@ -219,7 +219,9 @@ _cogl_xlib_remove_filter (CoglXlibFilterFunc func,
 
 typedef enum _CoglFeatureFlagsPrivate
 {
-  COGL_FEATURE_PRIVATE_ARB_FP = (1 << 0)
+  COGL_FEATURE_PRIVATE_ARB_FP = (1 << 0),
+  COGL_FEATURE_PRIVATE_SYNC   = (1 << 1),
+  COGL_FEATURE_PRIVATE_PROGRAM_BINARY = (1 << 2)
 } CoglFeatureFlagsPrivate;
 
 gboolean
@@ -34,7 +34,10 @@
 #include "cogl-material-opengl-private.h"
 #include "cogl-vertex-buffer-private.h"
 #include "cogl-framebuffer-private.h"
+#include "cogl-clip-stack.h"
 #include "cogl-profile.h"
+#include "cogl-gl-state-private.h"
+#include "cogl-util.h"
 
 #include <string.h>
 #include <gmodule.h>
@@ -45,7 +48,6 @@
 #ifdef HAVE_COGL_GL
 
 #define glGenBuffers ctx->drv.pf_glGenBuffers
-#define glBindBuffer ctx->drv.pf_glBindBuffer
 #define glBufferData ctx->drv.pf_glBufferData
 #define glBufferSubData ctx->drv.pf_glBufferSubData
 #define glDeleteBuffers ctx->drv.pf_glDeleteBuffers
@@ -460,8 +462,8 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
   else
     g_critical ("unknown indices type %d", indices->type);
 
-  GE (glBindBuffer (GL_ELEMENT_ARRAY_BUFFER,
-                    GPOINTER_TO_UINT (indices->vbo_name)));
+  _cogl_gl_state_bind_buffer (GL_ELEMENT_ARRAY_BUFFER,
+                              GPOINTER_TO_UINT (indices->vbo_name));
 #endif
 
   /* We only call gl{Vertex,Color,Texture}Pointer when the stride within
@@ -524,7 +526,7 @@ upload_vertices_to_vbo (GArray *vertices, CoglJournalFlushState *state)
 
   g_assert (needed_vbo_len);
   GE (glGenBuffers (1, &journal_vbo));
-  GE (glBindBuffer (GL_ARRAY_BUFFER, journal_vbo));
+  _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER, journal_vbo);
   GE (glBufferData (GL_ARRAY_BUFFER,
                     needed_vbo_len,
                     vertices->data,
@@ -559,6 +561,10 @@ _cogl_journal_flush (void)
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
+  /* Once the clipped quads are drawn the GL clip state can be used
+   * again */
+  ctx->journal_clip_in_software = FALSE;
+
   if (ctx->journal->len == 0)
     return;
 
@@ -627,7 +633,10 @@ _cogl_journal_flush (void)
     }
 
   if (!vbo_fallback)
-    GE (glDeleteBuffers (1, &journal_vbo));
+    {
+      _cogl_gl_state_forget_buffer (journal_vbo);
+      GE (glDeleteBuffers (1, &journal_vbo));
+    }
 
   g_array_set_size (ctx->journal, 0);
   g_array_set_size (ctx->logged_vertices, 0);
@@ -638,6 +647,8 @@ _cogl_journal_flush (void)
 static void
 _cogl_journal_init (void)
 {
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
   /* Here we flush anything that we know must remain constant until the
    * next the the journal is flushed. Note: This lets up flush things
    * that themselves depend on the journal, such as clip state. */
@@ -645,6 +656,232 @@ _cogl_journal_init (void)
   /* NB: the journal deals with flushing the modelview stack manually */
   _cogl_framebuffer_flush_state (_cogl_get_framebuffer (),
                                  COGL_FRAMEBUFFER_FLUSH_SKIP_MODELVIEW);
+
+  /* Remember the projection that GL will use for the logged quads in
+   * case they need to be clipped in software */
+  cogl_get_projection_matrix (&ctx->journal_projection);
+  cogl_get_viewport (ctx->journal_viewport);
+}
+
+/* Tries to clip a logged quad to the window space rectangle @box by
+ * moving its vertices. This only works if the quad is still a
+ * rectangle aligned to the window after projecting it, otherwise
+ * FALSE is returned and the quad is left untouched. @is_empty is
+ * set to TRUE if the quad is completely outside of the box. */
+static gboolean
+_cogl_journal_clip_quad (GLfloat *v,
+                         int n_layers,
+                         const int *box,
+                         gboolean *is_empty)
+{
+  gsize stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (n_layers);
+  const float *viewport;
+  float win[4][2], w0 = 0;
+  float x_range[2], y_range[2];
+  float *u_range, *v_range;
+  float du, dv;
+  int i, k;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  *is_empty = FALSE;
+
+  /* Nothing to do if the box doesn't clip anything on screen */
+  if (box[0] <= 0 && box[1] <= 0 &&
+      box[2] == G_MAXINT && box[3] == G_MAXINT)
+    return TRUE;
+
+  viewport = ctx->journal_viewport;
+
+  for (i = 0; i < 4; i++)
+    {
+      float x = v[i * stride], y = v[i * stride + 1];
+      float z = v[i * stride + 2], w = 1;
+
+      cogl_matrix_transform_point (&ctx->journal_projection,
+                                   &x, &y, &z, &w);
+
+      /* Interpolating the vertices linearly is only right if they
+         all have the same w */
+      if (i == 0)
+        {
+          if (w <= 0.0f)
+            return FALSE;
+          w0 = w;
+        }
+      else if (fabsf (w - w0) > w0 * 1e-5f)
+        return FALSE;
+
+      win[i][0] = (x / w + 1.0f) * viewport[2] / 2.0f + viewport[0];
+      win[i][1] = (1.0f - y / w) * viewport[3] / 2.0f + viewport[1];
+    }
+
+  /* The vertices are logged in the order (x0,y0), (x0,y1), (x1,y1),
+   * (x1,y0). Any point of the quad can be given as v0 + u * (v3 - v0)
+   * + v * (v1 - v0) so we work out the range of u and v that is
+   * inside the box. Depending on the rotation of the quad, u will
+   * either be along the x or the y axis of the window. */
+  if (COGL_UTIL_WINDOW_ALIGNED (win[0][1], win[3][1]) &&
+      COGL_UTIL_WINDOW_ALIGNED (win[0][0], win[1][0]) &&
+      COGL_UTIL_WINDOW_ALIGNED (win[1][1], win[2][1]) &&
+      COGL_UTIL_WINDOW_ALIGNED (win[2][0], win[3][0]))
+    {
+      u_range = x_range;
+      v_range = y_range;
+      du = win[3][0] - win[0][0];
+      dv = win[1][1] - win[0][1];
+    }
+  else if (COGL_UTIL_WINDOW_ALIGNED (win[0][0], win[3][0]) &&
+           COGL_UTIL_WINDOW_ALIGNED (win[0][1], win[1][1]) &&
+           COGL_UTIL_WINDOW_ALIGNED (win[1][0], win[2][0]) &&
+           COGL_UTIL_WINDOW_ALIGNED (win[2][1], win[3][1]))
+    {
+      u_range = y_range;
+      v_range = x_range;
+      du = win[3][1] - win[0][1];
+      dv = win[1][0] - win[0][0];
+    }
+  else
+    return FALSE;
+
+  if (du == 0.0f || dv == 0.0f)
+    return FALSE;
+
+  /* Work out the range of the parameter along each window axis */
+#define CLIP_RANGE(range, start, delta, min, max)                       \
+  G_STMT_START {                                                        \
+    float a = ((min) - (start)) / (delta);                              \
+    float b = ((max) - (start)) / (delta);                              \
+    (range)[0] = MAX (0.0f, MIN (a, b));                                \
+    (range)[1] = MIN (1.0f, MAX (a, b));                                \
+  } G_STMT_END
+
+  if (u_range == x_range)
+    {
+      CLIP_RANGE (x_range, win[0][0], du, box[0], box[2]);
+      CLIP_RANGE (y_range, win[0][1], dv, box[1], box[3]);
+    }
+  else
+    {
+      CLIP_RANGE (x_range, win[0][0], dv, box[0], box[2]);
+      CLIP_RANGE (y_range, win[0][1], du, box[1], box[3]);
+    }
+
+#undef CLIP_RANGE
+
+  if (x_range[0] >= x_range[1] || y_range[0] >= y_range[1])
+    {
+      *is_empty = TRUE;
+      return TRUE;
+    }
+
+  if (u_range[0] == 0.0f && u_range[1] == 1.0f &&
+      v_range[0] == 0.0f && v_range[1] == 1.0f)
+    return TRUE;
+
+  /* Interpolate the position and all of the texture coordinates. The
+   * color is the same for all of the vertices */
+  for (k = 0; k < POS_STRIDE + COLOR_STRIDE + TEX_STRIDE * n_layers; k++)
+    {
+      float a0, a_du, a_dv;
+
+      if (k >= POS_STRIDE && k < POS_STRIDE + COLOR_STRIDE)
+        continue;
+
+      a0 = v[k];
+      a_du = v[3 * stride + k] - a0;
+      a_dv = v[stride + k] - a0;
+
+      v[k] = a0 + u_range[0] * a_du + v_range[0] * a_dv;
+      v[stride + k] = a0 + u_range[0] * a_du + v_range[1] * a_dv;
+      v[2 * stride + k] = a0 + u_range[1] * a_du + v_range[1] * a_dv;
+      v[3 * stride + k] = a0 + u_range[1] * a_du + v_range[0] * a_dv;
+    }
+
+  return TRUE;
+}
+
+/* Tries to clip all of the quads logged so far to @box in software
+ * so that they no longer depend on the GL clip state */
+static gboolean
+_cogl_journal_clip_logged_quads (const int *box)
+{
+  GLfloat *v;
+  int i;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  v = (GLfloat *) ctx->logged_vertices->data;
+
+  for (i = 0; i < ctx->journal->len; i++)
+    {
+      CoglJournalEntry *entry =
+        &g_array_index (ctx->journal, CoglJournalEntry, i);
+      gsize stride = GET_JOURNAL_VB_STRIDE_FOR_N_LAYERS (entry->n_layers);
+      gboolean is_empty;
+      int j;
+
+      /* NB: a quad that was clipped before we failed is still fine
+       * because GL would clip it to the same box anyway */
+      if (!_cogl_journal_clip_quad (v, entry->n_layers, box, &is_empty))
+        return FALSE;
+
+      /* Collapse the quad to a point so that it won't draw anything */
+      if (is_empty)
+        for (j = 1; j < 4; j++)
+          memcpy (v + j * stride, v, sizeof (GLfloat) * POS_STRIDE);
+
+      v += stride * 4;
+    }
+
+  return TRUE;
+}
+
+/* Called when a quad is logged while the clip stack has changed
+ * since the journal was started. The journal has to be flushed before
+ * the new clip can be used unless the new clip is the same as the
+ * old one or all of the quads can be clipped in software instead. */
+static void
+_cogl_journal_update_clip (CoglClipState *clip_state)
+{
+  CoglHandle stack = clip_state->stacks->data;
+  int *box;
+  int flushed_box[4];
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  box = ctx->journal_clip_box;
+
+  if (ctx->journal_clip_in_software)
+    {
+      if (!_cogl_clip_stack_get_scissor (stack,
+                                         box, box + 1, box + 2, box + 3))
+        _cogl_journal_flush ();
+      return;
+    }
+
+  if (G_UNLIKELY (!SW_TRANSFORM) ||
+      G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_DISABLE_SOFTWARE_CLIP) ||
+      clip_state->flushed_stack == NULL ||
+      _cogl_clip_stack_equal (stack, clip_state->flushed_stack) ||
+      !_cogl_clip_stack_get_scissor (clip_state->flushed_stack,
+                                     flushed_box, flushed_box + 1,
+                                     flushed_box + 2, flushed_box + 3) ||
+      !_cogl_clip_stack_get_scissor (stack,
+                                     box, box + 1, box + 2, box + 3) ||
+      !_cogl_journal_clip_logged_quads (flushed_box))
+    {
+      /* This will only flush the journal if the clip has really
+       * changed */
+      _cogl_clip_state_flush (clip_state);
+      return;
+    }
+
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_BATCHING))
+    g_print ("BATCHING: clipping the journal in software\n");
+
+  _cogl_clip_state_disable_gl_clip (clip_state);
+  ctx->journal_clip_in_software = TRUE;
 }
 
 void
@@ -670,6 +907,7 @@ _cogl_journal_log_quad (const float  *position,
   CoglJournalEntry *entry;
   CoglHandle        source;
   CoglMaterialFlushOptions flush_options;
+  CoglClipState    *clip_state;
   COGL_STATIC_TIMER (log_timer,
                      "Mainloop", /* parent */
                      "Journal Log",
@@ -680,6 +918,13 @@ _cogl_journal_log_quad (const float  *position,
 
   COGL_TIMER_START (_cogl_uprof_context, log_timer);
 
+  clip_state = _cogl_framebuffer_get_clip_state (_cogl_get_framebuffer ());
+
+  /* If the clip has changed since the journal was started then this
+   * may end up flushing the journal */
+  if (ctx->logged_vertices->len > 0 && clip_state->stack_dirty)
+    _cogl_journal_update_clip (clip_state);
+
   if (ctx->logged_vertices->len == 0)
     _cogl_journal_init ();
 
@@ -775,6 +1020,35 @@ _cogl_journal_log_quad (const float  *position,
       t[0] = tex_coords[i * 4 + 2]; t[1] = tex_coords[i * 4 + 1];
     }
 
+  if (ctx->journal_clip_in_software)
+    {
+      gboolean is_empty;
+
+      v = &g_array_index (ctx->logged_vertices, GLfloat, next_vert);
+
+      if (!_cogl_journal_clip_quad (v, n_layers, ctx->journal_clip_box,
+                                    &is_empty))
+        {
+          /* The quad can't be clipped in software so we need to
+           * start a new journal with the GL clip state enabled */
+          g_array_set_size (ctx->logged_vertices, next_vert);
+          COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
+          _cogl_journal_flush ();
+          _cogl_journal_log_quad (position, material, n_layers,
+                                  fallback_layers, layer0_override_texture,
+                                  wrap_mode_overrides,
+                                  tex_coords, tex_coords_len);
+          return;
+        }
+
+      if (is_empty)
+        {
+          g_array_set_size (ctx->logged_vertices, next_vert);
+          COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
+          return;
+        }
+    }
+
   if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_JOURNAL))
     {
       g_print ("Logged new quad:\n");
@@ -841,4 +1115,3 @@ _cogl_journal_log_quad (const float  *position,
 
   COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
 }
-
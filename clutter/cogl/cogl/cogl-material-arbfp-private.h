@@ -32,5 +32,11 @@
 
 const CoglMaterialBackend _cogl_material_arbfp_backend;
 
+void
+_cogl_material_backend_arbfp_init_programs (void);
+
+void
+_cogl_material_backend_arbfp_free_programs (void);
+
 #endif /* __COGL_MATERIAL_ARBFP_PRIVATE_H */
 
@@ -43,6 +43,7 @@
 #include "cogl-journal-private.h"
 #include "cogl-color-private.h"
 #include "cogl-profile.h"
+#include "cogl-program-cache-private.h"
 #ifndef HAVE_COGL_GLES
 #include "cogl-program.h"
 #endif
@@ -73,17 +74,154 @@
 #define GL_TEXTURE_3D                           0x806F
 #endif
 
+/* Materials that generate the same source share a single program. The
+ * programs are kept in ctx->arbfp_programs keyed by their source */
+typedef struct _CoglMaterialBackendARBfpProgram
+{
+  char *source;
+  GLuint gl_program;
+  int ref_count;
+} CoglMaterialBackendARBfpProgram;
+
 typedef struct _CoglMaterialBackendARBfpPrivate
 {
   CoglMaterial *authority_cache;
   unsigned long authority_cache_age;
 
   GString *source;
-  GLuint gl_program;
+  CoglMaterialBackendARBfpProgram *program;
   gboolean *sampled;
   int next_constant_id;
 } CoglMaterialBackendARBfpPrivate;
 
+static void
+arbfp_program_free (CoglMaterialBackendARBfpProgram *program)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  GE (glDeletePrograms (1, &program->gl_program));
+  g_free (program->source);
+  g_slice_free (CoglMaterialBackendARBfpProgram, program);
+}
+
+static CoglMaterialBackendARBfpProgram *
+arbfp_program_compile (const char *source)
+{
+  CoglMaterialBackendARBfpProgram *program;
+  GLenum gl_error;
+  COGL_STATIC_COUNTER (backend_arbfp_compile_counter,
+                       "arbfp compile counter",
+                       "Increments each time a new ARBfp "
+                       "program is compiled",
+                       0 /* no application private data */);
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  COGL_COUNTER_INC (_cogl_uprof_context, backend_arbfp_compile_counter);
+
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_SHOW_SOURCE))
+    g_message ("material program:\n%s", source);
+
+  _cogl_program_build_begin ();
+
+  program = g_slice_new (CoglMaterialBackendARBfpProgram);
+  program->source = g_strdup (source);
+  program->ref_count = 0;
+
+  GE (glGenPrograms (1, &program->gl_program));
+
+  GE (glBindProgram (GL_FRAGMENT_PROGRAM_ARB, program->gl_program));
+
+  while ((gl_error = glGetError ()) != GL_NO_ERROR)
+    ;
+  glProgramString (GL_FRAGMENT_PROGRAM_ARB,
+                   GL_PROGRAM_FORMAT_ASCII_ARB,
+                   strlen (source),
+                   source);
+  if (glGetError () != GL_NO_ERROR)
+    {
+      g_warning ("\n%s\n%s",
+                 source,
+                 glGetString (GL_PROGRAM_ERROR_STRING_ARB));
+    }
+
+  _cogl_program_build_end ();
+
+  g_hash_table_insert (ctx->arbfp_programs, program->source, program);
+
+  return program;
+}
+
+static CoglMaterialBackendARBfpProgram *
+arbfp_program_get (const char *source)
+{
+  CoglMaterialBackendARBfpProgram *program;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  program = g_hash_table_lookup (ctx->arbfp_programs, source);
+
+  if (program == NULL)
+    {
+      program = arbfp_program_compile (source);
+      /* Remember the source so the program can be compiled up front
+         next time */
+      _cogl_program_cache_add_source (COGL_PROGRAM_CACHE_TYPE_ARBFP, source);
+    }
+
+  program->ref_count++;
+
+  return program;
+}
+
+static void
+arbfp_program_unref (CoglMaterialBackendARBfpProgram *program)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* This will also free the program */
+  if (--program->ref_count < 1)
+    g_hash_table_remove (ctx->arbfp_programs, program->source);
+}
+
+static void
+warm_up_program_cb (const char *source,
+                    void *user_data)
+{
+  CoglMaterialBackendARBfpProgram *program = arbfp_program_compile (source);
+
+  /* Programs from the program cache are kept for the lifetime of the
+     context so the reference is never dropped */
+  program->ref_count++;
+}
+
+void
+_cogl_material_backend_arbfp_init_programs (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  ctx->arbfp_programs =
+    g_hash_table_new_full (g_str_hash, g_str_equal,
+                           NULL,
+                           (GDestroyNotify) arbfp_program_free);
+
+  if (!_cogl_features_available_private (COGL_FEATURE_PRIVATE_ARB_FP))
+    return;
+
+  _cogl_program_cache_foreach_source (COGL_PROGRAM_CACHE_TYPE_ARBFP,
+                                      warm_up_program_cb,
+                                      NULL);
+}
+
+void
+_cogl_material_backend_arbfp_free_programs (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  g_hash_table_destroy (ctx->arbfp_programs);
+  ctx->arbfp_programs = NULL;
+}
+
 static int
 _cogl_material_backend_arbfp_get_max_texture_units (void)
 {
@@ -303,7 +441,7 @@ _cogl_material_backend_arbfp_start (CoglMaterial *material,
     }
   authority_priv = authority->backend_privs[COGL_MATERIAL_BACKEND_ARBFP];
 
-  if (authority_priv->gl_program == 0)
+  if (authority_priv->program == NULL)
     {
       /* We reuse a single grow-only GString for ARBfp code-gen */
       g_string_set_size (ctx->arbfp_source_buffer, 0);
@@ -916,45 +1054,19 @@ _cogl_material_backend_arbfp_end (CoglMaterial *material,
 
   if (priv->source)
     {
-      GLenum gl_error;
-      COGL_STATIC_COUNTER (backend_arbfp_compile_counter,
-                           "arbfp compile counter",
-                           "Increments each time a new ARBfp "
-                           "program is compiled",
-                           0 /* no application private data */);
-
-      COGL_COUNTER_INC (_cogl_uprof_context, backend_arbfp_compile_counter);
-
       g_string_append (priv->source, "MOV result.color,output;\n");
       g_string_append (priv->source, "END\n");
 
-      if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_SHOW_SOURCE))
-        g_message ("material program:\n%s", priv->source->str);
-
-      GE (glGenPrograms (1, &priv->gl_program));
-
-      GE (glBindProgram (GL_FRAGMENT_PROGRAM_ARB, priv->gl_program));
-
-      while ((gl_error = glGetError ()) != GL_NO_ERROR)
-        ;
-      glProgramString (GL_FRAGMENT_PROGRAM_ARB,
-                       GL_PROGRAM_FORMAT_ASCII_ARB,
-                       priv->source->len,
-                       priv->source->str);
-      if (glGetError () != GL_NO_ERROR)
-        {
-          g_warning ("\n%s\n%s",
-                     priv->source->str,
-                     glGetString (GL_PROGRAM_ERROR_STRING_ARB));
-        }
+      /* Another material may have already generated the same program */
+      priv->program = arbfp_program_get (priv->source->str);
 
       priv->source = NULL;
 
       g_free (priv->sampled);
       priv->sampled = NULL;
     }
-  else
-    GE (glBindProgram (GL_FRAGMENT_PROGRAM_ARB, priv->gl_program));
+
+  GE (glBindProgram (GL_FRAGMENT_PROGRAM_ARB, priv->program->gl_program));
 
   _cogl_use_program (COGL_INVALID_HANDLE, COGL_MATERIAL_PROGRAM_TYPE_ARBFP);
 
@@ -976,11 +1088,11 @@ _cogl_material_backend_arbfp_material_pre_change_notify (
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
   if (material->backend_priv_set_mask & COGL_MATERIAL_BACKEND_ARBFP_MASK &&
-      priv->gl_program &&
+      priv->program &&
       change & fragment_op_changes)
     {
-      GE (glDeletePrograms (1, &priv->gl_program));
-      priv->gl_program = 0;
+      arbfp_program_unref (priv->program);
+      priv->program = NULL;
     }
 }
 
@@ -1027,7 +1139,8 @@ _cogl_material_backend_arbfp_free_priv (CoglMaterial *material)
       CoglMaterialBackendARBfpPrivate *priv =
         material->backend_privs[COGL_MATERIAL_BACKEND_ARBFP];
 
-      glDeletePrograms (1, &priv->gl_program);
+      if (priv->program)
+        arbfp_program_unref (priv->program);
       if (priv->sampled)
         g_free (priv->sampled);
       g_slice_free (CoglMaterialBackendARBfpPrivate, priv);
@@ -34,6 +34,7 @@
 #include "cogl-material-opengl-private.h"
 #include "cogl-material-private.h"
 #include "cogl-context.h"
+#include "cogl-gl-state-private.h"
 #include "cogl-texture-private.h"
 #ifndef HAVE_COGL_GLES
 #include "cogl-program.h"
@@ -63,7 +64,6 @@
 #ifdef HAVE_COGL_GL
 #define glActiveTexture ctx->drv.pf_glActiveTexture
 #define glClientActiveTexture ctx->drv.pf_glClientActiveTexture
-#define glBlendFuncSeparate ctx->drv.pf_glBlendFuncSeparate
 #define glBlendEquation ctx->drv.pf_glBlendEquation
 #define glBlendColor ctx->drv.pf_glBlendColor
 #define glBlendEquationSeparate ctx->drv.pf_glBlendEquationSeparate
@@ -159,7 +159,10 @@ _cogl_set_active_texture_unit (int unit_index)
     {
       GE (glActiveTexture (GL_TEXTURE0 + unit_index));
       ctx->active_texture_unit = unit_index;
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_ACTIVE_TEXTURE, FALSE);
     }
+  else
+    _cogl_gl_state_count (COGL_GL_STATE_CALL_ACTIVE_TEXTURE, TRUE);
 }
 
 void
@@ -287,7 +290,12 @@ _cogl_gl_use_program_wrapper (GLuint program)
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
   if (ctx->current_gl_program == program)
-    return;
+    {
+      _cogl_gl_state_count (COGL_GL_STATE_CALL_PROGRAM, TRUE);
+      return;
+    }
+
+  _cogl_gl_state_count (COGL_GL_STATE_CALL_PROGRAM, FALSE);
 
   if (program)
     {
@@ -444,36 +452,11 @@ blend_factor_uses_constant (GLenum blend_factor)
 static void
 flush_depth_state (CoglMaterialDepthState *depth_state)
 {
-  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
-
-  if (ctx->depth_test_function_cache != depth_state->depth_test_function)
-    {
-      GE (glDepthFunc (depth_state->depth_test_function));
-      ctx->depth_test_function_cache = depth_state->depth_test_function;
-    }
-
-  if (ctx->depth_writing_enabled_cache != depth_state->depth_writing_enabled)
-    {
-      GE (glDepthMask (depth_state->depth_writing_enabled ?
-                       GL_TRUE : GL_FALSE));
-      ctx->depth_writing_enabled_cache = depth_state->depth_writing_enabled;
-    }
-
-#ifndef COGL_HAS_GLES
-  if (ctx->depth_range_near_cache != depth_state->depth_range_near ||
-      ctx->depth_range_far_cache != depth_state->depth_range_far)
-    {
-#ifdef COGL_HAS_GLES2
-      GE (glDepthRangef (depth_state->depth_range_near,
-                         depth_state->depth_range_far));
-#else
-      GE (glDepthRange (depth_state->depth_range_near,
-                        depth_state->depth_range_far));
-#endif
-      ctx->depth_range_near_cache = depth_state->depth_range_near;
-      ctx->depth_range_far_cache = depth_state->depth_range_far;
-    }
-#endif /* COGL_HAS_GLES */
+  /* NB: Currently the Cogl defines are compatible with the GL ones: */
+  _cogl_gl_state_depth_func (depth_state->depth_test_function);
+  _cogl_gl_state_depth_mask (depth_state->depth_writing_enabled);
+  _cogl_gl_state_depth_range (depth_state->depth_range_near,
+                              depth_state->depth_range_far);
 }
 
 static void
@@ -560,18 +543,17 @@ _cogl_material_flush_color_blend_alpha_depth_state (
       else
         GE (glBlendEquation (blend_state->blend_equation_rgb));
 
-      if (have_blend_func_separate &&
-          (blend_state->blend_src_factor_rgb != blend_state->blend_src_factor_alpha ||
-           (blend_state->blend_src_factor_rgb !=
-            blend_state->blend_src_factor_alpha)))
-        GE (glBlendFuncSeparate (blend_state->blend_src_factor_rgb,
-                                 blend_state->blend_dst_factor_rgb,
-                                 blend_state->blend_src_factor_alpha,
-                                 blend_state->blend_dst_factor_alpha));
+      if (have_blend_func_separate)
+        _cogl_gl_state_blend_func (blend_state->blend_src_factor_rgb,
+                                   blend_state->blend_dst_factor_rgb,
+                                   blend_state->blend_src_factor_alpha,
+                                   blend_state->blend_dst_factor_alpha);
       else
 #endif
-        GE (glBlendFunc (blend_state->blend_src_factor_rgb,
-                         blend_state->blend_dst_factor_rgb));
+        _cogl_gl_state_blend_func (blend_state->blend_src_factor_rgb,
+                                   blend_state->blend_dst_factor_rgb,
+                                   blend_state->blend_src_factor_rgb,
+                                   blend_state->blend_dst_factor_rgb);
     }
 
   if (materials_difference & COGL_MATERIAL_STATE_ALPHA_FUNC)
@@ -592,20 +574,10 @@ _cogl_material_flush_color_blend_alpha_depth_state (
         _cogl_material_get_authority (material, COGL_MATERIAL_STATE_DEPTH);
       CoglMaterialDepthState *depth_state = &authority->big_state->depth_state;
 
+      _cogl_gl_state_set_enabled (GL_DEPTH_TEST,
+                                  depth_state->depth_test_enabled);
       if (depth_state->depth_test_enabled)
-        {
-          if (ctx->depth_test_enabled_cache != TRUE)
-            {
-              GE (glEnable (GL_DEPTH_TEST));
-              ctx->depth_test_enabled_cache = depth_state->depth_test_enabled;
-            }
-          flush_depth_state (depth_state);
-        }
-      else if (ctx->depth_test_enabled_cache != FALSE)
-        {
-          GE (glDisable (GL_DEPTH_TEST));
-          ctx->depth_test_enabled_cache = depth_state->depth_test_enabled;
-        }
+        flush_depth_state (depth_state);
     }
 
   if (materials_difference & COGL_MATERIAL_STATE_POINT_SIZE)
@@ -620,16 +592,9 @@ _cogl_material_flush_color_blend_alpha_depth_state (
         }
     }
 
-  if (material->real_blend_enable != ctx->gl_blend_enable_cache)
-    {
-      if (material->real_blend_enable)
-        GE (glEnable (GL_BLEND));
-      else
-        GE (glDisable (GL_BLEND));
-      /* XXX: we shouldn't update any other blend state if blending
-       * is disabled! */
-      ctx->gl_blend_enable_cache = material->real_blend_enable;
-    }
+  /* XXX: we shouldn't update any other blend state if blending
+   * is disabled! */
+  _cogl_gl_state_set_enabled (GL_BLEND, material->real_blend_enable);
 }
 
 static int
@@ -1087,6 +1052,22 @@ _cogl_material_flush_gl_state (CoglMaterial *material,
 
   if (ctx->current_material == material)
     materials_difference = ctx->current_material_changes_since_flush;
+  else if (ctx->current_material &&
+           ctx->current_material_changes_since_flush == 0 &&
+           _cogl_material_equal (ctx->current_material,
+                                 material,
+                                 skip_gl_color))
+    {
+      /* The material is a different node but has exactly the same
+       * state as the last one flushed so there's no top level state
+       * to update. Thanks to the cached hashes this is quick to
+       * check when the materials differ.
+       *
+       * NB: The GLSL backend only binds the user program when it sees
+       * that it changed so we still report that as a difference.
+       */
+      materials_difference = COGL_MATERIAL_STATE_USER_SHADER;
+    }
   else if (ctx->current_material)
     {
       materials_difference = ctx->current_material_changes_since_flush;
@@ -430,6 +430,15 @@ struct _CoglMaterial
    * depends on the old state. */
   unsigned long    age;
 
+  /* A hash of the state that affects how the material is flushed to
+   * OpenGL, except for the color. It is calculated lazily by
+   * _cogl_material_get_hash and is only valid if ->hash_valid is set
+   * and ->hash_age still matches ->age. Two materials with different
+   * hashes can never be equal so this lets us quickly rule out most
+   * pairs before doing a full comparison. */
+  unsigned int     hash;
+  unsigned long    hash_age;
+
   /* This is the primary color of the material.
    *
    * This is a sparse property, ref COGL_MATERIAL_STATE_COLOR */
@@ -508,6 +517,10 @@ struct _CoglMaterial
   unsigned int          layers_cache_dirty:1;
   unsigned int          deprecated_get_layers_list_dirty:1;
 
+  /* Determines if ->hash can be used. This is cleared whenever the
+   * ancestry of the material changes */
+  unsigned int          hash_valid:1;
+
   /* For debugging purposes it's possible to associate a static const
    * string with a material which can be an aid when trying to trace
    * where the material originates from */
@@ -749,6 +762,9 @@ _cogl_material_set_static_breadcrumb (CoglMaterial *material,
 unsigned long
 _cogl_material_get_age (CoglMaterial *material);
 
+unsigned int
+_cogl_material_get_hash (CoglMaterial *material);
+
 CoglMaterial *
 _cogl_material_get_authority (CoglMaterial *material,
                               unsigned long difference);
@@ -198,6 +198,7 @@ _cogl_material_init_default_material (void)
 
   material->is_weak = FALSE;
   material->journal_ref_count = 0;
+  material->hash_valid = FALSE;
   material->backend = COGL_MATERIAL_BACKEND_UNDEFINED;
   material->differences = COGL_MATERIAL_STATE_ALL_SPARSE;
 
@@ -323,6 +324,9 @@ _cogl_material_set_parent (CoglMaterial *material, CoglMaterial *parent)
   if (material->differences & COGL_MATERIAL_STATE_LAYERS)
     recursively_free_layer_caches (material);
 
+  /* Whether the hash can be cached depends on the ancestry too */
+  material->hash_valid = FALSE;
+
   /* If the fragment processing backend is also caching state along
    * with the material that depends on the material's ancestry then it
    * may be notified here...
@@ -373,6 +377,7 @@ cogl_material_copy (CoglMaterial *src)
   material->has_static_breadcrumb = FALSE;
 
   material->age = 0;
+  material->hash_valid = FALSE;
 
   _cogl_material_set_parent (material, src);
 
@@ -3150,6 +3155,220 @@ simple_property_equal (CoglMaterial *material0,
   return TRUE;
 }
 
+/* This is Bob Jenkins' one-at-a-time hash */
+static unsigned int
+_cogl_material_hash_bytes (unsigned int hash,
+                           const void *data,
+                           size_t len)
+{
+  const guint8 *p = data;
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    {
+      hash += p[i];
+      hash += (hash << 10);
+      hash ^= (hash >> 6);
+    }
+
+  return hash;
+}
+
+#define HASH_VALUE(HASH, VALUE) \
+  _cogl_material_hash_bytes ((HASH), &(VALUE), sizeof (VALUE))
+
+/* NB: the hash must only depend on state that the corresponding
+ * _equal functions compare so that equal layers always have equal
+ * hashes */
+static unsigned int
+_cogl_material_layer_hash (CoglMaterialLayer *layer,
+                           unsigned int hash)
+{
+  CoglMaterialLayer *authority;
+  CoglMaterialLayerBigState *big_state;
+  int n_args;
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                        COGL_MATERIAL_LAYER_STATE_TEXTURE);
+  hash = HASH_VALUE (hash, authority->texture);
+  hash = HASH_VALUE (hash, authority->texture_overridden);
+  if (authority->texture_overridden)
+    {
+      hash = HASH_VALUE (hash, authority->slice_gl_texture);
+      hash = HASH_VALUE (hash, authority->slice_gl_target);
+    }
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                        COGL_MATERIAL_LAYER_STATE_COMBINE);
+  big_state = authority->big_state;
+  hash = HASH_VALUE (hash, big_state->texture_combine_rgb_func);
+  n_args =
+    _cogl_get_n_args_for_combine_func (big_state->texture_combine_rgb_func);
+  hash = _cogl_material_hash_bytes (hash, big_state->texture_combine_rgb_src,
+                                    sizeof (GLint) * n_args);
+  hash = _cogl_material_hash_bytes (hash, big_state->texture_combine_rgb_op,
+                                    sizeof (GLint) * n_args);
+  hash = HASH_VALUE (hash, big_state->texture_combine_alpha_func);
+  n_args =
+    _cogl_get_n_args_for_combine_func (big_state->texture_combine_alpha_func);
+  hash = _cogl_material_hash_bytes (hash, big_state->texture_combine_alpha_src,
+                                    sizeof (GLint) * n_args);
+  hash = _cogl_material_hash_bytes (hash, big_state->texture_combine_alpha_op,
+                                    sizeof (GLint) * n_args);
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                  COGL_MATERIAL_LAYER_STATE_COMBINE_CONSTANT);
+  hash = HASH_VALUE (hash, authority->big_state->texture_combine_constant);
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                        COGL_MATERIAL_LAYER_STATE_FILTERS);
+  hash = HASH_VALUE (hash, authority->mag_filter);
+  hash = HASH_VALUE (hash, authority->min_filter);
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                        COGL_MATERIAL_LAYER_STATE_WRAP_MODES);
+  hash = HASH_VALUE (hash, authority->wrap_mode_s);
+  hash = HASH_VALUE (hash, authority->wrap_mode_t);
+  hash = HASH_VALUE (hash, authority->wrap_mode_p);
+
+  /* Only the 16 matrix components are hashed because the rest of the
+   * CoglMatrix is private state that cogl_matrix_equal ignores */
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                                        COGL_MATERIAL_LAYER_STATE_USER_MATRIX);
+  hash = _cogl_material_hash_bytes (hash, &authority->big_state->matrix,
+                                    sizeof (float) * 16);
+
+  authority =
+    _cogl_material_layer_get_authority (layer,
+                               COGL_MATERIAL_LAYER_STATE_POINT_SPRITE_COORDS);
+  hash = HASH_VALUE (hash, authority->big_state->point_sprite_coords);
+
+  return hash;
+}
+
+static unsigned int
+_cogl_material_calculate_hash (CoglMaterial *material)
+{
+  CoglMaterial *authority;
+  CoglMaterialBigState *big_state;
+  unsigned int hash = 0;
+  int real_blend_enable = material->real_blend_enable;
+  int i;
+
+  /* The color is deliberately not included because the journal
+   * compares materials ignoring the color and it's cheap to compare
+   * separately anyway */
+
+  hash = HASH_VALUE (hash, real_blend_enable);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_LIGHTING);
+  hash = HASH_VALUE (hash, authority->big_state->lighting_state);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_ALPHA_FUNC);
+  big_state = authority->big_state;
+  hash = HASH_VALUE (hash, big_state->alpha_state.alpha_func);
+  hash = HASH_VALUE (hash, big_state->alpha_state.alpha_func_reference);
+
+  /* The blend state is ignored when comparing materials with blending
+   * disabled */
+  if (real_blend_enable)
+    {
+      CoglMaterialBlendState *blend_state;
+
+      authority =
+        _cogl_material_get_authority (material, COGL_MATERIAL_STATE_BLEND);
+      blend_state = &authority->big_state->blend_state;
+#ifndef HAVE_COGL_GLES
+      hash = HASH_VALUE (hash, blend_state->blend_equation_rgb);
+      hash = HASH_VALUE (hash, blend_state->blend_equation_alpha);
+      hash = HASH_VALUE (hash, blend_state->blend_src_factor_alpha);
+      hash = HASH_VALUE (hash, blend_state->blend_dst_factor_alpha);
+      hash = _cogl_material_hash_bytes (hash, &blend_state->blend_constant,
+                                        sizeof (guint32));
+#endif
+      hash = HASH_VALUE (hash, blend_state->blend_src_factor_rgb);
+      hash = HASH_VALUE (hash, blend_state->blend_dst_factor_rgb);
+    }
+
+  /* Similarly the rest of the depth state doesn't matter if depth
+   * testing is disabled */
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_DEPTH);
+  if (authority->big_state->depth_state.depth_test_enabled)
+    hash = HASH_VALUE (hash, authority->big_state->depth_state);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_FOG);
+  big_state = authority->big_state;
+  hash = HASH_VALUE (hash, big_state->fog_state.enabled);
+  hash = _cogl_material_hash_bytes (hash, &big_state->fog_state.color,
+                                    sizeof (guint32));
+  hash = HASH_VALUE (hash, big_state->fog_state.mode);
+  hash = HASH_VALUE (hash, big_state->fog_state.density);
+  hash = HASH_VALUE (hash, big_state->fog_state.z_near);
+  hash = HASH_VALUE (hash, big_state->fog_state.z_far);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_POINT_SIZE);
+  hash = HASH_VALUE (hash, authority->big_state->point_size);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_USER_SHADER);
+  hash = HASH_VALUE (hash, authority->big_state->user_program);
+
+  authority =
+    _cogl_material_get_authority (material, COGL_MATERIAL_STATE_LAYERS);
+  hash = HASH_VALUE (hash, authority->n_layers);
+  _cogl_material_update_layers_cache (authority);
+  for (i = 0; i < authority->n_layers; i++)
+    hash = _cogl_material_layer_hash (authority->layers_cache[i], hash);
+
+  hash += (hash << 3);
+  hash ^= (hash >> 11);
+  hash += (hash << 15);
+
+  return hash;
+}
+
+#undef HASH_VALUE
+
+/* Returns a hash of the state compared by _cogl_material_equal,
+ * except for the color. Materials with different hashes are treated
+ * as different (floats such as 0 and -0 can make this a false
+ * negative, which is allowed) but materials with the same hash still
+ * need a full comparison. */
+unsigned int
+_cogl_material_get_hash (CoglMaterial *material)
+{
+  CoglMaterial *node;
+
+  if (material->hash_valid && material->hash_age == material->age)
+    return material->hash;
+
+  material->hash = _cogl_material_calculate_hash (material);
+
+  /* The age of a material only changes when it is modified directly
+   * but a weak material's parent can be modified without the child
+   * noticing so we can't cache the hash of anything that depends on
+   * a weak material. */
+  for (node = material; node; node = _cogl_material_get_parent (node))
+    if (node->is_weak)
+      return material->hash;
+
+  material->hash_age = material->age;
+  material->hash_valid = TRUE;
+
+  return material->hash;
+}
+
 /* Comparison of two arbitrary materials is done by:
  * 1) walking up the parents of each material until a common
  *    ancestor is found, and at each step ORing together the
@@ -3181,6 +3400,12 @@ _cogl_material_equal (CoglMaterial *material0,
   if (material0->real_blend_enable != material1->real_blend_enable)
     return FALSE;
 
+  /* The hashes are cached so this rules out most different materials
+   * without having to walk their ancestry */
+  if (_cogl_material_get_hash (material0) !=
+      _cogl_material_get_hash (material1))
+    return FALSE;
+
   /* Then check sparse properties */
 
   materials_difference =
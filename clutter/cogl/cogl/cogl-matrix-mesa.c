@@ -258,6 +258,30 @@ matrix_multiply3x4 (float *result, const float *a, const float *b)
   R(3,3) = 1;
 }
 
+/*
+ * Multiply a matrix by a matrix known to be a pure translation, such
+ * as the transformation of an actor that has only been positioned.
+ *
+ * \param a matrix.
+ * \param b translation matrix.
+ * \param product will receive the product of \p a and \p b.
+ *
+ * Only the last column of the product differs from \p a. \p product
+ * may be the same as either \p a or \p b.
+ */
+static void
+matrix_multiply_translation (float *result, const float *a, const float *b)
+{
+  const float tx = B(0,3), ty = B(1,3), tz = B(2,3);
+  int i;
+
+  if (result != a)
+    memcpy (result, a, 12 * sizeof (float));
+
+  for (i = 0; i < 4; i++)
+    R(i,3) = A(i,0) * tx + A(i,1) * ty + A(i,2) * tz + A(i,3);
+}
+
 #undef A
 #undef B
 #undef R
@@ -303,15 +327,33 @@ _math_matrix_multiply (CoglMatrix *result,
                        const CoglMatrix *a,
                        const CoglMatrix *b)
 {
-  result->flags = (a->flags |
-                   b->flags |
-                   MAT_DIRTY_TYPE |
-                   MAT_DIRTY_INVERSE);
-
-  if (TEST_MAT_FLAGS(result, MAT_FLAGS_3D))
+  unsigned long flags = (a->flags |
+                         b->flags |
+                         MAT_DIRTY_TYPE |
+                         MAT_DIRTY_INVERSE);
+
+  /* Most of the matrices multiplied while painting a scene are either
+   * the identity or a pure translation so those are special cased.
+   * The flags of \p result can only be updated afterwards because it
+   * may be the same as \p a or \p b */
+  if (TEST_MAT_FLAGS (b, 0))
+    {
+      if (result != a)
+        memcpy (result, a, 16 * sizeof (float));
+    }
+  else if (TEST_MAT_FLAGS (a, 0))
+    {
+      if (result != b)
+        memcpy (result, b, 16 * sizeof (float));
+    }
+  else if (TEST_MAT_FLAGS (b, MAT_FLAG_TRANSLATION))
+    matrix_multiply_translation ((float *)result, (float *)a, (float *)b);
+  else if ((MAT_FLAGS_GEOMETRY & ~MAT_FLAGS_3D & flags) == 0)
     matrix_multiply3x4 ((float *)result, (float *)a, (float *)b);
   else
     matrix_multiply4x4 ((float *)result, (float *)a, (float *)b);
+
+  result->flags = flags;
 }
 
 /*
@@ -334,6 +376,55 @@ _math_matrix_multiply_array (CoglMatrix *result, const float *array)
   matrix_multiply4x4 ((float *)result, (float *)result, (float *)array);
 }
 
+/*
+ * Transform a point (column vector) by a matrix.
+ *
+ * \param mat matrix.
+ * \param x, y, z, w the point, which is transformed in-place.
+ *
+ * Uses the matrix flags to skip the parts of the full 4x4
+ * transformation that can't have an effect, so that translated and
+ * scaled points only cost a few multiplications and the bottom row
+ * is only used for projective matrices.
+ */
+void
+_math_matrix_transform_point (const CoglMatrix *matrix,
+                              float *x, float *y, float *z, float *w)
+{
+  const float *m = (const float *)matrix;
+  const float _x = *x, _y = *y, _z = *z, _w = *w;
+
+  if (TEST_MAT_FLAGS (matrix, 0))
+    return;
+  else if (TEST_MAT_FLAGS (matrix, MAT_FLAG_TRANSLATION))
+    {
+      *x = _x + m[12] * _w;
+      *y = _y + m[13] * _w;
+      *z = _z + m[14] * _w;
+    }
+  else if (TEST_MAT_FLAGS (matrix, (MAT_FLAG_TRANSLATION |
+                                    MAT_FLAG_UNIFORM_SCALE |
+                                    MAT_FLAG_GENERAL_SCALE)))
+    {
+      *x = m[0] * _x + m[12] * _w;
+      *y = m[5] * _y + m[13] * _w;
+      *z = m[10] * _z + m[14] * _w;
+    }
+  else if (TEST_MAT_FLAGS (matrix, MAT_FLAGS_3D))
+    {
+      *x = m[0] * _x + m[4] * _y + m[8] * _z + m[12] * _w;
+      *y = m[1] * _x + m[5] * _y + m[9] * _z + m[13] * _w;
+      *z = m[2] * _x + m[6] * _y + m[10] * _z + m[14] * _w;
+    }
+  else
+    {
+      *x = m[0] * _x + m[4] * _y + m[8] * _z + m[12] * _w;
+      *y = m[1] * _x + m[5] * _y + m[9] * _z + m[13] * _w;
+      *z = m[2] * _x + m[6] * _y + m[10] * _z + m[14] * _w;
+      *w = m[3] * _x + m[7] * _y + m[11] * _z + m[15] * _w;
+    }
+}
+
 /*@}*/
 
 
@@ -110,6 +110,10 @@ _math_matrix_multiply_array (CoglMatrix *result, const float *b);
 void
 _math_matrix_init_from_array (CoglMatrix *matrix, const float *array);
 
+void
+_math_matrix_transform_point (const CoglMatrix *matrix,
+                              float *x, float *y, float *z, float *w);
+
 void
 _math_matrix_translate (CoglMatrix *matrix, float x, float y, float z);
 
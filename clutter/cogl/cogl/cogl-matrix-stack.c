@@ -34,6 +34,7 @@
 #include "cogl-internal.h"
 #include "cogl-matrix-stack.h"
 #include "cogl-framebuffer-private.h"
+#include "cogl-gl-state-private.h"
 
 typedef struct {
   CoglMatrix matrix;
@@ -57,7 +58,6 @@ struct _CoglMatrixStack
 
   /* which state does GL have, NULL if unknown */
   CoglMatrixState *flushed_state;
-  gboolean flushed_identity;
 };
 
 /* XXX: this doesn't initialize the matrix! */
@@ -442,23 +442,13 @@ _cogl_matrix_stack_flush_to_gl (CoglMatrixStack *stack,
 
       cogl_matrix_multiply (&flipped_projection,
                             &ctx->y_flip_matrix, projection);
-      GE (glLoadMatrixf (cogl_matrix_get_array (&flipped_projection)));
-      stack->flushed_identity = FALSE;
+      _cogl_gl_state_load_matrix (mode, &flipped_projection);
     }
+  else if (state->is_identity)
+    _cogl_gl_state_load_matrix (mode, NULL);
   else
-    {
-      if (state->is_identity)
-        {
-          if (!stack->flushed_identity)
-            GE (glLoadIdentity ());
-          stack->flushed_identity = TRUE;
-        }
-      else
-        {
-            GE (glLoadMatrixf (cogl_matrix_get_array (&state->matrix)));
-          stack->flushed_identity = FALSE;
-        }
-    }
+    _cogl_gl_state_load_matrix (mode, &state->matrix);
+
   stack->flushed_state = state;
 }
 
@@ -466,6 +456,5 @@ void
 _cogl_matrix_stack_dirty (CoglMatrixStack *stack)
 {
   stack->flushed_state = NULL;
-  stack->flushed_identity = FALSE;
 }
 
@@ -382,12 +382,16 @@ cogl_matrix_transform_point (const CoglMatrix *matrix,
                              float *z,
                              float *w)
 {
+#ifndef USE_MESA_MATRIX_API
   float _x = *x, _y = *y, _z = *z, _w = *w;
 
   *x = matrix->xx * _x + matrix->xy * _y + matrix->xz * _z + matrix->xw * _w;
   *y = matrix->yx * _x + matrix->yy * _y + matrix->yz * _z + matrix->yw * _w;
   *z = matrix->zx * _x + matrix->zy * _y + matrix->zz * _z + matrix->zw * _w;
   *w = matrix->wx * _x + matrix->wy * _y + matrix->wz * _z + matrix->ww * _w;
+#else
+  _math_matrix_transform_point (matrix, x, y, z, w);
+#endif
 }
 
 
@@ -58,6 +58,7 @@ typedef struct _CoglBezCubic
 } CoglBezCubic;
 
 typedef struct _CoglPathData CoglPathData;
+typedef struct _CoglPathFill CoglPathFill;
 
 struct _CoglPath
 {
@@ -80,6 +81,36 @@ struct _CoglPathData
   floatVec2         path_nodes_min;
   floatVec2         path_nodes_max;
 
+  /* The tesselated fill for the current nodes or NULL if the path
+     hasn't been filled since it was last modified */
+  CoglPathFill     *fill;
+  /* The fill from before the path was last modified. This is only
+     kept when async tesselation is enabled so that it can be drawn
+     until the new fill is ready */
+  CoglPathFill     *prev_fill;
+};
+
+/* The result of tesselating a path. These are shared between all
+   paths with the same geometry by keeping them in a cache in the
+   context keyed by the nodes and the fill rule */
+struct _CoglPathFill
+{
+  unsigned int      ref_count;
+
+  /* A copy of the nodes that were tesselated. This is part of the
+     key for the cache so it must never be modified */
+  GArray           *path_nodes;
+  CoglPathFillRule  fill_rule;
+  unsigned int      hash;
+
+  /* The link in ctx->path_fill_cache_lru or NULL if the fill has been
+     evicted from the cache */
+  GList            *cache_link;
+
+  /* TRUE while the nodes are being tesselated in a thread. The vbo
+     is only valid once this is FALSE */
+  gboolean          pending;
+
   CoglHandle        vbo;
   unsigned int      vbo_n_vertices;
   CoglHandle        vbo_indices;
@@ -103,4 +134,10 @@ _cogl_path_get_bounds (CoglPath *path,
                        float *max_x,
                        float *max_y);
 
+void
+_cogl_path_fill_cache_init (void);
+
+void
+_cogl_path_fill_cache_free (void);
+
 #endif /* __COGL_PATH_PRIVATE_H */
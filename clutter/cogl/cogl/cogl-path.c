@@ -35,6 +35,7 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-path-private.h"
 #include "cogl-texture-private.h"
+#include "cogl-gl-state-private.h"
 #include "tesselator/tesselator.h"
 
 #include <string.h>
@@ -42,16 +43,58 @@
 
 #define _COGL_MAX_BEZ_RECURSE_DEPTH 16
 
+/* The maximum number of tesselated fills to keep in the cache */
+#define COGL_PATH_FILL_CACHE_SIZE 256
+
+/* The number of threads used for async tesselation */
+#define COGL_PATH_TESSELATION_THREADS 2
+
 #ifdef HAVE_COGL_GL
 #define glClientActiveTexture ctx->drv.pf_glClientActiveTexture
 #endif
 
 static void _cogl_path_free (CoglPath *path);
 
-static void _cogl_path_build_vbo (CoglPath *path);
+static CoglPathFill *_cogl_path_get_fill (CoglPath *path,
+                                          gboolean allow_async);
+
+static void _cogl_path_fill_build (CoglPathFill *fill);
 
 COGL_OBJECT_DEFINE (Path, path);
 
+/* Async tesselation state. The jobs are queued and uploaded on the
+   main thread so only the list of finished jobs and the counter need
+   to be protected by the mutex */
+static GThreadPool *_cogl_path_thread_pool = NULL;
+static GMutex *_cogl_path_thread_mutex = NULL;
+static GSList *_cogl_path_finished_jobs = NULL;
+static int _cogl_path_n_pending_jobs = 0;
+
+static CoglPathFill *
+_cogl_path_fill_ref (CoglPathFill *fill)
+{
+  fill->ref_count++;
+
+  return fill;
+}
+
+static void
+_cogl_path_fill_unref (CoglPathFill *fill)
+{
+  if (--fill->ref_count <= 0)
+    {
+      g_array_free (fill->path_nodes, TRUE);
+
+      if (fill->vbo)
+        {
+          cogl_handle_unref (fill->vbo);
+          cogl_handle_unref (fill->vbo_indices);
+        }
+
+      g_slice_free (CoglPathFill, fill);
+    }
+}
+
 static void
 _cogl_path_data_unref (CoglPathData *data)
 {
@@ -59,16 +102,35 @@ _cogl_path_data_unref (CoglPathData *data)
     {
       g_array_free (data->path_nodes, TRUE);
 
-      if (data->vbo)
-        {
-          cogl_handle_unref (data->vbo);
-          cogl_handle_unref (data->vbo_indices);
-        }
+      if (data->fill)
+        _cogl_path_fill_unref (data->fill);
+      if (data->prev_fill)
+        _cogl_path_fill_unref (data->prev_fill);
 
       g_slice_free (CoglPathData, data);
     }
 }
 
+/* Called when the nodes of @data no longer match @fill. This takes
+   ownership of the reference */
+static void
+_cogl_path_data_discard_fill (CoglPathData *data,
+                              CoglPathFill *fill)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* With async tesselation the old fill is kept so that it can be
+     drawn until the new one is ready */
+  if (ctx->async_path_fill && !fill->pending)
+    {
+      if (data->prev_fill)
+        _cogl_path_fill_unref (data->prev_fill);
+      data->prev_fill = fill;
+    }
+  else
+    _cogl_path_fill_unref (fill);
+}
+
 static void
 _cogl_path_modify (CoglPath *path)
 {
@@ -88,19 +150,23 @@ _cogl_path_modify (CoglPath *path)
                            old_data->path_nodes->data,
                            old_data->path_nodes->len);
 
-      path->data->vbo = COGL_INVALID_HANDLE;
-      path->data->vbo_indices = COGL_INVALID_HANDLE;
+      path->data->fill = NULL;
+      path->data->prev_fill = NULL;
       path->data->ref_count = 1;
 
+      if (old_data->fill)
+        _cogl_path_data_discard_fill (path->data,
+                                      _cogl_path_fill_ref (old_data->fill));
+
       _cogl_path_data_unref (old_data);
     }
-  /* The path is altered so the vbo will now be invalid */
-  else if (path->data->vbo)
+  /* The path is altered so the fill will now be invalid */
+  else if (path->data->fill)
     {
-      cogl_handle_unref (path->data->vbo);
-      cogl_handle_unref (path->data->vbo_indices);
-      path->data->vbo = COGL_INVALID_HANDLE;
-      path->data->vbo_indices = COGL_INVALID_HANDLE;
+      CoglPathFill *fill = path->data->fill;
+
+      path->data->fill = NULL;
+      _cogl_path_data_discard_fill (path->data, fill);
     }
 }
 
@@ -297,9 +363,72 @@ _cogl_path_fill_nodes_with_stencil_buffer (CoglPath *path)
   _cogl_clip_state_dirty (clip_state);
 }
 
+static void
+_cogl_path_fill_draw (CoglPathFill *fill)
+{
+  cogl_vertex_buffer_draw_elements (fill->vbo,
+                                    COGL_VERTICES_MODE_TRIANGLES,
+                                    fill->vbo_indices,
+                                    0, fill->vbo_n_vertices - 1,
+                                    0, fill->vbo_n_indices);
+}
+
+/* Draws the interior of the path into the stencil buffer using the
+   GL_INVERT stencil op that _cogl_add_path_to_stencil_buffer sets
+   up */
+static void
+_cogl_path_fill_nodes_to_stencil (CoglPath *path)
+{
+  CoglPathData *data = path->data;
+  CoglPathFill *fill = data->fill;
+  unsigned int path_start = 0;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (fill && !fill->pending)
+    {
+      _cogl_path_fill_draw (fill);
+      return;
+    }
+
+  /* With the even-odd rule the tesselation isn't needed because
+     inverting the stencil for a fan of each sub path gives the same
+     result. This saves waiting for an async tesselation */
+  if (data->fill_rule != COGL_PATH_FILL_RULE_EVEN_ODD)
+    {
+      fill = _cogl_path_get_fill (path, FALSE);
+
+      if (fill->pending)
+        _cogl_path_fill_build (fill);
+
+      _cogl_path_fill_draw (fill);
+      return;
+    }
+
+  /* Disable all client texture coordinate arrays */
+  _cogl_bitmask_clear_all (&ctx->temp_bitmask);
+  _cogl_disable_other_texcoord_arrays (&ctx->temp_bitmask);
+
+  /* The nodes are drawn straight from client memory */
+  if (cogl_features_available (COGL_FEATURE_VBOS))
+    _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER, 0);
+
+  while (path_start < data->path_nodes->len)
+    {
+      CoglPathNode *node = &g_array_index (data->path_nodes, CoglPathNode,
+                                           path_start);
+
+      GE( glVertexPointer (2, GL_FLOAT, sizeof (CoglPathNode), &node->x) );
+      GE( glDrawArrays (GL_TRIANGLE_FAN, 0, node->path_size) );
+
+      path_start += node->path_size;
+    }
+}
+
 static void
 _cogl_path_fill_nodes (CoglPath *path)
 {
+  CoglPathFill *fill;
   const GList *l;
 
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
@@ -336,13 +465,33 @@ _cogl_path_fill_nodes (CoglPath *path)
         }
     }
 
-  _cogl_path_build_vbo (path);
+  fill = _cogl_path_get_fill (path, TRUE);
 
-  cogl_vertex_buffer_draw_elements (path->data->vbo,
-                                    COGL_VERTICES_MODE_TRIANGLES,
-                                    path->data->vbo_indices,
-                                    0, path->data->vbo_n_vertices - 1,
-                                    0, path->data->vbo_n_indices);
+  if (fill->pending)
+    {
+      CoglPathFill *prev_fill = path->data->prev_fill;
+
+      /* Pick up any tesselations that have finished since the last
+         frame */
+      _cogl_path_upload_pending_fills ();
+
+      /* Until the new fill is ready we can draw the fill from before
+         the path was modified or use the stencil buffer */
+      if (!fill->pending)
+        ;
+      else if (prev_fill && !prev_fill->pending)
+        fill = prev_fill;
+      else if (path->data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD &&
+               cogl_features_available (COGL_FEATURE_STENCIL_BUFFER))
+        {
+          _cogl_path_fill_nodes_with_stencil_buffer (path);
+          return;
+        }
+      else
+        _cogl_path_fill_build (fill);
+    }
+
+  _cogl_path_fill_draw (fill);
 }
 
 void
@@ -378,15 +527,15 @@ _cogl_add_path_to_stencil_buffer (CoglPath  *path,
 
   _cogl_enable (enable_flags);
 
-  GE( glEnable (GL_STENCIL_TEST) );
+  _cogl_gl_state_set_enabled (GL_STENCIL_TEST, TRUE);
 
   GE( glColorMask (FALSE, FALSE, FALSE, FALSE) );
-  GE( glDepthMask (FALSE) );
+  _cogl_gl_state_depth_mask (FALSE);
 
   if (merge)
     {
-      GE (glStencilMask (2));
-      GE (glStencilFunc (GL_LEQUAL, 0x2, 0x6));
+      _cogl_gl_state_stencil_mask (2);
+      _cogl_gl_state_stencil_func (GL_LEQUAL, 0x2, 0x6);
     }
   else
     {
@@ -402,8 +551,8 @@ _cogl_add_path_to_stencil_buffer (CoglPath  *path,
       else
         {
           /* Just clear the bounding box */
-          GE( glStencilMask (~(GLuint) 0) );
-          GE( glStencilOp (GL_ZERO, GL_ZERO, GL_ZERO) );
+          _cogl_gl_state_stencil_mask (~(GLuint) 0);
+          _cogl_gl_state_stencil_op (GL_ZERO, GL_ZERO, GL_ZERO);
           cogl_rectangle (data->path_nodes_min.x,
                           data->path_nodes_min.y,
                           data->path_nodes_max.x,
@@ -417,22 +566,22 @@ _cogl_add_path_to_stencil_buffer (CoglPath  *path,
                                           COGL_MATRIX_MODELVIEW);
           _cogl_enable (enable_flags);
         }
-      GE (glStencilMask (1));
-      GE (glStencilFunc (GL_LEQUAL, 0x1, 0x3));
+      _cogl_gl_state_stencil_mask (1);
+      _cogl_gl_state_stencil_func (GL_LEQUAL, 0x1, 0x3);
     }
 
-  GE (glStencilOp (GL_INVERT, GL_INVERT, GL_INVERT));
+  _cogl_gl_state_stencil_op (GL_INVERT, GL_INVERT, GL_INVERT);
 
   if (path->data->path_nodes->len > 0)
-    _cogl_path_fill_nodes (path);
+    _cogl_path_fill_nodes_to_stencil (path);
 
   if (merge)
     {
       /* Now we have the new stencil buffer in bit 1 and the old
          stencil buffer in bit 0 so we need to intersect them */
-      GE (glStencilMask (3));
-      GE (glStencilFunc (GL_NEVER, 0x2, 0x3));
-      GE (glStencilOp (GL_DECR, GL_DECR, GL_DECR));
+      _cogl_gl_state_stencil_mask (3);
+      _cogl_gl_state_stencil_func (GL_NEVER, 0x2, 0x3);
+      _cogl_gl_state_stencil_op (GL_DECR, GL_DECR, GL_DECR);
       /* Decrement all of the bits twice so that only pixels where the
          value is 3 will remain */
 
@@ -456,12 +605,12 @@ _cogl_add_path_to_stencil_buffer (CoglPath  *path,
       _cogl_matrix_stack_pop (projection_stack);
     }
 
-  GE (glStencilMask (~(GLuint) 0));
-  GE (glDepthMask (TRUE));
+  _cogl_gl_state_stencil_mask (~(GLuint) 0);
+  _cogl_gl_state_depth_mask (TRUE);
   GE (glColorMask (TRUE, TRUE, TRUE, TRUE));
 
-  GE (glStencilFunc (GL_EQUAL, 0x1, 0x1));
-  GE (glStencilOp (GL_KEEP, GL_KEEP, GL_KEEP));
+  _cogl_gl_state_stencil_func (GL_EQUAL, 0x1, 0x1);
+  _cogl_gl_state_stencil_op (GL_KEEP, GL_KEEP, GL_KEEP);
 
   /* restore the original material */
   cogl_set_source (prev_source);
@@ -978,8 +1127,8 @@ _cogl_path_new (void)
   data->fill_rule = COGL_PATH_FILL_RULE_EVEN_ODD;
   data->path_nodes = g_array_new (FALSE, FALSE, sizeof (CoglPathNode));
   data->last_path = 0;
-  data->vbo = COGL_INVALID_HANDLE;
-  data->vbo_indices = COGL_INVALID_HANDLE;
+  data->fill = NULL;
+  data->prev_fill = NULL;
 
   return _cogl_path_object_new (path);
 }
@@ -1384,29 +1533,44 @@ _cogl_path_tesselator_combine (double coords[3],
     }
 }
 
+/* Tesselates @path_nodes into tess->vertices and tess->indices. This
+   doesn't touch the Cogl context so it can be called from a thread */
 static void
-_cogl_path_build_vbo (CoglPath *path)
+_cogl_path_tesselate (GArray *path_nodes,
+                      CoglPathFillRule fill_rule,
+                      CoglPathTesselator *tess)
 {
-  CoglPathTesselator tess;
   unsigned int path_start = 0;
-  CoglPathData *data = path->data;
+  floatVec2 nodes_min, nodes_max;
   int i;
 
-  /* If we've already got a vbo then we don't need to do anything */
-  if (data->vbo)
-    return;
+  tess->primitive_type = GL_FALSE;
 
-  tess.primitive_type = GL_FALSE;
+  /* Work out the bounding box of the nodes for the texture
+     coordinates. The path data has this as well but the thread only
+     gets the nodes */
+  nodes_min.x = nodes_max.x = g_array_index (path_nodes, CoglPathNode, 0).x;
+  nodes_min.y = nodes_max.y = g_array_index (path_nodes, CoglPathNode, 0).y;
+  for (i = 1; i < path_nodes->len; i++)
+    {
+      CoglPathNode *node = &g_array_index (path_nodes, CoglPathNode, i);
+
+      if (node->x < nodes_min.x) nodes_min.x = node->x;
+      if (node->x > nodes_max.x) nodes_max.x = node->x;
+      if (node->y < nodes_min.y) nodes_min.y = node->y;
+      if (node->y > nodes_max.y) nodes_max.y = node->y;
+    }
 
   /* Generate a vertex for each point on the path */
-  tess.vertices = g_array_new (FALSE, FALSE, sizeof (CoglPathTesselatorVertex));
-  g_array_set_size (tess.vertices, data->path_nodes->len);
-  for (i = 0; i < data->path_nodes->len; i++)
+  tess->vertices = g_array_new (FALSE, FALSE,
+                                sizeof (CoglPathTesselatorVertex));
+  g_array_set_size (tess->vertices, path_nodes->len);
+  for (i = 0; i < path_nodes->len; i++)
     {
       CoglPathNode *node =
-        &g_array_index (data->path_nodes, CoglPathNode, i);
+        &g_array_index (path_nodes, CoglPathNode, i);
       CoglPathTesselatorVertex *vertex =
-        &g_array_index (tess.vertices, CoglPathTesselatorVertex, i);
+        &g_array_index (tess->vertices, CoglPathTesselatorVertex, i);
 
       vertex->x = node->x;
       vertex->y = node->y;
@@ -1414,93 +1578,408 @@ _cogl_path_build_vbo (CoglPath *path)
       /* Add texture coordinates so that a texture would be drawn to
          fit the bounding box of the path and then cropped by the
          path */
-      if (data->path_nodes_min.x == data->path_nodes_max.x)
+      if (nodes_min.x == nodes_max.x)
         vertex->s = 0.0f;
       else
-        vertex->s = ((node->x - data->path_nodes_min.x)
-                     / (data->path_nodes_max.x - data->path_nodes_min.x));
-      if (data->path_nodes_min.y == data->path_nodes_max.y)
+        vertex->s = ((node->x - nodes_min.x)
+                     / (nodes_max.x - nodes_min.x));
+      if (nodes_min.y == nodes_max.y)
         vertex->t = 0.0f;
       else
-        vertex->t = ((node->y - data->path_nodes_min.y)
-                     / (data->path_nodes_max.y - data->path_nodes_min.y));
+        vertex->t = ((node->y - nodes_min.y)
+                     / (nodes_max.y - nodes_min.y));
     }
 
-  tess.indices_type =
-    _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
-  _cogl_path_tesselator_allocate_indices_array (&tess);
+  tess->indices_type =
+    _cogl_path_tesselator_get_indices_type_for_size (path_nodes->len);
+  _cogl_path_tesselator_allocate_indices_array (tess);
+
+  /* The mesh is allocated from an arena that is kept for the thread
+     between tesselations */
+  _cogl_tess_arena_begin ();
 
-  tess.glu_tess = gluNewTess ();
+  tess->glu_tess = gluNewTess ();
 
-  if (data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
+  if (fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
+    gluTessProperty (tess->glu_tess, GLU_TESS_WINDING_RULE,
                      GLU_TESS_WINDING_ODD);
   else
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
+    gluTessProperty (tess->glu_tess, GLU_TESS_WINDING_RULE,
                      GLU_TESS_WINDING_NONZERO);
 
   /* All vertices are on the xy-plane */
-  gluTessNormal (tess.glu_tess, 0.0, 0.0, 1.0);
+  gluTessNormal (tess->glu_tess, 0.0, 0.0, 1.0);
 
-  gluTessCallback (tess.glu_tess, GLU_TESS_BEGIN_DATA,
+  gluTessCallback (tess->glu_tess, GLU_TESS_BEGIN_DATA,
                    _cogl_path_tesselator_begin);
-  gluTessCallback (tess.glu_tess, GLU_TESS_VERTEX_DATA,
+  gluTessCallback (tess->glu_tess, GLU_TESS_VERTEX_DATA,
                    _cogl_path_tesselator_vertex);
-  gluTessCallback (tess.glu_tess, GLU_TESS_END_DATA,
+  gluTessCallback (tess->glu_tess, GLU_TESS_END_DATA,
                    _cogl_path_tesselator_end);
-  gluTessCallback (tess.glu_tess, GLU_TESS_COMBINE_DATA,
+  gluTessCallback (tess->glu_tess, GLU_TESS_COMBINE_DATA,
                    _cogl_path_tesselator_combine);
 
-  gluTessBeginPolygon (tess.glu_tess, &tess);
+  gluTessBeginPolygon (tess->glu_tess, tess);
 
-  while (path_start < data->path_nodes->len)
+  while (path_start < path_nodes->len)
     {
       CoglPathNode *node =
-        &g_array_index (data->path_nodes, CoglPathNode, path_start);
+        &g_array_index (path_nodes, CoglPathNode, path_start);
 
-      gluTessBeginContour (tess.glu_tess);
+      gluTessBeginContour (tess->glu_tess);
 
       for (i = 0; i < node->path_size; i++)
         {
           double vertex[3] = { node[i].x, node[i].y, 0.0 };
-          gluTessVertex (tess.glu_tess, vertex,
+          gluTessVertex (tess->glu_tess, vertex,
                          GINT_TO_POINTER (i + path_start));
         }
 
-      gluTessEndContour (tess.glu_tess);
+      gluTessEndContour (tess->glu_tess);
 
       path_start += node->path_size;
     }
 
-  gluTessEndPolygon (tess.glu_tess);
+  gluTessEndPolygon (tess->glu_tess);
+
+  gluDeleteTess (tess->glu_tess);
 
-  gluDeleteTess (tess.glu_tess);
+  _cogl_tess_arena_end ();
+}
 
-  data->vbo = cogl_vertex_buffer_new (tess.vertices->len);
-  cogl_vertex_buffer_add (data->vbo,
+/* Creates the vbo for @fill from the results of
+   _cogl_path_tesselate() and frees the arrays */
+static void
+_cogl_path_fill_upload (CoglPathFill *fill,
+                        CoglPathTesselator *tess)
+{
+  fill->vbo = cogl_vertex_buffer_new (tess->vertices->len);
+  cogl_vertex_buffer_add (fill->vbo,
                           "gl_Vertex",
                           2, COGL_ATTRIBUTE_TYPE_FLOAT,
                           FALSE,
                           sizeof (CoglPathTesselatorVertex),
-                          &g_array_index (tess.vertices,
+                          &g_array_index (tess->vertices,
                                           CoglPathTesselatorVertex,
                                           0).x);
-  cogl_vertex_buffer_add (data->vbo,
+  cogl_vertex_buffer_add (fill->vbo,
                           "gl_MultiTexCoord0",
                           2, COGL_ATTRIBUTE_TYPE_FLOAT,
                           FALSE,
                           sizeof (CoglPathTesselatorVertex),
-                          &g_array_index (tess.vertices,
+                          &g_array_index (tess->vertices,
                                           CoglPathTesselatorVertex,
                                           0).s);
-  cogl_vertex_buffer_submit (data->vbo);
-  data->vbo_n_vertices = tess.vertices->len;
-  data->vbo_indices =
-    cogl_vertex_buffer_indices_new (tess.indices_type,
-                                    tess.indices->data,
-                                    tess.indices->len);
-  data->vbo_n_indices = tess.indices->len;
-
-  g_array_free (tess.vertices, TRUE);
-  g_array_free (tess.indices, TRUE);
+  cogl_vertex_buffer_submit (fill->vbo);
+  fill->vbo_n_vertices = tess->vertices->len;
+  fill->vbo_indices =
+    cogl_vertex_buffer_indices_new (tess->indices_type,
+                                    tess->indices->data,
+                                    tess->indices->len);
+  fill->vbo_n_indices = tess->indices->len;
+
+  g_array_free (tess->vertices, TRUE);
+  g_array_free (tess->indices, TRUE);
+
+  fill->pending = FALSE;
+}
+
+/* Tesselates @fill on the calling thread. If the fill was also queued
+   for a thread then the result from the thread will be ignored */
+static void
+_cogl_path_fill_build (CoglPathFill *fill)
+{
+  CoglPathTesselator tess;
+
+  _cogl_path_tesselate (fill->path_nodes, fill->fill_rule, &tess);
+  _cogl_path_fill_upload (fill, &tess);
+}
+
+typedef struct _CoglPathFillJob
+{
+  /* The job holds a reference to the fill but the thread only reads
+     the nodes and the fill rule which never change */
+  CoglPathFill *fill;
+  CoglPathTesselator tess;
+} CoglPathFillJob;
+
+static void
+_cogl_path_thread_func (gpointer data,
+                        gpointer user_data)
+{
+  CoglPathFillJob *job = data;
+
+  _cogl_path_tesselate (job->fill->path_nodes, job->fill->fill_rule,
+                        &job->tess);
+
+  g_mutex_lock (_cogl_path_thread_mutex);
+  _cogl_path_finished_jobs = g_slist_prepend (_cogl_path_finished_jobs, job);
+  g_mutex_unlock (_cogl_path_thread_mutex);
+}
+
+/* Takes the jobs that the threads have finished and either uploads
+   them or just frees them if @upload is FALSE. Returns TRUE if there
+   were any jobs */
+static gboolean
+_cogl_path_process_finished_jobs (gboolean upload)
+{
+  GSList *jobs, *l;
+  int n_jobs = 0;
+
+  /* Steal the whole list so the threads can carry on while we
+     upload */
+  g_mutex_lock (_cogl_path_thread_mutex);
+  jobs = _cogl_path_finished_jobs;
+  _cogl_path_finished_jobs = NULL;
+  g_mutex_unlock (_cogl_path_thread_mutex);
+
+  if (jobs == NULL)
+    return FALSE;
+
+  for (l = jobs; l; l = l->next)
+    {
+      CoglPathFillJob *job = l->data;
+
+      /* The fill may have already been built on the main thread if it
+         was needed straight away */
+      if (upload && job->fill->pending)
+        _cogl_path_fill_upload (job->fill, &job->tess);
+      else
+        {
+          g_array_free (job->tess.vertices, TRUE);
+          g_array_free (job->tess.indices, TRUE);
+        }
+
+      _cogl_path_fill_unref (job->fill);
+      g_slice_free (CoglPathFillJob, job);
+      n_jobs++;
+    }
+
+  g_slist_free (jobs);
+
+  g_mutex_lock (_cogl_path_thread_mutex);
+  _cogl_path_n_pending_jobs -= n_jobs;
+  g_mutex_unlock (_cogl_path_thread_mutex);
+
+  return TRUE;
+}
+
+gboolean
+_cogl_path_upload_pending_fills (void)
+{
+  if (_cogl_path_thread_pool == NULL)
+    return FALSE;
+
+  return _cogl_path_process_finished_jobs (TRUE);
+}
+
+gboolean
+_cogl_path_has_pending_fills (void)
+{
+  gboolean ret;
+
+  if (_cogl_path_thread_pool == NULL)
+    return FALSE;
+
+  g_mutex_lock (_cogl_path_thread_mutex);
+  ret = _cogl_path_n_pending_jobs > 0;
+  g_mutex_unlock (_cogl_path_thread_mutex);
+
+  return ret;
+}
+
+static unsigned int
+_cogl_path_fill_hash_nodes (GArray *path_nodes,
+                            CoglPathFillRule fill_rule)
+{
+  const guint32 *p = (const guint32 *) path_nodes->data;
+  gsize n_words = path_nodes->len * sizeof (CoglPathNode) / sizeof (guint32);
+  unsigned int hash = fill_rule;
+  gsize i;
+
+  /* This just hashes the bits of the nodes so positive and negative
+     zero will be different but that will only cause a cache miss */
+  for (i = 0; i < n_words; i++)
+    hash = (hash << 5) + hash + p[i];
+
+  return hash;
+}
+
+static unsigned int
+_cogl_path_fill_hash (gconstpointer key)
+{
+  const CoglPathFill *fill = key;
+
+  return fill->hash;
+}
+
+static gboolean
+_cogl_path_fill_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const CoglPathFill *fill_a = a;
+  const CoglPathFill *fill_b = b;
+
+  return (fill_a->hash == fill_b->hash &&
+          fill_a->fill_rule == fill_b->fill_rule &&
+          fill_a->path_nodes->len == fill_b->path_nodes->len &&
+          memcmp (fill_a->path_nodes->data,
+                  fill_b->path_nodes->data,
+                  fill_a->path_nodes->len * sizeof (CoglPathNode)) == 0);
+}
+
+/* Returns the fill for @path, either from the path itself, from the
+   cache if another path had the same nodes or by tesselating it. If
+   @allow_async is TRUE and async tesselation is enabled then the
+   returned fill may still be pending */
+static CoglPathFill *
+_cogl_path_get_fill (CoglPath *path,
+                     gboolean allow_async)
+{
+  CoglPathData *data = path->data;
+  CoglPathFill key, *fill;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  if (data->fill)
+    return data->fill;
+
+  key.path_nodes = data->path_nodes;
+  key.fill_rule = data->fill_rule;
+  key.hash = _cogl_path_fill_hash_nodes (data->path_nodes, data->fill_rule);
+
+  fill = g_hash_table_lookup (ctx->path_fill_cache, &key);
+
+  if (fill)
+    {
+      /* Move the fill to the front of the LRU list */
+      g_queue_unlink (&ctx->path_fill_cache_lru, fill->cache_link);
+      g_queue_push_head_link (&ctx->path_fill_cache_lru, fill->cache_link);
+    }
+  else
+    {
+      fill = g_slice_new (CoglPathFill);
+      fill->ref_count = 1;
+      fill->path_nodes = g_array_sized_new (FALSE, FALSE,
+                                            sizeof (CoglPathNode),
+                                            data->path_nodes->len);
+      g_array_append_vals (fill->path_nodes,
+                           data->path_nodes->data,
+                           data->path_nodes->len);
+      fill->fill_rule = data->fill_rule;
+      fill->hash = key.hash;
+      fill->vbo = COGL_INVALID_HANDLE;
+      fill->vbo_indices = COGL_INVALID_HANDLE;
+      fill->pending = TRUE;
+
+      /* The cache takes the initial reference */
+      g_hash_table_insert (ctx->path_fill_cache, fill, fill);
+      g_queue_push_head (&ctx->path_fill_cache_lru, fill);
+      fill->cache_link = ctx->path_fill_cache_lru.head;
+
+      while (ctx->path_fill_cache_lru.length > COGL_PATH_FILL_CACHE_SIZE)
+        {
+          CoglPathFill *old_fill =
+            g_queue_pop_tail (&ctx->path_fill_cache_lru);
+
+          g_hash_table_remove (ctx->path_fill_cache, old_fill);
+          old_fill->cache_link = NULL;
+          _cogl_path_fill_unref (old_fill);
+        }
+
+      if (allow_async && ctx->async_path_fill)
+        {
+          CoglPathFillJob *job = g_slice_new (CoglPathFillJob);
+
+          job->fill = _cogl_path_fill_ref (fill);
+
+          g_mutex_lock (_cogl_path_thread_mutex);
+          _cogl_path_n_pending_jobs++;
+          g_mutex_unlock (_cogl_path_thread_mutex);
+
+          g_thread_pool_push (_cogl_path_thread_pool, job, NULL);
+        }
+      else
+        _cogl_path_fill_build (fill);
+    }
+
+  data->fill = _cogl_path_fill_ref (fill);
+
+  return fill;
+}
+
+void
+_cogl_path_fill_cache_init (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  ctx->path_fill_cache = g_hash_table_new (_cogl_path_fill_hash,
+                                           _cogl_path_fill_equal);
+  g_queue_init (&ctx->path_fill_cache_lru);
+  ctx->async_path_fill = FALSE;
+}
+
+void
+_cogl_path_fill_cache_free (void)
+{
+  CoglPathFill *fill;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (_cogl_path_thread_pool)
+    {
+      /* Wait for the queued jobs so that their references can be
+         dropped */
+      g_thread_pool_free (_cogl_path_thread_pool, FALSE, TRUE);
+      _cogl_path_process_finished_jobs (FALSE);
+
+      g_mutex_free (_cogl_path_thread_mutex);
+      _cogl_path_thread_mutex = NULL;
+      _cogl_path_thread_pool = NULL;
+      _cogl_path_n_pending_jobs = 0;
+    }
+
+  while ((fill = g_queue_pop_head (&ctx->path_fill_cache_lru)))
+    {
+      fill->cache_link = NULL;
+      _cogl_path_fill_unref (fill);
+    }
+
+  g_hash_table_destroy (ctx->path_fill_cache);
+  ctx->path_fill_cache = NULL;
+}
+
+void
+cogl_set_async_path_fill_enabled (gboolean enabled)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* Without threads there is nothing to gain so we just keep
+     tesselating on the paint path */
+  if (enabled && !g_thread_supported ())
+    return;
+
+  if (enabled && _cogl_path_thread_pool == NULL)
+    {
+      _cogl_path_thread_mutex = g_mutex_new ();
+      _cogl_path_thread_pool =
+        g_thread_pool_new (_cogl_path_thread_func,
+                           NULL,
+                           COGL_PATH_TESSELATION_THREADS,
+                           FALSE,
+                           NULL);
+    }
+
+  /* The thread pool is kept when async fills are disabled again
+     because there may still be jobs in it. They will be uploaded the
+     next time a pending fill is drawn */
+  ctx->async_path_fill = enabled && _cogl_path_thread_pool != NULL;
+}
+
+gboolean
+cogl_get_async_path_fill_enabled (void)
+{
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  return ctx->async_path_fill;
 }
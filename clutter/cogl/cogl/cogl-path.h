@@ -481,6 +481,41 @@ cogl_set_path (CoglPath *path);
 CoglPath *
 cogl_path_copy (CoglPath *path);
 
+/**
+ * cogl_set_async_path_fill_enabled:
+ * @enabled: whether to tesselate paths in a thread
+ *
+ * Sets whether paths that need to be tesselated for cogl_path_fill()
+ * should be tesselated in a thread. Until the tesselation is finished
+ * the path will be filled with the result from before it was last
+ * modified or using the stencil buffer, so the path may be drawn
+ * with the wrong shape or more slowly for a few frames. This is
+ * useful for applications that rebuild a lot of complex paths every
+ * frame.
+ *
+ * Paths with the same geometry share the same tesselation whether or
+ * not this is enabled so paths that don't change don't need to use
+ * it. This is a global setting and doesn't depend on the current
+ * path. It has no effect if threads aren't supported.
+ *
+ * Since: 1.4
+ */
+void
+cogl_set_async_path_fill_enabled (gboolean enabled);
+
+/**
+ * cogl_get_async_path_fill_enabled:
+ *
+ * Queries whether paths are tesselated in a thread. See
+ * cogl_set_async_path_fill_enabled().
+ *
+ * Return value: %TRUE if paths are tesselated in a thread
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_get_async_path_fill_enabled (void);
+
 G_END_DECLS
 
 #endif /* __COGL_PATH_H__ */
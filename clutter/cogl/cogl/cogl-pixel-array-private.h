@@ -63,6 +63,17 @@ struct _CoglPixelArray
   unsigned int          height;
   unsigned int          stride;
 
+  /* State of the last cogl_pixel_array_read_pixels(). The format of
+     the pixels stored in the array may differ from the format of the
+     array in its premult flag, and the rows are stored bottom row
+     first when they were read from an onscreen framebuffer. The
+     rectangle that was read is stored at the start of the array */
+  CoglPixelFormat       read_format;
+  unsigned int          read_width;
+  unsigned int          read_height;
+  gboolean              read_flipped;
+  /* GLsync for the pending read or NULL */
+  void                 *read_fence;
 };
 
 GQuark
@@ -45,6 +45,10 @@
 #include "cogl-object.h"
 #include "cogl-pixel-array-private.h"
 #include "cogl-pixel-array.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-texture-driver.h"
+#include "cogl-gl-state-private.h"
 
 /*
  * GL/GLES compatibility defines for the buffer API:
@@ -60,6 +64,9 @@
 #define glDeleteBuffers ctx->drv.pf_glDeleteBuffers
 #define glMapBuffer ctx->drv.pf_glMapBuffer
 #define glUnmapBuffer ctx->drv.pf_glUnmapBuffer
+#define glFenceSync ctx->drv.pf_glFenceSync
+#define glClientWaitSync ctx->drv.pf_glClientWaitSync
+#define glDeleteSync ctx->drv.pf_glDeleteSync
 
 #ifndef GL_PIXEL_UNPACK_BUFFER
 #define GL_PIXEL_UNPACK_BUFFER GL_PIXEL_UNPACK_BUFFER_ARB
@@ -69,6 +76,18 @@
 #define GL_PIXEL_PACK_BUFFER GL_PIXEL_PACK_BUFFER_ARB
 #endif
 
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+
 #elif defined (HAVE_COGL_GLES2)
 
 #include "../gles/cogl-gles2-wrapper.h"
@@ -144,18 +163,261 @@ cogl_pixel_array_new_with_size (unsigned int    width,
   pixel_array->height = height;
   pixel_array->format = format;
   pixel_array->stride = stride;
+  pixel_array->read_format = format;
+  pixel_array->read_width = width;
+  pixel_array->read_height = height;
 
   return buffer;
 }
 
+static void
+_cogl_pixel_array_delete_fence (CoglPixelArray *pixel_array)
+{
+#if defined (HAVE_COGL_GL)
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (pixel_array->read_fence)
+    {
+      glDeleteSync (pixel_array->read_fence);
+      pixel_array->read_fence = NULL;
+    }
+#endif
+}
+
+gboolean
+cogl_pixel_array_read_pixels (CoglPixelArray *pixel_array,
+                              int             x,
+                              int             y,
+                              int             width,
+                              int             height)
+{
+  CoglBuffer *buffer;
+  CoglPixelFormat format;
+  guint8 *data;
+
+  g_return_val_if_fail (cogl_is_pixel_array (pixel_array), FALSE);
+
+  buffer = COGL_BUFFER (pixel_array);
+  format = pixel_array->format;
+
+  g_return_val_if_fail (!COGL_BUFFER_FLAG_IS_SET (buffer, MAPPED), FALSE);
+  g_return_val_if_fail (width > 0 && width <= pixel_array->width, FALSE);
+  g_return_val_if_fail (height > 0 && height <= pixel_array->height, FALSE);
+
+  _cogl_pixel_array_delete_fence (pixel_array);
+
+  pixel_array->read_format = format;
+  pixel_array->read_flipped = FALSE;
+  pixel_array->read_width = width;
+  pixel_array->read_height = height;
+
+#if defined (HAVE_COGL_GL)
+  if (COGL_BUFFER_FLAG_IS_SET (buffer, BUFFER_OBJECT))
+    {
+      CoglFramebuffer *framebuffer;
+      CoglBitmap *bmp;
+      GLenum gl_intformat, gl_format, gl_type;
+      guint8 *ptr;
+
+      _COGL_GET_CONTEXT (ctx, FALSE);
+
+      if (_cogl_pixel_format_to_gl (format,
+                                    &gl_intformat,
+                                    &gl_format,
+                                    &gl_type) != format)
+        goto read_synchronously;
+
+      /* make sure any batched primitives get emitted to the GL driver
+       * before issuing our read pixels... */
+      cogl_flush ();
+
+      framebuffer = _cogl_get_framebuffer ();
+
+      _cogl_framebuffer_flush_state (framebuffer, 0);
+
+      /* The rows are flipped when the data is retrieved instead of
+         when it is read. See cogl_read_pixels() for the coordinates
+         and the premult flag */
+      if (!cogl_is_offscreen (framebuffer))
+        {
+          y = _cogl_framebuffer_get_height (framebuffer) - y - height;
+          pixel_array->read_flipped = TRUE;
+        }
+
+      if ((format & COGL_A_BIT))
+        pixel_array->read_format |= COGL_PREMULT_BIT;
+
+      bmp = _cogl_bitmap_new_from_buffer (buffer,
+                                          pixel_array->read_format,
+                                          width,
+                                          height,
+                                          pixel_array->stride,
+                                          0);
+      ptr = _cogl_bitmap_bind (bmp, COGL_BUFFER_ACCESS_WRITE, 0);
+
+      /* The store is created with a hint for reading back instead of
+         the usual hints for uploading textures */
+      if (!COGL_PIXEL_ARRAY_FLAG_IS_SET (pixel_array, STORE_CREATED))
+        {
+          GE( glBufferData (GL_PIXEL_PACK_BUFFER,
+                            buffer->size,
+                            NULL,
+                            GL_STREAM_READ) );
+          COGL_PIXEL_ARRAY_SET_FLAG (pixel_array, STORE_CREATED);
+        }
+
+      _cogl_texture_driver_prep_gl_for_pixels_download
+        (pixel_array->stride, _cogl_get_format_bpp (format));
+
+      GE( glReadPixels (x, y,
+                        width, height,
+                        gl_format, gl_type,
+                        ptr) );
+
+      _cogl_bitmap_unbind (bmp);
+      cogl_object_unref (bmp);
+
+      if (_cogl_features_available_private (COGL_FEATURE_PRIVATE_SYNC))
+        {
+          pixel_array->read_fence =
+            glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+          /* Make sure the fence reaches the GPU, otherwise polling it
+             would never see it signalled */
+          GE( glFlush () );
+        }
+
+      return TRUE;
+    }
+
+ read_synchronously:
+#endif /* HAVE_COGL_GL */
+
+  /* Without a buffer object the read can't be asynchronous so the
+     pixels are read straight into the array */
+  data = cogl_buffer_map (buffer,
+                          COGL_BUFFER_ACCESS_WRITE,
+                          COGL_BUFFER_MAP_HINT_DISCARD);
+  if (data == NULL)
+    return FALSE;
+
+  /* cogl_read_pixels() uses width * bpp as the rowstride */
+  if (width == pixel_array->width)
+    cogl_read_pixels (x, y, width, height,
+                      COGL_READ_PIXELS_COLOR_BUFFER,
+                      format,
+                      data);
+  else
+    {
+      unsigned int row_size = width * _cogl_get_format_bpp (format);
+      guint8 *pixels = g_malloc (row_size * height);
+      int row;
+
+      cogl_read_pixels (x, y, width, height,
+                        COGL_READ_PIXELS_COLOR_BUFFER,
+                        format,
+                        pixels);
+
+      for (row = 0; row < height; row++)
+        memcpy (data + row * pixel_array->stride,
+                pixels + row * row_size,
+                row_size);
+
+      g_free (pixels);
+    }
+
+  cogl_buffer_unmap (buffer);
+
+  return TRUE;
+}
+
+gboolean
+cogl_pixel_array_is_read_complete (CoglPixelArray *pixel_array)
+{
+  g_return_val_if_fail (cogl_is_pixel_array (pixel_array), FALSE);
+
+#if defined (HAVE_COGL_GL)
+  if (pixel_array->read_fence)
+    {
+      _COGL_GET_CONTEXT (ctx, FALSE);
+
+      /* A zero timeout only polls the fence */
+      if (glClientWaitSync (pixel_array->read_fence,
+                            0, 0) == GL_TIMEOUT_EXPIRED)
+        return FALSE;
+
+      _cogl_pixel_array_delete_fence (pixel_array);
+    }
+#endif
+
+  return TRUE;
+}
+
+gboolean
+cogl_pixel_array_get_data (CoglPixelArray *pixel_array,
+                           unsigned int    rowstride,
+                           guint8         *data)
+{
+  CoglBuffer *buffer;
+  unsigned int row_size, row;
+  guint8 *src;
+
+  g_return_val_if_fail (cogl_is_pixel_array (pixel_array), FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  buffer = COGL_BUFFER (pixel_array);
+
+  /* Mapping the buffer waits for the read anyway */
+  _cogl_pixel_array_delete_fence (pixel_array);
+
+  src = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (src == NULL)
+    return FALSE;
+
+  row_size = (pixel_array->read_width *
+              _cogl_get_format_bpp (pixel_array->format));
+
+  for (row = 0; row < pixel_array->read_height; row++)
+    {
+      unsigned int src_row = (pixel_array->read_flipped ?
+                              pixel_array->read_height - row - 1 :
+                              row);
+
+      memcpy (data + row * rowstride,
+              src + src_row * pixel_array->stride,
+              row_size);
+    }
+
+  cogl_buffer_unmap (buffer);
+
+  if (pixel_array->read_format != pixel_array->format)
+    {
+      CoglBitmap *bmp;
+
+      bmp = _cogl_bitmap_new_from_data (data,
+                                        pixel_array->read_format,
+                                        pixel_array->read_width,
+                                        pixel_array->read_height,
+                                        rowstride,
+                                        NULL, NULL);
+      _cogl_bitmap_convert_premult_status (bmp, pixel_array->format);
+      cogl_object_unref (bmp);
+    }
+
+  return TRUE;
+}
+
 static void
 _cogl_pixel_array_free (CoglPixelArray *buffer)
 {
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
+  _cogl_pixel_array_delete_fence (buffer);
+
   /* parent's destructor */
   _cogl_buffer_fini (COGL_BUFFER (buffer));
 
+  _cogl_gl_state_forget_buffer (COGL_BUFFER (buffer)->gl_handle);
   GE( glDeleteBuffers (1, &(COGL_BUFFER (buffer)->gl_handle)) );
 
   g_slice_free (CoglPixelArray, buffer);
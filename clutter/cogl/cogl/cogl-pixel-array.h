@@ -46,6 +46,9 @@ G_BEGIN_DECLS
 #define cogl_pixel_array_new cogl_pixel_array_new_EXP
 #define cogl_pixel_array_new_with_size cogl_pixel_array_new_with_size_EXP
 #define cogl_is_pixel_array cogl_is_pixel_array_EXP
+#define cogl_pixel_array_read_pixels cogl_pixel_array_read_pixels_EXP
+#define cogl_pixel_array_is_read_complete cogl_pixel_array_is_read_complete_EXP
+#define cogl_pixel_array_get_data cogl_pixel_array_get_data_EXP
 #if 0
 #define cogl_pixel_array_set_region cogl_pixel_array_set_region_EXP
 #endif
@@ -95,6 +98,86 @@ cogl_pixel_array_new_with_size (unsigned int     width,
 gboolean
 cogl_is_pixel_array (void *object);
 
+/**
+ * cogl_pixel_array_read_pixels:
+ * @array: a #CoglPixelArray
+ * @x: the window x position to start reading from
+ * @y: the window y position to start reading from
+ * @width: the width of the rectangle to read, no bigger than the
+ *   width of @array
+ * @height: the height of the rectangle to read, no bigger than the
+ *   height of @array
+ *
+ * Starts reading a rectangle of pixels from the color buffer of the
+ * current framebuffer into @array, converting them to the format of
+ * @array. As with cogl_read_pixels(), position (0, 0) is the top
+ * left. Reading a smaller rectangle than the size of @array allows
+ * an array to be reused for rectangles of different sizes.
+ *
+ * When the array is backed by a pixel buffer object the read is done
+ * asynchronously by the GPU, so this function returns without waiting
+ * for the framebuffer to be rendered. Use
+ * cogl_pixel_array_is_read_complete() to check whether the read has
+ * finished, typically a frame later, and cogl_pixel_array_get_data()
+ * to retrieve the pixels. Otherwise the pixels are read before this
+ * function returns.
+ *
+ * The array can be reused for another read once the data of the
+ * previous one has been retrieved.
+ *
+ * Return value: %TRUE if the read was started, %FALSE otherwise
+ *
+ * Since: 1.4
+ * Stability: Unstable
+ */
+gboolean
+cogl_pixel_array_read_pixels (CoglPixelArray *array,
+                              int             x,
+                              int             y,
+                              int             width,
+                              int             height);
+
+/**
+ * cogl_pixel_array_is_read_complete:
+ * @array: a #CoglPixelArray
+ *
+ * Checks, without blocking, whether the GPU has finished the last
+ * read started with cogl_pixel_array_read_pixels().
+ *
+ * <note>If the GL driver has no way to tell whether the read has
+ * finished this function always returns %TRUE, and
+ * cogl_pixel_array_get_data() may have to wait for the read if it is
+ * called too early.</note>
+ *
+ * Return value: %TRUE if the pixels can be retrieved without waiting
+ *
+ * Since: 1.4
+ * Stability: Unstable
+ */
+gboolean
+cogl_pixel_array_is_read_complete (CoglPixelArray *array);
+
+/**
+ * cogl_pixel_array_get_data:
+ * @array: a #CoglPixelArray
+ * @rowstride: the rowstride of @data in bytes
+ * @data: the memory to copy the pixels to
+ *
+ * Copies the rectangle of pixels read by
+ * cogl_pixel_array_read_pixels() to @data in the format of @array,
+ * with the top row first. This waits for the read to finish if it
+ * hasn't yet.
+ *
+ * Return value: %TRUE if the pixels were copied, %FALSE otherwise
+ *
+ * Since: 1.4
+ * Stability: Unstable
+ */
+gboolean
+cogl_pixel_array_get_data (CoglPixelArray *array,
+                           unsigned int    rowstride,
+                           guint8         *data);
+
 #if 0
 /*
  * cogl_pixel_array_set_region:
@@ -0,0 +1,102 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifndef __COGL_PROGRAM_CACHE_PRIVATE_H
+#define __COGL_PROGRAM_CACHE_PRIVATE_H
+
+#include "cogl.h"
+
+/*
+ * The program cache remembers the programs that Cogl generates for
+ * materials in a directory under the user's cache directory so that
+ * they can be prepared before they are first needed the next time an
+ * application is run. There is a separate directory for each GL
+ * driver so that a driver update won't make us use stale binaries.
+ *
+ * If the driver can give us a program binary then that is stored,
+ * otherwise only the source is stored and the backend compiles it
+ * when the context is created.
+ *
+ * New programs are written to the directory from an idle handler so
+ * that the file IO doesn't slow down the frame that first used them.
+ * Anything still pending is written when the context is destroyed.
+ */
+
+typedef enum
+{
+  COGL_PROGRAM_CACHE_TYPE_ARBFP,
+  COGL_PROGRAM_CACHE_TYPE_GLSL
+} CoglProgramCacheType;
+
+typedef void (* CoglProgramCacheSourceFunc) (const char *source,
+                                             void *user_data);
+
+void
+_cogl_program_cache_init (void);
+
+void
+_cogl_program_cache_free (void);
+
+/* Calls @func for each program of the given type that was read from
+ * the cache when the context was created */
+void
+_cogl_program_cache_foreach_source (CoglProgramCacheType type,
+                                    CoglProgramCacheSourceFunc func,
+                                    void *user_data);
+
+void
+_cogl_program_cache_add_source (CoglProgramCacheType type,
+                                const char *source);
+
+/* Tries to initialize @gl_program from a binary stored for @source.
+ * If this returns FALSE the program needs to be compiled and linked
+ * as normal */
+gboolean
+_cogl_program_cache_load_binary (const char *source,
+                                 GLuint gl_program);
+
+/* Stores the binary of the linked program @gl_program, if the driver
+ * supports it, so that _cogl_program_cache_load_binary can use it
+ * next time */
+void
+_cogl_program_cache_add_binary (const char *source,
+                                GLuint gl_program);
+
+/* These should be called around any code that builds a program so
+ * that the time taken can be reported by _cogl_end_program_build_log.
+ * They must not be nested */
+void
+_cogl_program_build_begin (void);
+
+void
+_cogl_program_build_end (void);
+
+/* This should be used instead of _cogl_program_build_end after
+ * compiling a shader on its own. The time taken is added to the entry
+ * for the next program that is linked so that each program is only
+ * counted once */
+void
+_cogl_program_build_end_shader (void);
+
+#endif /* __COGL_PROGRAM_CACHE_PRIVATE_H */
@@ -0,0 +1,585 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl.h"
+#include "cogl-internal.h"
+#include "cogl-context.h"
+#include "cogl-debug.h"
+#include "cogl-program-cache-private.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+
+#ifdef HAVE_COGL_GLES2
+
+#define glGetProgramBinary ctx->drv.pf_glGetProgramBinary
+#define glProgramBinary ctx->drv.pf_glProgramBinary
+
+#ifndef GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_PROGRAM_BINARY_LENGTH_OES 0x8741
+#endif
+
+#endif /* HAVE_COGL_GLES2 */
+
+/* Each program is stored in a separate file named after a checksum of
+   its source. The file contains a CoglProgramCacheHeader followed by
+   the source and then the binary, if there is one */
+#define COGL_PROGRAM_CACHE_SUFFIX   ".cogl-program"
+#define COGL_PROGRAM_CACHE_MAGIC    "CoglPrg"
+/* The version is also used to detect files written with a different
+   byte order */
+#define COGL_PROGRAM_CACHE_VERSION  1
+
+/* Materials with animated combine constants generate a new program
+   for every value so we need to stop remembering programs at some
+   point */
+#define COGL_PROGRAM_CACHE_MAX_ENTRIES 256
+
+typedef struct _CoglProgramCacheHeader
+{
+  char    magic[8];
+  guint32 version;
+  guint32 type;
+  guint32 binary_format;
+  guint32 source_length;
+  guint32 binary_length;
+} CoglProgramCacheHeader;
+
+typedef struct _CoglProgramCacheEntry
+{
+  CoglProgramCacheType type;
+  char *source;
+
+  GLenum binary_format;
+  guint8 *binary;
+  gsize binary_length;
+} CoglProgramCacheEntry;
+
+static void
+_cogl_program_cache_entry_free (CoglProgramCacheEntry *entry)
+{
+  g_free (entry->source);
+  g_free (entry->binary);
+  g_slice_free (CoglProgramCacheEntry, entry);
+}
+
+static char *
+_cogl_program_cache_get_dir (void)
+{
+  static const GLenum driver_strings[] =
+    { GL_VENDOR, GL_RENDERER, GL_VERSION };
+  GChecksum *checksum;
+  const char *env_string;
+  char *dir;
+  int i;
+
+  /* The binaries are only valid for the driver that created them and
+     the sources are only useful for the version of Cogl that
+     generated them so both are used to pick the directory */
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+
+  for (i = 0; i < G_N_ELEMENTS (driver_strings); i++)
+    {
+      const char *str = (const char *) glGetString (driver_strings[i]);
+
+      if (str)
+        g_checksum_update (checksum, (const guchar *) str, -1);
+      g_checksum_update (checksum, (const guchar *) "\n", 1);
+    }
+
+  g_checksum_update (checksum, (const guchar *) PACKAGE_VERSION, -1);
+
+  /* COGL_PROGRAM_CACHE_DIR can be used to keep the cache somewhere
+     other than the user's cache directory */
+  if ((env_string = g_getenv ("COGL_PROGRAM_CACHE_DIR")) != NULL)
+    dir = g_build_filename (env_string,
+                            g_checksum_get_string (checksum),
+                            NULL);
+  else
+    dir = g_build_filename (g_get_user_cache_dir (),
+                            "cogl", "programs",
+                            g_checksum_get_string (checksum),
+                            NULL);
+
+  g_checksum_free (checksum);
+
+  return dir;
+}
+
+static char *
+_cogl_program_cache_get_filename (const char *source)
+{
+  char *checksum, *basename, *filename;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, source, -1);
+  basename = g_strconcat (checksum, COGL_PROGRAM_CACHE_SUFFIX, NULL);
+  filename = g_build_filename (ctx->program_cache_dir, basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+static CoglProgramCacheEntry *
+_cogl_program_cache_read_entry (const char *filename)
+{
+  const CoglProgramCacheHeader *header;
+  CoglProgramCacheEntry *entry;
+  gchar *contents;
+  gsize length;
+
+  if (!g_file_get_contents (filename, &contents, &length, NULL))
+    return NULL;
+
+  header = (const CoglProgramCacheHeader *) contents;
+
+  if (length < sizeof (CoglProgramCacheHeader) ||
+      memcmp (header->magic, COGL_PROGRAM_CACHE_MAGIC,
+              sizeof (header->magic)) != 0 ||
+      header->version != COGL_PROGRAM_CACHE_VERSION ||
+      header->type > COGL_PROGRAM_CACHE_TYPE_GLSL ||
+      header->source_length == 0 ||
+      length != (sizeof (CoglProgramCacheHeader) +
+                 (guint64) header->source_length +
+                 header->binary_length))
+    {
+      COGL_NOTE (DRAW, "Ignoring invalid program cache file %s", filename);
+      g_free (contents);
+      return NULL;
+    }
+
+  entry = g_slice_new (CoglProgramCacheEntry);
+  entry->type = header->type;
+  entry->source = g_strndup (contents + sizeof (CoglProgramCacheHeader),
+                             header->source_length);
+  entry->binary_format = header->binary_format;
+  entry->binary_length = header->binary_length;
+  if (entry->binary_length)
+    entry->binary = g_memdup (contents + sizeof (CoglProgramCacheHeader) +
+                              header->source_length,
+                              header->binary_length);
+  else
+    entry->binary = NULL;
+
+  g_free (contents);
+
+  return entry;
+}
+
+static void
+_cogl_program_cache_write_entry (CoglProgramCacheEntry *entry)
+{
+  CoglProgramCacheHeader header;
+  gchar *contents, *filename;
+  gsize length;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (g_mkdir_with_parents (ctx->program_cache_dir, 0700) != 0)
+    return;
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, COGL_PROGRAM_CACHE_MAGIC, sizeof (header.magic));
+  header.version = COGL_PROGRAM_CACHE_VERSION;
+  header.type = entry->type;
+  header.binary_format = entry->binary_format;
+  header.source_length = strlen (entry->source);
+  header.binary_length = entry->binary_length;
+
+  length = sizeof (header) + header.source_length + header.binary_length;
+  contents = g_malloc (length);
+  memcpy (contents, &header, sizeof (header));
+  memcpy (contents + sizeof (header), entry->source, header.source_length);
+  if (entry->binary_length)
+    memcpy (contents + sizeof (header) + header.source_length,
+            entry->binary, entry->binary_length);
+
+  filename = _cogl_program_cache_get_filename (entry->source);
+
+  /* Failing to write the cache isn't fatal, the program will just
+     have to be compiled again next time */
+  if (!g_file_set_contents (filename, contents, length, NULL))
+    COGL_NOTE (DRAW, "Failed to write program cache file %s", filename);
+
+  g_free (filename);
+  g_free (contents);
+}
+
+static void
+_cogl_program_cache_sync (void)
+{
+  GSList *l;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->program_cache_write_idle)
+    {
+      g_source_remove (ctx->program_cache_write_idle);
+      ctx->program_cache_write_idle = 0;
+    }
+
+  ctx->program_cache_pending = g_slist_reverse (ctx->program_cache_pending);
+
+  for (l = ctx->program_cache_pending; l; l = l->next)
+    _cogl_program_cache_write_entry (l->data);
+
+  g_slist_free (ctx->program_cache_pending);
+  ctx->program_cache_pending = NULL;
+}
+
+static gboolean
+_cogl_program_cache_write_idle_cb (void *user_data)
+{
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  ctx->program_cache_write_idle = 0;
+
+  _cogl_program_cache_sync ();
+
+  return FALSE;
+}
+
+/* New entries are usually added in the middle of painting a frame so
+   the file isn't written until the main loop is idle */
+static void
+_cogl_program_cache_queue_write (CoglProgramCacheEntry *entry)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  ctx->program_cache_pending =
+    g_slist_prepend (ctx->program_cache_pending, entry);
+
+  if (ctx->program_cache_write_idle == 0)
+    ctx->program_cache_write_idle =
+      g_idle_add_full (G_PRIORITY_LOW,
+                       _cogl_program_cache_write_idle_cb,
+                       NULL, NULL);
+}
+
+static void
+_cogl_program_cache_read_dir (void)
+{
+  const char *name;
+  GDir *dir;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if ((dir = g_dir_open (ctx->program_cache_dir, 0, NULL)) == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir)) &&
+         g_hash_table_size (ctx->program_cache) <
+         COGL_PROGRAM_CACHE_MAX_ENTRIES)
+    if (g_str_has_suffix (name, COGL_PROGRAM_CACHE_SUFFIX))
+      {
+        char *filename = g_build_filename (ctx->program_cache_dir,
+                                           name, NULL);
+        CoglProgramCacheEntry *entry =
+          _cogl_program_cache_read_entry (filename);
+
+        if (entry)
+          g_hash_table_replace (ctx->program_cache, entry->source, entry);
+        else
+          g_unlink (filename);
+
+        g_free (filename);
+      }
+
+  g_dir_close (dir);
+
+  COGL_NOTE (DRAW, "Loaded %u programs from %s",
+             g_hash_table_size (ctx->program_cache),
+             ctx->program_cache_dir);
+}
+
+void
+_cogl_program_cache_init (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* The entries are keyed by their source */
+  ctx->program_cache =
+    g_hash_table_new_full (g_str_hash, g_str_equal,
+                           NULL,
+                           (GDestroyNotify) _cogl_program_cache_entry_free);
+  ctx->program_cache_dir = NULL;
+  ctx->program_cache_pending = NULL;
+  ctx->program_cache_write_idle = 0;
+
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_DISABLE_PROGRAM_CACHE))
+    return;
+
+  ctx->program_cache_dir = _cogl_program_cache_get_dir ();
+
+  _cogl_program_cache_read_dir ();
+}
+
+void
+_cogl_program_cache_free (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* Anything that is still waiting for the idle handler is written
+     now */
+  _cogl_program_cache_sync ();
+
+  g_hash_table_destroy (ctx->program_cache);
+  ctx->program_cache = NULL;
+  g_free (ctx->program_cache_dir);
+  ctx->program_cache_dir = NULL;
+}
+
+typedef struct
+{
+  CoglProgramCacheType type;
+  CoglProgramCacheSourceFunc func;
+  void *user_data;
+} ForeachSourceState;
+
+static void
+foreach_source_cb (void *key,
+                   void *value,
+                   void *user_data)
+{
+  CoglProgramCacheEntry *entry = value;
+  ForeachSourceState *state = user_data;
+
+  if (entry->type == state->type)
+    state->func (entry->source, state->user_data);
+}
+
+void
+_cogl_program_cache_foreach_source (CoglProgramCacheType type,
+                                    CoglProgramCacheSourceFunc func,
+                                    void *user_data)
+{
+  ForeachSourceState state;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  state.type = type;
+  state.func = func;
+  state.user_data = user_data;
+
+  g_hash_table_foreach (ctx->program_cache, foreach_source_cb, &state);
+}
+
+static gboolean
+_cogl_program_cache_is_full (void)
+{
+  _COGL_GET_CONTEXT (ctx, TRUE);
+
+  return (ctx->program_cache_dir == NULL ||
+          g_hash_table_size (ctx->program_cache) >=
+          COGL_PROGRAM_CACHE_MAX_ENTRIES);
+}
+
+void
+_cogl_program_cache_add_source (CoglProgramCacheType type,
+                                const char *source)
+{
+  CoglProgramCacheEntry *entry;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (_cogl_program_cache_is_full () ||
+      g_hash_table_lookup (ctx->program_cache, source))
+    return;
+
+  entry = g_slice_new (CoglProgramCacheEntry);
+  entry->type = type;
+  entry->source = g_strdup (source);
+  entry->binary_format = 0;
+  entry->binary = NULL;
+  entry->binary_length = 0;
+
+  g_hash_table_insert (ctx->program_cache, entry->source, entry);
+
+  _cogl_program_cache_queue_write (entry);
+}
+
+gboolean
+_cogl_program_cache_load_binary (const char *source,
+                                 GLuint gl_program)
+{
+#ifdef HAVE_COGL_GLES2
+  CoglProgramCacheEntry *entry;
+  GLint status;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  if (!_cogl_features_available_private (COGL_FEATURE_PRIVATE_PROGRAM_BINARY))
+    return FALSE;
+
+  entry = g_hash_table_lookup (ctx->program_cache, source);
+  if (entry == NULL || entry->binary == NULL)
+    return FALSE;
+
+  glProgramBinary (gl_program,
+                   entry->binary_format,
+                   entry->binary,
+                   entry->binary_length);
+
+  glGetProgramiv (gl_program, GL_LINK_STATUS, &status);
+
+  if (status)
+    return TRUE;
+
+  /* The driver is allowed to reject a binary at any time, for example
+     if some other part of the system changed, so we just forget about
+     it and let the program be compiled again */
+  COGL_NOTE (DRAW, "Stale program binary in the program cache");
+
+  if (ctx->program_cache_dir)
+    {
+      char *filename = _cogl_program_cache_get_filename (source);
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  ctx->program_cache_pending =
+    g_slist_remove (ctx->program_cache_pending, entry);
+  g_hash_table_remove (ctx->program_cache, source);
+#endif /* HAVE_COGL_GLES2 */
+
+  return FALSE;
+}
+
+void
+_cogl_program_cache_add_binary (const char *source,
+                                GLuint gl_program)
+{
+#ifdef HAVE_COGL_GLES2
+  CoglProgramCacheEntry *entry;
+  GLint length = 0;
+  GLsizei written = 0;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  /* Without a binary there is nothing to gain from storing the
+     source of a GLSL program because it can only be linked once the
+     shaders for it have been compiled */
+  if (!_cogl_features_available_private (COGL_FEATURE_PRIVATE_PROGRAM_BINARY))
+    return;
+
+  /* If there is already an entry for this source then the binary was
+     loaded from it so there's no need to write it again */
+  if (_cogl_program_cache_is_full () ||
+      g_hash_table_lookup (ctx->program_cache, source))
+    return;
+
+  glGetProgramiv (gl_program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+  if (length <= 0)
+    return;
+
+  entry = g_slice_new (CoglProgramCacheEntry);
+  entry->type = COGL_PROGRAM_CACHE_TYPE_GLSL;
+  entry->source = g_strdup (source);
+  entry->binary = g_malloc (length);
+
+  glGetProgramBinary (gl_program, length, &written,
+                      &entry->binary_format, entry->binary);
+  entry->binary_length = written;
+
+  if (written <= 0)
+    {
+      _cogl_program_cache_entry_free (entry);
+      return;
+    }
+
+  g_hash_table_insert (ctx->program_cache, entry->source, entry);
+
+  _cogl_program_cache_queue_write (entry);
+#endif /* HAVE_COGL_GLES2 */
+}
+
+void
+_cogl_begin_program_build_log (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  g_return_if_fail (ctx->program_build_log == NULL);
+
+  ctx->program_build_log = g_array_new (FALSE, FALSE, sizeof (double));
+  ctx->program_build_timer = g_timer_new ();
+  ctx->program_build_shader_time = 0.0;
+}
+
+GArray *
+_cogl_end_program_build_log (void)
+{
+  GArray *log;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  g_return_val_if_fail (ctx->program_build_log != NULL, NULL);
+
+  log = ctx->program_build_log;
+  ctx->program_build_log = NULL;
+  g_timer_destroy (ctx->program_build_timer);
+  ctx->program_build_timer = NULL;
+
+  return log;
+}
+
+void
+_cogl_program_build_begin (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->program_build_log)
+    g_timer_start (ctx->program_build_timer);
+}
+
+void
+_cogl_program_build_end (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->program_build_log)
+    {
+      double seconds = (g_timer_elapsed (ctx->program_build_timer, NULL) +
+                        ctx->program_build_shader_time);
+
+      g_array_append_val (ctx->program_build_log, seconds);
+      ctx->program_build_shader_time = 0.0;
+    }
+}
+
+void
+_cogl_program_build_end_shader (void)
+{
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  if (ctx->program_build_log)
+    ctx->program_build_shader_time +=
+      g_timer_elapsed (ctx->program_build_timer, NULL);
+}
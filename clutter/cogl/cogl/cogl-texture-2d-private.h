@@ -80,4 +80,19 @@ _cogl_texture_2d_new_from_bitmap (CoglBitmap      *bmp,
 void
 _cogl_texture_2d_externally_modified (CoglHandle handle);
 
+/*
+ * _cogl_texture_2d_set_mipmaps_from_bitmap:
+ * @handle: A handle to a 2D texture
+ * @bmp: A bitmap with levels from cogl_bitmap_generate_mipmaps()
+ *
+ * Replaces the mipmap levels of the texture with the levels attached
+ * to @bmp so that they don't need to be generated by the GPU.
+ *
+ * Return value: %FALSE if @handle is not a 2D texture or the levels
+ *   don't match its size
+ */
+gboolean
+_cogl_texture_2d_set_mipmaps_from_bitmap (CoglHandle  handle,
+                                          CoglBitmap *bmp);
+
 #endif /* __COGL_TEXTURE_2D_H */
@@ -253,6 +253,69 @@ _cogl_texture_2d_new_with_size (unsigned int     width,
   return _cogl_texture_2d_handle_new (tex_2d);
 }
 
+/* Uploads the levels attached to @bmp with
+   cogl_bitmap_generate_mipmaps() instead of letting the GPU generate
+   them. The levels are only used if they form a full chain for the
+   size of the texture */
+static gboolean
+_cogl_texture_2d_upload_mipmaps (CoglTexture2D *tex_2d,
+                                 CoglBitmap    *bmp)
+{
+  int n_levels = _cogl_bitmap_get_n_mipmaps (bmp);
+  int width = tex_2d->width, height = tex_2d->height;
+  int level;
+
+  if (n_levels < 1)
+    return FALSE;
+
+  /* Check the size of every level first so that we don't leave the
+     texture with half of the levels uploaded */
+  for (level = 1; level <= n_levels; level++)
+    {
+      CoglBitmap *level_bmp = _cogl_bitmap_get_mipmap (bmp, level);
+
+      width = MAX (width >> 1, 1);
+      height = MAX (height >> 1, 1);
+
+      if (_cogl_bitmap_get_width (level_bmp) != width ||
+          _cogl_bitmap_get_height (level_bmp) != height)
+        return FALSE;
+    }
+
+  if (width != 1 || height != 1)
+    return FALSE;
+
+  for (level = 1; level <= n_levels; level++)
+    {
+      CoglBitmap *level_bmp = _cogl_bitmap_get_mipmap (bmp, level);
+      CoglBitmap *dst_bmp;
+      GLenum gl_intformat, gl_format, gl_type;
+
+      if ((dst_bmp = _cogl_texture_prepare_for_upload (level_bmp,
+                                                       tex_2d->format,
+                                                       NULL,
+                                                       &gl_intformat,
+                                                       &gl_format,
+                                                       &gl_type)) == NULL)
+        return FALSE;
+
+      _cogl_texture_driver_upload_level_to_gl (GL_TEXTURE_2D,
+                                               tex_2d->gl_texture,
+                                               FALSE,
+                                               level,
+                                               dst_bmp,
+                                               tex_2d->gl_format,
+                                               gl_format,
+                                               gl_type);
+
+      cogl_object_unref (dst_bmp);
+    }
+
+  tex_2d->mipmaps_dirty = FALSE;
+
+  return TRUE;
+}
+
 CoglHandle
 _cogl_texture_2d_new_from_bitmap (CoglBitmap      *bmp,
                                   CoglTextureFlags flags,
@@ -316,6 +379,8 @@ _cogl_texture_2d_new_from_bitmap (CoglBitmap      *bmp,
 
   cogl_object_unref (dst_bmp);
 
+  _cogl_texture_2d_upload_mipmaps (tex_2d, bmp);
+
   return _cogl_texture_2d_handle_new (tex_2d);
 }
 
@@ -328,6 +393,16 @@ _cogl_texture_2d_externally_modified (CoglHandle handle)
   COGL_TEXTURE_2D (handle)->mipmaps_dirty = TRUE;
 }
 
+gboolean
+_cogl_texture_2d_set_mipmaps_from_bitmap (CoglHandle  handle,
+                                          CoglBitmap *bmp)
+{
+  if (!_cogl_is_texture_2d (handle))
+    return FALSE;
+
+  return _cogl_texture_2d_upload_mipmaps (COGL_TEXTURE_2D (handle), bmp);
+}
+
 static int
 _cogl_texture_2d_get_max_waste (CoglTexture *tex)
 {
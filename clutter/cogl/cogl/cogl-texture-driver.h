@@ -87,6 +87,20 @@ _cogl_texture_driver_upload_to_gl (GLenum       gl_target,
                                    GLuint       source_gl_format,
                                    GLuint       source_gl_type);
 
+/*
+ * Same as _cogl_texture_driver_upload_to_gl() but replaces the given
+ * mipmap level of the texture instead of the base level
+ */
+void
+_cogl_texture_driver_upload_level_to_gl (GLenum       gl_target,
+                                         GLuint       gl_handle,
+                                         gboolean     is_foreign,
+                                         GLint        level,
+                                         CoglBitmap  *source_bmp,
+                                         GLint        internal_gl_format,
+                                         GLuint       source_gl_format,
+                                         GLuint       source_gl_type);
+
 /*
  * Replaces the contents of the GL texture with the entire bitmap. The
  * width of the texture is inferred from the bitmap. The height and
@@ -450,8 +450,10 @@ cogl_texture_new_from_bitmap (CoglHandle       bmp_handle,
 {
   CoglHandle tex;
 
-  /* First try putting the texture in the atlas */
-  if ((tex = _cogl_atlas_texture_new_from_bitmap (bmp_handle,
+  /* First try putting the texture in the atlas. Bitmaps with
+     generated mipmaps are skipped because the atlas can't use them */
+  if (_cogl_bitmap_get_n_mipmaps (bmp_handle) == 0 &&
+      (tex = _cogl_atlas_texture_new_from_bitmap (bmp_handle,
                                                   flags,
                                                   internal_format)))
     return tex;
@@ -489,10 +491,12 @@ cogl_texture_new_from_file (const char        *filename,
   /* We know that the bitmap data is solely owned by this function so
      we can do the premult conversion in place. This avoids having to
      copy the bitmap which will otherwise happen in
-     _cogl_texture_prepare_for_upload */
+     _cogl_texture_prepare_for_upload. Bitmaps mapped from a cache
+     file are left for _cogl_texture_prepare_for_upload to copy */
   internal_format =
     _cogl_texture_determine_internal_format (src_format, internal_format);
   if (!_cogl_texture_needs_premult_conversion (src_format, internal_format) ||
+      _cogl_bitmap_is_read_only (bmp) ||
       _cogl_bitmap_convert_premult_status (bmp, src_format ^ COGL_PREMULT_BIT))
     handle = cogl_texture_new_from_bitmap (bmp, flags, internal_format);
 
@@ -898,6 +902,36 @@ cogl_texture_set_region (CoglHandle       handle,
   return ret;
 }
 
+gboolean
+cogl_texture_set_region_from_bitmap (CoglHandle    handle,
+                                     int           src_x,
+                                     int           src_y,
+                                     int           dst_x,
+                                     int           dst_y,
+                                     unsigned int  dst_width,
+                                     unsigned int  dst_height,
+                                     CoglHandle    bmp_handle)
+{
+  g_return_val_if_fail (cogl_is_texture (handle), FALSE);
+  g_return_val_if_fail (cogl_is_bitmap (bmp_handle), FALSE);
+
+  return _cogl_texture_set_region_from_bitmap (handle,
+                                               src_x, src_y,
+                                               dst_x, dst_y,
+                                               dst_width, dst_height,
+                                               bmp_handle);
+}
+
+gboolean
+cogl_texture_set_mipmaps_from_bitmap (CoglHandle handle,
+                                      CoglHandle bmp_handle)
+{
+  g_return_val_if_fail (cogl_is_texture (handle), FALSE);
+  g_return_val_if_fail (cogl_is_bitmap (bmp_handle), FALSE);
+
+  return _cogl_texture_2d_set_mipmaps_from_bitmap (handle, bmp_handle);
+}
+
 /* Reads back the contents of a texture by rendering it to the framebuffer
  * and reading back the resulting pixels.
  *
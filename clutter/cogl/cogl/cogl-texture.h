@@ -339,6 +339,61 @@ cogl_texture_set_region (CoglHandle       handle,
                          unsigned int     rowstride,
                          const guint8    *data);
 
+/**
+ * cogl_texture_set_region_from_bitmap:
+ * @handle: a #CoglHandle for a texture
+ * @src_x: upper left coordinate to use from the source bitmap
+ * @src_y: upper left coordinate to use from the source bitmap
+ * @dst_x: upper left destination horizontal coordinate
+ * @dst_y: upper left destination vertical coordinate
+ * @dst_width: width of destination region to write
+ * @dst_height: height of destination region to write
+ * @bmp_handle: a #CoglBitmap handle
+ *
+ * Like cogl_texture_set_region() but the pixel data is taken from a
+ * #CoglBitmap. This can be used to upload a bitmap loaded with
+ * cogl_bitmap_new_from_file() in several steps.
+ *
+ * Return value: %TRUE if the subregion upload was successful, and
+ *   %FALSE otherwise
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_texture_set_region_from_bitmap (CoglHandle    handle,
+                                     int           src_x,
+                                     int           src_y,
+                                     int           dst_x,
+                                     int           dst_y,
+                                     unsigned int  dst_width,
+                                     unsigned int  dst_height,
+                                     CoglHandle    bmp_handle);
+
+/**
+ * cogl_texture_set_mipmaps_from_bitmap:
+ * @handle: a #CoglHandle for a texture
+ * @bmp_handle: a #CoglBitmap handle
+ *
+ * Replaces the mipmap levels of the texture with the levels computed
+ * for @bmp_handle by cogl_bitmap_generate_mipmaps(). This can be used
+ * when the base level was uploaded separately, for example with
+ * cogl_texture_set_region_from_bitmap(), so that the GPU doesn't have
+ * to generate the levels. The levels are invalidated again by any
+ * later change to the texture.
+ *
+ * Only non-sliced textures whose size matches the bitmap support
+ * this.
+ *
+ * Return value: %TRUE if the levels were uploaded, and %FALSE
+ *   otherwise, in which case the levels will be generated by the GPU
+ *   as usual
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_texture_set_mipmaps_from_bitmap (CoglHandle handle,
+                                      CoglHandle bmp_handle);
+
 /**
  * cogl_texture_new_from_sub_texture:
  * @full_texture: a #CoglHandle to an existing texture
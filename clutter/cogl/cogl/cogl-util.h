@@ -60,6 +60,12 @@ cogl_util_float_signbit (float x)
    negative numbers. */
 #define COGL_UTIL_NEARBYINT(x) ((int) ((x) < 0.0f ? (x) - 0.5f : (x) + 0.5f))
 
+/* Checks whether two projected window coordinates are close enough
+   to be considered on the same edge. This is used to decide whether a
+   rectangle is still aligned to the window after it has been
+   transformed so that it can be clipped without the stencil buffer */
+#define COGL_UTIL_WINDOW_ALIGNED(a, b) (fabsf ((a) - (b)) < 0.01f)
+
 /* Returns whether the given integer is a power of two */
 static inline gboolean
 _cogl_util_is_pot (unsigned int num)
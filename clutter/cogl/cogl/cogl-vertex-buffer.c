@@ -141,6 +141,7 @@
 #include "cogl-primitives.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-journal-private.h"
+#include "cogl-gl-state-private.h"
 
 #define PAD_FOR_ALIGNMENT(VAR, TYPE_SIZE) \
   (VAR = TYPE_SIZE + ((VAR - 1) & ~(TYPE_SIZE - 1)))
@@ -153,7 +154,6 @@
 #if defined (HAVE_COGL_GL)
 
 #define glGenBuffers ctx->drv.pf_glGenBuffers
-#define glBindBuffer ctx->drv.pf_glBindBuffer
 #define glBufferData ctx->drv.pf_glBufferData
 #define glBufferSubData ctx->drv.pf_glBufferSubData
 #define glGetBufferSubData ctx->drv.pf_glGetBufferSubData
@@ -920,7 +920,10 @@ cogl_vertex_buffer_vbo_free (CoglVertexBufferVBO *cogl_vbo,
       COGL_VERTEX_BUFFER_VBO_FLAG_SUBMITTED)
     {
       if (cogl_get_features () & COGL_FEATURE_VBOS)
-	GE (glDeleteBuffers (1, (GLuint *)&cogl_vbo->vbo_name));
+	{
+	  _cogl_gl_state_forget_buffer (GPOINTER_TO_UINT (cogl_vbo->vbo_name));
+	  GE (glDeleteBuffers (1, (GLuint *)&cogl_vbo->vbo_name));
+	}
       else
 	g_free (cogl_vbo->vbo_name);
     }
@@ -1062,8 +1065,8 @@ upload_gl_vbo (CoglVertexBufferVBO *cogl_vbo)
     {
       g_return_if_fail (cogl_vbo->vbo_name != NULL);
 
-      GE (glBindBuffer (GL_ARRAY_BUFFER,
-			GPOINTER_TO_UINT (cogl_vbo->vbo_name)));
+      _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER,
+				  GPOINTER_TO_UINT (cogl_vbo->vbo_name));
     }
   else if (cogl_vbo->vbo_name == NULL)
     {
@@ -1133,7 +1136,7 @@ upload_gl_vbo (CoglVertexBufferVBO *cogl_vbo)
   cogl_vbo->flags |= COGL_VERTEX_BUFFER_VBO_FLAG_SUBMITTED;
 
   if (!fallback)
-    GE (glBindBuffer (GL_ARRAY_BUFFER, 0));
+    _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER, 0);
 }
 
 /* Note: although there ends up being quite a few inner loops involved with
@@ -1549,8 +1552,8 @@ enable_state_for_drawing_buffer (CoglVertexBuffer *buffer)
 
       if (cogl_get_features () & COGL_FEATURE_VBOS)
 	{
-	  GE (glBindBuffer (GL_ARRAY_BUFFER,
-			    GPOINTER_TO_UINT (cogl_vbo->vbo_name)));
+	  _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER,
+				      GPOINTER_TO_UINT (cogl_vbo->vbo_name));
 	  base = NULL;
 	}
       else
@@ -1815,7 +1818,7 @@ disable_state_for_drawing_buffer (CoglVertexBuffer *buffer,
    * about:
    */
   if (cogl_get_features () & COGL_FEATURE_VBOS)
-    GE (glBindBuffer (GL_ARRAY_BUFFER, 0));
+    _cogl_gl_state_bind_buffer (GL_ARRAY_BUFFER, 0);
 
   for (tmp = buffer->submitted_vbos; tmp != NULL; tmp = tmp->next)
     {
@@ -1945,13 +1948,13 @@ cogl_vertex_buffer_indices_new (CoglIndicesType  indices_type,
   else
     {
       GE (glGenBuffers (1, (GLuint *)&indices->vbo_name));
-      GE (glBindBuffer (GL_ELEMENT_ARRAY_BUFFER,
-			GPOINTER_TO_UINT (indices->vbo_name)));
+      _cogl_gl_state_bind_buffer (GL_ELEMENT_ARRAY_BUFFER,
+				  GPOINTER_TO_UINT (indices->vbo_name));
       GE (glBufferData (GL_ELEMENT_ARRAY_BUFFER,
                         indices_bytes,
                         indices_array,
                         GL_STATIC_DRAW));
-      GE (glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0));
+      _cogl_gl_state_bind_buffer (GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
   return _cogl_vertex_buffer_indices_handle_new (indices);
@@ -1989,7 +1992,10 @@ _cogl_vertex_buffer_indices_free (CoglVertexBufferIndices *indices)
   if (fallback)
     g_free (indices->vbo_name);
   else
-    GE (glDeleteBuffers (1, (GLuint *)&indices->vbo_name));
+    {
+      _cogl_gl_state_forget_buffer (GPOINTER_TO_UINT (indices->vbo_name));
+      GE (glDeleteBuffers (1, (GLuint *)&indices->vbo_name));
+    }
 
   g_slice_free (CoglVertexBufferIndices, indices);
 }
@@ -2030,15 +2036,15 @@ cogl_vertex_buffer_draw_elements (CoglHandle       handle,
   if (fallback)
     byte_offset = (size_t)(((char *)indices->vbo_name) + byte_offset);
   else
-    GE (glBindBuffer (GL_ELEMENT_ARRAY_BUFFER,
-                      GPOINTER_TO_UINT (indices->vbo_name)));
+    _cogl_gl_state_bind_buffer (GL_ELEMENT_ARRAY_BUFFER,
+				GPOINTER_TO_UINT (indices->vbo_name));
 
   GE (glDrawRangeElements (mode, min_index, max_index,
                            count, indices->type, (void *)byte_offset));
 
   disable_state_for_drawing_buffer (buffer, source);
 
-  GE (glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0));
+  _cogl_gl_state_bind_buffer (GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 static void
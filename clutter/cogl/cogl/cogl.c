@@ -45,6 +45,7 @@
 #include "cogl-bitmap-private.h"
 #include "cogl-texture-private.h"
 #include "cogl-texture-driver.h"
+#include "cogl-gl-state-private.h"
 
 #if defined (HAVE_COGL_GLES2) || defined (HAVE_COGL_GLES)
 #include "cogl-gles2-wrapper.h"
@@ -202,6 +203,11 @@ cogl_clear (const CoglColor *color, unsigned long buffers)
       ctxt->journal_rectangles_color = 1;
     }
 
+  /* The clear is also taken as the start of a new frame when
+     printing the number of GL state changes that were filtered */
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_GL_STATE))
+    _cogl_gl_state_dump_stats ();
+
   COGL_NOTE (DRAW, "Clear end");
 }
 
@@ -605,6 +611,11 @@ void
 cogl_flush (void)
 {
   _cogl_journal_flush ();
+
+  /* Everything that has been drawn so far has reached GL so the
+     shadow state should match it */
+  if (G_UNLIKELY (cogl_debug_flags & COGL_DEBUG_GL_STATE))
+    _cogl_gl_state_verify ();
 }
 
 void
@@ -1014,6 +1025,14 @@ _cogl_get_clip_state (void)
   return _cogl_framebuffer_get_clip_state (framebuffer);
 }
 
+CoglHandle
+_cogl_get_current_program (void)
+{
+  _COGL_GET_CONTEXT (ctx, COGL_INVALID_HANDLE);
+
+  return ctx->current_program;
+}
+
 GQuark
 _cogl_driver_error_quark (void)
 {
@@ -1256,6 +1256,37 @@ _cogl_driver_error_quark (void);
 void
 _cogl_onscreen_clutter_backend_set_size (int width, int height);
 
+gboolean
+_cogl_atlas_texture_defragment (int max_textures);
+
+/* Returns the program set with cogl_program_use() without taking a
+ * reference so that code which temporarily replaces it can put it
+ * back afterwards */
+CoglHandle
+_cogl_get_current_program (void);
+
+/* Starts recording how long it takes to build each program that Cogl
+ * generates for a material or that is compiled and linked with the
+ * cogl_shader and cogl_program API. _cogl_end_program_build_log
+ * returns an array of doubles with the number of seconds taken by
+ * each program. There is one entry for each program that is linked
+ * and it includes the time taken to compile its shaders. The array
+ * should be freed with g_array_free() */
+void
+_cogl_begin_program_build_log (void);
+
+GArray *
+_cogl_end_program_build_log (void);
+
+/* Uploads the path fills that have been tesselated in a thread since
+ * the last call. Returns TRUE if there were any, in which case the
+ * paths that were drawn with a fallback should be redrawn */
+gboolean
+_cogl_path_upload_pending_fills (void);
+
+gboolean
+_cogl_path_has_pending_fills (void);
+
 G_END_DECLS
 
 #undef __COGL_H_INSIDE__
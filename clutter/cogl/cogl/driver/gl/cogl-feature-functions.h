@@ -115,6 +115,24 @@ COGL_FEATURE_BEGIN (read_pixels_async, 2, 1,
                     0)
 COGL_FEATURE_END ()
 
+/* GLsync is declared as a void pointer because older GL headers don't
+   define it */
+COGL_FEATURE_BEGIN (sync, 3, 2,
+                    "ARB:\0",
+                    "sync\0",
+                    0,
+                    COGL_FEATURE_PRIVATE_SYNC)
+COGL_FEATURE_FUNCTION (void *, glFenceSync,
+                       (GLenum                condition,
+                        GLbitfield            flags))
+COGL_FEATURE_FUNCTION (GLenum, glClientWaitSync,
+                       (void                 *sync,
+                        GLbitfield            flags,
+                        guint64               timeout))
+COGL_FEATURE_FUNCTION (void, glDeleteSync,
+                       (void                 *sync))
+COGL_FEATURE_END ()
+
 /* ARB_fragment_program */
 COGL_FEATURE_BEGIN (arbfp, 255, 255,
                     "ARB\0",
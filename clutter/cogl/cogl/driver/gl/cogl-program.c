@@ -33,6 +33,7 @@
 #include "cogl-context.h"
 #include "cogl-journal-private.h"
 #include "cogl-material-opengl-private.h"
+#include "cogl-program-cache-private.h"
 
 #include <glib.h>
 
@@ -119,7 +120,9 @@ cogl_program_link (CoglHandle handle)
 
   program = _cogl_program_pointer_from_handle (handle);
 
+  _cogl_program_build_begin ();
   GE (glLinkProgram (program->gl_handle));
+  _cogl_program_build_end ();
 }
 
 void
@@ -185,6 +185,26 @@ _cogl_texture_driver_upload_to_gl (GLenum       gl_target,
                                    GLint        internal_gl_format,
                                    GLuint       source_gl_format,
                                    GLuint       source_gl_type)
+{
+  _cogl_texture_driver_upload_level_to_gl (gl_target,
+                                           gl_handle,
+                                           is_foreign,
+                                           0, /* level */
+                                           source_bmp,
+                                           internal_gl_format,
+                                           source_gl_format,
+                                           source_gl_type);
+}
+
+void
+_cogl_texture_driver_upload_level_to_gl (GLenum       gl_target,
+                                         GLuint       gl_handle,
+                                         gboolean     is_foreign,
+                                         GLint        level,
+                                         CoglBitmap  *source_bmp,
+                                         GLint        internal_gl_format,
+                                         GLuint       source_gl_format,
+                                         GLuint       source_gl_type)
 {
   guint8 *data;
   int bpp = _cogl_get_format_bpp (_cogl_bitmap_get_format (source_bmp));
@@ -197,7 +217,7 @@ _cogl_texture_driver_upload_to_gl (GLenum       gl_target,
 
   _cogl_bind_gl_texture_transient (gl_target, gl_handle, is_foreign);
 
-  GE( glTexImage2D (gl_target, 0,
+  GE( glTexImage2D (gl_target, level,
                     internal_gl_format,
                     _cogl_bitmap_get_width (source_bmp),
                     _cogl_bitmap_get_height (source_bmp),
@@ -109,3 +109,17 @@ COGL_FEATURE_FUNCTION (void, glTexSubImage3D,
                         GLsizei width, GLsizei height, GLsizei depth,
                         GLenum format, GLenum type, const GLvoid* pixels))
 COGL_FEATURE_END ()
+
+COGL_FEATURE_BEGIN (get_program_binary, 255, 255,
+                    "OES\0",
+                    "get_program_binary\0",
+                    0,
+                    COGL_FEATURE_PRIVATE_PROGRAM_BINARY)
+COGL_FEATURE_FUNCTION (void, glGetProgramBinary,
+                       (GLuint program, GLsizei bufSize,
+                        GLsizei *length, GLenum *binaryFormat,
+                        GLvoid *binary))
+COGL_FEATURE_FUNCTION (void, glProgramBinary,
+                       (GLuint program, GLenum binaryFormat,
+                        const GLvoid *binary, GLint length))
+COGL_FEATURE_END ()
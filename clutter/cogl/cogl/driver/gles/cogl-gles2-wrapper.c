@@ -42,6 +42,7 @@
 #include "cogl-shader-private.h"
 #include "cogl-program.h"
 #include "cogl-internal.h"
+#include "cogl-program-cache-private.h"
 
 #define _COGL_GET_GLES2_WRAPPER(wvar, retval)			\
   CoglGles2Wrapper *wvar;					\
@@ -293,11 +294,20 @@ cogl_gles2_settings_equal (const CoglGles2WrapperSettings *a,
   return TRUE;
 }
 
+static gboolean
+cogl_gles2_wrapper_compile_shader (GLenum type,
+                                   CoglGles2WrapperShader *shader)
+{
+  if (shader->shader == 0)
+    shader->shader = cogl_gles2_wrapper_create_shader (type, shader->source);
+
+  return shader->shader != 0;
+}
+
 static CoglGles2WrapperShader *
 cogl_gles2_get_vertex_shader (const CoglGles2WrapperSettings *settings)
 {
   GString *shader_source;
-  GLuint shader_obj;
   CoglGles2WrapperShader *shader;
   GSList *node;
   int i;
@@ -385,16 +395,9 @@ cogl_gles2_get_vertex_shader (const CoglGles2WrapperSettings *settings)
 
   g_string_append (shader_source, _cogl_fixed_vertex_shader_end);
 
-  shader_obj = cogl_gles2_wrapper_create_shader (GL_VERTEX_SHADER,
-						 shader_source->str);
-
-  g_string_free (shader_source, TRUE);
-
-  if (shader_obj == 0)
-    return NULL;
-
   shader = g_slice_new (CoglGles2WrapperShader);
-  shader->shader = shader_obj;
+  shader->shader = 0;
+  shader->source = g_string_free (shader_source, FALSE);
   shader->settings = *settings;
 
   w->compiled_vertex_shaders = g_slist_prepend (w->compiled_vertex_shaders,
@@ -607,7 +610,6 @@ static CoglGles2WrapperShader *
 cogl_gles2_get_fragment_shader (const CoglGles2WrapperSettings *settings)
 {
   GString *shader_source;
-  GLuint shader_obj;
   CoglGles2WrapperShader *shader;
   GSList *node;
   int i;
@@ -743,16 +745,9 @@ cogl_gles2_get_fragment_shader (const CoglGles2WrapperSettings *settings)
 
   g_string_append (shader_source, _cogl_fixed_fragment_shader_end);
 
-  shader_obj = cogl_gles2_wrapper_create_shader (GL_FRAGMENT_SHADER,
-						 shader_source->str);
-
-  g_string_free (shader_source, TRUE);
-
-  if (shader_obj == 0)
-    return NULL;
-
   shader = g_slice_new (CoglGles2WrapperShader);
-  shader->shader = shader_obj;
+  shader->shader = 0;
+  shader->source = g_string_free (shader_source, FALSE);
   shader->settings = *settings;
 
   w->compiled_fragment_shaders = g_slist_prepend (w->compiled_fragment_shaders,
@@ -827,15 +822,66 @@ cogl_gles2_wrapper_bind_attributes (GLuint program)
 			"normal_attrib");
 }
 
+static gboolean
+cogl_gles2_wrapper_link_program (GLuint gl_program,
+                                 CoglGles2WrapperShader *vertex_shader,
+                                 CoglGles2WrapperShader *fragment_shader,
+                                 CoglProgram *user_program)
+{
+  GSList *node;
+  GLint status;
+
+  if (vertex_shader)
+    {
+      if (!cogl_gles2_wrapper_compile_shader (GL_VERTEX_SHADER,
+                                              vertex_shader))
+        return FALSE;
+      glAttachShader (gl_program, vertex_shader->shader);
+    }
+  if (fragment_shader)
+    {
+      if (!cogl_gles2_wrapper_compile_shader (GL_FRAGMENT_SHADER,
+                                              fragment_shader))
+        return FALSE;
+      glAttachShader (gl_program, fragment_shader->shader);
+    }
+  if (user_program)
+    for (node = user_program->attached_shaders; node; node = node->next)
+      {
+	CoglShader *shader
+	  = _cogl_shader_pointer_from_handle ((CoglHandle) node->data);
+	glAttachShader (gl_program, shader->gl_handle);
+      }
+  cogl_gles2_wrapper_bind_attributes (gl_program);
+  glLinkProgram (gl_program);
+
+  glGetProgramiv (gl_program, GL_LINK_STATUS, &status);
+
+  if (!status)
+    {
+      char shader_log[1024];
+      GLint len;
+
+      glGetProgramInfoLog (gl_program, sizeof (shader_log) - 1, &len, shader_log);
+      shader_log[len] = '\0';
+
+      g_critical ("%s", shader_log);
+
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 static CoglGles2WrapperProgram *
 cogl_gles2_wrapper_get_program (const CoglGles2WrapperSettings *settings)
 {
   GSList *node;
   CoglGles2WrapperProgram *program;
   CoglGles2WrapperShader *vertex_shader, *fragment_shader;
-  GLint status;
   gboolean custom_vertex_shader = FALSE, custom_fragment_shader = FALSE;
   CoglProgram *user_program = NULL;
+  char *cache_key = NULL;
   int i;
 
   _COGL_GET_GLES2_WRAPPER (w, NULL);
@@ -874,53 +920,52 @@ cogl_gles2_wrapper_get_program (const CoglGles2WrapperSettings *settings)
   /* Get or create the fixed functionality shaders for these settings
      if there is no custom replacement */
   if (!custom_vertex_shader)
-    {
-      vertex_shader = cogl_gles2_get_vertex_shader (settings);
-      if (vertex_shader == NULL)
-	return NULL;
-    }
+    vertex_shader = cogl_gles2_get_vertex_shader (settings);
   if (!custom_fragment_shader)
-    {
-      fragment_shader = cogl_gles2_get_fragment_shader (settings);
-      if (fragment_shader == NULL)
-	return NULL;
-    }
+    fragment_shader = cogl_gles2_get_fragment_shader (settings);
+
+  _cogl_program_build_begin ();
 
   program = g_slice_new (CoglGles2WrapperProgram);
 
   program->program = glCreateProgram ();
-  if (!custom_vertex_shader)
-    glAttachShader (program->program, vertex_shader->shader);
-  if (!custom_fragment_shader)
-    glAttachShader (program->program, fragment_shader->shader);
-  if (user_program)
-    for (node = user_program->attached_shaders; node; node = node->next)
-      {
-	CoglShader *shader
-	  = _cogl_shader_pointer_from_handle ((CoglHandle) node->data);
-	glAttachShader (program->program, shader->gl_handle);
-      }
-  cogl_gles2_wrapper_bind_attributes (program->program);
-  glLinkProgram (program->program);
 
-  glGetProgramiv (program->program, GL_LINK_STATUS, &status);
-
-  if (!status)
+  /* Programs that only use the generated shaders can be stored in the
+     program cache using the source of both shaders as the key. If
+     there is a binary for it then the shaders don't need to be
+     compiled at all */
+  if (user_program == NULL)
+    cache_key = g_strconcat (vertex_shader->source,
+                             fragment_shader->source,
+                             NULL);
+
+  if (cache_key == NULL ||
+      !_cogl_program_cache_load_binary (cache_key, program->program))
     {
-      char shader_log[1024];
-      GLint len;
-
-      glGetProgramInfoLog (program->program, sizeof (shader_log) - 1, &len, shader_log);
-      shader_log[len] = '\0';
+      if (!cogl_gles2_wrapper_link_program (program->program,
+                                            custom_vertex_shader
+                                            ? NULL : vertex_shader,
+                                            custom_fragment_shader
+                                            ? NULL : fragment_shader,
+                                            user_program))
+        {
+          glDeleteProgram (program->program);
+          g_slice_free (CoglGles2WrapperProgram, program);
+          g_free (cache_key);
 
-      g_critical ("%s", shader_log);
+          _cogl_program_build_end ();
 
-      glDeleteProgram (program->program);
-      g_slice_free (CoglGles2WrapperProgram, program);
+          return NULL;
+        }
 
-      return NULL;
+      if (cache_key)
+        _cogl_program_cache_add_binary (cache_key, program->program);
     }
 
+  g_free (cache_key);
+
+  _cogl_program_build_end ();
+
   program->settings = *settings;
 
   cogl_gles2_wrapper_get_locations (program->program,
@@ -938,6 +983,15 @@ cogl_gles2_wrapper_get_program (const CoglGles2WrapperSettings *settings)
   return program;
 }
 
+static void
+cogl_gles2_wrapper_free_shader (CoglGles2WrapperShader *shader)
+{
+  if (shader->shader)
+    glDeleteShader (shader->shader);
+  g_free (shader->source);
+  g_slice_free (CoglGles2WrapperShader, shader);
+}
+
 void
 _cogl_gles2_wrapper_deinit (CoglGles2Wrapper *wrapper)
 {
@@ -955,7 +1009,7 @@ _cogl_gles2_wrapper_deinit (CoglGles2Wrapper *wrapper)
   for (node = wrapper->compiled_vertex_shaders; node; node = next)
     {
       next = node->next;
-      glDeleteShader (((CoglGles2WrapperShader *) node->data)->shader);
+      cogl_gles2_wrapper_free_shader (node->data);
       g_slist_free1 (node);
     }
   wrapper->compiled_vertex_shaders = NULL;
@@ -963,7 +1017,7 @@ _cogl_gles2_wrapper_deinit (CoglGles2Wrapper *wrapper)
   for (node = wrapper->compiled_fragment_shaders; node; node = next)
     {
       next = node->next;
-      glDeleteShader (((CoglGles2WrapperShader *) node->data)->shader);
+      cogl_gles2_wrapper_free_shader (node->data);
       g_slist_free1 (node);
     }
   wrapper->compiled_fragment_shaders = NULL;
@@ -235,7 +235,11 @@ struct _CoglGles2WrapperProgram
 
 struct _CoglGles2WrapperShader
 {
+  /* The shader is only compiled when a program needs it and there
+     wasn't a binary for the program in the program cache. Until then
+     this is 0 */
   GLuint shader;
+  char *source;
 
   /* The settings that were used to generate this shader */
   CoglGles2WrapperSettings settings;
@@ -31,6 +31,7 @@
 #include "cogl-internal.h"
 #include "cogl-context.h"
 #include "cogl-handle.h"
+#include "cogl-program-cache-private.h"
 
 #ifdef HAVE_COGL_GLES2
 
@@ -100,7 +101,9 @@ cogl_shader_compile (CoglHandle handle)
 
   shader = _cogl_shader_pointer_from_handle (handle);
 
+  _cogl_program_build_begin ();
   glCompileShader (shader->gl_handle);
+  _cogl_program_build_end_shader ();
 }
 
 char *
@@ -174,6 +174,26 @@ _cogl_texture_driver_upload_to_gl (GLenum       gl_target,
                                    GLint        internal_gl_format,
                                    GLuint       source_gl_format,
                                    GLuint       source_gl_type)
+{
+  _cogl_texture_driver_upload_level_to_gl (gl_target,
+                                           gl_handle,
+                                           is_foreign,
+                                           0, /* level */
+                                           source_bmp,
+                                           internal_gl_format,
+                                           source_gl_format,
+                                           source_gl_type);
+}
+
+void
+_cogl_texture_driver_upload_level_to_gl (GLenum       gl_target,
+                                         GLuint       gl_handle,
+                                         gboolean     is_foreign,
+                                         GLint        level,
+                                         CoglBitmap  *source_bmp,
+                                         GLint        internal_gl_format,
+                                         GLuint       source_gl_format,
+                                         GLuint       source_gl_type)
 {
   int bpp = _cogl_get_format_bpp (_cogl_bitmap_get_format (source_bmp));
   int rowstride = _cogl_bitmap_get_rowstride (source_bmp);
@@ -210,7 +230,7 @@ _cogl_texture_driver_upload_to_gl (GLenum       gl_target,
 
   data = _cogl_bitmap_bind (bmp, COGL_BUFFER_ACCESS_READ, 0);
 
-  GE( glTexImage2D (gl_target, 0,
+  GE( glTexImage2D (gl_target, level,
                     internal_gl_format,
                     bmp_width, bmp_height,
                     0,
@@ -74,6 +74,7 @@ void
 _cogl_features_init (void)
 {
   CoglFeatureFlags flags = 0;
+  CoglFeatureFlagsPrivate flags_private = 0;
   int              max_clip_planes = 0;
   GLint            num_stencil_bits = 0;
   const char      *gl_extensions;
@@ -87,7 +88,10 @@ _cogl_features_init (void)
     if (_cogl_feature_check ("GL", cogl_feature_data + i,
                              0, 0,
                              gl_extensions))
+      {
         flags |= cogl_feature_data[i].feature_flags;
+        flags_private |= cogl_feature_data[i].feature_flags_private;
+      }
 
   GE( glGetIntegerv (GL_STENCIL_BITS, &num_stencil_bits) );
   /* We need at least three stencil bits to combine clips */
@@ -112,6 +116,7 @@ _cogl_features_init (void)
 
   /* Cache features */
   ctx->feature_flags = flags;
+  ctx->feature_flags_private = flags_private;
   ctx->features_cached = TRUE;
 }
 
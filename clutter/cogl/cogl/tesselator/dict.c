@@ -40,7 +40,7 @@
 Dict *dictNewDict( void *frame,
 		   int (*leq)(void *frame, DictKey key1, DictKey key2) )
 {
-  Dict *dict = (Dict *) memAlloc( sizeof( Dict ));
+  Dict *dict = (Dict *) memAllocObj( sizeof( Dict ));
   DictNode *head;
 
   if (dict == NULL) return NULL;
@@ -62,11 +62,14 @@ void dictDeleteDict( Dict *dict )
 {
   DictNode *node, *next;
 
+  /* Everything will be freed at once when the arena is reset */
+  if( memArenaActive() ) return;
+
   for( node = dict->head.next; node != &dict->head; node = next ) {
     next = node->next;
-    memFree( node );
+    memFreeObj( node, sizeof( DictNode ));
   }
-  memFree( dict );
+  memFreeObj( dict, sizeof( Dict ));
 }
 
 /* really __gl_dictListInsertBefore */
@@ -78,7 +81,7 @@ DictNode *dictInsertBefore( Dict *dict, DictNode *node, DictKey key )
     node = node->prev;
   } while( node->key != NULL && ! (*dict->leq)(dict->frame, node->key, key));
 
-  newNode = (DictNode *) memAlloc( sizeof( DictNode ));
+  newNode = (DictNode *) memAllocObj( sizeof( DictNode ));
   if (newNode == NULL) return NULL;
 
   newNode->key = key;
@@ -95,7 +98,7 @@ void dictDelete( Dict *dict, DictNode *node ) /*ARGSUSED*/
 {
   node->next->prev = node->prev;
   node->prev->next = node->next;
-  memFree( node );
+  memFreeObj( node, sizeof( DictNode ));
 }
 
 /* really __gl_dictListSearch */
@@ -0,0 +1,290 @@
+/*
+ * Cogl
+ *
+ * An object oriented GL/GLES Abstraction/Utility Layer
+ *
+ * Copyright (C) 2010 Intel Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ */
+
+/* A tesselation allocates and frees a very large number of small
+   structures (half-edges, vertices, faces, dictionary nodes and
+   active regions) which all die when the tesselator is deleted. This
+   implements a simple arena for them so that allocation is just
+   bumping a pointer and the whole lot can be thrown away in one go.
+   Objects that are freed during the tesselation are put on a free
+   list for their size so that the arena doesn't keep growing while
+   the sweep creates and destroys regions.
+
+   There is one arena per thread so that paths can be tesselated in
+   threads. The chunks are kept between tesselations so that filling
+   paths doesn't need to allocate at all once the arena is big
+   enough. */
+
+#include "memalloc.h"
+#include "tesselator.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* Size of the first chunk. Each new chunk is twice the size of the
+   last one */
+#define MEM_ARENA_CHUNK_SIZE (16 * 1024)
+/* Chunks beyond this total size are freed when the arena is reset so
+   that one huge path doesn't keep its memory around forever */
+#define MEM_ARENA_MAX_KEPT_SIZE (1024 * 1024)
+/* The number of different object sizes that can have a free list.
+   The tesselator only uses about six */
+#define MEM_ARENA_N_FREE_LISTS 8
+
+/* All of the objects are aligned to the size of a double because
+   the vertices contain doubles */
+#define MEM_ARENA_ALIGN(size) \
+  (((size) + sizeof (double) - 1) & ~(gsize) (sizeof (double) - 1))
+
+typedef struct _MemArenaChunk MemArenaChunk;
+
+struct _MemArenaChunk
+{
+  MemArenaChunk *next;
+  gsize size;
+  /* Keeps the data after the header aligned */
+  double data[1];
+};
+
+typedef struct
+{
+  gsize size;
+  void *head;
+} MemArenaFreeList;
+
+typedef struct
+{
+  gboolean active;
+
+  /* The chunks in the order they were allocated */
+  MemArenaChunk *chunks;
+  MemArenaChunk *current;
+  char *pos, *end;
+
+  MemArenaFreeList free_lists[MEM_ARENA_N_FREE_LISTS];
+  int n_free_lists;
+} MemArena;
+
+static GStaticPrivate mem_arena_key = G_STATIC_PRIVATE_INIT;
+
+static void
+mem_arena_destroy (gpointer data)
+{
+  MemArena *arena = data;
+  MemArenaChunk *chunk, *next;
+
+  for (chunk = arena->chunks; chunk; chunk = next)
+    {
+      next = chunk->next;
+      g_free (chunk);
+    }
+
+  g_slice_free (MemArena, arena);
+}
+
+static MemArena *
+mem_arena_get (void)
+{
+  return g_static_private_get (&mem_arena_key);
+}
+
+static void
+mem_arena_set_chunk (MemArena *arena,
+                     MemArenaChunk *chunk)
+{
+  arena->current = chunk;
+  arena->pos = (char *) chunk->data;
+  arena->end = arena->pos + chunk->size;
+}
+
+static void *
+mem_arena_alloc_from_chunks (MemArena *arena,
+                             gsize size)
+{
+  void *ret;
+
+  /* Move on to the next chunk that was kept from a previous
+     tesselation until there is one with enough space */
+  while (arena->current &&
+         arena->pos + size > arena->end &&
+         arena->current->next)
+    mem_arena_set_chunk (arena, arena->current->next);
+
+  if (arena->current == NULL || arena->pos + size > arena->end)
+    {
+      MemArenaChunk *chunk;
+      gsize chunk_size = (arena->current
+                          ? arena->current->size * 2
+                          : MEM_ARENA_CHUNK_SIZE);
+
+      while (chunk_size < size)
+        chunk_size *= 2;
+
+      chunk = g_malloc (G_STRUCT_OFFSET (MemArenaChunk, data) + chunk_size);
+      chunk->next = NULL;
+      chunk->size = chunk_size;
+
+      /* The current chunk is always the last one at this point */
+      if (arena->current)
+        arena->current->next = chunk;
+      else
+        arena->chunks = chunk;
+
+      mem_arena_set_chunk (arena, chunk);
+    }
+
+  ret = arena->pos;
+  arena->pos += size;
+
+  return ret;
+}
+
+static MemArenaFreeList *
+mem_arena_get_free_list (MemArena *arena,
+                         gsize size)
+{
+  int i;
+
+  for (i = 0; i < arena->n_free_lists; i++)
+    if (arena->free_lists[i].size == size)
+      return arena->free_lists + i;
+
+  if (arena->n_free_lists >= MEM_ARENA_N_FREE_LISTS)
+    return NULL;
+
+  arena->free_lists[i].size = size;
+  arena->free_lists[i].head = NULL;
+  arena->n_free_lists++;
+
+  return arena->free_lists + i;
+}
+
+void *
+_cogl_tess_arena_alloc (gsize size)
+{
+  MemArena *arena = mem_arena_get ();
+  MemArenaFreeList *free_list;
+
+  if (arena == NULL || !arena->active)
+    return g_malloc (size);
+
+  size = MEM_ARENA_ALIGN (size);
+
+  /* Reuse an object of the same size if one has been freed */
+  free_list = mem_arena_get_free_list (arena, size);
+  if (free_list && free_list->head)
+    {
+      void *ret = free_list->head;
+      free_list->head = *(void **) ret;
+      return ret;
+    }
+
+  return mem_arena_alloc_from_chunks (arena, size);
+}
+
+void
+_cogl_tess_arena_free (void *p,
+                       gsize size)
+{
+  MemArena *arena = mem_arena_get ();
+  MemArenaFreeList *free_list;
+
+  if (arena == NULL || !arena->active)
+    {
+      g_free (p);
+      return;
+    }
+
+  /* If there's no free list then the memory is just wasted until the
+     arena is reset */
+  free_list = mem_arena_get_free_list (arena, MEM_ARENA_ALIGN (size));
+  if (free_list)
+    {
+      *(void **) p = free_list->head;
+      free_list->head = p;
+    }
+}
+
+gboolean
+_cogl_tess_arena_is_active (void)
+{
+  MemArena *arena = mem_arena_get ();
+
+  return arena && arena->active;
+}
+
+void
+_cogl_tess_arena_begin (void)
+{
+  MemArena *arena = mem_arena_get ();
+
+  if (arena == NULL)
+    {
+      arena = g_slice_new0 (MemArena);
+      g_static_private_set (&mem_arena_key, arena, mem_arena_destroy);
+    }
+
+  g_return_if_fail (!arena->active);
+
+  arena->active = TRUE;
+}
+
+void
+_cogl_tess_arena_end (void)
+{
+  MemArena *arena = mem_arena_get ();
+  MemArenaChunk *chunk, *next;
+  gsize kept_size = 0;
+
+  g_return_if_fail (arena != NULL && arena->active);
+
+  arena->active = FALSE;
+  arena->n_free_lists = 0;
+
+  if (arena->chunks == NULL)
+    return;
+
+  /* Keep the first chunks for the next tesselation */
+  for (chunk = arena->chunks; chunk->next; chunk = chunk->next)
+    {
+      kept_size += chunk->size;
+      if (kept_size + chunk->next->size > MEM_ARENA_MAX_KEPT_SIZE)
+        break;
+    }
+
+  next = chunk->next;
+  chunk->next = NULL;
+
+  while (next)
+    {
+      chunk = next->next;
+      g_free (next);
+      next = chunk;
+    }
+
+  mem_arena_set_chunk (arena, arena->chunks);
+}
@@ -34,6 +34,29 @@
 #define memFree    g_free
 #define memInit(x) 1
 
+/* The fixed size structures of the mesh, the sweep line dictionary
+   and the active regions are allocated with these instead. Between
+   _cogl_tess_arena_begin() and _cogl_tess_arena_end() they come from
+   an arena for the current thread that is freed in one go at the end,
+   otherwise they just use g_malloc. The size must be passed when
+   freeing so that the memory can be reused for the next object of the
+   same size. See memalloc.c */
+#define memAllocObj(size)   _cogl_tess_arena_alloc (size)
+#define memFreeObj(p, size) _cogl_tess_arena_free ((p), (size))
+/* If this is TRUE then there's no need to free a whole structure
+   object by object because it will all be freed at the end */
+#define memArenaActive()    _cogl_tess_arena_is_active ()
+
+void *
+_cogl_tess_arena_alloc (gsize size);
+
+void
+_cogl_tess_arena_free (void *p,
+                       gsize size);
+
+gboolean
+_cogl_tess_arena_is_active (void);
+
 /* tess.c defines TRUE and FALSE itself unconditionally so we need to
    undefine it from the glib headers */
 #undef TRUE
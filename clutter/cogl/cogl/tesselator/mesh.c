@@ -47,12 +47,12 @@
 
 static GLUvertex *allocVertex()
 {
-   return (GLUvertex *)memAlloc( sizeof( GLUvertex ));
+   return (GLUvertex *)memAllocObj( sizeof( GLUvertex ));
 }
 
 static GLUface *allocFace()
 {
-   return (GLUface *)memAlloc( sizeof( GLUface ));
+   return (GLUface *)memAllocObj( sizeof( GLUface ));
 }
 
 /************************ Utility Routines ************************/
@@ -71,7 +71,7 @@ static GLUhalfEdge *MakeEdge( GLUhalfEdge *eNext )
   GLUhalfEdge *e;
   GLUhalfEdge *eSym;
   GLUhalfEdge *ePrev;
-  EdgePair *pair = (EdgePair *)memAlloc( sizeof( EdgePair ));
+  EdgePair *pair = (EdgePair *)memAllocObj( sizeof( EdgePair ));
   if (pair == NULL) return NULL;
 
   e = &pair->e;
@@ -214,7 +214,7 @@ static void KillEdge( GLUhalfEdge *eDel )
   eNext->Sym->next = ePrev;
   ePrev->Sym->next = eNext;
 
-  memFree( eDel );
+  memFreeObj( eDel, sizeof( EdgePair ));
 }
 
 
@@ -239,7 +239,7 @@ static void KillVertex( GLUvertex *vDel, GLUvertex *newOrg )
   vNext->prev = vPrev;
   vPrev->next = vNext;
 
-  memFree( vDel );
+  memFreeObj( vDel, sizeof( GLUvertex ));
 }
 
 /* KillFace( fDel ) destroys a face and removes it from the global face
@@ -263,7 +263,7 @@ static void KillFace( GLUface *fDel, GLUface *newLface )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fDel );
+  memFreeObj( fDel, sizeof( GLUface ));
 }
 
 
@@ -281,17 +281,17 @@ GLUhalfEdge *__gl_meshMakeEdge( GLUmesh *mesh )
 
   /* if any one is null then all get freed */
   if (newVertex1 == NULL || newVertex2 == NULL || newFace == NULL) {
-     if (newVertex1 != NULL) memFree(newVertex1);
-     if (newVertex2 != NULL) memFree(newVertex2);
-     if (newFace != NULL) memFree(newFace);     
+     if (newVertex1 != NULL) memFreeObj(newVertex1, sizeof(GLUvertex));
+     if (newVertex2 != NULL) memFreeObj(newVertex2, sizeof(GLUvertex));
+     if (newFace != NULL) memFreeObj(newFace, sizeof(GLUface));
      return NULL;
   } 
 
   e = MakeEdge( &mesh->eHead );
   if (e == NULL) {
-     memFree(newVertex1);
-     memFree(newVertex2);
-     memFree(newFace);
+     memFreeObj(newVertex1, sizeof(GLUvertex));
+     memFreeObj(newVertex2, sizeof(GLUvertex));
+     memFreeObj(newFace, sizeof(GLUface));
      return NULL;
   }
 
@@ -593,7 +593,7 @@ void __gl_meshZapFace( GLUface *fZap )
   fNext->prev = fPrev;
   fPrev->next = fNext;
 
-  memFree( fZap );
+  memFreeObj( fZap, sizeof( GLUface ));
 }
 
 
@@ -606,7 +606,7 @@ GLUmesh *__gl_meshNewMesh( void )
   GLUface *f;
   GLUhalfEdge *e;
   GLUhalfEdge *eSym;
-  GLUmesh *mesh = (GLUmesh *)memAlloc( sizeof( GLUmesh ));
+  GLUmesh *mesh = (GLUmesh *)memAllocObj( sizeof( GLUmesh ));
   if (mesh == NULL) {
      return NULL;
   }
@@ -683,7 +683,7 @@ GLUmesh *__gl_meshUnion( GLUmesh *mesh1, GLUmesh *mesh2 )
     e1->Sym->next = e2->Sym->next;
   }
 
-  memFree( mesh2 );
+  memFreeObj( mesh2, sizeof( GLUmesh ));
   return mesh1;
 }
 
@@ -701,7 +701,7 @@ void __gl_meshDeleteMesh( GLUmesh *mesh )
   }
   assert( mesh->vHead.next == &mesh->vHead );
 
-  memFree( mesh );
+  memFreeObj( mesh, sizeof( GLUmesh ));
 }
 
 #else
@@ -714,23 +714,26 @@ void __gl_meshDeleteMesh( GLUmesh *mesh )
   GLUvertex *v, *vNext;
   GLUhalfEdge *e, *eNext;
 
+  /* Everything will be freed at once when the arena is reset */
+  if( memArenaActive() ) return;
+
   for( f = mesh->fHead.next; f != &mesh->fHead; f = fNext ) {
     fNext = f->next;
-    memFree( f );
+    memFreeObj( f, sizeof( GLUface ));
   }
 
   for( v = mesh->vHead.next; v != &mesh->vHead; v = vNext ) {
     vNext = v->next;
-    memFree( v );
+    memFreeObj( v, sizeof( GLUvertex ));
   }
 
   for( e = mesh->eHead.next; e != &mesh->eHead; e = eNext ) {
     /* One call frees both e and e->Sym (see EdgePair above) */
     eNext = e->next;
-    memFree( e );
+    memFreeObj( e, sizeof( EdgePair ));
   }
 
-  memFree( mesh );
+  memFreeObj( mesh, sizeof( GLUmesh ));
 }
 
 #endif
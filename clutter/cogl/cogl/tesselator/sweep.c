@@ -159,7 +159,7 @@ static void DeleteRegion( GLUtesselator *tess, ActiveRegion *reg )
   }
   reg->eUp->activeRegion = NULL;
   dictDelete( tess->dict, reg->nodeUp ); /* __gl_dictListDelete */
-  memFree( reg );
+  memFreeObj( reg, sizeof( ActiveRegion ));
 }
 
 
@@ -220,7 +220,7 @@ static ActiveRegion *AddRegionBelow( GLUtesselator *tess,
  * Winding number and "inside" flag are not updated.
  */
 {
-  ActiveRegion *regNew = (ActiveRegion *)memAlloc( sizeof( ActiveRegion ));
+  ActiveRegion *regNew = (ActiveRegion *)memAllocObj( sizeof( ActiveRegion ));
   if (regNew == NULL) longjmp(tess->env,1);
 
   regNew->eUp = eNewUp;
@@ -1132,7 +1132,7 @@ static void AddSentinel( GLUtesselator *tess, GLdouble t )
  */
 {
   GLUhalfEdge *e;
-  ActiveRegion *reg = (ActiveRegion *)memAlloc( sizeof( ActiveRegion ));
+  ActiveRegion *reg = (ActiveRegion *)memAllocObj( sizeof( ActiveRegion ));
   if (reg == NULL) longjmp(tess->env,1);
 
   e = __gl_meshMakeEdge( tess->mesh );
@@ -60,6 +60,13 @@ void gluTessNormal (GLUtesselator* tess, double valueX, double valueY, double va
 void gluTessProperty (GLUtesselator* tess, GLenum which, double data);
 void gluTessVertex (GLUtesselator* tess, double *location, GLvoid* data);
 
+/* Cogl extension: the mesh and sweep structures of all tesselators
+   used on the current thread between these calls are allocated from
+   an arena that is emptied in one go by _cogl_tess_arena_end. All of
+   the tesselators must be deleted before then */
+void _cogl_tess_arena_begin (void);
+void _cogl_tess_arena_end (void);
+
 /* ErrorCode */
 #define GLU_INVALID_ENUM                   100900
 #define GLU_INVALID_VALUE                  100901
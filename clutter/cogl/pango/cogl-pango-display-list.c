@@ -28,9 +28,22 @@
 #include <glib.h>
 #include <cogl/cogl.h>
 #include <string.h>
+#include <stdlib.h>
 
 #include "cogl-pango-display-list.h"
 
+/* Number of glyphs in a texture node below which the glyphs are drawn
+   through the Cogl journal instead of a retained VBO. Short runs are
+   usually cheaper through the journal because it can batch the quads
+   of many separate layouts sharing a glyph texture into a single
+   draw, whereas every VBO needs its own draw call and modelview
+   flush. The default is only a rough guess and hasn't been measured
+   on a range of drivers. It can be overridden with the
+   COGL_PANGO_VBO_THRESHOLD environment variable. The third argument
+   of tests/micro-bench/test-text-perf sets the variable so the rates
+   it prints can be compared for different values */
+#define COGL_PANGO_DEFAULT_VBO_THRESHOLD 25
+
 typedef enum
 {
   COGL_PANGO_DISPLAY_LIST_TEXTURE,
@@ -66,6 +79,9 @@ struct _CoglPangoDisplayListNode
       GArray     *verts;
       /* A VBO representing those vertices */
       CoglHandle  vertex_buffer;
+      /* The same vertices packed as an array of rectangles suitable
+         for cogl_rectangles_with_texture_coords() */
+      float      *rectangles;
     } texture;
 
     struct
@@ -147,6 +163,11 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
           cogl_handle_unref (node->d.texture.vertex_buffer);
           node->d.texture.vertex_buffer = COGL_INVALID_HANDLE;
         }
+      if (node->d.texture.rectangles)
+        {
+          g_free (node->d.texture.rectangles);
+          node->d.texture.rectangles = NULL;
+        }
     }
   else
     {
@@ -160,6 +181,7 @@ _cogl_pango_display_list_add_texture (CoglPangoDisplayList *dl,
       node->d.texture.verts
         = g_array_new (FALSE, FALSE, sizeof (CoglPangoDisplayListVertex));
       node->d.texture.vertex_buffer = COGL_INVALID_HANDLE;
+      node->d.texture.rectangles = NULL;
 
       _cogl_pango_display_list_append_node (dl, node);
     }
@@ -233,38 +255,68 @@ _cogl_pango_display_list_add_trapezoid (CoglPangoDisplayList *dl,
   _cogl_pango_display_list_append_node (dl, node);
 }
 
+static int
+_cogl_pango_display_list_get_vbo_threshold (void)
+{
+  static int threshold = -1;
+
+  if (G_UNLIKELY (threshold < 0))
+    {
+      const char *env = g_getenv ("COGL_PANGO_VBO_THRESHOLD");
+
+      if (env)
+        threshold = MAX (atoi (env), 0);
+      else
+        threshold = COGL_PANGO_DEFAULT_VBO_THRESHOLD;
+    }
+
+  return threshold;
+}
+
 static void
-_cogl_pango_display_list_render_texture (CoglHandle material,
-                                         const CoglColor *color,
-                                         CoglPangoDisplayListNode *node)
+_cogl_pango_display_list_render_texture_geometry (CoglPangoDisplayListNode *node)
 {
-  CoglColor premult_color = *color;
-  cogl_material_set_layer (material, 0, node->d.texture.texture);
-  cogl_material_set_color (material, &premult_color);
-  cogl_set_source (material);
+  int n_rects = node->d.texture.verts->len / 4;
 
   /* For small runs of text like icon labels, we can get better performance
    * going through the Cogl journal since text may then be batched together
    * with other geometry. */
-  /* FIXME: 100 is a number I plucked out of thin air; it would be good
-   * to determine this empirically! */
-  if (node->d.texture.verts->len < 100)
+  if (n_rects < _cogl_pango_display_list_get_vbo_threshold ())
     {
-      int i;
-
-      for (i = 0; i < node->d.texture.verts->len; i += 4)
+      /* The rectangles are kept with the node so that they only have
+         to be rebuilt when the text changes */
+      if (node->d.texture.rectangles == NULL)
         {
-          CoglPangoDisplayListVertex *v0 =
-            &g_array_index (node->d.texture.verts,
-                            CoglPangoDisplayListVertex, i);
-          CoglPangoDisplayListVertex *v1 =
-            &g_array_index (node->d.texture.verts,
-                            CoglPangoDisplayListVertex, i + 2);
-          cogl_rectangle_with_texture_coords (v0->x, v0->y, v1->x, v1->y,
-                                              v0->t_x, v0->t_y,
-                                              v1->t_x, v1->t_y);
+          float *r;
+          int i;
+
+          r = node->d.texture.rectangles = g_new (float, n_rects * 8);
+
+          for (i = 0; i < node->d.texture.verts->len; i += 4)
+            {
+              CoglPangoDisplayListVertex *v0 =
+                &g_array_index (node->d.texture.verts,
+                                CoglPangoDisplayListVertex, i);
+              CoglPangoDisplayListVertex *v1 =
+                &g_array_index (node->d.texture.verts,
+                                CoglPangoDisplayListVertex, i + 2);
+
+              *(r++) = v0->x;
+              *(r++) = v0->y;
+              *(r++) = v1->x;
+              *(r++) = v1->y;
+              *(r++) = v0->t_x;
+              *(r++) = v0->t_y;
+              *(r++) = v1->t_x;
+              *(r++) = v1->t_y;
+            }
         }
 
+      /* Log all of the glyphs with a single call so they end up as one
+         batch in the journal */
+      cogl_rectangles_with_texture_coords (node->d.texture.rectangles,
+                                           n_rects);
+
       return;
     }
 
@@ -321,10 +373,49 @@ _cogl_pango_display_list_render_texture (CoglHandle material,
 #endif /* CLUTTER_COGL_HAS_GL */
 }
 
+static void
+_cogl_pango_display_list_render_texture (CoglHandle material,
+                                         CoglHandle program,
+                                         const CoglColor *color,
+                                         CoglPangoDisplayListNode *node)
+{
+  CoglColor premult_color = *color;
+  CoglHandle old_program = COGL_INVALID_HANDLE;
+
+  cogl_material_set_layer (material, 0, node->d.texture.texture);
+  cogl_material_set_color (material, &premult_color);
+  cogl_set_source (material);
+
+  /* The program is picked up from the legacy state when the geometry
+     is logged so it only affects the glyphs. Any program that the
+     application had set (for example from a ClutterShader) is put
+     back afterwards so that it still applies to the rest of the
+     display list */
+  if (program != COGL_INVALID_HANDLE)
+    {
+      old_program = _cogl_get_current_program ();
+      if (old_program != COGL_INVALID_HANDLE)
+        cogl_handle_ref (old_program);
+
+      cogl_program_use (program);
+    }
+
+  _cogl_pango_display_list_render_texture_geometry (node);
+
+  if (program != COGL_INVALID_HANDLE)
+    {
+      cogl_program_use (old_program);
+
+      if (old_program != COGL_INVALID_HANDLE)
+        cogl_handle_unref (old_program);
+    }
+}
+
 void
 _cogl_pango_display_list_render (CoglPangoDisplayList *dl,
                                  const CoglColor *color,
                                  CoglHandle glyph_material,
+                                 CoglHandle glyph_program,
                                  CoglHandle solid_material)
 {
   GSList *l;
@@ -350,6 +441,7 @@ _cogl_pango_display_list_render (CoglPangoDisplayList *dl,
         {
         case COGL_PANGO_DISPLAY_LIST_TEXTURE:
           _cogl_pango_display_list_render_texture (glyph_material,
+                                                   glyph_program,
                                                    &draw_color, node);
           break;
 
@@ -395,6 +487,7 @@ _cogl_pango_display_list_node_free (CoglPangoDisplayListNode *node)
         cogl_handle_unref (node->d.texture.texture);
       if (node->d.texture.vertex_buffer != COGL_INVALID_HANDLE)
         cogl_handle_unref (node->d.texture.vertex_buffer);
+      g_free (node->d.texture.rectangles);
     }
 
   g_slice_free (CoglPangoDisplayListNode, node);
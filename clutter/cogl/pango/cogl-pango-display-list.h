@@ -59,6 +59,7 @@ void _cogl_pango_display_list_add_trapezoid (CoglPangoDisplayList *dl,
 void _cogl_pango_display_list_render (CoglPangoDisplayList *dl,
                                       const CoglColor *color,
                                       CoglHandle glyph_material,
+                                      CoglHandle glyph_program,
                                       CoglHandle solid_material);
 
 void _cogl_pango_display_list_clear (CoglPangoDisplayList *dl);
@@ -197,6 +197,159 @@ cogl_pango_font_map_get_use_mipmapping (CoglPangoFontMap *fm)
   return _cogl_pango_renderer_get_use_mipmapping (renderer);
 }
 
+/**
+ * cogl_pango_font_map_set_use_async_rasterization:
+ * @fm: a #CoglPangoFontMap
+ * @value: %TRUE to rasterize glyphs in worker threads
+ *
+ * Sets whether the renderer for the passed font map should rasterize
+ * glyphs that are missing from the glyph cache in worker threads
+ * instead of on the paint path.
+ *
+ * When enabled, a missing glyph gets its space in the cache reserved
+ * immediately and is drawn blank until its image has been uploaded.
+ * Finished glyphs are uploaded in a batch whenever a layout is
+ * rendered or when cogl_pango_font_map_upload_pending_glyphs() is
+ * called, which is typically done at the start of every frame.
+ *
+ * This has no effect if the GLib thread system has not been
+ * initialized.
+ *
+ * Since: 1.4
+ */
+void
+cogl_pango_font_map_set_use_async_rasterization (CoglPangoFontMap *fm,
+                                                 gboolean          value)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  _cogl_pango_renderer_set_use_async_rasterization (renderer, value);
+}
+
+/**
+ * cogl_pango_font_map_get_use_async_rasterization:
+ * @fm: a #CoglPangoFontMap
+ *
+ * Retrieves whether the #CoglPangoRenderer used by @fm rasterizes
+ * glyphs in worker threads.
+ *
+ * Return value: %TRUE if glyphs are rasterized asynchronously
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_pango_font_map_get_use_async_rasterization (CoglPangoFontMap *fm)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  return _cogl_pango_renderer_get_use_async_rasterization (renderer);
+}
+
+/**
+ * cogl_pango_font_map_upload_pending_glyphs:
+ * @fm: a #CoglPangoFontMap
+ *
+ * Uploads all of the glyphs that have been rasterized by the worker
+ * threads since the last call into the glyph cache textures.
+ *
+ * Return value: %TRUE if any glyphs were uploaded, in which case any
+ *   text drawn with @fm should be repainted
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_pango_font_map_upload_pending_glyphs (CoglPangoFontMap *fm)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  return _cogl_pango_renderer_upload_pending_glyphs (renderer);
+}
+
+/**
+ * cogl_pango_font_map_has_pending_glyphs:
+ * @fm: a #CoglPangoFontMap
+ *
+ * Checks whether any glyphs are still being rasterized by the worker
+ * threads or are waiting to be uploaded.
+ *
+ * Return value: %TRUE if there are glyphs pending
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_pango_font_map_has_pending_glyphs (CoglPangoFontMap *fm)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  return _cogl_pango_renderer_has_pending_glyphs (renderer);
+}
+
+/**
+ * cogl_pango_font_map_set_use_distance_field:
+ * @fm: a #CoglPangoFontMap
+ * @value: %TRUE to render glyphs from signed distance fields
+ *
+ * Sets whether the renderer for the passed font map should render
+ * glyphs from signed distance fields instead of coverage images.
+ *
+ * In this mode each glyph is rasterized once at a fixed reference
+ * size, converted to a distance field and drawn scaled to the size
+ * of the font. Text stays sharp when it is scaled up by the actor
+ * transformation and changing the font size doesn't need any new
+ * glyphs to be rasterized, which makes it suitable for zooming
+ * animations. Small text is rendered with slightly less detail than
+ * with the normal glyph cache.
+ *
+ * When GLSL is available the outline is reconstructed with a smooth
+ * edge in a fragment shader, otherwise the material's alpha test is
+ * used which gives hard edges. In both cases the glyphs fade with the
+ * opacity of the text. The shader is only used for the glyphs
+ * themselves; a program set with cogl_program_use() is still used for
+ * the rest of the layout, such as underlines, and is current again
+ * once the layout has been drawn.
+ *
+ * Since: 1.4
+ */
+void
+cogl_pango_font_map_set_use_distance_field (CoglPangoFontMap *fm,
+                                            gboolean          value)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  _cogl_pango_renderer_set_use_distance_field (renderer, value);
+}
+
+/**
+ * cogl_pango_font_map_get_use_distance_field:
+ * @fm: a #CoglPangoFontMap
+ *
+ * Retrieves whether the #CoglPangoRenderer used by @fm renders glyphs
+ * from signed distance fields.
+ *
+ * Return value: %TRUE if distance fields are used
+ *
+ * Since: 1.4
+ */
+gboolean
+cogl_pango_font_map_get_use_distance_field (CoglPangoFontMap *fm)
+{
+  CoglPangoRenderer *renderer;
+
+  renderer = COGL_PANGO_RENDERER (cogl_pango_font_map_get_renderer (fm));
+
+  return _cogl_pango_renderer_get_use_distance_field (renderer);
+}
+
 static GQuark
 cogl_pango_font_map_get_renderer_key (void)
 {
@@ -226,16 +226,18 @@ cogl_pango_glyph_cache_lookup (CoglPangoGlyphCache *cache,
     g_hash_table_lookup (cache->hash_table, &key);
 }
 
+/* Reserves space for a glyph of the given size and adds an entry for
+   it to the hash table without putting any data in the texture. The
+   region is left blank until something uploads the glyph image to
+   value->tex_x and value->tex_y */
 CoglPangoGlyphCacheValue *
-cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
-			    PangoFont           *font,
-			    PangoGlyph           glyph,
-			    gconstpointer        pixels,
-			    int                  width,
-			    int                  height,
-			    int                  stride,
-			    int                  draw_x,
-			    int                  draw_y)
+cogl_pango_glyph_cache_reserve (CoglPangoGlyphCache *cache,
+                                PangoFont           *font,
+                                PangoGlyph           glyph,
+                                int                  width,
+                                int                  height,
+                                int                  draw_x,
+                                int                  draw_y)
 {
   int                       band_height;
   CoglPangoGlyphCacheBand  *band;
@@ -317,16 +319,6 @@ cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
   width--;
   height--;
 
-  cogl_texture_set_region (band->texture,
-			   0, 0,
-			   band->space_remaining,
-			   band->top,
-			   width, height,
-			   width, height,
-			   COGL_PIXEL_FORMAT_A_8,
-			   stride,
-			   pixels);
-
   key = g_slice_new (CoglPangoGlyphCacheKey);
   key->font = g_object_ref (font);
   key->glyph = glyph;
@@ -341,6 +333,8 @@ cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
              / band->texture_size;
   value->ty2 = (float)(band->top + height)
              / band->texture_size;
+  value->tex_x = band->space_remaining;
+  value->tex_y = band->top;
   value->draw_x = draw_x;
   value->draw_y = draw_y;
   value->draw_width = width;
@@ -350,3 +344,33 @@ cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
 
   return value;
 }
+
+CoglPangoGlyphCacheValue *
+cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
+			    PangoFont           *font,
+			    PangoGlyph           glyph,
+			    gconstpointer        pixels,
+			    int                  width,
+			    int                  height,
+			    int                  stride,
+			    int                  draw_x,
+			    int                  draw_y)
+{
+  CoglPangoGlyphCacheValue *value;
+
+  value = cogl_pango_glyph_cache_reserve (cache, font, glyph,
+                                          width, height,
+                                          draw_x, draw_y);
+
+  cogl_texture_set_region (value->texture,
+			   0, 0,
+			   value->tex_x,
+			   value->tex_y,
+			   width, height,
+			   width, height,
+			   COGL_PIXEL_FORMAT_A_8,
+			   stride,
+			   pixels);
+
+  return value;
+}
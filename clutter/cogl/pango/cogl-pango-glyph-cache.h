@@ -42,6 +42,10 @@ struct _CoglPangoGlyphCacheValue
   float  tx2;
   float  ty2;
 
+  /* The position of the glyph in pixels within the texture */
+  int        tex_x;
+  int        tex_y;
+
   int        draw_x;
   int        draw_y;
   int        draw_width;
@@ -70,6 +74,15 @@ cogl_pango_glyph_cache_set (CoglPangoGlyphCache *cache,
 			    int                  draw_x,
 			    int                  draw_y);
 
+CoglPangoGlyphCacheValue *
+cogl_pango_glyph_cache_reserve (CoglPangoGlyphCache *cache,
+                                PangoFont           *font,
+                                PangoGlyph           glyph,
+                                int                  width,
+                                int                  height,
+                                int                  draw_x,
+                                int                  draw_y);
+
 void
 cogl_pango_glyph_cache_clear (CoglPangoGlyphCache *cache);
 
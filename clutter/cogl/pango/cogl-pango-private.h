@@ -32,6 +32,19 @@ void           _cogl_pango_renderer_clear_glyph_cache  (CoglPangoRenderer *rende
 void           _cogl_pango_renderer_set_use_mipmapping (CoglPangoRenderer *renderer,
                                                         gboolean           value);
 gboolean       _cogl_pango_renderer_get_use_mipmapping (CoglPangoRenderer *renderer);
+void           _cogl_pango_renderer_set_use_async_rasterization
+                                                       (CoglPangoRenderer *renderer,
+                                                        gboolean           value);
+gboolean       _cogl_pango_renderer_get_use_async_rasterization
+                                                       (CoglPangoRenderer *renderer);
+gboolean       _cogl_pango_renderer_upload_pending_glyphs
+                                                       (CoglPangoRenderer *renderer);
+gboolean       _cogl_pango_renderer_has_pending_glyphs (CoglPangoRenderer *renderer);
+void           _cogl_pango_renderer_set_use_distance_field
+                                                       (CoglPangoRenderer *renderer,
+                                                        gboolean           value);
+gboolean       _cogl_pango_renderer_get_use_distance_field
+                                                       (CoglPangoRenderer *renderer);
 
 G_END_DECLS
 
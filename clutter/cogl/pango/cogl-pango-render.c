@@ -33,11 +33,42 @@
 #include <pango/pangocairo.h>
 #include <pango/pango-renderer.h>
 #include <cairo.h>
+#include <string.h>
+#include <math.h>
 
 #include "cogl-pango-private.h"
 #include "cogl-pango-glyph-cache.h"
 #include "cogl-pango-display-list.h"
 
+/* Number of threads used to rasterize glyphs when asynchronous
+   rasterization is enabled */
+#define COGL_PANGO_RASTERIZE_THREADS 2
+
+/* Size in pixels that glyphs are rasterized at when the distance
+   field mode is used. Glyphs drawn at any other size are scaled from
+   this one */
+#define COGL_PANGO_DISTANCE_FIELD_SIZE   32
+/* Distance in pixels, at the reference size, covered by the distance
+   field on either side of the outline */
+#define COGL_PANGO_DISTANCE_FIELD_SPREAD 4
+
+#ifdef CLUTTER_COGL_HAS_GL
+/* Reconstructs the outline from the distance field with a smooth edge
+   roughly one screen pixel wide whatever the scale. The material
+   colour is already premultiplied */
+static const char distance_field_shader_source[] =
+  "uniform sampler2D tex;\n"
+  "\n"
+  "void\n"
+  "main ()\n"
+  "{\n"
+  "  float dist = texture2D (tex, gl_TexCoord[0].st).a;\n"
+  "  float width = fwidth (dist) * 0.75;\n"
+  "  float alpha = smoothstep (0.5 - width, 0.5 + width, dist);\n"
+  "  gl_FragColor = gl_Color * alpha;\n"
+  "}\n";
+#endif /* CLUTTER_COGL_HAS_GL */
+
 struct _CoglPangoRenderer
 {
   PangoRenderer parent_instance;
@@ -52,6 +83,46 @@ struct _CoglPangoRenderer
 
   /* The current display list that is being built */
   CoglPangoDisplayList *display_list;
+
+  /* Pool of threads used to rasterize glyphs when asynchronous
+     rasterization is enabled. This is NULL otherwise */
+  GThreadPool *rasterize_pool;
+
+  /* Protects the two members below which are shared with the
+     rasterization threads */
+  GMutex *rasterize_mutex;
+  /* List of CoglPangoGlyphJobs that have been rasterized and are
+     waiting to be uploaded */
+  GSList *finished_jobs;
+  /* Number of jobs that have been queued but not yet uploaded */
+  int n_pending_jobs;
+
+  /* Whether glyphs are rendered from signed distance fields */
+  gboolean use_distance_field;
+  /* Cache of distance field images of the glyphs at the reference
+     size, kept separately from the normal glyph cache */
+  CoglPangoGlyphCache *distance_field_cache;
+  /* The material used to draw from the distance field cache */
+  CoglHandle distance_field_material;
+  /* GLSL program used to reconstruct the outline, or
+     COGL_INVALID_HANDLE if the material's alpha test is used */
+  CoglHandle distance_field_program;
+  /* Context and font options used to load the reference size fonts */
+  PangoContext *distance_field_context;
+  cairo_font_options_t *distance_field_font_options;
+  /* Maps from each font to a CoglPangoDistanceFieldFont */
+  GHashTable *distance_field_fonts;
+};
+
+typedef struct _CoglPangoDistanceFieldFont CoglPangoDistanceFieldFont;
+
+/* The same face as a given font loaded at the reference size */
+struct _CoglPangoDistanceFieldFont
+{
+  PangoFont *font;
+  /* The factor to scale the reference glyphs by to get the size of
+     the original font */
+  float      scale;
 };
 
 struct _CoglPangoRendererClass
@@ -70,20 +141,49 @@ struct _CoglPangoRendererQdata
   /* A reference to the first line of the layout. This is just used to
      detect changes */
   PangoLayoutLine *first_line;
+  /* Whether the display list was built from distance field glyphs */
+  gboolean distance_field;
+};
+
+typedef struct _CoglPangoGlyphJob CoglPangoGlyphJob;
+
+/* A glyph whose space has been reserved in the glyph cache but whose
+   image is being rendered by one of the rasterization threads */
+struct _CoglPangoGlyphJob
+{
+  /* Inputs for the thread. These are owned by the job */
+  cairo_scaled_font_t *scaled_font;
+  PangoGlyph           glyph;
+  PangoRectangle       ink_rect;
+
+  /* Where the glyph should end up. We keep our own reference to the
+     texture so that it is safe to clear the glyph cache while the
+     job is still in flight */
+  CoglHandle           texture;
+  int                  tex_x;
+  int                  tex_y;
+
+  /* Whether the thread should convert the glyph to a distance
+     field */
+  gboolean             distance_field;
+
+  /* Output of the thread */
+  cairo_surface_t     *surface;
 };
 
 static void
 cogl_pango_renderer_draw_glyph (CoglPangoRenderer        *priv,
                                 CoglPangoGlyphCacheValue *cache_value,
                                 float                     x1,
-                                float                     y1)
+                                float                     y1,
+                                float                     scale)
 {
   float x2, y2;
 
   g_return_if_fail (priv->display_list != NULL);
 
-  x2 = x1 + (float) cache_value->draw_width;
-  y2 = y1 + (float) cache_value->draw_height;
+  x2 = x1 + (float) cache_value->draw_width * scale;
+  y2 = y1 + (float) cache_value->draw_height * scale;
 
   _cogl_pango_display_list_add_texture (priv->display_list,
                                         cache_value->texture,
@@ -146,6 +246,19 @@ cogl_pango_renderer_init (CoglPangoRenderer *priv)
 
   priv->glyph_cache = cogl_pango_glyph_cache_new ();
 
+  priv->rasterize_pool = NULL;
+  priv->rasterize_mutex = NULL;
+  priv->finished_jobs = NULL;
+  priv->n_pending_jobs = 0;
+
+  priv->use_distance_field = FALSE;
+  priv->distance_field_cache = NULL;
+  priv->distance_field_material = COGL_INVALID_HANDLE;
+  priv->distance_field_program = COGL_INVALID_HANDLE;
+  priv->distance_field_context = NULL;
+  priv->distance_field_font_options = NULL;
+  priv->distance_field_fonts = NULL;
+
   _cogl_pango_renderer_set_use_mipmapping (priv, FALSE);
 }
 
@@ -167,8 +280,23 @@ cogl_pango_renderer_finalize (GObject *object)
 {
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (object);
 
+  _cogl_pango_renderer_set_use_async_rasterization (priv, FALSE);
+
   cogl_pango_glyph_cache_free (priv->glyph_cache);
 
+  if (priv->distance_field_cache)
+    cogl_pango_glyph_cache_free (priv->distance_field_cache);
+  if (priv->distance_field_material != COGL_INVALID_HANDLE)
+    cogl_handle_unref (priv->distance_field_material);
+  if (priv->distance_field_program != COGL_INVALID_HANDLE)
+    cogl_handle_unref (priv->distance_field_program);
+  if (priv->distance_field_fonts)
+    g_hash_table_destroy (priv->distance_field_fonts);
+  if (priv->distance_field_context)
+    g_object_unref (priv->distance_field_context);
+  if (priv->distance_field_font_options)
+    cairo_font_options_destroy (priv->distance_field_font_options);
+
   G_OBJECT_CLASS (cogl_pango_renderer_parent_class)->finalize (object);
 }
 
@@ -189,6 +317,441 @@ cogl_pango_get_renderer_from_context (PangoContext *context)
   return COGL_PANGO_RENDERER (renderer);
 }
 
+static void
+cogl_pango_glyph_job_free (CoglPangoGlyphJob *job)
+{
+  cairo_scaled_font_destroy (job->scaled_font);
+  cogl_handle_unref (job->texture);
+  if (job->surface)
+    cairo_surface_destroy (job->surface);
+  g_slice_free (CoglPangoGlyphJob, job);
+}
+
+static cairo_surface_t *
+cogl_pango_rasterize_glyph (cairo_scaled_font_t  *scaled_font,
+                            PangoGlyph            glyph,
+                            const PangoRectangle *ink_rect)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  cairo_glyph_t cairo_glyph;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
+                                        ink_rect->width,
+                                        ink_rect->height);
+  cr = cairo_create (surface);
+
+  cairo_set_scaled_font (cr, scaled_font);
+
+  cairo_glyph.x = -ink_rect->x;
+  cairo_glyph.y = -ink_rect->y;
+  /* The PangoCairo glyph numbers directly map to Cairo glyph
+     numbers */
+  cairo_glyph.index = glyph;
+  cairo_show_glyphs (cr, &cairo_glyph, 1);
+
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+
+  return surface;
+}
+
+/* Replaces the coverage values in an A8 image with a signed distance
+   field. 0.5 lies on the outline, larger values are inside the glyph
+   and the field saturates COGL_PANGO_DISTANCE_FIELD_SPREAD pixels
+   away from the edge. The search is brute force but the images are
+   small and this is only done once per glyph */
+static void
+cogl_pango_glyph_to_distance_field (guint8 *data,
+                                    int     width,
+                                    int     height,
+                                    int     stride)
+{
+  const int spread = COGL_PANGO_DISTANCE_FIELD_SPREAD;
+  guint8 *coverage;
+  int x, y;
+
+  coverage = g_malloc (width * height);
+  for (y = 0; y < height; y++)
+    memcpy (coverage + y * width, data + y * stride, width);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        gboolean inside = coverage[y * width + x] >= 128;
+        int best = spread * spread * 2 + 1;
+        float dist;
+        int dx, dy;
+
+        for (dy = -spread; dy <= spread; dy++)
+          for (dx = -spread; dx <= spread; dx++)
+            {
+              int nx = x + dx, ny = y + dy;
+              gboolean n_inside;
+
+              /* Everything outside the image is outside the glyph */
+              if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                n_inside = FALSE;
+              else
+                n_inside = coverage[ny * width + nx] >= 128;
+
+              if (n_inside != inside && dx * dx + dy * dy < best)
+                best = dx * dx + dy * dy;
+            }
+
+        /* The edge lies half way between the two pixel centres */
+        dist = CLAMP (sqrtf (best) - 0.5f, 0.0f, (float) spread);
+        if (!inside)
+          dist = -dist;
+
+        data[y * stride + x] =
+          CLAMP ((0.5f + dist / (2.0f * spread)) * 255.0f + 0.5f,
+                 0.0f, 255.0f);
+      }
+
+  g_free (coverage);
+}
+
+static void
+cogl_pango_renderer_rasterize_thread_func (gpointer job_data,
+                                           gpointer user_data)
+{
+  CoglPangoGlyphJob *job = job_data;
+  CoglPangoRenderer *priv = user_data;
+
+  /* Cairo scaled fonts are thread-safe so we can render with them
+     here without taking any locks. Only the hand over of the result
+     needs to be protected */
+  job->surface = cogl_pango_rasterize_glyph (job->scaled_font,
+                                             job->glyph,
+                                             &job->ink_rect);
+
+  if (job->distance_field)
+    cogl_pango_glyph_to_distance_field
+      (cairo_image_surface_get_data (job->surface),
+       job->ink_rect.width,
+       job->ink_rect.height,
+       cairo_image_surface_get_stride (job->surface));
+
+  g_mutex_lock (priv->rasterize_mutex);
+  priv->finished_jobs = g_slist_prepend (priv->finished_jobs, job);
+  g_mutex_unlock (priv->rasterize_mutex);
+}
+
+gboolean
+_cogl_pango_renderer_upload_pending_glyphs (CoglPangoRenderer *renderer)
+{
+  GSList *jobs, *l;
+  int n_jobs = 0;
+
+  if (renderer->rasterize_pool == NULL)
+    return FALSE;
+
+  /* Steal the whole list so the rasterization threads can carry on
+     while we upload */
+  g_mutex_lock (renderer->rasterize_mutex);
+  jobs = renderer->finished_jobs;
+  renderer->finished_jobs = NULL;
+  g_mutex_unlock (renderer->rasterize_mutex);
+
+  if (jobs == NULL)
+    return FALSE;
+
+  for (l = jobs; l; l = l->next)
+    {
+      CoglPangoGlyphJob *job = l->data;
+
+      cogl_texture_set_region (job->texture,
+                               0, 0,
+                               job->tex_x,
+                               job->tex_y,
+                               job->ink_rect.width,
+                               job->ink_rect.height,
+                               job->ink_rect.width,
+                               job->ink_rect.height,
+                               COGL_PIXEL_FORMAT_A_8,
+                               cairo_image_surface_get_stride (job->surface),
+                               cairo_image_surface_get_data (job->surface));
+
+      cogl_pango_glyph_job_free (job);
+      n_jobs++;
+    }
+
+  g_slist_free (jobs);
+
+  g_mutex_lock (renderer->rasterize_mutex);
+  renderer->n_pending_jobs -= n_jobs;
+  g_mutex_unlock (renderer->rasterize_mutex);
+
+  COGL_NOTE (PANGO, "uploaded %i asynchronously rasterized glyphs", n_jobs);
+
+  return TRUE;
+}
+
+gboolean
+_cogl_pango_renderer_has_pending_glyphs (CoglPangoRenderer *renderer)
+{
+  gboolean ret;
+
+  if (renderer->rasterize_pool == NULL)
+    return FALSE;
+
+  g_mutex_lock (renderer->rasterize_mutex);
+  ret = renderer->n_pending_jobs > 0;
+  g_mutex_unlock (renderer->rasterize_mutex);
+
+  return ret;
+}
+
+void
+_cogl_pango_renderer_set_use_async_rasterization (CoglPangoRenderer *renderer,
+                                                  gboolean           value)
+{
+  if (value && renderer->rasterize_pool == NULL)
+    {
+      /* Without threads there is nothing to gain so we just keep
+         rasterizing on the paint path */
+      if (!g_thread_supported ())
+        return;
+
+      renderer->rasterize_mutex = g_mutex_new ();
+      renderer->rasterize_pool =
+        g_thread_pool_new (cogl_pango_renderer_rasterize_thread_func,
+                           renderer,
+                           COGL_PANGO_RASTERIZE_THREADS,
+                           FALSE,
+                           NULL);
+    }
+  else if (!value && renderer->rasterize_pool != NULL)
+    {
+      /* Wait for all of the queued jobs to finish and then upload
+         them so that the reserved glyphs don't stay blank */
+      g_thread_pool_free (renderer->rasterize_pool, FALSE, TRUE);
+
+      _cogl_pango_renderer_upload_pending_glyphs (renderer);
+
+      g_mutex_free (renderer->rasterize_mutex);
+      renderer->rasterize_mutex = NULL;
+      renderer->rasterize_pool = NULL;
+    }
+}
+
+gboolean
+_cogl_pango_renderer_get_use_async_rasterization (CoglPangoRenderer *renderer)
+{
+  return renderer->rasterize_pool != NULL;
+}
+
+static void
+cogl_pango_distance_field_font_free (CoglPangoDistanceFieldFont *df_font)
+{
+  g_object_unref (df_font->font);
+  g_slice_free (CoglPangoDistanceFieldFont, df_font);
+}
+
+static CoglHandle
+cogl_pango_create_distance_field_program (void)
+{
+#ifdef CLUTTER_COGL_HAS_GL
+  CoglHandle shader, program;
+
+  if (!cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    return COGL_INVALID_HANDLE;
+
+  shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
+  cogl_shader_source (shader, distance_field_shader_source);
+  cogl_shader_compile (shader);
+
+  if (!cogl_shader_is_compiled (shader))
+    {
+      char *log = cogl_shader_get_info_log (shader);
+
+      g_warning ("Failed to compile the distance field shader, falling "
+                 "back to the alpha test: %s", log);
+
+      g_free (log);
+      cogl_handle_unref (shader);
+
+      return COGL_INVALID_HANDLE;
+    }
+
+  program = cogl_create_program ();
+  cogl_program_attach_shader (program, shader);
+  cogl_program_link (program);
+
+  cogl_handle_unref (shader);
+
+  return program;
+#else
+  /* The GLES 2 wrapper doesn't provide the fixed function builtins
+     the shader relies on so we just use the alpha test there */
+  return COGL_INVALID_HANDLE;
+#endif /* CLUTTER_COGL_HAS_GL */
+}
+
+void
+_cogl_pango_renderer_set_use_distance_field (CoglPangoRenderer *renderer,
+                                             gboolean           value)
+{
+  if (value && renderer->distance_field_cache == NULL)
+    {
+      cairo_font_options_t *font_options;
+
+      renderer->distance_field_cache = cogl_pango_glyph_cache_new ();
+
+      renderer->distance_field_material = cogl_material_new ();
+      cogl_material_set_layer_combine (renderer->distance_field_material, 0,
+                                       "RGBA = MODULATE (PREVIOUS, TEXTURE[A])",
+                                       NULL);
+      cogl_material_set_layer_wrap_mode (renderer->distance_field_material, 0,
+                                         COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
+      /* Mipmapping would blend the field with the blank space around
+         the glyphs so only linear filtering is used */
+      cogl_material_set_layer_filters (renderer->distance_field_material, 0,
+                                       COGL_MATERIAL_FILTER_LINEAR,
+                                       COGL_MATERIAL_FILTER_LINEAR);
+
+      renderer->distance_field_program =
+        cogl_pango_create_distance_field_program ();
+
+      /* Without a program the best we can do is to threshold the
+         field. This gives hard edges but it still stays sharp at any
+         scale. The threshold is updated for the paint opacity in
+         cogl_pango_renderer_get_glyph_material() */
+      if (renderer->distance_field_program == COGL_INVALID_HANDLE)
+        cogl_material_set_alpha_test_function
+          (renderer->distance_field_material,
+           COGL_MATERIAL_ALPHA_FUNC_GEQUAL,
+           0.5f);
+
+      renderer->distance_field_fonts =
+        g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                               g_object_unref,
+                               (GDestroyNotify)
+                               cogl_pango_distance_field_font_free);
+
+      /* Hinting would distort the outlines at the reference size */
+      font_options = cairo_font_options_create ();
+      cairo_font_options_set_hint_style (font_options, CAIRO_HINT_STYLE_NONE);
+      cairo_font_options_set_hint_metrics (font_options,
+                                           CAIRO_HINT_METRICS_OFF);
+      cairo_font_options_set_antialias (font_options, CAIRO_ANTIALIAS_GRAY);
+      renderer->distance_field_font_options = font_options;
+    }
+
+  renderer->use_distance_field = value;
+}
+
+gboolean
+_cogl_pango_renderer_get_use_distance_field (CoglPangoRenderer *renderer)
+{
+  return renderer->use_distance_field;
+}
+
+/* Returns the font to look up glyphs with in the distance field cache
+   for the given font and the factor to scale the reference glyphs
+   by */
+static PangoFont *
+cogl_pango_renderer_get_distance_field_font (CoglPangoRenderer *priv,
+                                             PangoFont         *font,
+                                             float             *scale)
+{
+  CoglPangoDistanceFieldFont *df_font;
+
+  df_font = g_hash_table_lookup (priv->distance_field_fonts, font);
+
+  if (df_font == NULL)
+    {
+      PangoFontDescription *desc;
+      PangoFontMap *font_map;
+      int size;
+
+      font_map = pango_font_get_font_map (font);
+
+      if (priv->distance_field_context == NULL)
+        {
+          priv->distance_field_context =
+            pango_cairo_font_map_create_context
+              (PANGO_CAIRO_FONT_MAP (font_map));
+          pango_cairo_context_set_font_options
+            (priv->distance_field_context,
+             priv->distance_field_font_options);
+        }
+
+      desc = pango_font_describe_with_absolute_size (font);
+      size = pango_font_description_get_size (desc);
+
+      pango_font_description_set_absolute_size
+        (desc, COGL_PANGO_DISTANCE_FIELD_SIZE * PANGO_SCALE);
+
+      df_font = g_slice_new (CoglPangoDistanceFieldFont);
+      df_font->font = pango_font_map_load_font (font_map,
+                                                priv->distance_field_context,
+                                                desc);
+      df_font->scale = (float) size
+                     / (COGL_PANGO_DISTANCE_FIELD_SIZE * PANGO_SCALE);
+
+      pango_font_description_free (desc);
+
+      /* If the font can't be loaded at the reference size just use
+         the original font unscaled */
+      if (df_font->font == NULL)
+        {
+          df_font->font = g_object_ref (font);
+          df_font->scale = 1.0f;
+        }
+
+      g_hash_table_insert (priv->distance_field_fonts,
+                           g_object_ref (font),
+                           df_font);
+    }
+
+  *scale = df_font->scale;
+
+  return df_font->font;
+}
+
+static CoglHandle
+cogl_pango_renderer_get_glyph_material (CoglPangoRenderer *priv,
+                                        const CoglColor   *color)
+{
+  if (!priv->use_distance_field)
+    return priv->glyph_material;
+
+  /* The alpha of the fragments in the fallback is the paint alpha
+     multiplied by the field so the threshold has to be scaled by the
+     same amount, otherwise the glyphs would disappear completely
+     when the text is drawn below half opacity */
+  if (priv->distance_field_program == COGL_INVALID_HANDLE)
+    cogl_material_set_alpha_test_function
+      (priv->distance_field_material,
+       COGL_MATERIAL_ALPHA_FUNC_GEQUAL,
+       0.5f * cogl_color_get_alpha_float (color));
+
+  return priv->distance_field_material;
+}
+
+static CoglHandle
+cogl_pango_renderer_get_glyph_program (CoglPangoRenderer *priv)
+{
+  return (priv->use_distance_field
+          ? priv->distance_field_program
+          : COGL_INVALID_HANDLE);
+}
+
+static void
+cogl_pango_renderer_render_display_list (CoglPangoRenderer    *priv,
+                                         CoglPangoDisplayList *display_list,
+                                         const CoglColor      *color)
+{
+  _cogl_pango_display_list_render (display_list,
+                                   color,
+                                   cogl_pango_renderer_get_glyph_material
+                                     (priv, color),
+                                   cogl_pango_renderer_get_glyph_program (priv),
+                                   priv->solid_material);
+}
+
 static GQuark
 cogl_pango_render_get_qdata_key (void)
 {
@@ -238,6 +801,10 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
   if (G_UNLIKELY (!priv))
     return;
 
+  /* Make sure any glyphs that were rasterized in a thread since the
+     last frame end up in the textures before we use them */
+  _cogl_pango_renderer_upload_pending_glyphs (priv);
+
   qdata = g_object_get_qdata (G_OBJECT (layout),
                               cogl_pango_render_get_qdata_key ());
 
@@ -254,8 +821,9 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
   /* Check if the layout has changed since the last build of the
      display list. This trick was suggested by Behdad Esfahbod here:
      http://mail.gnome.org/archives/gtk-i18n-list/2009-May/msg00019.html */
-  if (qdata->display_list && qdata->first_line
-      && qdata->first_line->layout != layout)
+  if (qdata->display_list
+      && ((qdata->first_line && qdata->first_line->layout != layout)
+          || qdata->distance_field != priv->use_distance_field))
     {
       _cogl_pango_display_list_free (qdata->display_list);
       qdata->display_list = NULL;
@@ -264,6 +832,7 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
   if (qdata->display_list == NULL)
     {
       qdata->display_list = _cogl_pango_display_list_new ();
+      qdata->distance_field = priv->use_distance_field;
 
       priv->display_list = qdata->display_list;
       pango_renderer_draw_layout (PANGO_RENDERER (priv), layout, 0, 0);
@@ -272,10 +841,7 @@ cogl_pango_render_layout_subpixel (PangoLayout     *layout,
 
   cogl_push_matrix ();
   cogl_translate (x / (gfloat) PANGO_SCALE, y / (gfloat) PANGO_SCALE, 0);
-  _cogl_pango_display_list_render (qdata->display_list,
-                                   color,
-                                   priv->glyph_material,
-                                   priv->solid_material);
+  cogl_pango_renderer_render_display_list (priv, qdata->display_list, color);
   cogl_pop_matrix ();
 
   /* Keep a reference to the first line of the layout so we can detect
@@ -343,14 +909,13 @@ cogl_pango_render_layout_line (PangoLayoutLine *line,
   if (G_UNLIKELY (!priv))
     return;
 
+  _cogl_pango_renderer_upload_pending_glyphs (priv);
+
   priv->display_list = _cogl_pango_display_list_new ();
 
   pango_renderer_draw_layout_line (PANGO_RENDERER (priv), line, x, y);
 
-  _cogl_pango_display_list_render (priv->display_list,
-                                   color,
-                                   priv->glyph_material,
-                                   priv->solid_material);
+  cogl_pango_renderer_render_display_list (priv, priv->display_list, color);
 
   _cogl_pango_display_list_free (priv->display_list);
   priv->display_list = NULL;
@@ -360,6 +925,8 @@ void
 _cogl_pango_renderer_clear_glyph_cache (CoglPangoRenderer *renderer)
 {
   cogl_pango_glyph_cache_clear (renderer->glyph_cache);
+  if (renderer->distance_field_cache)
+    cogl_pango_glyph_cache_clear (renderer->distance_field_cache);
 }
 
 void
@@ -393,41 +960,87 @@ cogl_pango_renderer_get_cached_glyph (PangoRenderer *renderer,
                                       PangoGlyph     glyph)
 {
   CoglPangoRenderer *priv = COGL_PANGO_RENDERER (renderer);
+  CoglPangoGlyphCache *cache;
   CoglPangoGlyphCacheValue *value;
 
-  value = cogl_pango_glyph_cache_lookup (priv->glyph_cache, font, glyph);
+  /* In distance field mode @font is expected to be the reference size
+     font returned by cogl_pango_renderer_get_distance_field_font() */
+  cache = (priv->use_distance_field
+           ? priv->distance_field_cache
+           : priv->glyph_cache);
+
+  value = cogl_pango_glyph_cache_lookup (cache, font, glyph);
   if (value == NULL)
     {
       cairo_surface_t *surface;
-      cairo_t *cr;
       cairo_scaled_font_t *scaled_font;
       PangoRectangle ink_rect;
-      cairo_glyph_t cairo_glyph;
 
       pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
       pango_extents_to_pixels (&ink_rect, NULL);
 
-      surface = cairo_image_surface_create (CAIRO_FORMAT_A8,
-					    ink_rect.width,
-					    ink_rect.height);
-      cr = cairo_create (surface);
+      /* Leave room around the outline for the field to fade out */
+      if (priv->use_distance_field
+          && ink_rect.width > 0
+          && ink_rect.height > 0)
+        {
+          ink_rect.x -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+          ink_rect.y -= COGL_PANGO_DISTANCE_FIELD_SPREAD;
+          ink_rect.width += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+          ink_rect.height += COGL_PANGO_DISTANCE_FIELD_SPREAD * 2;
+        }
 
       scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
-      cairo_set_scaled_font (cr, scaled_font);
 
-      cairo_glyph.x = -ink_rect.x;
-      cairo_glyph.y = -ink_rect.y;
-      /* The PangoCairo glyph numbers directly map to Cairo glyph
-	 numbers */
-      cairo_glyph.index = glyph;
-      cairo_show_glyphs (cr, &cairo_glyph, 1);
+      if (priv->rasterize_pool
+          && ink_rect.width > 0
+          && ink_rect.height > 0)
+        {
+          CoglPangoGlyphJob *job;
+
+          /* Reserve the space straight away so that the display list
+             can be built with the right texture coordinates. The
+             glyph will be blank until the image has been uploaded by
+             _cogl_pango_renderer_upload_pending_glyphs() */
+          value =
+            cogl_pango_glyph_cache_reserve (cache, font, glyph,
+                                            ink_rect.width,
+                                            ink_rect.height,
+                                            ink_rect.x, ink_rect.y);
+
+          job = g_slice_new (CoglPangoGlyphJob);
+          job->scaled_font = cairo_scaled_font_reference (scaled_font);
+          job->glyph = glyph;
+          job->ink_rect = ink_rect;
+          job->texture = cogl_handle_ref (value->texture);
+          job->tex_x = value->tex_x;
+          job->tex_y = value->tex_y;
+          job->distance_field = priv->use_distance_field;
+          job->surface = NULL;
+
+          g_mutex_lock (priv->rasterize_mutex);
+          priv->n_pending_jobs++;
+          g_mutex_unlock (priv->rasterize_mutex);
+
+          g_thread_pool_push (priv->rasterize_pool, job, NULL);
+
+          COGL_NOTE (PANGO, "cache fail    %i (queued)", glyph);
+
+          return value;
+        }
+
+      surface = cogl_pango_rasterize_glyph (scaled_font, glyph, &ink_rect);
 
-      cairo_destroy (cr);
-      cairo_surface_flush (surface);
+      if (priv->use_distance_field)
+        cogl_pango_glyph_to_distance_field
+          (cairo_image_surface_get_data (surface),
+           ink_rect.width,
+           ink_rect.height,
+           cairo_image_surface_get_stride (surface));
 
       /* Copy the glyph to the cache */
       value =
-        cogl_pango_glyph_cache_set (priv->glyph_cache, font, glyph,
+        cogl_pango_glyph_cache_set (cache, font, glyph,
                                     cairo_image_surface_get_data (surface),
                                     cairo_image_surface_get_width (surface),
                                     cairo_image_surface_get_height (surface),
@@ -473,14 +1086,23 @@ cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout)
         {
           PangoLayoutRun *run = l->data;
           PangoGlyphString *glyphs = run->glyphs;
+          PangoFont *font = run->item->analysis.font;
 	  int i;
 
+          if (COGL_PANGO_RENDERER (renderer)->use_distance_field)
+            {
+              float scale;
+
+              font = cogl_pango_renderer_get_distance_field_font
+                (COGL_PANGO_RENDERER (renderer), font, &scale);
+            }
+
           for (i = 0; i < glyphs->num_glyphs; i++)
             {
               PangoGlyphInfo *gi = &glyphs->glyphs[i];
 
 	      cogl_pango_renderer_get_cached_glyph (renderer,
-						    run->item->analysis.font,
+						    font,
 						    gi->glyph);
             }
         }
@@ -490,6 +1112,43 @@ cogl_pango_ensure_glyph_cache_for_layout (PangoLayout *layout)
   pango_layout_iter_free (iter);
 }
 
+/**
+ * cogl_pango_ensure_glyph_cache_for_text:
+ * @context: a #PangoContext created from a #CoglPangoFontMap
+ * @desc: the font to use
+ * @text: a UTF-8 string containing the characters to cache
+ *
+ * Makes sure that the glyph cache contains all of the glyphs needed
+ * to render @text using the font described by @desc. This can be
+ * used at startup to pre-warm the cache for the fonts and character
+ * sets an application is going to use so that the first frame that
+ * displays them doesn't have to rasterize any glyphs.
+ *
+ * If asynchronous rasterization is enabled on the font map then the
+ * glyphs will be rendered by the worker threads and this function
+ * returns without waiting for them.
+ *
+ * Since: 1.4
+ */
+void
+cogl_pango_ensure_glyph_cache_for_text (PangoContext               *context,
+                                        const PangoFontDescription *desc,
+                                        const char                 *text)
+{
+  PangoLayout *layout;
+
+  g_return_if_fail (PANGO_IS_CONTEXT (context));
+  g_return_if_fail (text != NULL);
+
+  layout = pango_layout_new (context);
+  pango_layout_set_font_description (layout, desc);
+  pango_layout_set_text (layout, text, -1);
+
+  cogl_pango_ensure_glyph_cache_for_layout (layout);
+
+  g_object_unref (layout);
+}
+
 static void
 cogl_pango_renderer_set_color_for_part (PangoRenderer   *renderer,
                                         PangoRenderPart  part)
@@ -625,11 +1284,19 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
 {
   CoglPangoRenderer *priv = (CoglPangoRenderer *) renderer;
   CoglPangoGlyphCacheValue *cache_value;
+  PangoFont *cache_font = font;
+  float scale = 1.0f;
   int i;
 
   cogl_pango_renderer_set_color_for_part (renderer,
 					  PANGO_RENDER_PART_FOREGROUND);
 
+  /* Distance field glyphs are all cached at the reference size and
+     scaled to the size of the font when drawn */
+  if (priv->use_distance_field && font != NULL)
+    cache_font = cogl_pango_renderer_get_distance_field_font (priv, font,
+                                                              &scale);
+
   for (i = 0; i < glyphs->num_glyphs; i++)
     {
       PangoGlyphInfo *gi = glyphs->glyphs + i;
@@ -671,7 +1338,7 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
 	     the cache entry if there isn't already one */
 	  cache_value =
             cogl_pango_renderer_get_cached_glyph (renderer,
-                                                  font,
+                                                  cache_font,
                                                   gi->glyph);
 
 	  if (cache_value == NULL)
@@ -684,10 +1351,10 @@ cogl_pango_renderer_draw_glyphs (PangoRenderer    *renderer,
             }
 	  else
 	    {
-	      x += (float)(cache_value->draw_x);
-	      y += (float)(cache_value->draw_y);
+	      x += (float)(cache_value->draw_x) * scale;
+	      y += (float)(cache_value->draw_y) * scale;
 
-              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y);
+              cogl_pango_renderer_draw_glyph (priv, cache_value, x, y, scale);
 	    }
 	}
 
@@ -47,9 +47,25 @@ void           cogl_pango_font_map_set_resolution       (CoglPangoFontMap *font_
                                                          double            dpi);
 void           cogl_pango_font_map_clear_glyph_cache    (CoglPangoFontMap *fm);
 void           cogl_pango_ensure_glyph_cache_for_layout (PangoLayout      *layout);
+void           cogl_pango_ensure_glyph_cache_for_text   (PangoContext     *context,
+                                                         const PangoFontDescription *desc,
+                                                         const char       *text);
 void           cogl_pango_font_map_set_use_mipmapping   (CoglPangoFontMap *fm,
                                                          gboolean          value);
 gboolean       cogl_pango_font_map_get_use_mipmapping   (CoglPangoFontMap *fm);
+void           cogl_pango_font_map_set_use_async_rasterization
+                                                        (CoglPangoFontMap *fm,
+                                                         gboolean          value);
+gboolean       cogl_pango_font_map_get_use_async_rasterization
+                                                        (CoglPangoFontMap *fm);
+gboolean       cogl_pango_font_map_upload_pending_glyphs
+                                                        (CoglPangoFontMap *fm);
+gboolean       cogl_pango_font_map_has_pending_glyphs   (CoglPangoFontMap *fm);
+void           cogl_pango_font_map_set_use_distance_field
+                                                        (CoglPangoFontMap *fm,
+                                                         gboolean          value);
+gboolean       cogl_pango_font_map_get_use_distance_field
+                                                        (CoglPangoFontMap *fm);
 PangoRenderer *cogl_pango_font_map_get_renderer         (CoglPangoFontMap *fm);
 
 #define COGL_PANGO_TYPE_RENDERER                (cogl_pango_renderer_get_type ())
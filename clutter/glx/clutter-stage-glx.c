@@ -321,6 +321,35 @@ clutter_stage_glx_ignoring_redraw_clips (ClutterStageWindow *stage_window)
     return FALSE;
 }
 
+/* Whether the next redraw will only paint the bounding redraw clip
+ * and blit it to the front buffer */
+static gboolean
+clutter_stage_glx_use_clipped_redraw (ClutterStageGLX *stage_glx)
+{
+  ClutterBackendGLX *backend_glx =
+    CLUTTER_BACKEND_GLX (clutter_get_default_backend ());
+
+  return (backend_glx->can_blit_sub_buffer &&
+          /* NB: a degenerate redraw clip width == full stage redraw */
+          stage_glx->bounding_redraw_clip.width != 0 &&
+          G_LIKELY (!(clutter_paint_debug_flags &
+                      CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS)));
+}
+
+static gboolean
+clutter_stage_glx_get_redraw_clip_bounds (ClutterStageWindow *stage_window,
+                                          ClutterGeometry    *stage_clip)
+{
+  ClutterStageGLX *stage_glx = CLUTTER_STAGE_GLX (stage_window);
+
+  if (!clutter_stage_glx_use_clipped_redraw (stage_glx))
+    return FALSE;
+
+  *stage_clip = stage_glx->bounding_redraw_clip;
+
+  return TRUE;
+}
+
 /* A redraw clip represents (in stage coordinates) the bounding box of
  * something that needs to be redraw. Typically they are added to the
  * StageWindow as a result of clutter_actor_queue_clipped_redraw() by
@@ -438,6 +467,7 @@ clutter_stage_window_iface_init (ClutterStageWindowIface *iface)
   iface->add_redraw_clip = clutter_stage_glx_add_redraw_clip;
   iface->has_redraw_clips = clutter_stage_glx_has_redraw_clips;
   iface->ignoring_redraw_clips = clutter_stage_glx_ignoring_redraw_clips;
+  iface->get_redraw_clip_bounds = clutter_stage_glx_get_redraw_clip_bounds;
 
   /* the rest is inherited from ClutterStageX11 */
 }
@@ -524,21 +554,17 @@ clutter_stage_glx_redraw (ClutterStageGLX *stage_glx,
 
   CLUTTER_TIMER_START (_clutter_uprof_context, painting_timer);
 
-  if (backend_glx->can_blit_sub_buffer &&
-      /* NB: a degenerate redraw clip width == full stage redraw */
-      (stage_glx->bounding_redraw_clip.width != 0) &&
-      G_LIKELY (!(clutter_paint_debug_flags &
-                  CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS)))
+  if (clutter_stage_glx_use_clipped_redraw (stage_glx))
     {
       cogl_clip_push_window_rectangle (stage_glx->bounding_redraw_clip.x,
                                        stage_glx->bounding_redraw_clip.y,
                                        stage_glx->bounding_redraw_clip.width,
                                        stage_glx->bounding_redraw_clip.height);
-      clutter_actor_paint (CLUTTER_ACTOR (stage));
+      _clutter_stage_do_paint (stage);
       cogl_clip_pop ();
     }
   else
-    clutter_actor_paint (CLUTTER_ACTOR (stage));
+    _clutter_stage_do_paint (stage);
 
   cogl_flush ();
   CLUTTER_TIMER_STOP (_clutter_uprof_context, painting_timer);
@@ -560,11 +586,7 @@ clutter_stage_glx_redraw (ClutterStageGLX *stage_glx,
     backend_glx->get_video_sync (&video_sync_count);
 
   /* push on the screen */
-  if (backend_glx->can_blit_sub_buffer &&
-      /* NB: a degenerate redraw clip width == full stage redraw */
-      (stage_glx->bounding_redraw_clip.width != 0) &&
-      G_LIKELY (!(clutter_paint_debug_flags &
-                  CLUTTER_DEBUG_DISABLE_CLIPPED_REDRAWS)))
+  if (clutter_stage_glx_use_clipped_redraw (stage_glx))
     {
       ClutterGeometry *clip = &stage_glx->bounding_redraw_clip;
       ClutterGeometry copy_area;
@@ -270,6 +270,53 @@ test_text_get_chars (TestConformSimpleFixture *fixture,
   clutter_actor_destroy (CLUTTER_ACTOR (text));
 }
 
+void
+test_text_long_get_chars (TestConformSimpleFixture *fixture,
+                          gconstpointer             data)
+{
+  ClutterText *text = CLUTTER_TEXT (clutter_text_new ());
+  GString *str = g_string_new (NULL);
+  gchar *chars;
+  int i;
+
+  /* long enough to need several checkpoints in the offset index */
+  for (i = 0; i < 500; i++)
+    g_string_append (str, test_text_data[i % 2].bytes);
+
+  clutter_text_set_text (text, str->str);
+  g_assert_cmpint (get_nchars (text), ==, 500);
+
+  for (i = 0; i < 500; i += 37)
+    {
+      chars = clutter_text_get_chars (text, i, i + 1);
+      g_assert_cmpstr (chars, ==, test_text_data[i % 2].bytes);
+      g_free (chars);
+    }
+
+  /* editing the end of the text must keep the offsets before it */
+  clutter_text_insert_text (text, "x", 400);
+  g_assert_cmpint (get_nchars (text), ==, 501);
+
+  chars = clutter_text_get_chars (text, 399, 402);
+  g_assert_cmpstr (chars, ==, "\xe2\x99\xa5x\xc3\xa4");
+  g_free (chars);
+
+  /* and editing the start must invalidate the offsets after it */
+  clutter_text_delete_text (text, 0, 1);
+  g_assert_cmpint (get_nchars (text), ==, 500);
+
+  chars = clutter_text_get_chars (text, 398, 401);
+  g_assert_cmpstr (chars, ==, "\xe2\x99\xa5x\xc3\xa4");
+  g_free (chars);
+
+  chars = clutter_text_get_chars (text, 499, -1);
+  g_assert_cmpstr (chars, ==, test_text_data[1].bytes);
+  g_free (chars);
+
+  g_string_free (str, TRUE);
+  clutter_actor_destroy (CLUTTER_ACTOR (text));
+}
+
 void
 test_text_delete_text (TestConformSimpleFixture *fixture,
 			gconstpointer data)
@@ -1,6 +1,10 @@
 #include <glib.h>
 #include <clutter/clutter.h>
 #include <string.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
 
 #include "test-conform-common.h"
 
@@ -87,3 +91,97 @@ test_texture_pick_with_alpha (TestConformSimpleFixture *fixture,
     g_print ("OK\n");
 }
 
+
+static CoglHandle
+load_cached_texture (ClutterActor *texture,
+                     const gchar  *filename)
+{
+  GError *error = NULL;
+
+  if (g_test_verbose ())
+    g_print ("Loading '%s'\n", filename);
+
+  clutter_texture_set_from_file (CLUTTER_TEXTURE (texture),
+                                 filename,
+                                 &error);
+  g_assert_no_error (error);
+
+  return clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (texture));
+}
+
+void
+test_texture_cache (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  ClutterActor *first, *second;
+  CoglHandle cached;
+  gchar *filename, *dirname, *alternate;
+  const gchar *alternate_paths[3];
+  int i;
+
+  filename = clutter_test_get_data_file ("redhand.png");
+  dirname = g_path_get_dirname (filename);
+
+  first = clutter_texture_new ();
+  second = clutter_texture_new ();
+
+  cached = load_cached_texture (first, filename);
+  g_assert (cached != COGL_INVALID_HANDLE);
+
+  /* Each of these names the same file so they should all get the
+     texture that was loaded for the first actor */
+  alternate_paths[0] = "./redhand.png";
+  alternate_paths[1] = "../data//redhand.png";
+  alternate_paths[2] = ".//./redhand.png";
+
+  for (i = 0; i < G_N_ELEMENTS (alternate_paths); i++)
+    {
+      alternate = g_build_filename (dirname, alternate_paths[i], NULL);
+      g_assert (load_cached_texture (second, alternate) == cached);
+      g_free (alternate);
+    }
+
+#ifdef G_OS_UNIX
+  /* A symbolic link to the file should also share the texture */
+  {
+    gchar *absolute, *link_name;
+
+    if (g_path_is_absolute (filename))
+      absolute = g_strdup (filename);
+    else
+      {
+        gchar *cwd = g_get_current_dir ();
+        absolute = g_build_filename (cwd, filename, NULL);
+        g_free (cwd);
+      }
+
+    link_name = g_strdup_printf ("clutter-texture-cache-%i.png",
+                                 (int) getpid ());
+    alternate = g_build_filename (g_get_tmp_dir (), link_name, NULL);
+
+    if (symlink (absolute, alternate) == 0)
+      {
+        g_assert (load_cached_texture (second, alternate) == cached);
+        g_unlink (alternate);
+      }
+
+    g_free (alternate);
+    g_free (link_name);
+    g_free (absolute);
+  }
+#endif /* G_OS_UNIX */
+
+  /* A different file must not share the texture */
+  alternate = g_build_filename (dirname, "redhand_alpha.png", NULL);
+  g_assert (load_cached_texture (second, alternate) != cached);
+  g_free (alternate);
+
+  clutter_actor_destroy (second);
+  clutter_actor_destroy (first);
+
+  g_free (dirname);
+  g_free (filename);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
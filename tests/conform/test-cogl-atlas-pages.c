@@ -0,0 +1,193 @@
+#include <clutter/clutter.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* Enough textures of this size to need several pages of the atlas.
+   Each 512x512 page holds 25 of them */
+#define N_TEXTURES 80
+#define TEX_SIZE 100
+
+static CoglHandle
+make_texture (int number)
+{
+  CoglPixelFormat format;
+  CoglHandle tex;
+  guint8 *data, *p;
+  int bpp, i;
+
+  /* Alternate between opaque and transparent textures so that both
+     kinds of pages are used */
+  if ((number & 1))
+    {
+      format = COGL_PIXEL_FORMAT_RGB_888;
+      bpp = 3;
+    }
+  else
+    {
+      format = COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+      bpp = 4;
+    }
+
+  p = data = g_malloc (TEX_SIZE * TEX_SIZE * bpp);
+
+  for (i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+    {
+      *(p++) = number;
+      *(p++) = i / TEX_SIZE;
+      *(p++) = i % TEX_SIZE;
+      if (bpp == 4)
+        *(p++) = 255;
+    }
+
+  tex = cogl_texture_new_from_data (TEX_SIZE, TEX_SIZE,
+                                    COGL_TEXTURE_NONE,
+                                    format,
+                                    COGL_PIXEL_FORMAT_ANY,
+                                    TEX_SIZE * bpp,
+                                    data);
+
+  g_free (data);
+
+  return tex;
+}
+
+static void
+check_texture (CoglHandle tex,
+               int        number)
+{
+  guint8 *data, *p;
+  int i;
+
+  p = data = g_malloc (TEX_SIZE * TEX_SIZE * 3);
+
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGB_888,
+                         TEX_SIZE * 3, data);
+
+  for (i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+    {
+      g_assert_cmpint (*(p++), ==, number);
+      g_assert_cmpint (*(p++), ==, i / TEX_SIZE);
+      g_assert_cmpint (*(p++), ==, i % TEX_SIZE);
+    }
+
+  g_free (data);
+}
+
+/* Number of frames to run after freeing most of the textures. The
+   master clock defragments the atlas a few textures at a time after
+   each frame, so this is enough for it to run out of work */
+#define N_DEFRAG_FRAMES 100
+
+typedef struct _TestState
+{
+  CoglHandle textures[N_TEXTURES];
+  int frame;
+} TestState;
+
+static void
+fill_atlas (TestState *state)
+{
+  CoglHandle *textures = state->textures;
+  int i;
+
+  for (i = 0; i < N_TEXTURES; i++)
+    textures[i] = make_texture (i);
+
+  /* Adding pages must not have disturbed the textures already in
+     the atlas */
+  for (i = 0; i < N_TEXTURES; i++)
+    check_texture (textures[i], i);
+
+  /* Free every other texture and fill the holes again */
+  for (i = 0; i < N_TEXTURES; i += 2)
+    cogl_handle_unref (textures[i]);
+  for (i = 0; i < N_TEXTURES; i += 2)
+    textures[i] = make_texture (i);
+
+  for (i = 0; i < N_TEXTURES; i++)
+    check_texture (textures[i], i);
+
+  /* Leave most of the pages empty so that the defragmenter moves the
+     remaining textures together */
+  for (i = 0; i < N_TEXTURES; i++)
+    if ((i & 3) > 1)
+      {
+        cogl_handle_unref (textures[i]);
+        textures[i] = COGL_INVALID_HANDLE;
+      }
+}
+
+static void
+check_defragmented (TestState *state)
+{
+  CoglHandle *textures = state->textures;
+  int i;
+
+  /* Moving the textures must not have changed their contents */
+  for (i = 0; i < N_TEXTURES; i++)
+    if (textures[i] != COGL_INVALID_HANDLE)
+      check_texture (textures[i], i);
+
+  /* Freeing all of the textures reclaims the pages, after which new
+     textures can still be added */
+  for (i = 0; i < N_TEXTURES; i++)
+    if (textures[i] != COGL_INVALID_HANDLE)
+      cogl_handle_unref (textures[i]);
+
+  textures[0] = make_texture (0);
+  check_texture (textures[0], 0);
+  cogl_handle_unref (textures[0]);
+}
+
+static void
+paint_cb (ClutterActor *stage,
+          TestState *state)
+{
+  if (state->frame == 0)
+    fill_atlas (state);
+  else if (state->frame == N_DEFRAG_FRAMES)
+    {
+      check_defragmented (state);
+      clutter_main_quit ();
+    }
+
+  state->frame++;
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_cogl_atlas_pages (TestConformSimpleFixture *fixture,
+                       gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  guint paint_handler, idle_source;
+
+  state.frame = 0;
+
+  /* The textures are read back in the paint handler so that the
+     draw-and-read fallback has something to draw to */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+  idle_source = g_idle_add (queue_redraw, stage);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_source_remove (idle_source);
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,275 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+#include "test-conform-common.h"
+
+/* This must match the header written by cogl_bitmap_write_cache_file()
+   in cogl-bitmap.c */
+typedef struct _CacheHeader
+{
+  char    magic[8];
+  guint32 version;
+  guint32 format;
+  guint32 width;
+  guint32 height;
+  guint32 rowstride;
+  guint32 data_offset;
+  guint64 source_mtime;
+  guint64 source_size;
+} CacheHeader;
+
+typedef struct _TestState
+{
+  gchar *filename;
+  gchar *cache_filename;
+
+  int width, height;
+  guint8 *reference;
+} TestState;
+
+static guint8 *
+get_bitmap_data (CoglBitmap *bitmap)
+{
+  CoglHandle tex;
+  guint8 *data;
+  int width, height;
+
+  width = cogl_bitmap_get_width (bitmap);
+  height = cogl_bitmap_get_height (bitmap);
+
+  tex = cogl_texture_new_from_bitmap (bitmap,
+                                      COGL_TEXTURE_NO_ATLAS,
+                                      COGL_PIXEL_FORMAT_ANY);
+  g_assert (tex != COGL_INVALID_HANDLE);
+
+  data = g_malloc (width * height * 4);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         width * 4, data);
+
+  cogl_handle_unref (tex);
+
+  return data;
+}
+
+/* Loads the image and checks that it has the right contents. Returns
+   whether the first pixel was the one we planted in the cache file */
+static gboolean
+check_load (TestState *state)
+{
+  CoglBitmap *bitmap;
+  GError *error = NULL;
+  guint8 *data;
+  int width, height;
+  gboolean from_cache;
+
+  g_assert (cogl_bitmap_get_size_from_file (state->filename,
+                                            &width, &height));
+  g_assert_cmpint (width, ==, state->width);
+  g_assert_cmpint (height, ==, state->height);
+
+  bitmap = cogl_bitmap_new_from_file (state->filename, &error);
+  g_assert_no_error (error);
+  g_assert (bitmap != NULL);
+  g_assert_cmpint (cogl_bitmap_get_width (bitmap), ==, state->width);
+  g_assert_cmpint (cogl_bitmap_get_height (bitmap), ==, state->height);
+
+  data = get_bitmap_data (bitmap);
+  cogl_handle_unref (bitmap);
+
+  from_cache = memcmp (data, state->reference, 4) != 0;
+
+  /* Apart from the planted pixel the image must be the same */
+  g_assert (memcmp (data + 4, state->reference + 4,
+                    state->width * state->height * 4 - 4) == 0);
+
+  g_free (data);
+
+  return from_cache;
+}
+
+/* Writes a new cache file and changes its first pixel so that we can
+   tell when it is used */
+static void
+write_cache_file (TestState *state,
+                  gchar **contents,
+                  gsize *length)
+{
+  CacheHeader *header;
+  GError *error = NULL;
+
+  g_assert (cogl_bitmap_write_cache_file (state->filename, &error));
+  g_assert_no_error (error);
+
+  g_assert (g_file_get_contents (state->cache_filename,
+                                 contents, length, &error));
+  g_assert_no_error (error);
+
+  header = (CacheHeader *) *contents;
+  g_assert_cmpint (header->format, ==, COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  g_assert_cmpint (header->width, ==, state->width);
+
+  (*contents)[header->data_offset] ^= 0xff;
+}
+
+static void
+replace_cache_file (TestState *state,
+                    const gchar *contents,
+                    gsize length)
+{
+  GError *error = NULL;
+
+  g_assert (g_file_set_contents (state->cache_filename,
+                                 contents, length, &error));
+  g_assert_no_error (error);
+}
+
+static void
+check_valid_cache_file (TestState *state)
+{
+  gchar *contents;
+  gsize length;
+
+  write_cache_file (state, &contents, &length);
+  replace_cache_file (state, contents, length);
+
+  g_assert (check_load (state));
+  g_assert (g_file_test (state->cache_filename, G_FILE_TEST_EXISTS));
+
+  g_free (contents);
+}
+
+/* Each of these should make the cache file be ignored and the image
+   be decoded instead. The file is left for cogl_bitmap_write_cache_file()
+   to replace */
+
+static void
+check_rejected (TestState *state,
+                const gchar *contents,
+                gsize length)
+{
+  replace_cache_file (state, contents, length);
+
+  g_assert (!check_load (state));
+  g_assert (g_file_test (state->cache_filename, G_FILE_TEST_EXISTS));
+}
+
+static void
+check_invalid_cache_files (TestState *state)
+{
+  CacheHeader *header;
+  gchar *contents;
+  gsize length;
+
+  write_cache_file (state, &contents, &length);
+  header = (CacheHeader *) contents;
+
+  if (g_test_verbose ())
+    g_print ("Truncated data\n");
+  check_rejected (state, contents, length - 1);
+
+  if (g_test_verbose ())
+    g_print ("Truncated header\n");
+  check_rejected (state, contents, sizeof (CacheHeader) / 2);
+
+  if (g_test_verbose ())
+    g_print ("Unknown format\n");
+  header->format = 0x7f;
+  check_rejected (state, contents, length);
+
+  /* A valid format that doesn't match the rowstride of the data */
+  if (g_test_verbose ())
+    g_print ("Mismatched format\n");
+  header->format = COGL_PIXEL_FORMAT_A_8;
+  check_rejected (state, contents, length);
+  header->format = COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+
+  if (g_test_verbose ())
+    g_print ("Huge height\n");
+  header->height = G_MAXUINT32;
+  check_rejected (state, contents, length);
+  header->height = state->height;
+
+  if (g_test_verbose ())
+    g_print ("Data offset past the end\n");
+  header->data_offset = length;
+  check_rejected (state, contents, length);
+
+  g_free (contents);
+}
+
+static void
+paint_cb (TestState *state)
+{
+  CoglBitmap *bitmap;
+  GError *error = NULL;
+
+  /* Decode the image before there is any cache file to get the
+     reference data */
+  bitmap = cogl_bitmap_new_from_file (state->filename, &error);
+  g_assert_no_error (error);
+  state->width = cogl_bitmap_get_width (bitmap);
+  state->height = cogl_bitmap_get_height (bitmap);
+  state->reference = get_bitmap_data (bitmap);
+  cogl_handle_unref (bitmap);
+
+  check_valid_cache_file (state);
+  check_invalid_cache_files (state);
+
+  /* Writing the cache file again replaces the invalid one */
+  check_valid_cache_file (state);
+
+  g_free (state->reference);
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_cache (TestConformSimpleFixture *fixture,
+                        gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  guint paint_handler;
+  gchar *source, *contents, *basename;
+  gsize length;
+  GError *error = NULL;
+
+  /* The cache file is written next to the image so the image is
+     copied somewhere writable first */
+  source = clutter_test_get_data_file ("redhand_alpha.png");
+  g_assert (g_file_get_contents (source, &contents, &length, &error));
+  g_assert_no_error (error);
+  g_free (source);
+
+  basename = g_strdup_printf ("test-cogl-bitmap-cache-%i.png",
+                              (int) getpid ());
+  state.filename = g_build_filename (g_get_tmp_dir (), basename, NULL);
+  state.cache_filename = g_strconcat (state.filename, ".cogl-bitmap", NULL);
+  g_free (basename);
+
+  g_assert (g_file_set_contents (state.filename, contents, length, &error));
+  g_assert_no_error (error);
+  g_free (contents);
+
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  g_unlink (state.cache_filename);
+  g_unlink (state.filename);
+  g_free (state.cache_filename);
+  g_free (state.filename);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
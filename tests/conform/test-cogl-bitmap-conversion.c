@@ -0,0 +1,356 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* An odd size so that the conversions have to handle the pixels left
+   over after the ones converted in groups */
+#define CONVERT_WIDTH  37
+#define CONVERT_HEIGHT 7
+
+typedef struct _FormatDesc
+{
+  CoglPixelFormat format;
+  const char *name;
+  int bpp;
+  /* Offsets of the red, green, blue and alpha components, or -1 if
+     there is no alpha */
+  int offsets[4];
+} FormatDesc;
+
+static const FormatDesc formats[] =
+  {
+    { COGL_PIXEL_FORMAT_RGB_888, "RGB_888", 3, { 0, 1, 2, -1 } },
+    { COGL_PIXEL_FORMAT_BGR_888, "BGR_888", 3, { 2, 1, 0, -1 } },
+    { COGL_PIXEL_FORMAT_RGBA_8888, "RGBA_8888", 4, { 0, 1, 2, 3 } },
+    { COGL_PIXEL_FORMAT_BGRA_8888, "BGRA_8888", 4, { 2, 1, 0, 3 } },
+    { COGL_PIXEL_FORMAT_ARGB_8888, "ARGB_8888", 4, { 1, 2, 3, 0 } },
+    { COGL_PIXEL_FORMAT_ABGR_8888, "ABGR_8888", 4, { 3, 2, 1, 0 } }
+  };
+
+static guint8
+test_component (int x, int y, int component)
+{
+  return (x * 7 + y * 31 + component * 67) & 0xff;
+}
+
+/* Reference implementation of the premultiplication */
+static guint8
+premult (guint8 c, guint8 a)
+{
+  unsigned int t = c * a + 128;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static void
+check_conversion (const FormatDesc *src, const FormatDesc *dst)
+{
+  CoglHandle tex;
+  guint8 *data, *p;
+  int x, y, i;
+
+  if (g_test_verbose ())
+    g_print ("Converting %s to %s\n", src->name, dst->name);
+
+  data = g_malloc (CONVERT_WIDTH * CONVERT_HEIGHT * 4);
+
+  for (y = 0, p = data; y < CONVERT_HEIGHT; y++)
+    for (x = 0; x < CONVERT_WIDTH; x++, p += src->bpp)
+      for (i = 0; i < 4; i++)
+        if (src->offsets[i] != -1)
+          p[src->offsets[i]] = test_component (x, y, i);
+
+  tex = cogl_texture_new_from_data (CONVERT_WIDTH, CONVERT_HEIGHT,
+                                    COGL_TEXTURE_NO_ATLAS,
+                                    src->format,
+                                    dst->format,
+                                    CONVERT_WIDTH * src->bpp,
+                                    data);
+
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888,
+                         CONVERT_WIDTH * 4, data);
+
+  for (y = 0, p = data; y < CONVERT_HEIGHT; y++)
+    for (x = 0; x < CONVERT_WIDTH; x++, p += 4)
+      {
+        g_assert_cmpint (p[0], ==, test_component (x, y, 0));
+        g_assert_cmpint (p[1], ==, test_component (x, y, 1));
+        g_assert_cmpint (p[2], ==, test_component (x, y, 2));
+
+        if (src->offsets[3] != -1 && dst->offsets[3] != -1)
+          g_assert_cmpint (p[3], ==, test_component (x, y, 3));
+        else
+          g_assert_cmpint (p[3], ==, 255);
+      }
+
+  cogl_handle_unref (tex);
+  g_free (data);
+}
+
+/* The widest row read back. Every width up to this is tried so that
+   the pixels left over after the groups handled by the SIMD paths
+   are converted with every possible remainder */
+#define READ_MAX_WIDTH 40
+#define READ_HEIGHT    3
+/* Size of the texture that the pixels are read from */
+#define READ_TEX_WIDTH  64
+#define READ_TEX_HEIGHT 4
+
+/* The premultiplied component of the texture read back */
+static guint8
+read_component (int x, int y, int component)
+{
+  guint8 alpha = test_component (x, y, 3);
+
+  if (component == 3)
+    return alpha;
+  else
+    return premult (test_component (x, y, component), alpha);
+}
+
+/* Reads back the pixels of an offscreen framebuffer. Cogl reads them
+   as RGBA_8888 and does any other conversion, including the
+   unpremultiplication, with the bitmap conversion code instead of
+   letting GL do it. This checks every byte of the result */
+static void
+check_read_conversion (const FormatDesc *dst,
+                       gboolean          premultiply,
+                       int               width)
+{
+  CoglPixelFormat dst_format = dst->format;
+  guint8 *data, *p;
+  int x, y, i;
+
+  if (premultiply)
+    dst_format |= COGL_PREMULT_BIT;
+
+  data = g_malloc (width * READ_HEIGHT * dst->bpp);
+
+  cogl_read_pixels (0, 0, width, READ_HEIGHT,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    dst_format,
+                    data);
+
+  for (y = 0, p = data; y < READ_HEIGHT; y++)
+    for (x = 0; x < width; x++, p += dst->bpp)
+      {
+        guint8 alpha = read_component (x, y, 3);
+
+        for (i = 0; i < 3; i++)
+          {
+            guint8 expected = read_component (x, y, i);
+
+            /* Formats without an alpha get the premultiplied
+               components as they are */
+            if (dst->offsets[3] != -1 && !premultiply)
+              expected = alpha == 0 ? 0 : (expected * 255) / alpha;
+
+            if (p[dst->offsets[i]] != expected)
+              {
+                g_print ("RGBA_8888_PRE -> %s%s, width %i: pixel %i,%i "
+                         "component %i is 0x%02x, expected 0x%02x\n",
+                         dst->name, premultiply ? "_PRE" : "",
+                         width, x, y, i,
+                         p[dst->offsets[i]], expected);
+                g_assert_not_reached ();
+              }
+          }
+
+        if (dst->offsets[3] != -1)
+          g_assert_cmpint (p[dst->offsets[3]], ==, alpha);
+      }
+
+  g_free (data);
+}
+
+static void
+check_read_conversions (void)
+{
+  CoglHandle tex, offscreen;
+  guint8 *data, *p;
+  int x, y, i, width;
+
+  if (g_test_verbose ())
+    g_print ("Converting read pixels with widths up to %i\n",
+             READ_MAX_WIDTH);
+
+  data = g_malloc (READ_TEX_WIDTH * READ_TEX_HEIGHT * 4);
+
+  for (y = 0, p = data; y < READ_TEX_HEIGHT; y++)
+    for (x = 0; x < READ_TEX_WIDTH; x++)
+      for (i = 0; i < 4; i++)
+        *(p++) = read_component (x, y, i);
+
+  tex = cogl_texture_new_from_data (READ_TEX_WIDTH, READ_TEX_HEIGHT,
+                                    COGL_TEXTURE_NO_ATLAS |
+                                    COGL_TEXTURE_NO_SLICING,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    READ_TEX_WIDTH * 4,
+                                    data);
+  g_free (data);
+
+  offscreen = cogl_offscreen_new_to_texture (tex);
+  cogl_push_framebuffer (offscreen);
+
+  for (width = 1; width <= READ_MAX_WIDTH; width++)
+    for (i = 0; i < G_N_ELEMENTS (formats); i++)
+      {
+        check_read_conversion (formats + i, FALSE, width);
+
+        if (formats[i].offsets[3] != -1)
+          check_read_conversion (formats + i, TRUE, width);
+      }
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+  cogl_handle_unref (tex);
+}
+
+/* Creates a 256x256 image where each pixel has a different
+   combination of color component and alpha */
+static guint8 *
+make_premult_data (const FormatDesc *desc, gboolean premultiplied)
+{
+  guint8 *data = g_malloc (256 * 256 * 4), *p = data;
+  int x, y, i;
+
+  for (y = 0; y < 256; y++)
+    for (x = 0; x < 256; x++, p += 4)
+      {
+        for (i = 0; i < 3; i++)
+          p[desc->offsets[i]] = premultiplied ? premult (x, y) : x;
+        p[desc->offsets[3]] = y;
+      }
+
+  return data;
+}
+
+static void
+check_premult (const FormatDesc *desc)
+{
+  CoglHandle tex;
+  guint8 *data, *p;
+  int x, y, i;
+
+  if (g_test_verbose ())
+    g_print ("Premultiplying %s\n", desc->name);
+
+  data = make_premult_data (desc, FALSE);
+
+  tex = cogl_texture_new_from_data (256, 256,
+                                    COGL_TEXTURE_NO_ATLAS,
+                                    desc->format,
+                                    desc->format | COGL_PREMULT_BIT,
+                                    256 * 4,
+                                    data);
+
+  cogl_texture_get_data (tex, desc->format | COGL_PREMULT_BIT,
+                         256 * 4, data);
+
+  for (y = 0, p = data; y < 256; y++)
+    for (x = 0; x < 256; x++, p += 4)
+      {
+        for (i = 0; i < 3; i++)
+          g_assert_cmpint (p[desc->offsets[i]], ==, premult (x, y));
+        g_assert_cmpint (p[desc->offsets[3]], ==, y);
+      }
+
+  cogl_handle_unref (tex);
+  g_free (data);
+}
+
+static void
+check_unpremult (const FormatDesc *desc)
+{
+  CoglHandle tex, offscreen;
+  guint8 *data, *p;
+  int x, y, i;
+
+  if (g_test_verbose ())
+    g_print ("Unpremultiplying %s\n", desc->name);
+
+  data = make_premult_data (desc, TRUE);
+
+  tex = cogl_texture_new_from_data (256, 256,
+                                    COGL_TEXTURE_NO_ATLAS |
+                                    COGL_TEXTURE_NO_SLICING,
+                                    desc->format | COGL_PREMULT_BIT,
+                                    desc->format | COGL_PREMULT_BIT,
+                                    256 * 4,
+                                    data);
+
+  /* Reading back the pixels of an offscreen framebuffer in a format
+     without the premult flag makes Cogl unpremultiply them */
+  offscreen = cogl_offscreen_new_to_texture (tex);
+  cogl_push_framebuffer (offscreen);
+  cogl_read_pixels (0, 0, 256, 256,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    desc->format,
+                    data);
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  for (y = 0, p = data; y < 256; y++)
+    for (x = 0; x < 256; x++, p += 4)
+      {
+        guint8 c = premult (x, y);
+        guint8 expected = y == 0 ? 0 : (c * 255) / y;
+
+        for (i = 0; i < 3; i++)
+          g_assert_cmpint (p[desc->offsets[i]], ==, expected);
+        g_assert_cmpint (p[desc->offsets[3]], ==, y);
+      }
+
+  cogl_handle_unref (tex);
+  g_free (data);
+}
+
+static void
+paint_cb (void)
+{
+  int i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    for (j = 0; j < G_N_ELEMENTS (formats); j++)
+      if (i != j)
+        check_conversion (formats + i, formats + j);
+
+  check_read_conversions ();
+
+  /* The premultiplication only works on formats with an alpha */
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    if (formats[i].offsets[3] != -1)
+      {
+        check_premult (formats + i);
+        check_unpremult (formats + i);
+      }
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_conversion (TestConformSimpleFixture *fixture,
+                             gconstpointer data)
+{
+  ClutterActor *stage;
+  guint paint_handler;
+
+  /* The conversions are done in the paint handler so that there is a
+     context to create textures and read pixels with */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), NULL);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
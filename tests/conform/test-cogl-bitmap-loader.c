@@ -0,0 +1,203 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "test-conform-common.h"
+
+/* Size of the generated image. It is big enough that the loader
+   returns it in several strips */
+#define BIG_WIDTH  512
+#define BIG_HEIGHT 512
+
+/* Loads @filename incrementally, uploading each strip of rows as it
+   is returned, and checks that the result is the same as loading the
+   file in one go. Returns the number of strips */
+static int
+check_loader (const char *filename)
+{
+  CoglBitmapLoader *loader;
+  CoglBitmap *bitmap;
+  CoglHandle full_tex, tex = COGL_INVALID_HANDLE;
+  GError *error = NULL;
+  guint8 *full_data, *data;
+  int width, height, size, n_strips = 0;
+
+  if (g_test_verbose ())
+    g_print ("Loading %s\n", filename);
+
+  full_tex = cogl_texture_new_from_file (filename,
+                                         COGL_TEXTURE_NO_ATLAS,
+                                         COGL_PIXEL_FORMAT_ANY,
+                                         &error);
+  g_assert_no_error (error);
+
+  loader = cogl_bitmap_loader_new (filename, &error);
+  g_assert_no_error (error);
+  g_assert (loader != NULL);
+
+  /* Nothing has been decoded yet */
+  g_assert (!cogl_bitmap_loader_get_size (loader, NULL, NULL));
+  g_assert (cogl_bitmap_loader_get_bitmap (loader) == NULL);
+
+  do
+    {
+      CoglBitmap *rows, *converted;
+      int first_row;
+
+      g_assert (cogl_bitmap_loader_load_more (loader, &error));
+      g_assert_no_error (error);
+
+      while ((rows = cogl_bitmap_loader_get_rows (loader, &first_row)))
+        {
+          converted = cogl_bitmap_convert_for_upload (rows,
+                                                      COGL_PIXEL_FORMAT_ANY);
+          g_assert (converted != NULL);
+
+          if (tex == COGL_INVALID_HANDLE)
+            {
+              g_assert (cogl_bitmap_loader_get_size (loader,
+                                                     &width, &height));
+              tex = cogl_texture_new_with_size (width, height,
+                                                COGL_TEXTURE_NO_ATLAS,
+                                                cogl_bitmap_get_format
+                                                                (converted));
+            }
+
+          g_assert_cmpint (cogl_bitmap_get_width (converted), ==, width);
+          g_assert_cmpint (first_row + cogl_bitmap_get_height (converted),
+                           <=, height);
+
+          cogl_texture_set_region_from_bitmap (tex,
+                                               0, 0,
+                                               0, first_row,
+                                               width,
+                                               cogl_bitmap_get_height
+                                                                (converted),
+                                               converted);
+
+          cogl_handle_unref (converted);
+          cogl_handle_unref (rows);
+
+          n_strips++;
+        }
+    }
+  while (!cogl_bitmap_loader_is_finished (loader));
+
+  /* The whole image is available once the loader has finished */
+  bitmap = cogl_bitmap_loader_get_bitmap (loader);
+  g_assert (bitmap != NULL);
+  g_assert_cmpint (cogl_bitmap_get_width (bitmap), ==, width);
+  g_assert_cmpint (cogl_bitmap_get_height (bitmap), ==, height);
+  cogl_handle_unref (bitmap);
+
+  cogl_handle_unref (loader);
+
+  g_assert (tex != COGL_INVALID_HANDLE);
+  g_assert_cmpint (cogl_texture_get_width (full_tex), ==, width);
+  g_assert_cmpint (cogl_texture_get_height (full_tex), ==, height);
+
+  size = width * height * 4;
+  full_data = g_malloc (size);
+  data = g_malloc (size);
+
+  cogl_texture_get_data (full_tex, COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         width * 4, full_data);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         width * 4, data);
+
+  g_assert (memcmp (full_data, data, size) == 0);
+
+  g_free (full_data);
+  g_free (data);
+  cogl_handle_unref (tex);
+  cogl_handle_unref (full_tex);
+
+  if (g_test_verbose ())
+    g_print ("  %i strips\n", n_strips);
+
+  return n_strips;
+}
+
+static void
+check_data_file (const char *name)
+{
+  gchar *filename = clutter_test_get_data_file (name);
+
+  check_loader (filename);
+
+  g_free (filename);
+}
+
+static void
+check_big_image (void)
+{
+  guint8 *data, *p;
+  gchar *filename;
+  int x, y;
+
+  data = g_malloc (BIG_WIDTH * BIG_HEIGHT * 3);
+
+  for (y = 0, p = data; y < BIG_HEIGHT; y++)
+    for (x = 0; x < BIG_WIDTH; x++, p += 3)
+      {
+        p[0] = x;
+        p[1] = y;
+        p[2] = x ^ y;
+      }
+
+  filename = clutter_test_write_bmp_file (BIG_WIDTH, BIG_HEIGHT, data);
+  g_free (data);
+
+  g_assert_cmpint (check_loader (filename), >, 1);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+check_missing_file (void)
+{
+  GError *error = NULL;
+
+  g_assert (cogl_bitmap_loader_new ("this-file-does-not-exist.png",
+                                    &error) == NULL);
+  g_assert (error != NULL);
+
+  g_error_free (error);
+}
+
+static void
+paint_cb (void)
+{
+  check_data_file ("redhand.png");
+  check_data_file ("redhand_alpha.png");
+  check_big_image ();
+  check_missing_file ();
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_loader (TestConformSimpleFixture *fixture,
+                         gconstpointer data)
+{
+  ClutterActor *stage;
+  guint paint_handler;
+
+  /* The textures are created in the paint handler so that reading
+     them back can fall back to drawing them if needed */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), NULL);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
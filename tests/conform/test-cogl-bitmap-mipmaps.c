@@ -0,0 +1,163 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+static const struct
+{
+  CoglBitmapFilter filter;
+  /* How far the smallest level can be from the one generated by the
+     GPU. The Lanczos filter sharpens the image so it differs more */
+  int tolerance;
+} filters[] =
+  {
+    { COGL_BITMAP_FILTER_BOX, 8 },
+    { COGL_BITMAP_FILTER_LANCZOS, 24 }
+  };
+
+/* Renders a 1x1 quad at @x so that only the smallest level of the
+   texture is used */
+static void
+draw_smallest_level (CoglHandle tex,
+                     int        x)
+{
+  CoglHandle material = cogl_material_new ();
+
+  cogl_material_set_layer (material, 0, tex);
+  cogl_material_set_layer_filters (material, 0,
+                                   COGL_MATERIAL_FILTER_NEAREST_MIPMAP_NEAREST,
+                                   COGL_MATERIAL_FILTER_NEAREST);
+  cogl_set_source (material);
+  cogl_rectangle (x, 0, x + 1, 1);
+
+  cogl_handle_unref (material);
+}
+
+static gboolean
+check_pixel (const guint8 *pixel,
+             const guint8 *expected,
+             int           tolerance)
+{
+  int i;
+
+  if (g_test_verbose ())
+    g_print ("%02x%02x%02x%02x, expected %02x%02x%02x%02x\n",
+             pixel[0], pixel[1], pixel[2], pixel[3],
+             expected[0], expected[1], expected[2], expected[3]);
+
+  for (i = 0; i < 4; i++)
+    if (ABS (pixel[i] - expected[i]) > tolerance)
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+paint_cb (void)
+{
+  CoglHandle bitmap, converted, reference, tex, chunked, small;
+  guint8 pixels[(G_N_ELEMENTS (filters) * 2 + 1) * 4];
+  GError *error = NULL;
+  gchar *filename;
+  int width, height, i;
+
+  filename = clutter_test_get_data_file ("redhand.png");
+  bitmap = cogl_bitmap_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_free (filename);
+
+  converted = cogl_bitmap_convert_for_upload (bitmap, COGL_PIXEL_FORMAT_ANY);
+  g_assert (converted != NULL);
+  cogl_handle_unref (bitmap);
+
+  width = cogl_bitmap_get_width (converted);
+  height = cogl_bitmap_get_height (converted);
+
+  /* The reference texture is created before the levels are generated
+     so its mipmaps come from the GPU */
+  reference = cogl_texture_new_from_bitmap (converted,
+                                            COGL_TEXTURE_NO_ATLAS,
+                                            COGL_PIXEL_FORMAT_ANY);
+  draw_smallest_level (reference, 0);
+  cogl_handle_unref (reference);
+
+  for (i = 0; i < G_N_ELEMENTS (filters); i++)
+    {
+      g_assert (cogl_bitmap_generate_mipmaps (converted, filters[i].filter));
+
+      tex = cogl_texture_new_from_bitmap (converted,
+                                          COGL_TEXTURE_NONE,
+                                          COGL_PIXEL_FORMAT_ANY);
+
+      /* Upload the base level separately like the big textures loaded
+         asynchronously by ClutterTexture */
+      chunked = cogl_texture_new_with_size (width, height,
+                                            COGL_TEXTURE_NO_ATLAS,
+                                            cogl_bitmap_get_format (converted));
+      cogl_texture_set_region_from_bitmap (chunked,
+                                           0, 0, 0, 0,
+                                           width, height,
+                                           converted);
+      g_assert (cogl_texture_set_mipmaps_from_bitmap (chunked, converted) ==
+                !cogl_texture_is_sliced (chunked));
+
+      draw_smallest_level (tex, i * 2 + 1);
+      draw_smallest_level (chunked, i * 2 + 2);
+
+      cogl_handle_unref (tex);
+      cogl_handle_unref (chunked);
+    }
+
+  /* The levels can't be used for a texture of a different size */
+  small = cogl_texture_new_with_size (width / 2, height / 2,
+                                      COGL_TEXTURE_NO_ATLAS,
+                                      cogl_bitmap_get_format (converted));
+  g_assert (!cogl_texture_set_mipmaps_from_bitmap (small, converted));
+  cogl_handle_unref (small);
+
+  cogl_handle_unref (converted);
+
+  cogl_read_pixels (0, 0, G_N_ELEMENTS (filters) * 2 + 1, 1,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixels);
+
+  for (i = 0; i < G_N_ELEMENTS (filters); i++)
+    {
+      const guint8 *tex_pixel = pixels + (i * 2 + 1) * 4;
+      const guint8 *chunked_pixel = pixels + (i * 2 + 2) * 4;
+
+      /* Both textures were given the same levels */
+      g_assert (check_pixel (chunked_pixel, tex_pixel, 0));
+      /* which should be close to the GPU's */
+      g_assert (check_pixel (tex_pixel, pixels, filters[i].tolerance));
+    }
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_mipmaps (TestConformSimpleFixture *fixture,
+                          gconstpointer data)
+{
+  ClutterActor *stage;
+  guint paint_handler;
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), NULL);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,221 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* Bitmaps with at least 512x512 pixels are converted, premultiplied
+   and unpremultiplied in bands of rows spread over a pool of threads.
+   This checks that the result is the same as converting the pixels
+   one by one */
+
+/* The texture is premultiplied in parallel when it is uploaded */
+#define TEX_SIZE 1024
+
+/* The region read back is converted and unpremultiplied in parallel.
+   The size doesn't divide into whole bands so the last band is
+   shorter than the others */
+#define READ_WIDTH  1000
+#define READ_HEIGHT 517
+
+/* Each strip read back on its own is too small to be split */
+#define STRIP_HEIGHT 100
+
+static guint8
+test_component (int x, int y, int component)
+{
+  return (x * 13 + y * 7 + ((x ^ y) & 0x3f) + component * 59) & 0xff;
+}
+
+/* Reference implementation of the premultiplication */
+static guint8
+premult (guint8 c, guint8 a)
+{
+  unsigned int t = c * a + 128;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static guint8
+unpremult (guint8 c, guint8 a)
+{
+  return a == 0 ? 0 : (c * 255) / a;
+}
+
+/* Uploads unpremultiplied BGRA data to a premultiplied RGBA texture,
+   which makes Cogl premultiply a copy of the data before GL swaps
+   the components */
+static CoglHandle
+make_texture (void)
+{
+  CoglHandle tex;
+  guint8 *data, *p;
+  int x, y;
+
+  data = g_malloc (TEX_SIZE * TEX_SIZE * 4);
+
+  for (y = 0, p = data; y < TEX_SIZE; y++)
+    for (x = 0; x < TEX_SIZE; x++, p += 4)
+      {
+        p[0] = test_component (x, y, 2);
+        p[1] = test_component (x, y, 1);
+        p[2] = test_component (x, y, 0);
+        p[3] = test_component (x, y, 3);
+      }
+
+  tex = cogl_texture_new_from_data (TEX_SIZE, TEX_SIZE,
+                                    COGL_TEXTURE_NO_ATLAS |
+                                    COGL_TEXTURE_NO_SLICING,
+                                    COGL_PIXEL_FORMAT_BGRA_8888,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                    TEX_SIZE * 4,
+                                    data);
+  g_assert (tex != COGL_INVALID_HANDLE);
+
+  g_free (data);
+
+  return tex;
+}
+
+static void
+check_premult (CoglHandle tex)
+{
+  guint8 *data, *p;
+  int x, y, i;
+
+  if (g_test_verbose ())
+    g_print ("Checking the premultiplied texture\n");
+
+  data = g_malloc (TEX_SIZE * TEX_SIZE * 4);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         TEX_SIZE * 4, data);
+
+  for (y = 0, p = data; y < TEX_SIZE; y++)
+    for (x = 0; x < TEX_SIZE; x++, p += 4)
+      {
+        guint8 alpha = test_component (x, y, 3);
+
+        for (i = 0; i < 3; i++)
+          if (p[i] != premult (test_component (x, y, i), alpha))
+            {
+              g_print ("pixel %i,%i component %i is 0x%02x, "
+                       "expected 0x%02x\n",
+                       x, y, i, p[i],
+                       premult (test_component (x, y, i), alpha));
+              g_assert_not_reached ();
+            }
+
+        g_assert_cmpint (p[3], ==, alpha);
+      }
+
+  g_free (data);
+}
+
+/* Reading in a format other than RGBA_8888_PRE makes Cogl convert and
+   unpremultiply the pixels that GL returns */
+static void
+read_bgra (int y,
+           int height,
+           guint8 *data)
+{
+  cogl_read_pixels (0, y, READ_WIDTH, height,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_BGRA_8888,
+                    data + y * READ_WIDTH * 4);
+}
+
+static void
+check_read (CoglHandle tex)
+{
+  CoglHandle offscreen;
+  guint8 *data, *strip_data, *p;
+  int x, y, i;
+
+  if (g_test_verbose ())
+    g_print ("Reading back %ix%i pixels\n", READ_WIDTH, READ_HEIGHT);
+
+  data = g_malloc (READ_WIDTH * READ_HEIGHT * 4);
+  strip_data = g_malloc (READ_WIDTH * READ_HEIGHT * 4);
+
+  offscreen = cogl_offscreen_new_to_texture (tex);
+  cogl_push_framebuffer (offscreen);
+
+  read_bgra (0, READ_HEIGHT, data);
+
+  for (y = 0; y < READ_HEIGHT; y += STRIP_HEIGHT)
+    read_bgra (y, MIN (STRIP_HEIGHT, READ_HEIGHT - y), strip_data);
+
+  cogl_pop_framebuffer ();
+  cogl_handle_unref (offscreen);
+
+  /* The strips are converted in a single band so they must give the
+     same result as the whole region */
+  g_assert (memcmp (data, strip_data, READ_WIDTH * READ_HEIGHT * 4) == 0);
+
+  for (y = 0, p = data; y < READ_HEIGHT; y++)
+    for (x = 0; x < READ_WIDTH; x++, p += 4)
+      {
+        guint8 alpha = test_component (x, y, 3);
+
+        for (i = 0; i < 3; i++)
+          {
+            guint8 expected =
+              unpremult (premult (test_component (x, y, i), alpha), alpha);
+
+            if (p[2 - i] != expected)
+              {
+                g_print ("pixel %i,%i component %i is 0x%02x, "
+                         "expected 0x%02x\n",
+                         x, y, i, p[2 - i], expected);
+                g_assert_not_reached ();
+              }
+          }
+
+        g_assert_cmpint (p[3], ==, alpha);
+      }
+
+  g_free (strip_data);
+  g_free (data);
+}
+
+static void
+paint_cb (void)
+{
+  CoglHandle tex = make_texture ();
+
+  check_premult (tex);
+  check_read (tex);
+
+  cogl_handle_unref (tex);
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_parallel (TestConformSimpleFixture *fixture,
+                           gconstpointer data)
+{
+  ClutterActor *stage;
+  guint paint_handler;
+
+  /* The number of threads is read the first time a big bitmap is
+     processed. Make sure there is more than one, even on a single
+     processor, unless it was set explicitly */
+  g_setenv ("COGL_BITMAP_THREADS", "4", FALSE);
+
+  /* The textures are created in the paint handler so that there is a
+     context */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), NULL);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
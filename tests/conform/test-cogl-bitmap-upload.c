@@ -0,0 +1,215 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* Checks which format cogl_bitmap_convert_for_upload() picks for a
+   loaded image and that the converted bitmap contains the right
+   pixels */
+
+typedef struct _TestState
+{
+  CoglBitmap *bitmap;
+  int width, height;
+  /* The unpremultiplied RGBA pixels of the image */
+  guint8 *reference;
+} TestState;
+
+/* Reference implementation of the premultiplication */
+static guint8
+premult (guint8 c, guint8 a)
+{
+  unsigned int t = c * a + 128;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+/* Gets the data of @bitmap in @format. If @format is the format of
+   the bitmap then the data is uploaded and read back unchanged */
+static guint8 *
+get_bitmap_data (CoglBitmap *bitmap,
+                 CoglPixelFormat format,
+                 int bpp)
+{
+  CoglHandle tex;
+  guint8 *data;
+  int width, height;
+
+  width = cogl_bitmap_get_width (bitmap);
+  height = cogl_bitmap_get_height (bitmap);
+
+  tex = cogl_texture_new_from_bitmap (bitmap,
+                                      COGL_TEXTURE_NO_ATLAS,
+                                      cogl_bitmap_get_format (bitmap));
+  g_assert (tex != COGL_INVALID_HANDLE);
+
+  data = g_malloc (width * height * bpp);
+  cogl_texture_get_data (tex, format, width * bpp, data);
+
+  cogl_handle_unref (tex);
+
+  return data;
+}
+
+static CoglBitmap *
+convert (TestState *state,
+         CoglPixelFormat internal_format,
+         CoglPixelFormat expected_format)
+{
+  CoglBitmap *converted;
+
+  converted = cogl_bitmap_convert_for_upload (state->bitmap,
+                                              internal_format);
+  g_assert (converted != NULL);
+
+  if (g_test_verbose ())
+    g_print ("Converting for 0x%x gave 0x%x\n",
+             internal_format, cogl_bitmap_get_format (converted));
+
+  g_assert_cmpint (cogl_bitmap_get_format (converted), ==, expected_format);
+  g_assert_cmpint (cogl_bitmap_get_width (converted), ==, state->width);
+  g_assert_cmpint (cogl_bitmap_get_height (converted), ==, state->height);
+
+  return converted;
+}
+
+/* An image with an alpha channel is premultiplied for the default
+   internal format */
+static void
+check_premultiplied (TestState *state)
+{
+  CoglBitmap *converted;
+  guint8 *data, *p, *r;
+  int i;
+
+  converted = convert (state,
+                       COGL_PIXEL_FORMAT_ANY,
+                       COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+  g_assert (converted != state->bitmap);
+
+  data = get_bitmap_data (converted, COGL_PIXEL_FORMAT_RGBA_8888_PRE, 4);
+
+  for (i = 0, p = data, r = state->reference;
+       i < state->width * state->height;
+       i++, p += 4, r += 4)
+    {
+      g_assert_cmpint (p[0], ==, premult (r[0], r[3]));
+      g_assert_cmpint (p[1], ==, premult (r[1], r[3]));
+      g_assert_cmpint (p[2], ==, premult (r[2], r[3]));
+      g_assert_cmpint (p[3], ==, r[3]);
+    }
+
+  g_free (data);
+  cogl_handle_unref (converted);
+}
+
+/* Asking for a format without alpha drops the alpha channel without
+   premultiplying */
+static void
+check_no_alpha (TestState *state)
+{
+  CoglBitmap *converted;
+  guint8 *data, *p, *r;
+  int i;
+
+  converted = convert (state,
+                       COGL_PIXEL_FORMAT_RGB_888,
+                       COGL_PIXEL_FORMAT_RGB_888);
+
+  data = get_bitmap_data (converted, COGL_PIXEL_FORMAT_RGB_888, 3);
+
+  for (i = 0, p = data, r = state->reference;
+       i < state->width * state->height;
+       i++, p += 3, r += 4)
+    {
+      g_assert_cmpint (p[0], ==, r[0]);
+      g_assert_cmpint (p[1], ==, r[1]);
+      g_assert_cmpint (p[2], ==, r[2]);
+    }
+
+  g_free (data);
+  cogl_handle_unref (converted);
+}
+
+/* A bitmap that is already in the requested format isn't copied */
+static void
+check_same_format (TestState *state)
+{
+  CoglBitmap *converted;
+
+  converted = convert (state,
+                       COGL_PIXEL_FORMAT_RGBA_8888,
+                       COGL_PIXEL_FORMAT_RGBA_8888);
+  g_assert (converted == state->bitmap);
+
+  cogl_handle_unref (converted);
+}
+
+static void
+paint_cb (ClutterActor *stage,
+          TestState *state)
+{
+  gboolean has_translucent = FALSE;
+  int i;
+
+  state->reference = get_bitmap_data (state->bitmap,
+                                      COGL_PIXEL_FORMAT_RGBA_8888, 4);
+
+  /* The premultiplication would not be tested if the image was
+     opaque */
+  for (i = 0; i < state->width * state->height; i++)
+    if (state->reference[i * 4 + 3] > 0 && state->reference[i * 4 + 3] < 255)
+      has_translucent = TRUE;
+  g_assert (has_translucent);
+
+  check_premultiplied (state);
+  check_no_alpha (state);
+  check_same_format (state);
+
+  g_free (state->reference);
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_bitmap_upload (TestConformSimpleFixture *fixture,
+                         gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  GError *error = NULL;
+  gchar *filename;
+  guint paint_handler;
+
+  filename = clutter_test_get_data_file ("redhand_alpha.png");
+  state.bitmap = cogl_bitmap_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert (state.bitmap != NULL);
+  g_free (filename);
+
+  /* The loader gives unpremultiplied data */
+  g_assert_cmpint (cogl_bitmap_get_format (state.bitmap),
+                   ==,
+                   COGL_PIXEL_FORMAT_RGBA_8888);
+  state.width = cogl_bitmap_get_width (state.bitmap);
+  state.height = cogl_bitmap_get_height (state.bitmap);
+
+  /* The pixels are checked in the paint handler so that there is a
+     context to create textures with */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  cogl_handle_unref (state.bitmap);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,306 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* When the clip changes while there are quads in the journal, the
+   journal tries to clip all of the quads in software so that it can
+   keep batching. These tests draw a mixture of clips that can and
+   can't be done in software, with and without the
+   disable-software-clip debug option, and check that the results are
+   the same */
+
+static const ClutterColor stage_color = { 0x0, 0x0, 0x0, 0xff };
+static const ClutterColor red = { 0xff, 0x00, 0x00, 0xff };
+static const ClutterColor green = { 0x00, 0xff, 0x00, 0xff };
+
+/* The texture has four texels in a row and is stretched over a quad
+   that is TEXEL_SIZE pixels wide for each texel */
+#define TEXEL_SIZE 20
+#define QUAD_HEIGHT 20
+
+/* The area that the Cogl tests draw into */
+#define RESULT_WIDTH 400
+#define RESULT_HEIGHT 200
+
+/* Somewhere outside of the result area to draw a quad that makes
+   sure the journal isn't empty before the clip changes */
+#define STARTER_X 600
+
+typedef struct _TestState
+{
+  CoglHandle material;
+} TestState;
+
+static const guint8 texels[4][4] =
+  {
+    { 0xff, 0x00, 0x00, 0xff },
+    { 0x00, 0xff, 0x00, 0xff },
+    { 0x00, 0x00, 0xff, 0xff },
+    { 0xff, 0xff, 0xff, 0xff }
+  };
+
+static void
+check_pixel (int x,
+             int y,
+             const guint8 *expected)
+{
+  guint8 pixel[4];
+
+  cogl_read_pixels (x, y, 1, 1,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixel);
+
+  if (g_test_verbose ())
+    g_print ("  pixel %i,%i = %02x%02x%02x, expected %02x%02x%02x\n",
+             x, y, pixel[0], pixel[1], pixel[2],
+             expected[0], expected[1], expected[2]);
+
+  g_assert_cmpint (pixel[0], ==, expected[0]);
+  g_assert_cmpint (pixel[1], ==, expected[1]);
+  g_assert_cmpint (pixel[2], ==, expected[2]);
+}
+
+static void
+check_background (int x,
+                  int y)
+{
+  static const guint8 black[4] = { 0x00, 0x00, 0x00, 0xff };
+
+  check_pixel (x, y, black);
+}
+
+static void
+draw_starter (int y)
+{
+  cogl_flush ();
+
+  cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+  cogl_rectangle (STARTER_X, y, STARTER_X + 10, y + 10);
+}
+
+/* A window aligned clip cuts the textured quad in the middle of the
+   first and last texels. The texture coordinates at the clipped edges
+   must be interpolated so the texels should still line up with where
+   they would be without the clip */
+static void
+test_window_clip (TestState *state)
+{
+  draw_starter (0);
+
+  cogl_clip_push_window_rectangle (TEXEL_SIZE * 3 / 2, 0,
+                                   TEXEL_SIZE * 2, QUAD_HEIGHT);
+  cogl_set_source (state->material);
+  cogl_rectangle (0, 0, TEXEL_SIZE * 4, QUAD_HEIGHT);
+  cogl_clip_pop ();
+
+  cogl_flush ();
+
+  check_background (TEXEL_SIZE * 3 / 2 - 1, QUAD_HEIGHT / 2);
+  check_pixel (TEXEL_SIZE * 3 / 2, QUAD_HEIGHT / 2, texels[1]);
+  check_pixel (TEXEL_SIZE * 5 / 2, QUAD_HEIGHT / 2, texels[2]);
+  check_pixel (TEXEL_SIZE * 7 / 2 - 1, QUAD_HEIGHT / 2, texels[3]);
+  check_background (TEXEL_SIZE * 7 / 2, QUAD_HEIGHT / 2);
+}
+
+/* Rotating by 90 degrees keeps the clip aligned to the window so it
+   can still use the scissor and the quads can be clipped in software
+   but the texture now runs down the window instead of across */
+static void
+test_rotated_90_clip (TestState *state)
+{
+  int x = 100, y = 40;
+
+  draw_starter (y);
+
+  /* Local coordinates (x, y) end up at (x - local y, y + local x) */
+  cogl_push_matrix ();
+  cogl_translate (x, y, 0);
+  cogl_rotate (90, 0, 0, 1);
+  cogl_clip_push_rectangle (TEXEL_SIZE * 3 / 2, 0,
+                            TEXEL_SIZE * 7 / 2, QUAD_HEIGHT);
+  cogl_set_source (state->material);
+  cogl_rectangle (0, 0, TEXEL_SIZE * 4, QUAD_HEIGHT);
+  cogl_clip_pop ();
+  cogl_pop_matrix ();
+
+  cogl_flush ();
+
+  x -= QUAD_HEIGHT / 2;
+  check_background (x, y + TEXEL_SIZE * 3 / 2 - 1);
+  check_pixel (x, y + TEXEL_SIZE * 3 / 2, texels[1]);
+  check_pixel (x, y + TEXEL_SIZE * 5 / 2, texels[2]);
+  check_pixel (x, y + TEXEL_SIZE * 7 / 2 - 1, texels[3]);
+  check_background (x, y + TEXEL_SIZE * 7 / 2);
+}
+
+/* A clip rotated by 30 degrees isn't aligned to the window so the
+   journal has to be flushed and the stencil buffer or the clip
+   planes used instead */
+static void
+test_rotated_30_clip (TestState *state)
+{
+  static const guint8 white[4] = { 0xff, 0xff, 0xff, 0xff };
+  int x = 250, y = 140;
+
+  draw_starter (y);
+
+  cogl_push_matrix ();
+  cogl_translate (x, y, 0);
+  cogl_rotate (30, 0, 0, 1);
+  cogl_clip_push_rectangle (-20, -20, 20, 20);
+  cogl_pop_matrix ();
+
+  cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+  cogl_rectangle (x - 40, y - 40, x + 40, y + 40);
+  cogl_clip_pop ();
+
+  cogl_flush ();
+
+  check_pixel (x, y, white);
+  check_pixel (x + 18, y, white);
+  /* This is inside the bounding box of the clip but outside of the
+     rotated rectangle */
+  check_background (x + 25, y - 25);
+  check_background (x + 30, y);
+}
+
+static guint8 *
+run_cogl_tests (TestState *state,
+                gboolean software_clip)
+{
+  guint8 *pixels = g_malloc (RESULT_WIDTH * RESULT_HEIGHT * 4);
+  unsigned int old_flags = cogl_debug_flags;
+  CoglColor black;
+
+  if (g_test_verbose ())
+    g_print ("Software clipping %s\n",
+             software_clip ? "enabled" : "disabled");
+
+  cogl_flush ();
+  if (software_clip)
+    cogl_debug_flags &= ~COGL_DEBUG_DISABLE_SOFTWARE_CLIP;
+  else
+    cogl_debug_flags |= COGL_DEBUG_DISABLE_SOFTWARE_CLIP;
+
+  cogl_color_set_from_4ub (&black, 0x00, 0x00, 0x00, 0xff);
+  cogl_clear (&black, COGL_BUFFER_BIT_COLOR);
+
+  test_window_clip (state);
+  test_rotated_90_clip (state);
+  test_rotated_30_clip (state);
+
+  cogl_read_pixels (0, 0, RESULT_WIDTH, RESULT_HEIGHT,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixels);
+
+  cogl_debug_flags = old_flags;
+
+  return pixels;
+}
+
+/* The two sibling actors are clipped to the same window rectangle
+   even though their clips are given in different coordinates */
+static void
+check_siblings (TestState *state)
+{
+  static const guint8 red_pixel[4] = { 0xff, 0x00, 0x00, 0xff };
+  static const guint8 green_pixel[4] = { 0x00, 0xff, 0x00, 0xff };
+
+  if (g_test_verbose ())
+    g_print ("Sibling clips\n");
+
+  check_pixel (5, 325, red_pixel);
+  check_pixel (30, 325, green_pixel);
+  check_background (55, 325);
+}
+
+static void
+paint_cb (ClutterActor *stage,
+          TestState *state)
+{
+  guint8 *software_pixels, *gl_pixels;
+
+  check_siblings (state);
+
+  software_pixels = run_cogl_tests (state, TRUE);
+  gl_pixels = run_cogl_tests (state, FALSE);
+
+  g_assert (memcmp (software_pixels, gl_pixels,
+                    RESULT_WIDTH * RESULT_HEIGHT * 4) == 0);
+
+  g_free (software_pixels);
+  g_free (gl_pixels);
+
+  clutter_main_quit ();
+}
+
+static CoglHandle
+make_material (void)
+{
+  CoglHandle texture, material;
+
+  texture = cogl_texture_new_from_data (4, 1,
+                                        COGL_TEXTURE_NO_ATLAS,
+                                        COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                        COGL_PIXEL_FORMAT_ANY,
+                                        4 * 4,
+                                        (const guint8 *) texels);
+
+  material = cogl_material_new ();
+  cogl_material_set_layer (material, 0, texture);
+  cogl_material_set_layer_filters (material, 0,
+                                   COGL_MATERIAL_FILTER_NEAREST,
+                                   COGL_MATERIAL_FILTER_NEAREST);
+  cogl_handle_unref (texture);
+
+  return material;
+}
+
+void
+test_cogl_clip (TestConformSimpleFixture *fixture,
+                gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage, *group, *rect;
+  guint paint_handler;
+
+  state.material = make_material ();
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  group = clutter_group_new ();
+  clutter_actor_set_position (group, 0, 300);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), group);
+
+  /* Both rectangles are clipped to x = 0..50 of the group */
+  rect = clutter_rectangle_new_with_color (&red);
+  clutter_actor_set_size (rect, 100, 50);
+  clutter_actor_set_clip (rect, 0, 0, 50, 50);
+  clutter_container_add_actor (CLUTTER_CONTAINER (group), rect);
+
+  rect = clutter_rectangle_new_with_color (&green);
+  clutter_actor_set_size (rect, 100, 50);
+  clutter_actor_set_position (rect, 10, 0);
+  clutter_actor_set_clip (rect, -10, 0, 50, 50);
+  clutter_container_add_actor (CLUTTER_CONTAINER (group), rect);
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+
+  clutter_actor_show_all (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  clutter_actor_destroy (group);
+  cogl_handle_unref (state.material);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
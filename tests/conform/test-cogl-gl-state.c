@@ -0,0 +1,224 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* Cogl keeps a shadow copy of the GL state so that it can skip
+   redundant calls. This draws with a mixture of the journal, paths,
+   clips and buffers and flushes after each step. With
+   COGL_DEBUG=gl-state cogl_flush() reads the state back from GL and
+   warns if the shadow copy is out of date, which makes the test
+   fail */
+
+static const ClutterColor stage_color = { 0x0, 0x0, 0x0, 0xff };
+
+#define TEX_SIZE 4
+
+static void
+verify_state (const char *description)
+{
+  if (g_test_verbose ())
+    g_print ("%s\n", description);
+
+  cogl_flush ();
+}
+
+static void
+draw_journal (void)
+{
+  CoglMaterial *material;
+
+  cogl_set_source_color4ub (0xff, 0x00, 0x00, 0x80);
+  cogl_rectangle (0, 0, 10, 10);
+
+  material = cogl_material_new ();
+  cogl_material_set_color4ub (material, 0x00, 0xff, 0x00, 0xff);
+  cogl_material_set_depth_test_enabled (material, TRUE);
+  cogl_material_set_depth_test_function (material,
+                                         COGL_DEPTH_TEST_FUNCTION_ALWAYS);
+  cogl_material_set_depth_writing_enabled (material, FALSE);
+  cogl_set_source (material);
+  cogl_rectangle (10, 0, 20, 10);
+  cogl_object_unref (material);
+
+  cogl_set_source_color4ub (0x00, 0x00, 0xff, 0xff);
+  cogl_rectangle (20, 0, 30, 10);
+}
+
+static void
+draw_paths (void)
+{
+  cogl_set_source_color4ub (0xff, 0xff, 0x00, 0x80);
+
+  cogl_path_new ();
+  cogl_path_ellipse (50, 10, 10, 8);
+  cogl_path_fill_preserve ();
+  cogl_path_stroke ();
+
+  cogl_path_new ();
+  cogl_path_move_to (70, 0);
+  cogl_path_line_to (90, 20);
+  cogl_path_line_to (70, 20);
+  cogl_path_close ();
+  cogl_path_fill ();
+}
+
+static void
+draw_clipped (void)
+{
+  /* Scissored */
+  cogl_clip_push_window_rectangle (0, 20, 40, 20);
+  cogl_set_source_color4ub (0x00, 0xff, 0xff, 0xff);
+  cogl_rectangle (0, 20, 40, 40);
+  verify_state ("Window clip");
+
+  /* A rotated clip can't use the scissor so it uses the stencil
+     buffer or the clip planes */
+  cogl_push_matrix ();
+  cogl_translate (20, 30, 0);
+  cogl_rotate (30, 0, 0, 1);
+  cogl_clip_push_rectangle (-10, -10, 10, 10);
+  cogl_pop_matrix ();
+  cogl_rectangle (0, 20, 40, 40);
+  verify_state ("Rotated clip");
+
+  cogl_path_new ();
+  cogl_path_ellipse (20, 30, 10, 10);
+  cogl_clip_push_from_path ();
+  cogl_set_source_color4ub (0xff, 0x00, 0xff, 0xff);
+  cogl_rectangle (0, 20, 40, 40);
+  verify_state ("Path clip");
+
+  cogl_clip_pop ();
+  cogl_clip_pop ();
+  cogl_clip_pop ();
+  cogl_rectangle (40, 20, 50, 30);
+  verify_state ("Popped clips");
+}
+
+static void
+draw_vertex_buffer (void)
+{
+  static const float verts[3][2] =
+    {
+      { 50, 20 },
+      { 60, 20 },
+      { 50, 30 }
+    };
+  CoglHandle buffer;
+
+  buffer = cogl_vertex_buffer_new (3);
+  cogl_vertex_buffer_add (buffer, "gl_Vertex",
+                          2, COGL_ATTRIBUTE_TYPE_FLOAT, FALSE, 0,
+                          verts);
+  cogl_vertex_buffer_submit (buffer);
+
+  cogl_set_source_color4ub (0x80, 0x80, 0x80, 0xff);
+  cogl_vertex_buffer_draw (buffer, COGL_VERTICES_MODE_TRIANGLES, 0, 3);
+
+  cogl_handle_unref (buffer);
+}
+
+static void
+draw_pixel_array (void)
+{
+  guint8 pixels[TEX_SIZE * TEX_SIZE * 4];
+  CoglHandle buffer, texture;
+  unsigned int stride;
+
+  memset (pixels, 0xff, sizeof (pixels));
+
+  buffer = cogl_pixel_array_new_with_size (TEX_SIZE, TEX_SIZE,
+                                           COGL_PIXEL_FORMAT_RGBA_8888,
+                                           &stride);
+  cogl_buffer_set_data (buffer, 0, pixels, sizeof (pixels));
+
+  texture = cogl_texture_new_from_buffer (buffer, TEX_SIZE, TEX_SIZE,
+                                          COGL_TEXTURE_NO_SLICING,
+                                          COGL_PIXEL_FORMAT_RGBA_8888,
+                                          COGL_PIXEL_FORMAT_RGBA_8888,
+                                          stride, 0);
+  g_assert (texture != COGL_INVALID_HANDLE);
+
+  cogl_set_source_texture (texture);
+  cogl_rectangle (60, 20, 70, 30);
+
+  cogl_handle_unref (texture);
+  cogl_handle_unref (buffer);
+}
+
+static void
+on_paint (ClutterActor *actor, gpointer data)
+{
+  verify_state ("Start of paint");
+
+  draw_journal ();
+  verify_state ("Journal");
+
+  draw_paths ();
+  verify_state ("Paths");
+
+  draw_clipped ();
+
+  /* Mix them all up without flushing in between */
+  draw_paths ();
+  draw_journal ();
+  cogl_clip_push_window_rectangle (0, 0, 30, 30);
+  draw_paths ();
+  cogl_clip_pop ();
+  draw_journal ();
+  verify_state ("Mixed");
+
+  draw_vertex_buffer ();
+  verify_state ("Vertex buffer");
+
+  draw_pixel_array ();
+  verify_state ("Pixel array");
+
+  clutter_main_quit ();
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_cogl_gl_state (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  ClutterActor *stage;
+  guint idle_source;
+  gboolean async_path_fill;
+  unsigned int old_flags = cogl_debug_flags;
+
+  cogl_debug_flags |= COGL_DEBUG_GL_STATE;
+
+  /* Tesselate the paths straight away so they are drawn in the same
+     frame */
+  async_path_fill = cogl_get_async_path_fill_enabled ();
+  cogl_set_async_path_fill_enabled (FALSE);
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  idle_source = g_idle_add (queue_redraw, stage);
+  g_signal_connect_after (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  clutter_actor_show (stage);
+  clutter_main ();
+
+  g_source_remove (idle_source);
+  g_signal_handlers_disconnect_by_func (stage, on_paint, NULL);
+
+  cogl_set_async_path_fill_enabled (async_path_fill);
+
+  cogl_debug_flags = old_flags;
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,411 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include "test-conform-common.h"
+
+/* A material caches a hash of its state so that the journal and the
+   material flushing code can quickly decide whether two materials are
+   equal. If two materials are wrongly found to be equal the GL state
+   of the first would be used to draw the second. Each test case
+   changes a single piece of state and checks that rectangles drawn
+   alternately with and without the change get the right colors,
+   including when the material is modified after it has been drawn */
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+#define QUAD_WIDTH 20
+
+/* Linear filtering may be rounded differently by each driver */
+#define TOLERANCE 2
+
+typedef struct _TestState TestState;
+
+typedef void (* TestFunc) (TestState *state, CoglMaterial *material);
+
+typedef struct _TestCase
+{
+  const char *description;
+  /* Sets up state in the base material needed to see the change */
+  TestFunc setup;
+  TestFunc change;
+  guint32 before;
+  guint32 after;
+} TestCase;
+
+struct _TestState
+{
+  CoglHandle texture;
+  CoglHandle green_texture;
+  CoglHandle red_texture;
+};
+
+static CoglHandle
+make_texture (guint32 top_left,
+              guint32 top_right,
+              guint32 bottom_left,
+              guint32 bottom_right)
+{
+  guint32 colors[4] = { top_left, top_right, bottom_left, bottom_right };
+  guint8 pixels[2 * 2 * 4];
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      pixels[i * 4] = colors[i] >> 24;
+      pixels[i * 4 + 1] = colors[i] >> 16;
+      pixels[i * 4 + 2] = colors[i] >> 8;
+      pixels[i * 4 + 3] = colors[i];
+    }
+
+  /* The texture can't be in the atlas because the tests use a layer
+     matrix and the wrap modes */
+  return cogl_texture_new_from_data (2, 2,
+                                     COGL_TEXTURE_NO_ATLAS,
+                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                     COGL_PIXEL_FORMAT_ANY,
+                                     2 * 4,
+                                     pixels);
+}
+
+static void
+change_blend_enable (TestState *state, CoglMaterial *material)
+{
+  /* Making the color transparent enables blending */
+  cogl_material_set_color4ub (material, 0x80, 0x80, 0x80, 0x80);
+}
+
+static void
+change_blend_function (TestState *state, CoglMaterial *material)
+{
+  /* The rectangles are opaque so this leaves the stage color */
+  g_assert (cogl_material_set_blend (material,
+                                     "RGBA = ADD (SRC_COLOR * "
+                                     "(1-SRC_COLOR[A]), DST_COLOR)",
+                                     NULL));
+}
+
+static void
+change_alpha_function (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_alpha_test_function (material,
+                                         COGL_MATERIAL_ALPHA_FUNC_NEVER,
+                                         0.0f);
+}
+
+static void
+setup_depth_test_enable (TestState *state, CoglMaterial *material)
+{
+  /* This has no effect until the depth test is enabled */
+  cogl_material_set_depth_test_function (material,
+                                         COGL_DEPTH_TEST_FUNCTION_NEVER);
+}
+
+static void
+change_depth_test_enable (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_depth_test_enabled (material, TRUE);
+}
+
+static void
+setup_depth_test_function (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_depth_test_enabled (material, TRUE);
+  cogl_material_set_depth_test_function (material,
+                                         COGL_DEPTH_TEST_FUNCTION_ALWAYS);
+}
+
+static void
+change_depth_test_function (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_depth_test_function (material,
+                                         COGL_DEPTH_TEST_FUNCTION_NEVER);
+}
+
+static void
+change_layer_texture (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_layer (material, 0, state->green_texture);
+}
+
+static void
+change_layer_combine (TestState *state, CoglMaterial *material)
+{
+  g_assert (cogl_material_set_layer_combine (material, 0,
+                                             "RGBA = REPLACE (CONSTANT)",
+                                             NULL));
+}
+
+static void
+setup_layer_combine_constant (TestState *state, CoglMaterial *material)
+{
+  change_layer_combine (state, material);
+}
+
+static void
+change_layer_combine_constant (TestState *state, CoglMaterial *material)
+{
+  CoglColor color;
+
+  cogl_color_set_from_4ub (&color, 0x00, 0x00, 0xff, 0xff);
+  cogl_material_set_layer_combine_constant (material, 0, &color);
+}
+
+static void
+change_layer_filters (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_layer_filters (material, 0,
+                                   COGL_MATERIAL_FILTER_LINEAR,
+                                   COGL_MATERIAL_FILTER_LINEAR);
+}
+
+static void
+set_layer_scale (CoglMaterial *material,
+                 float s_scale,
+                 float t_scale)
+{
+  CoglMatrix matrix;
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_scale (&matrix, s_scale, t_scale, 1.0f);
+  cogl_material_set_layer_matrix (material, 0, &matrix);
+}
+
+static void
+setup_layer_wrap_mode_s (TestState *state, CoglMaterial *material)
+{
+  set_layer_scale (material, 2.0f, 1.0f);
+}
+
+static void
+change_layer_wrap_mode_s (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_layer_wrap_mode_s (material, 0,
+                                       COGL_MATERIAL_WRAP_MODE_REPEAT);
+}
+
+static void
+setup_layer_wrap_mode_t (TestState *state, CoglMaterial *material)
+{
+  set_layer_scale (material, 1.0f, 2.0f);
+}
+
+static void
+change_layer_wrap_mode_t (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_layer_wrap_mode_t (material, 0,
+                                       COGL_MATERIAL_WRAP_MODE_REPEAT);
+}
+
+static void
+change_layer_matrix (TestState *state, CoglMaterial *material)
+{
+  CoglMatrix matrix;
+
+  cogl_matrix_init_identity (&matrix);
+  cogl_matrix_translate (&matrix, -0.5f, 0.0f, 0.0f);
+  cogl_material_set_layer_matrix (material, 0, &matrix);
+}
+
+static void
+change_second_layer (TestState *state, CoglMaterial *material)
+{
+  cogl_material_set_layer (material, 1, state->red_texture);
+}
+
+static void
+setup_removed_layer (TestState *state, CoglMaterial *material)
+{
+  change_second_layer (state, material);
+}
+
+static void
+change_removed_layer (TestState *state, CoglMaterial *material)
+{
+  cogl_material_remove_layer (material, 1);
+}
+
+/* The sampled point of each rectangle is just inside the bottom right
+   texel of the texture, which is white */
+static const TestCase test_cases[] =
+  {
+    { "Blend enable", NULL, change_blend_enable, 0xffffffff, 0x808080ff },
+    { "Blend function", NULL, change_blend_function, 0xffffffff, 0x000000ff },
+    { "Alpha function", NULL, change_alpha_function, 0xffffffff, 0x000000ff },
+    { "Depth test enable", setup_depth_test_enable, change_depth_test_enable,
+      0xffffffff, 0x000000ff },
+    { "Depth test function",
+      setup_depth_test_function, change_depth_test_function,
+      0xffffffff, 0x000000ff },
+    { "Layer texture", NULL, change_layer_texture, 0xffffffff, 0x00ff00ff },
+    { "Layer combine", NULL, change_layer_combine, 0xffffffff, 0x00ff00ff },
+    { "Layer combine constant",
+      setup_layer_combine_constant, change_layer_combine_constant,
+      0x00ff00ff, 0x0000ffff },
+    /* The weights of the four texels are 0.2025, 0.2475, 0.2475 and
+       0.3025 */
+    { "Layer filters", NULL, change_layer_filters, 0xffffffff, 0x818c8cff },
+    { "Layer wrap mode s", setup_layer_wrap_mode_s, change_layer_wrap_mode_s,
+      0xffffffff, 0x00ff00ff },
+    { "Layer wrap mode t", setup_layer_wrap_mode_t, change_layer_wrap_mode_t,
+      0xffffffff, 0x0000ffff },
+    { "Layer matrix", NULL, change_layer_matrix, 0xffffffff, 0x00ff00ff },
+    { "Second layer", NULL, change_second_layer, 0xffffffff, 0xff0000ff },
+    { "Removed layer", setup_removed_layer, change_removed_layer,
+      0xff0000ff, 0xffffffff }
+  };
+
+static void
+check_pixel (int x, int y, guint32 color)
+{
+  guint8 pixel[4];
+  guint8 expected[3] = { color >> 24, color >> 16, color >> 8 };
+  int i;
+
+  cogl_read_pixels (x * QUAD_WIDTH + QUAD_WIDTH / 2,
+                    y * QUAD_WIDTH + QUAD_WIDTH / 2,
+                    1, 1,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixel);
+
+  if (g_test_verbose ())
+    g_print ("  (%i, %i) = %02x%02x%02x, expected %02x%02x%02x\n",
+             x, y,
+             pixel[0], pixel[1], pixel[2],
+             expected[0], expected[1], expected[2]);
+
+  for (i = 0; i < 3; i++)
+    g_assert_cmpint (ABS (pixel[i] - expected[i]), <=, TOLERANCE);
+}
+
+static void
+draw_rectangle (CoglMaterial *material, int x, int y)
+{
+  cogl_set_source (material);
+  cogl_rectangle_with_texture_coords (x * QUAD_WIDTH,
+                                      y * QUAD_WIDTH,
+                                      (x + 1) * QUAD_WIDTH,
+                                      (y + 1) * QUAD_WIDTH,
+                                      0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+static void
+run_test_case (TestState *state, const TestCase *test_case, int x)
+{
+  CoglMaterial *material, *changed, *child;
+  CoglColor constant;
+
+  if (g_test_verbose ())
+    g_print ("%s\n", test_case->description);
+
+  material = cogl_material_new ();
+  cogl_material_set_layer (material, 0, state->texture);
+  cogl_material_set_layer_filters (material, 0,
+                                   COGL_MATERIAL_FILTER_NEAREST,
+                                   COGL_MATERIAL_FILTER_NEAREST);
+  cogl_material_set_layer_wrap_mode (material, 0,
+                                     COGL_MATERIAL_WRAP_MODE_CLAMP_TO_EDGE);
+  /* The constant is not used unless the combine string is changed */
+  cogl_color_set_from_4ub (&constant, 0x00, 0xff, 0x00, 0xff);
+  cogl_material_set_layer_combine_constant (material, 0, &constant);
+
+  if (test_case->setup)
+    test_case->setup (state, material);
+
+  /* The rectangles are drawn one after the other so the journal
+     compares each material with the one before */
+  draw_rectangle (material, x, 0);
+
+  changed = cogl_material_copy (material);
+  test_case->change (state, changed);
+  draw_rectangle (changed, x, 1);
+
+  draw_rectangle (material, x, 2);
+
+  /* Modifying a material that has been drawn and that has a child
+     copies the old state into the child. Both materials must be
+     hashed again */
+  child = cogl_material_copy (material);
+  draw_rectangle (child, x, 3);
+  test_case->change (state, material);
+  draw_rectangle (material, x, 4);
+  draw_rectangle (child, x, 5);
+
+  check_pixel (x, 0, test_case->before);
+  check_pixel (x, 1, test_case->after);
+  check_pixel (x, 2, test_case->before);
+  check_pixel (x, 3, test_case->before);
+  check_pixel (x, 4, test_case->after);
+  check_pixel (x, 5, test_case->before);
+
+  cogl_object_unref (child);
+  cogl_object_unref (changed);
+  cogl_object_unref (material);
+}
+
+static void
+on_paint (ClutterActor *actor, TestState *state)
+{
+  int i;
+
+  state->texture = make_texture (0xff0000ff, 0x0000ffff,
+                                 0x00ff00ff, 0xffffffff);
+  state->green_texture = make_texture (0x00ff00ff, 0x00ff00ff,
+                                       0x00ff00ff, 0x00ff00ff);
+  state->red_texture = make_texture (0xff0000ff, 0xff0000ff,
+                                     0xff0000ff, 0xff0000ff);
+
+  for (i = 0; i < G_N_ELEMENTS (test_cases); i++)
+    run_test_case (state, test_cases + i, i);
+
+  cogl_handle_unref (state->texture);
+  cogl_handle_unref (state->green_texture);
+  cogl_handle_unref (state->red_texture);
+
+  /* Comment this out if you want visual feedback for what this test paints */
+#if 1
+  clutter_main_quit ();
+#endif
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_cogl_material_hash (TestConformSimpleFixture *fixture,
+                         gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  ClutterActor *group;
+  guint idle_source;
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  group = clutter_group_new ();
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), group);
+
+  /* We force continuous redrawing of the stage, since we need to skip
+   * the first few frames, and we wont be doing anything else that
+   * will trigger redrawing. */
+  idle_source = g_idle_add (queue_redraw, stage);
+
+  g_signal_connect (group, "paint", G_CALLBACK (on_paint), &state);
+
+  clutter_actor_show_all (stage);
+
+  clutter_main ();
+
+  g_source_remove (idle_source);
+
+  clutter_actor_destroy (group);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,118 @@
+#include <clutter/clutter.h>
+#include <math.h>
+
+#include "test-conform-common.h"
+
+/* Cogl uses the way a matrix was built to pick a cheaper way to
+   multiply it or transform points with it. These checks compare the
+   results against the same matrices loaded from an array, which
+   always use the full 4x4 math */
+
+static void
+make_general (CoglMatrix *general, const CoglMatrix *matrix)
+{
+  cogl_matrix_init_from_array (general, cogl_matrix_get_array (matrix));
+}
+
+static void
+assert_matrices_equal (const CoglMatrix *a, const CoglMatrix *b)
+{
+  const float *fa = cogl_matrix_get_array (a);
+  const float *fb = cogl_matrix_get_array (b);
+  int i;
+
+  for (i = 0; i < 16; i++)
+    g_assert_cmpfloat (fabsf (fa[i] - fb[i]), <, 0.0001f);
+}
+
+static void
+check_transform_point (const CoglMatrix *matrix)
+{
+  static const float points[][4] =
+    {
+      { 0, 0, 0, 1 },
+      { 10, 20, 0, 1 },
+      { -3, 7, 11, 1 },
+      { 5, -5, 2, 0.5f }
+    };
+  CoglMatrix general;
+  int i;
+
+  make_general (&general, matrix);
+
+  for (i = 0; i < G_N_ELEMENTS (points); i++)
+    {
+      float x = points[i][0], y = points[i][1];
+      float z = points[i][2], w = points[i][3];
+      float gx = x, gy = y, gz = z, gw = w;
+
+      cogl_matrix_transform_point (matrix, &x, &y, &z, &w);
+      cogl_matrix_transform_point (&general, &gx, &gy, &gz, &gw);
+
+      g_assert_cmpfloat (fabsf (x - gx), <, 0.0001f);
+      g_assert_cmpfloat (fabsf (y - gy), <, 0.0001f);
+      g_assert_cmpfloat (fabsf (z - gz), <, 0.0001f);
+      g_assert_cmpfloat (fabsf (w - gw), <, 0.0001f);
+    }
+}
+
+static void
+check_multiply (const CoglMatrix *a, const CoglMatrix *b)
+{
+  CoglMatrix general_a, general_b;
+  CoglMatrix result, general_result;
+
+  make_general (&general_a, a);
+  make_general (&general_b, b);
+
+  cogl_matrix_multiply (&result, a, b);
+  cogl_matrix_multiply (&general_result, &general_a, &general_b);
+  assert_matrices_equal (&result, &general_result);
+  check_transform_point (&result);
+
+  /* The result can also be one of the operands */
+  result = *a;
+  cogl_matrix_multiply (&result, &result, b);
+  assert_matrices_equal (&result, &general_result);
+
+  result = *b;
+  cogl_matrix_multiply (&result, a, &result);
+  assert_matrices_equal (&result, &general_result);
+}
+
+void
+test_cogl_matrix (TestConformSimpleFixture *fixture,
+                  gconstpointer data)
+{
+  CoglMatrix matrices[5];
+  int i, j;
+
+  cogl_matrix_init_identity (&matrices[0]);
+
+  cogl_matrix_init_identity (&matrices[1]);
+  cogl_matrix_translate (&matrices[1], 10, 20, 30);
+
+  cogl_matrix_init_identity (&matrices[2]);
+  cogl_matrix_translate (&matrices[2], 5, 6, 0);
+  cogl_matrix_scale (&matrices[2], 2, 3, 1);
+
+  cogl_matrix_init_identity (&matrices[3]);
+  cogl_matrix_translate (&matrices[3], 1, 2, 3);
+  cogl_matrix_rotate (&matrices[3], 30, 0, 0, 1);
+  cogl_matrix_rotate (&matrices[3], 45, 1, 0, 0);
+
+  cogl_matrix_init_identity (&matrices[4]);
+  cogl_matrix_perspective (&matrices[4], 60, 1.5, 0.1, 100);
+  cogl_matrix_translate (&matrices[4], -1, -2, -30);
+
+  for (i = 0; i < G_N_ELEMENTS (matrices); i++)
+    {
+      check_transform_point (&matrices[i]);
+
+      for (j = 0; j < G_N_ELEMENTS (matrices); j++)
+        check_multiply (&matrices[i], &matrices[j]);
+    }
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -11,10 +11,15 @@
 static const ClutterColor stage_color = { 0x0, 0x0, 0x0, 0xff };
 static const ClutterColor block_color = { 0xff, 0xff, 0xff, 0xff };
 
+/* Number of frames to keep drawing the async path for. The master
+   clock picks up the tesselation from the thread between frames */
+#define N_ASYNC_FRAMES 10
+
 typedef struct _TestState
 {
   ClutterActor *stage;
   guint frame;
+  CoglHandle async_path;
 } TestState;
 
 static void
@@ -66,15 +71,10 @@ verify_block (int block_x, int block_y, int block_mask)
 }
 
 static void
-on_paint (ClutterActor *actor, TestState *state)
+draw_paths (void)
 {
   CoglHandle path_a, path_b, path_c;
 
-  if (state->frame++ < 2)
-    return;
-
-  cogl_set_source_color4ub (255, 255, 255, 255);
-
   /* Create a path filling just a quarter of a block. It will use two
      rectangles so that we have a sub path in the path */
   cogl_path_new ();
@@ -129,7 +129,6 @@ on_paint (ClutterActor *actor, TestState *state)
   draw_path_at (7, 0);
 
   cogl_handle_unref (path_a);
-  cogl_handle_unref (path_b);
   cogl_handle_unref (path_c);
 
   /* Draw a self-intersecting path. The part that intersects should be
@@ -176,6 +175,75 @@ on_paint (ClutterActor *actor, TestState *state)
 
   cogl_handle_unref (path_a);
 
+  /* Build the same path as path b again from scratch. This should
+     share the tesselation from the cache */
+  cogl_path_rectangle (0, 0, BLOCK_SIZE, BLOCK_SIZE);
+  draw_path_at (12, 0);
+
+  /* Changing the fill rule of a copy of path b and then changing it
+     back gives the copy its own nodes without a tesselation. It
+     should find the same one in the cache when it is drawn */
+  path_c = cogl_path_copy (path_b);
+  cogl_set_path (path_c);
+  cogl_path_set_fill_rule (COGL_PATH_FILL_RULE_NON_ZERO);
+  cogl_path_set_fill_rule (COGL_PATH_FILL_RULE_EVEN_ODD);
+  draw_path_at (13, 0);
+  cogl_handle_unref (path_c);
+
+  cogl_handle_unref (path_b);
+}
+
+static void
+draw_async_paths (TestState *state)
+{
+  cogl_set_async_path_fill_enabled (TRUE);
+
+  /* Fill a new path with async tesselation. In the first frame it is
+     drawn with a fallback that still gives the right result. Once the
+     thread has finished the master clock uploads the tesselation and
+     the later frames draw the same path with it */
+  if (state->async_path == COGL_INVALID_HANDLE)
+    {
+      cogl_path_new ();
+      cogl_path_rectangle (BLOCK_SIZE / 2, BLOCK_SIZE / 2,
+                           BLOCK_SIZE, BLOCK_SIZE);
+      cogl_path_rectangle (0, 0, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+      state->async_path = cogl_handle_ref (cogl_get_path ());
+    }
+
+  cogl_set_path (state->async_path);
+  draw_path_at (14, 0);
+  cogl_set_path (state->async_path);
+  draw_path_at (15, 0);
+
+  /* With the non-zero rule the stencil buffer can't be used as a
+     fallback so the path is tesselated straight away even though a
+     job is queued for the thread. The two rectangles overlap in the
+     top left quadrant which would be left empty with the even-odd
+     rule */
+  cogl_path_new ();
+  cogl_path_set_fill_rule (COGL_PATH_FILL_RULE_NON_ZERO);
+  cogl_path_rectangle (0, 0, BLOCK_SIZE, BLOCK_SIZE / 2);
+  cogl_path_rectangle (0, 0, BLOCK_SIZE / 2, BLOCK_SIZE);
+  draw_path_at (16, 0);
+
+  cogl_set_async_path_fill_enabled (FALSE);
+}
+
+static void
+on_paint (ClutterActor *actor, TestState *state)
+{
+  if (state->frame++ < 2)
+    return;
+
+  cogl_set_source_color4ub (255, 255, 255, 255);
+
+  draw_paths ();
+  draw_async_paths (state);
+
+  if (g_test_verbose ())
+    g_print ("Checking frame %u\n", state->frame);
+
   verify_block (0, 0, 0x8 /* bottom right */);
   verify_block (1, 0, 0xf /* all of them */);
   verify_block (2, 0, 0x8 /* bottom right */);
@@ -188,11 +256,19 @@ on_paint (ClutterActor *actor, TestState *state)
   verify_block (9, 0, 0x7 /* all but bottom right */);
   verify_block (10, 0, 0xc /* bottom two */);
   verify_block (11, 0, 0xd /* all but top right */);
-
-  /* Comment this out if you want visual feedback of what this test
+  verify_block (12, 0, 0xf /* all of them */);
+  verify_block (13, 0, 0xf /* all of them */);
+  verify_block (14, 0, 0x9 /* top left and bottom right */);
+  verify_block (15, 0, 0x9 /* top left and bottom right */);
+  verify_block (16, 0, 0x7 /* all but bottom right */);
+
+  /* Keep drawing until the async tesselation has had time to finish
+   * so that both the fallback and the tesselation are checked.
+   * Comment this out if you want visual feedback of what this test
    * paints.
    */
-  clutter_main_quit ();
+  if (state->frame >= 2 + N_ASYNC_FRAMES)
+    clutter_main_quit ();
 }
 
 static gboolean
@@ -212,6 +288,7 @@ test_cogl_path (TestConformSimpleFixture *fixture,
   unsigned int paint_handler;
 
   state.frame = 0;
+  state.async_path = COGL_INVALID_HANDLE;
   state.stage = clutter_stage_get_default ();
   clutter_stage_set_color (CLUTTER_STAGE (state.stage), &stage_color);
 
@@ -228,6 +305,8 @@ test_cogl_path (TestConformSimpleFixture *fixture,
   g_signal_handler_disconnect (state.stage, paint_handler);
   g_source_remove (idle_source);
 
+  cogl_handle_unref (state.async_path);
+
   if (g_test_verbose ())
     g_print ("OK\n");
 }
@@ -0,0 +1,279 @@
+#include "config.h"
+
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+/* Cogl remembers the programs it generates in the directory given by
+   COGL_PROGRAM_CACHE_DIR, which the test harness points at an empty
+   temporary directory. New programs are written from an idle handler
+   so this checks that nothing is written while painting, not even by
+   cogl_flush(), and that the files appear once the main loop is
+   idle */
+
+static const ClutterColor stage_color = { 0x0, 0x0, 0x0, 0xff };
+
+#define QUAD_SIZE 10
+
+#define CACHE_SUFFIX ".cogl-program"
+#define CACHE_MAGIC  "CoglPrg"
+
+/* This must match the header written by
+   _cogl_program_cache_write_entry() in cogl-program-cache.c */
+typedef struct _CacheHeader
+{
+  char    magic[8];
+  guint32 version;
+  guint32 type;
+  guint32 binary_format;
+  guint32 source_length;
+  guint32 binary_length;
+} CacheHeader;
+
+typedef struct _TestState
+{
+  const gchar *dir;
+  CoglHandle texture;
+  gboolean painted;
+  gboolean arbfp;
+  int n_files;
+} TestState;
+
+static void
+check_cache_file (const gchar *filename)
+{
+  const CacheHeader *header;
+  GError *error = NULL;
+  gchar *contents;
+  gsize length;
+
+  if (g_test_verbose ())
+    g_print ("Checking %s\n", filename);
+
+  g_assert (g_file_get_contents (filename, &contents, &length, &error));
+  g_assert_no_error (error);
+
+  header = (const CacheHeader *) contents;
+  g_assert_cmpint (length, >=, sizeof (CacheHeader));
+  g_assert (memcmp (header->magic, CACHE_MAGIC, sizeof (header->magic)) == 0);
+  g_assert_cmpint (header->source_length, >, 0);
+  g_assert_cmpint (length, ==, (sizeof (CacheHeader) +
+                                header->source_length +
+                                header->binary_length));
+
+  g_free (contents);
+}
+
+/* The files are in a subdirectory for each GL driver so this counts
+   the files in the subdirectories too */
+static int
+count_cache_files (const gchar *path)
+{
+  const gchar *name;
+  int n_files = 0;
+  GDir *dir;
+
+  if ((dir = g_dir_open (path, 0, NULL)) == NULL)
+    return 0;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *filename = g_build_filename (path, name, NULL);
+
+      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+        n_files += count_cache_files (filename);
+      else if (g_str_has_suffix (name, CACHE_SUFFIX))
+        {
+          check_cache_file (filename);
+          n_files++;
+        }
+
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+
+  return n_files;
+}
+
+/* Only the ARBfp backend puts programs in the cache */
+static gboolean
+uses_arbfp (void)
+{
+#ifdef HAVE_COGL_GL
+  const char *extensions = (const char *) glGetString (GL_EXTENSIONS);
+
+  return (cogl_check_extension ("GL_ARB_fragment_program", extensions) &&
+          !(cogl_debug_flags & COGL_DEBUG_DISABLE_ARBFP));
+#else
+  return FALSE;
+#endif
+}
+
+static CoglMaterial *
+make_material (TestState *state,
+               guint8 red,
+               guint8 green,
+               guint8 blue)
+{
+  CoglMaterial *material = cogl_material_new ();
+  CoglColor constant;
+  GError *error = NULL;
+
+  cogl_material_set_layer (material, 0, state->texture);
+  g_assert (cogl_material_set_layer_combine (material, 0,
+                                             "RGBA = MODULATE (TEXTURE, "
+                                             "CONSTANT)",
+                                             &error));
+  g_assert_no_error (error);
+  cogl_color_set_from_4ub (&constant, red, green, blue, 0xff);
+  cogl_material_set_layer_combine_constant (material, 0, &constant);
+
+  return material;
+}
+
+static void
+draw_material (CoglMaterial *material,
+               int x)
+{
+  cogl_set_source (material);
+  cogl_rectangle (x * QUAD_SIZE, 0, (x + 1) * QUAD_SIZE, QUAD_SIZE);
+}
+
+static void
+check_pixel (int x,
+             guint8 red,
+             guint8 green,
+             guint8 blue)
+{
+  guint8 pixel[4];
+
+  cogl_read_pixels (x * QUAD_SIZE + QUAD_SIZE / 2, QUAD_SIZE / 2, 1, 1,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixel);
+
+  if (g_test_verbose ())
+    g_print ("  pixel %i = %02x%02x%02x, expected %02x%02x%02x\n",
+             x, pixel[0], pixel[1], pixel[2], red, green, blue);
+
+  g_assert_cmpint (ABS (pixel[0] - red), <=, 1);
+  g_assert_cmpint (ABS (pixel[1] - green), <=, 1);
+  g_assert_cmpint (ABS (pixel[2] - blue), <=, 1);
+}
+
+/* The constants are chosen so that no other test is likely to have
+   generated the same programs already. Otherwise they wouldn't be
+   added to the cache */
+static void
+draw_materials (TestState *state)
+{
+  CoglMaterial *first, *same, *different;
+
+  /* Two materials with the same state should share a program */
+  first = make_material (state, 0x12, 0xfe, 0x34);
+  same = make_material (state, 0x12, 0xfe, 0x34);
+  different = make_material (state, 0xfe, 0x12, 0x34);
+
+  draw_material (first, 0);
+  draw_material (same, 1);
+  draw_material (different, 2);
+
+  cogl_flush ();
+
+  check_pixel (0, 0x12, 0xfe, 0x34);
+  check_pixel (1, 0x12, 0xfe, 0x34);
+  check_pixel (2, 0xfe, 0x12, 0x34);
+
+  cogl_object_unref (first);
+  cogl_object_unref (same);
+  cogl_object_unref (different);
+}
+
+static gboolean
+check_files_idle (gpointer user_data)
+{
+  TestState *state = user_data;
+  int n_files = count_cache_files (state->dir);
+
+  if (g_test_verbose ())
+    g_print ("%i programs were written to the cache\n",
+             n_files - state->n_files);
+
+  /* The first two materials share a program so there should be one
+     for each of the different materials */
+  if (state->arbfp)
+    g_assert_cmpint (n_files, ==, state->n_files + 2);
+
+  clutter_main_quit ();
+
+  return FALSE;
+}
+
+static void
+paint_cb (ClutterActor *stage,
+          TestState *state)
+{
+  if (state->painted)
+    return;
+
+  state->painted = TRUE;
+  state->arbfp = uses_arbfp ();
+  state->n_files = count_cache_files (state->dir);
+
+  draw_materials (state);
+
+  /* Nothing should be written while painting, even though the
+     programs were generated when the journal was flushed */
+  g_assert_cmpint (count_cache_files (state->dir), ==, state->n_files);
+
+  /* Cogl writes the files from an idle handler with a low priority so
+     this is dispatched after it */
+  g_idle_add_full (G_PRIORITY_LOW + 10, check_files_idle, state, NULL);
+}
+
+void
+test_cogl_program_cache (TestConformSimpleFixture *fixture,
+                         gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  guint paint_handler;
+  guint8 white[4] = { 0xff, 0xff, 0xff, 0xff };
+
+  state.dir = g_getenv ("COGL_PROGRAM_CACHE_DIR");
+
+  if (state.dir == NULL ||
+      (cogl_debug_flags & COGL_DEBUG_DISABLE_PROGRAM_CACHE))
+    {
+      if (g_test_verbose ())
+        g_print ("The program cache is disabled\n");
+      return;
+    }
+
+  state.painted = FALSE;
+  state.texture = cogl_texture_new_from_data (1, 1,
+                                              COGL_TEXTURE_NO_ATLAS,
+                                              COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                              COGL_PIXEL_FORMAT_ANY,
+                                              4, white);
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  cogl_handle_unref (state.texture);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,174 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+static const ClutterColor quadrant_colors[] =
+  {
+    { 0xff, 0x00, 0x00, 0xff }, /* red, top left */
+    { 0x00, 0xff, 0x00, 0xff }, /* green, top right */
+    { 0x00, 0x00, 0xff, 0xff }, /* blue, bottom left */
+    { 0xff, 0xff, 0xff, 0xff }  /* white, bottom right */
+  };
+
+/* Number of reads which should call the callback */
+#define N_READS 3
+
+typedef struct _TestState
+{
+  int n_reads;
+  int n_notified;
+} TestState;
+
+static void
+check_pixel (const guchar *pixels,
+             int rowstride,
+             int x,
+             int y,
+             const ClutterColor *color)
+{
+  const guchar *p = pixels + y * rowstride + x * 4;
+
+  if (g_test_verbose ())
+    g_print ("(%i, %i) = %02x%02x%02x, expected %02x%02x%02x\n",
+             x, y,
+             p[0], p[1], p[2],
+             color->red, color->green, color->blue);
+
+  g_assert_cmpint (p[0], ==, color->red);
+  g_assert_cmpint (p[1], ==, color->green);
+  g_assert_cmpint (p[2], ==, color->blue);
+}
+
+/* Checks that each quadrant of the pixels has the right color, which
+   also verifies that the rows are not upside down */
+static void
+read_cb (ClutterStage *stage,
+         const guchar *pixels,
+         gint width,
+         gint height,
+         gpointer user_data)
+{
+  TestState *state = user_data;
+
+  check_pixel (pixels, width * 4, 0, 0, quadrant_colors + 0);
+  check_pixel (pixels, width * 4, width - 1, 0, quadrant_colors + 1);
+  check_pixel (pixels, width * 4, 0, height - 1, quadrant_colors + 2);
+  check_pixel (pixels, width * 4, width - 1, height - 1, quadrant_colors + 3);
+
+  if (++state->n_reads == N_READS)
+    clutter_main_quit ();
+}
+
+/* The rectangle that goes past the right edge of the stage is clipped
+   so only the two columns on the stage are given */
+static void
+clipped_read_cb (ClutterStage *stage,
+                 const guchar *pixels,
+                 gint width,
+                 gint height,
+                 gpointer user_data)
+{
+  TestState *state = user_data;
+
+  g_assert_cmpint (width, ==, 2);
+  g_assert_cmpint (height, ==, 4);
+
+  check_pixel (pixels, width * 4, 0, 0, quadrant_colors + 1);
+  check_pixel (pixels, width * 4, 1, 3, quadrant_colors + 3);
+
+  if (++state->n_reads == N_READS)
+    clutter_main_quit ();
+}
+
+static void
+outside_read_cb (ClutterStage *stage,
+                 const guchar *pixels,
+                 gint width,
+                 gint height,
+                 gpointer user_data)
+{
+  /* Reads starting outside of the stage fail */
+  g_assert_not_reached ();
+}
+
+static void
+read_notify (gpointer user_data)
+{
+  TestState *state = user_data;
+
+  state->n_notified++;
+}
+
+void
+test_cogl_readpixels_async (TestConformSimpleFixture *fixture,
+                            gconstpointer data)
+{
+  TestState state = { 0, 0 };
+  ClutterActor *stage;
+  gfloat stage_width, stage_height;
+  int i;
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+  clutter_actor_get_size (stage, &stage_width, &stage_height);
+
+  for (i = 0; i < G_N_ELEMENTS (quadrant_colors); i++)
+    {
+      ClutterActor *rect = clutter_rectangle_new_with_color (quadrant_colors
+                                                             + i);
+
+      clutter_actor_set_position (rect,
+                                  (i & 1) * stage_width / 2,
+                                  (i >> 1) * stage_height / 2);
+      clutter_actor_set_size (rect, stage_width / 2, stage_height / 2);
+      clutter_container_add_actor (CLUTTER_CONTAINER (stage), rect);
+    }
+
+  clutter_actor_show (stage);
+
+  /* The whole stage */
+  clutter_stage_read_pixels_async (CLUTTER_STAGE (stage),
+                                   0, 0, -1, -1,
+                                   read_cb,
+                                   &state,
+                                   read_notify);
+  /* A small rectangle straddling the four quadrants */
+  clutter_stage_read_pixels_async (CLUTTER_STAGE (stage),
+                                   stage_width / 2 - 2,
+                                   stage_height / 2 - 2,
+                                   4, 4,
+                                   read_cb,
+                                   &state,
+                                   read_notify);
+  /* A rectangle going past the right edge of the stage */
+  clutter_stage_read_pixels_async (CLUTTER_STAGE (stage),
+                                   stage_width - 2,
+                                   stage_height / 2 - 2,
+                                   100, 4,
+                                   clipped_read_cb,
+                                   &state,
+                                   read_notify);
+  /* A rectangle entirely outside of the stage */
+  clutter_stage_read_pixels_async (CLUTTER_STAGE (stage),
+                                   stage_width, 0,
+                                   10, 10,
+                                   outside_read_cb,
+                                   &state,
+                                   read_notify);
+
+  clutter_main ();
+
+  g_assert_cmpint (state.n_reads, ==, N_READS);
+  g_assert_cmpint (state.n_notified, ==, N_READS + 1);
+
+  /* Remove all of the actors from the stage */
+  clutter_container_foreach (CLUTTER_CONTAINER (stage),
+                             (ClutterCallback) clutter_actor_destroy,
+                             NULL);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
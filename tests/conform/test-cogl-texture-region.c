@@ -0,0 +1,216 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "test-conform-common.h"
+
+/* Uploads parts of a bitmap to textures with
+   cogl_texture_set_region_from_bitmap() and checks the result */
+
+#define BITMAP_WIDTH  64
+#define BITMAP_HEIGHT 48
+
+#define SMALL_SIZE 16
+
+/* The region of the bitmap copied over the small texture */
+#define REGION_SRC_X  40
+#define REGION_SRC_Y  30
+#define REGION_DST_X  3
+#define REGION_DST_Y  4
+#define REGION_WIDTH  8
+#define REGION_HEIGHT 6
+
+typedef struct _TestState
+{
+  CoglBitmap *bitmap;
+} TestState;
+
+static guint8
+test_component (int x, int y, int component)
+{
+  return (x * 5 + y * 37 + component * 83) & 0xff;
+}
+
+static guint8 *
+make_bitmap_data (void)
+{
+  guint8 *data = g_malloc (BITMAP_WIDTH * BITMAP_HEIGHT * 3), *p = data;
+  int x, y, i;
+
+  for (y = 0; y < BITMAP_HEIGHT; y++)
+    for (x = 0; x < BITMAP_WIDTH; x++)
+      for (i = 0; i < 3; i++)
+        *(p++) = test_component (x, y, i);
+
+  return data;
+}
+
+static void
+check_pixel (const guint8 *p,
+             int x, int y,
+             int bitmap_x, int bitmap_y)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    if (p[i] != test_component (bitmap_x, bitmap_y, i))
+      {
+        g_print ("pixel %i,%i component %i is 0x%02x, expected 0x%02x\n",
+                 x, y, i, p[i], test_component (bitmap_x, bitmap_y, i));
+        g_assert_not_reached ();
+      }
+
+  g_assert_cmpint (p[3], ==, 0xff);
+}
+
+/* Uploads the whole bitmap in two halves, bottom half first */
+static void
+check_halves (TestState *state)
+{
+  CoglHandle tex;
+  guint8 *data;
+  int x, y;
+
+  if (g_test_verbose ())
+    g_print ("Uploading the bitmap in two halves\n");
+
+  tex = cogl_texture_new_with_size (BITMAP_WIDTH, BITMAP_HEIGHT,
+                                    COGL_TEXTURE_NO_ATLAS,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+  g_assert (cogl_texture_set_region_from_bitmap (tex,
+                                                 0, BITMAP_HEIGHT / 2,
+                                                 0, BITMAP_HEIGHT / 2,
+                                                 BITMAP_WIDTH,
+                                                 BITMAP_HEIGHT / 2,
+                                                 state->bitmap));
+  g_assert (cogl_texture_set_region_from_bitmap (tex,
+                                                 0, 0,
+                                                 0, 0,
+                                                 BITMAP_WIDTH,
+                                                 BITMAP_HEIGHT / 2,
+                                                 state->bitmap));
+
+  data = g_malloc (BITMAP_WIDTH * BITMAP_HEIGHT * 4);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888,
+                         BITMAP_WIDTH * 4, data);
+
+  for (y = 0; y < BITMAP_HEIGHT; y++)
+    for (x = 0; x < BITMAP_WIDTH; x++)
+      check_pixel (data + (y * BITMAP_WIDTH + x) * 4, x, y, x, y);
+
+  g_free (data);
+  cogl_handle_unref (tex);
+}
+
+/* Copies a region of the bitmap to a different position in a
+   texture smaller than the bitmap */
+static void
+check_offset_region (TestState *state)
+{
+  CoglHandle tex;
+  guint8 *data;
+  int x, y;
+
+  if (g_test_verbose ())
+    g_print ("Uploading a region of the bitmap at an offset\n");
+
+  tex = cogl_texture_new_with_size (SMALL_SIZE, SMALL_SIZE,
+                                    COGL_TEXTURE_NO_ATLAS,
+                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+  g_assert (cogl_texture_set_region_from_bitmap (tex,
+                                                 0, 0,
+                                                 0, 0,
+                                                 SMALL_SIZE, SMALL_SIZE,
+                                                 state->bitmap));
+  g_assert (cogl_texture_set_region_from_bitmap (tex,
+                                                 REGION_SRC_X,
+                                                 REGION_SRC_Y,
+                                                 REGION_DST_X,
+                                                 REGION_DST_Y,
+                                                 REGION_WIDTH,
+                                                 REGION_HEIGHT,
+                                                 state->bitmap));
+
+  data = g_malloc (SMALL_SIZE * SMALL_SIZE * 4);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888,
+                         SMALL_SIZE * 4, data);
+
+  for (y = 0; y < SMALL_SIZE; y++)
+    for (x = 0; x < SMALL_SIZE; x++)
+      {
+        const guint8 *p = data + (y * SMALL_SIZE + x) * 4;
+
+        if (x >= REGION_DST_X && x < REGION_DST_X + REGION_WIDTH &&
+            y >= REGION_DST_Y && y < REGION_DST_Y + REGION_HEIGHT)
+          check_pixel (p, x, y,
+                       x - REGION_DST_X + REGION_SRC_X,
+                       y - REGION_DST_Y + REGION_SRC_Y);
+        else
+          check_pixel (p, x, y, x, y);
+      }
+
+  g_free (data);
+  cogl_handle_unref (tex);
+}
+
+static void
+paint_cb (ClutterActor *stage,
+          TestState *state)
+{
+  check_halves (state);
+  check_offset_region (state);
+
+  clutter_main_quit ();
+}
+
+void
+test_cogl_texture_region (TestConformSimpleFixture *fixture,
+                          gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  GError *error = NULL;
+  guint8 *bitmap_data;
+  gchar *filename;
+  guint paint_handler;
+
+  bitmap_data = make_bitmap_data ();
+  filename = clutter_test_write_bmp_file (BITMAP_WIDTH, BITMAP_HEIGHT,
+                                          bitmap_data);
+  g_free (bitmap_data);
+
+  state.bitmap = cogl_bitmap_new_from_file (filename, &error);
+  g_assert_no_error (error);
+  g_assert (state.bitmap != NULL);
+
+  g_unlink (filename);
+  g_free (filename);
+
+  g_assert_cmpint (cogl_bitmap_get_width (state.bitmap), ==, BITMAP_WIDTH);
+  g_assert_cmpint (cogl_bitmap_get_height (state.bitmap), ==, BITMAP_HEIGHT);
+  /* The image has no alpha channel */
+  g_assert_cmpint (cogl_bitmap_get_format (state.bitmap),
+                   ==,
+                   COGL_PIXEL_FORMAT_RGB_888);
+
+  /* The textures are created in the paint handler so that there is a
+     context */
+  stage = clutter_stage_get_default ();
+
+  paint_handler = g_signal_connect_after (stage, "paint",
+                                          G_CALLBACK (paint_cb), &state);
+
+  clutter_actor_show (stage);
+
+  clutter_main ();
+
+  g_signal_handler_disconnect (stage, paint_handler);
+
+  cogl_handle_unref (state.bitmap);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -25,3 +25,6 @@ void test_conform_simple_fixture_teardown (TestConformSimpleFixture *fixture,
 					   gconstpointer data);
 
 gchar *clutter_test_get_data_file (const gchar *filename);
+gchar *clutter_test_write_bmp_file (gint          width,
+                                    gint          height,
+                                    const guint8 *data);
@@ -3,8 +3,12 @@
 #include <clutter/clutter.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <locale.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "test-conform-common.h"
 
@@ -17,6 +21,9 @@ test_conform_skip_test (TestConformSimpleFixture *fixture,
 
 static TestConformSharedState *shared_state = NULL;
 
+/* The directory the tests cache their programs in, if we picked it */
+static gchar *program_cache_dir = NULL;
+
 /* This is a bit of sugar for adding new conformance tests:
  *
  * - It adds an extern function definition just to save maintaining a header
@@ -65,6 +72,104 @@ clutter_test_get_data_file (const gchar *filename)
   return g_build_filename (TESTS_DATADIR, filename, NULL);
 }
 
+static void
+put_le32 (guint8 *p,
+          guint32 value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+/* Writes an uncompressed 24-bit BMP file so that tests can use images
+ * of any size. The data is tightly packed RGB, top row first. The
+ * returned file name should be unlinked and freed by the caller.
+ */
+gchar *
+clutter_test_write_bmp_file (gint          width,
+                             gint          height,
+                             const guint8 *data)
+{
+  gint row_size = (width * 3 + 3) & ~3;
+  guint8 header[54], *row;
+  GError *error = NULL;
+  gchar *filename;
+  FILE *file;
+  gint fd, x, y;
+
+  memset (header, 0, sizeof (header));
+
+  /* BITMAPFILEHEADER */
+  header[0] = 'B';
+  header[1] = 'M';
+  put_le32 (header + 2, sizeof (header) + row_size * height);
+  put_le32 (header + 10, sizeof (header));
+
+  /* BITMAPINFOHEADER */
+  put_le32 (header + 14, 40);
+  put_le32 (header + 18, width);
+  put_le32 (header + 22, height);
+  header[26] = 1; /* planes */
+  header[28] = 24; /* bits per pixel */
+  put_le32 (header + 34, row_size * height);
+
+  fd = g_file_open_tmp ("clutter-test-XXXXXX.bmp", &filename, &error);
+  g_assert_no_error (error);
+  file = fdopen (fd, "wb");
+  g_assert (file != NULL);
+
+  g_assert (fwrite (header, sizeof (header), 1, file) == 1);
+
+  row = g_malloc0 (row_size);
+
+  /* The rows are stored bottom up and the pixels in BGR order */
+  for (y = height - 1; y >= 0; y--)
+    {
+      const guint8 *src = data + y * width * 3;
+
+      for (x = 0; x < width; x++, src += 3)
+        {
+          row[x * 3 + 0] = src[2];
+          row[x * 3 + 1] = src[1];
+          row[x * 3 + 2] = src[0];
+        }
+
+      g_assert (fwrite (row, row_size, 1, file) == 1);
+    }
+
+  g_free (row);
+  g_assert (fclose (file) == 0);
+
+  return filename;
+}
+
+static void
+remove_directory (const gchar *path)
+{
+  const gchar *name;
+  GDir *dir;
+
+  if ((dir = g_dir_open (path, 0, NULL)) != NULL)
+    {
+      while ((name = g_dir_read_name (dir)))
+        {
+          gchar *child = g_build_filename (path, name, NULL);
+
+          if (g_file_test (child, G_FILE_TEST_IS_DIR))
+            remove_directory (child);
+          else
+            g_unlink (child);
+
+          g_free (child);
+        }
+
+      g_dir_close (dir);
+    }
+
+  g_rmdir (path);
+}
+
 static void
 clutter_test_init (gint    *argc,
                    gchar ***argv)
@@ -88,6 +193,26 @@ clutter_test_init (gint    *argc,
    */
   g_setenv ("CLUTTER_VBLANK", "none", FALSE);
 
+  /* Keep the programs generated by the tests out of the user's
+   * program cache. The directory is removed once the tests have run.
+   */
+  if (g_getenv ("COGL_PROGRAM_CACHE_DIR") == NULL)
+    {
+      gchar *basename = g_strdup_printf ("clutter-conform-programs-%i",
+                                         (int) getpid ());
+
+      program_cache_dir = g_build_filename (g_get_tmp_dir (), basename, NULL);
+      g_setenv ("COGL_PROGRAM_CACHE_DIR", program_cache_dir, TRUE);
+
+      g_free (basename);
+    }
+
+  /* The asynchronous code paths (such as the text layout threads) are
+   * only used if threads are enabled.
+   */
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
   g_test_init (argc, argv, NULL);
 
   g_test_bug_base ("http://bugzilla.openedhand.com/show_bug.cgi?id=%s");
@@ -105,6 +230,8 @@ clutter_test_init (gint    *argc,
 int
 main (int argc, char **argv)
 {
+  int ret;
+
   clutter_test_init (&argc, &argv);
 
   TEST_CONFORM_SIMPLE ("/timeline", test_timeline);
@@ -125,8 +252,11 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/text", test_text_cursor);
   TEST_CONFORM_SIMPLE ("/text", test_text_event);
   TEST_CONFORM_SIMPLE ("/text", test_text_get_chars);
+  TEST_CONFORM_SIMPLE ("/text", test_text_long_get_chars);
   TEST_CONFORM_SIMPLE ("/text", test_text_cache);
+  TEST_CONFORM_SIMPLE ("/text", test_text_layout_async);
   TEST_CONFORM_SIMPLE ("/text", test_text_password_char);
+  TEST_CONFORM_SIMPLE ("/text", test_text_distance_field);
 
   TEST_CONFORM_SIMPLE ("/rectangle", test_rect_set_size);
   TEST_CONFORM_SIMPLE ("/rectangle", test_rect_set_color);
@@ -146,8 +276,13 @@ main (int argc, char **argv)
 
   TEST_CONFORM_SIMPLE ("/texture", test_texture_pick_with_alpha);
   TEST_CONFORM_SIMPLE ("/texture", test_texture_fbo);
+  TEST_CONFORM_SIMPLE ("/texture", test_texture_cache);
+  TEST_CONFORM_SIMPLE ("/texture", test_texture_async);
   TEST_CONFORM_SIMPLE ("/texture/cairo", test_clutter_cairo_texture);
 
+  TEST_CONFORM_SIMPLE ("/stage", test_stage_capture);
+  TEST_CONFORM_SIMPLE ("/stage", test_stage_warm_up);
+
   TEST_CONFORM_SIMPLE ("/path", test_path);
 
   TEST_CONFORM_SIMPLE ("/binding-pool", test_binding_pool);
@@ -192,13 +327,19 @@ main (int argc, char **argv)
 
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_object);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_fixed);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_matrix);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_backface_culling);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_materials);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_material_hash);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_blend_strings);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_premult);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_readpixels);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_readpixels_async);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_path);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_depth_test);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_gl_state);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_clip);
+  TEST_CONFORM_SIMPLE ("/cogl", test_cogl_program_cache);
 
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_npot_texture);
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_multitexture);
@@ -210,6 +351,14 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_wrap_modes);
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_texture_pixmap_x11);
   TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_texture_get_set_data);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_conversion);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_parallel);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_loader);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_cache);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_upload);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_texture_region);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_bitmap_mipmaps);
+  TEST_CONFORM_SIMPLE ("/cogl/texture", test_cogl_atlas_pages);
 
   TEST_CONFORM_SIMPLE ("/cogl/vertex-buffer", test_cogl_vertex_buffer_contiguous);
   TEST_CONFORM_SIMPLE ("/cogl/vertex-buffer", test_cogl_vertex_buffer_interleved);
@@ -220,5 +369,13 @@ main (int argc, char **argv)
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_viewport);
   TEST_CONFORM_SIMPLE ("/cogl", test_cogl_offscreen);
 
-  return g_test_run ();
+  ret = g_test_run ();
+
+  if (program_cache_dir)
+    {
+      remove_directory (program_cache_dir);
+      g_free (program_cache_dir);
+    }
+
+  return ret;
 }
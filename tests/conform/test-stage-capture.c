@@ -0,0 +1,208 @@
+#include <clutter/clutter.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+static const ClutterColor quadrant_colors[] =
+  {
+    { 0xff, 0x00, 0x00, 0xff }, /* red, top left */
+    { 0x00, 0xff, 0x00, 0xff }, /* green, top right */
+    { 0x00, 0x00, 0xff, 0xff }, /* blue, bottom left */
+    { 0xff, 0xff, 0xff, 0xff }  /* white, bottom right */
+  };
+
+static const ClutterColor changed_color = { 0xff, 0xff, 0x00, 0xff };
+
+/* The maximum number of frames to wait for the change of color */
+#define MAX_FRAMES 10
+
+typedef struct _TestState
+{
+  /* Protected by the mutex, as the capture function is called from
+     another thread */
+  GMutex *mutex;
+  guchar *pixels;
+  gint width;
+  gint height;
+  gint rowstride;
+  ClutterGeometry damage;
+  int n_frames;
+
+  gboolean notified;
+} TestState;
+
+static gboolean
+quit_idle (gpointer user_data)
+{
+  clutter_main_quit ();
+
+  return FALSE;
+}
+
+static void
+capture_cb (ClutterStage          *stage,
+            const guchar          *pixels,
+            gint                   width,
+            gint                   height,
+            gint                   rowstride,
+            const ClutterGeometry *damage,
+            gpointer               user_data)
+{
+  TestState *state = user_data;
+
+  g_mutex_lock (state->mutex);
+
+  g_free (state->pixels);
+  state->pixels = g_memdup (pixels, rowstride * height);
+  state->width = width;
+  state->height = height;
+  state->rowstride = rowstride;
+  state->damage = *damage;
+  state->n_frames++;
+
+  g_mutex_unlock (state->mutex);
+
+  g_idle_add (quit_idle, state);
+}
+
+static void
+capture_notify (gpointer user_data)
+{
+  TestState *state = user_data;
+
+  state->notified = TRUE;
+}
+
+static gboolean
+check_pixel (TestState *state,
+             int x,
+             int y,
+             const ClutterColor *color)
+{
+  const guchar *p = state->pixels + y * state->rowstride + x * 3;
+
+  if (g_test_verbose ())
+    g_print ("(%i, %i) = %02x%02x%02x, expected %02x%02x%02x\n",
+             x, y,
+             p[0], p[1], p[2],
+             color->red, color->green, color->blue);
+
+  return (p[0] == color->red &&
+          p[1] == color->green &&
+          p[2] == color->blue);
+}
+
+/* Checks the center of each quadrant, which is scaled down to half
+   the size of the stage */
+static void
+check_quadrants (TestState *state,
+                 const ClutterColor *top_left)
+{
+  g_assert_cmpint (state->width, ==, state->rowstride / 3);
+
+  g_assert (check_pixel (state, state->width / 4, state->height / 4,
+                         top_left));
+  g_assert (check_pixel (state, state->width * 3 / 4, state->height / 4,
+                         quadrant_colors + 1));
+  g_assert (check_pixel (state, state->width / 4, state->height * 3 / 4,
+                         quadrant_colors + 2));
+  g_assert (check_pixel (state, state->width * 3 / 4, state->height * 3 / 4,
+                         quadrant_colors + 3));
+}
+
+void
+test_stage_capture (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage, *rects[G_N_ELEMENTS (quadrant_colors)];
+  gfloat stage_width, stage_height;
+  guint capture_id;
+  gboolean changed;
+  int i;
+
+  memset (&state, 0, sizeof (state));
+  state.mutex = g_mutex_new ();
+
+  stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+  clutter_actor_get_size (stage, &stage_width, &stage_height);
+
+  for (i = 0; i < G_N_ELEMENTS (quadrant_colors); i++)
+    {
+      rects[i] = clutter_rectangle_new_with_color (quadrant_colors + i);
+
+      clutter_actor_set_position (rects[i],
+                                  (i & 1) * stage_width / 2,
+                                  (i >> 1) * stage_height / 2);
+      clutter_actor_set_size (rects[i], stage_width / 2, stage_height / 2);
+      clutter_container_add_actor (CLUTTER_CONTAINER (stage), rects[i]);
+    }
+
+  clutter_actor_show (stage);
+
+  capture_id = clutter_stage_add_capture (CLUTTER_STAGE (stage),
+                                          COGL_PIXEL_FORMAT_RGB_888,
+                                          stage_width / 2,
+                                          stage_height / 2,
+                                          capture_cb,
+                                          &state,
+                                          capture_notify);
+  g_assert_cmpuint (capture_id, >, 0);
+
+  /* The first frame captures the whole stage */
+  clutter_main ();
+
+  g_mutex_lock (state.mutex);
+  g_assert_cmpint (state.n_frames, >, 0);
+  g_assert_cmpint (state.width, ==, (int) stage_width / 2);
+  g_assert_cmpint (state.height, ==, (int) stage_height / 2);
+  check_quadrants (&state, quadrant_colors + 0);
+  g_mutex_unlock (state.mutex);
+
+  /* Changing the color of one of the rectangles only repaints the
+     stage, and so captures a frame, once more */
+  clutter_rectangle_set_color (CLUTTER_RECTANGLE (rects[0]), &changed_color);
+
+  for (i = 0, changed = FALSE; i < MAX_FRAMES && !changed; i++)
+    {
+      clutter_main ();
+
+      g_mutex_lock (state.mutex);
+      changed = check_pixel (&state, state.width / 4, state.height / 4,
+                             &changed_color);
+      g_mutex_unlock (state.mutex);
+    }
+
+  g_assert (changed);
+
+  g_mutex_lock (state.mutex);
+  check_quadrants (&state, &changed_color);
+  /* The damage must at least cover the rectangle that changed */
+  g_assert_cmpint (state.damage.x, ==, 0);
+  g_assert_cmpint (state.damage.y, ==, 0);
+  g_assert_cmpint (state.damage.width, >=, state.width / 2);
+  g_assert_cmpint (state.damage.height, >=, state.height / 2);
+  g_mutex_unlock (state.mutex);
+
+  clutter_stage_remove_capture (CLUTTER_STAGE (stage), capture_id);
+  g_assert (state.notified);
+
+  /* Don't let the frames captured meanwhile quit the next test */
+  while (g_source_remove_by_user_data (&state))
+    ;
+
+  /* Remove all of the actors from the stage */
+  clutter_container_foreach (CLUTTER_CONTAINER (stage),
+                             (ClutterCallback) clutter_actor_destroy,
+                             NULL);
+
+  g_free (state.pixels);
+  if (state.mutex != NULL)
+    g_mutex_free (state.mutex);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
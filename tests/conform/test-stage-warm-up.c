@@ -0,0 +1,124 @@
+#include <clutter/clutter.h>
+
+#include "test-conform-common.h"
+
+static const ClutterColor rect_color = { 0x80, 0x40, 0x20, 0xff };
+
+static ClutterActor *
+make_scene (void)
+{
+  ClutterActor *group, *rect;
+
+  group = clutter_group_new ();
+
+  rect = clutter_rectangle_new_with_color (&rect_color);
+  clutter_actor_set_size (rect, 50, 50);
+  clutter_container_add_actor (CLUTTER_CONTAINER (group), rect);
+
+  /* An effect makes the scene use a program that isn't needed by
+     anything else on the stage */
+  rect = clutter_rectangle_new_with_color (&rect_color);
+  clutter_actor_set_size (rect, 50, 50);
+  clutter_actor_set_position (rect, 50, 0);
+  clutter_actor_add_effect (rect, clutter_desaturate_effect_new (0.5));
+  clutter_container_add_actor (CLUTTER_CONTAINER (group), rect);
+
+  return group;
+}
+
+static ClutterActor *
+make_effects_scene (int n_effects)
+{
+  ClutterActor *group, *rect;
+  int i;
+
+  group = clutter_group_new ();
+
+  for (i = 0; i < n_effects; i++)
+    {
+      rect = clutter_rectangle_new_with_color (&rect_color);
+      clutter_actor_set_size (rect, 50, 50);
+      clutter_actor_set_position (rect, i * 50, 50);
+      clutter_actor_add_effect (rect, clutter_desaturate_effect_new (0.5));
+      clutter_container_add_actor (CLUTTER_CONTAINER (group), rect);
+    }
+
+  return group;
+}
+
+static guint
+warm_up (ClutterActor *stage,
+         ClutterActor *actor)
+{
+  GArray *build_times;
+  guint n_programs, i;
+
+  n_programs = clutter_stage_warm_up (CLUTTER_STAGE (stage), actor,
+                                      &build_times);
+
+  if (g_test_verbose ())
+    g_print ("Built %u programs\n", n_programs);
+
+  g_assert (build_times != NULL);
+  g_assert_cmpint (build_times->len, ==, n_programs);
+  for (i = 0; i < build_times->len; i++)
+    g_assert (g_array_index (build_times, double, i) >= 0.0);
+  g_array_free (build_times, TRUE);
+
+  return n_programs;
+}
+
+void
+test_stage_warm_up (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  ClutterActor *stage, *group;
+  guint n_programs;
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_show (stage);
+
+  /* An actor without a parent is added to the stage for the duration
+     of the warm up */
+  group = make_scene ();
+  g_object_ref_sink (group);
+
+  /* The effect always needs a program of its own that hasn't been
+     built by anything else */
+  n_programs = warm_up (stage, group);
+  if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    g_assert_cmpint (n_programs, >, 0);
+
+  g_assert (clutter_actor_get_parent (group) == NULL);
+
+  /* Everything the scene needs has been built so warming it up again
+     shouldn't build anything */
+  n_programs = warm_up (stage, group);
+  g_assert_cmpint (n_programs, ==, 0);
+
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), group);
+
+  n_programs = clutter_stage_warm_up (CLUTTER_STAGE (stage), NULL, NULL);
+  g_assert_cmpint (n_programs, ==, 0);
+
+  clutter_actor_destroy (group);
+  g_object_unref (group);
+
+  /* Each effect creates its own program. Its vertex and fragment
+     shaders are compiled separately from the link but the log should
+     only count the program once. The materials used to paint the
+     effects have already been built above */
+  if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    {
+      group = make_effects_scene (2);
+      g_object_ref_sink (group);
+
+      n_programs = warm_up (stage, group);
+      g_assert_cmpint (n_programs, ==, 2);
+
+      g_object_unref (group);
+    }
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,240 @@
+#include <clutter/clutter.h>
+#include <cogl/cogl.h>
+#include <string.h>
+#include "pango/cogl-pango.h"
+
+#include "test-conform-common.h"
+
+static const ClutterColor stage_color = { 0x0, 0x0, 0x0, 0xff };
+
+/* The glyph is drawn at this scale so that a coverage glyph would be
+   visibly blurred */
+#define TEXT_SCALE 4
+
+/* The total coverage of the distance field glyph may differ from the
+   normal glyph by this fraction. The outline is reconstructed at a
+   different size so it won't be exactly the same */
+#define COVERAGE_TOLERANCE 0.2
+
+/* Paints the underline with a solid color so we can tell whether the
+   program survived drawing the glyphs */
+static const char user_shader_source[] =
+  "void\n"
+  "main ()\n"
+  "{\n"
+  "  gl_FragColor = vec4 (0.0, 1.0, 0.0, 1.0);\n"
+  "}\n";
+
+typedef struct _TestState
+{
+  ClutterActor *stage;
+  PangoLayout *layout;
+  CoglPangoFontMap *font_map;
+  int width, height;
+} TestState;
+
+typedef struct _Coverage
+{
+  /* Sum of the red channel over the area in units of a fully lit
+     pixel */
+  double total;
+  int n_lit, n_edge, n_clear;
+  /* Number of pixels painted by the user program */
+  int n_green;
+} Coverage;
+
+static void
+draw_layout (TestState *state,
+             int x,
+             guint8 alpha,
+             gboolean distance_field,
+             Coverage *coverage)
+{
+  CoglColor color;
+  guint8 *pixels, *p;
+  int i;
+
+  cogl_pango_font_map_set_use_distance_field (state->font_map,
+                                              distance_field);
+
+  cogl_color_set_from_4ub (&color, 0xff, 0xff, 0xff, alpha);
+
+  cogl_push_matrix ();
+  cogl_translate (x, 0, 0);
+  cogl_scale (TEXT_SCALE, TEXT_SCALE, 1);
+  cogl_pango_render_layout (state->layout, 0, 0, &color, 0);
+  cogl_pop_matrix ();
+
+  pixels = g_malloc (state->width * state->height * 4);
+  cogl_read_pixels (x, 0, state->width, state->height,
+                    COGL_READ_PIXELS_COLOR_BUFFER,
+                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                    pixels);
+
+  memset (coverage, 0, sizeof (Coverage));
+
+  for (i = 0, p = pixels; i < state->width * state->height; i++, p += 4)
+    {
+      coverage->total += p[0] / 255.0;
+
+      if (p[1] >= 0xf0 && p[0] <= 0x10)
+        coverage->n_green++;
+      else if (p[0] >= 0xf0)
+        coverage->n_lit++;
+      else if (p[0] <= 0x10)
+        coverage->n_clear++;
+      else
+        coverage->n_edge++;
+    }
+
+  g_free (pixels);
+
+  if (g_test_verbose ())
+    g_print ("distance field = %i, alpha = %i: total = %f, lit = %i, "
+             "edge = %i, clear = %i, green = %i\n",
+             distance_field, alpha, coverage->total,
+             coverage->n_lit, coverage->n_edge, coverage->n_clear,
+             coverage->n_green);
+}
+
+static void
+assert_coverage_similar (const Coverage *a,
+                         const Coverage *b)
+{
+  g_assert_cmpfloat (a->total, >, 0.0);
+  g_assert_cmpfloat (ABS (a->total - b->total) / b->total,
+                     <=, COVERAGE_TOLERANCE);
+}
+
+static void
+on_paint (ClutterActor *actor, TestState *state)
+{
+  PangoRectangle logical_rect;
+  Coverage normal, normal_half, df, df_half, df_user;
+  PangoAttrList *attrs;
+  int x = 0;
+
+  pango_layout_get_pixel_extents (state->layout, NULL, &logical_rect);
+  state->width = logical_rect.width * TEXT_SCALE;
+  state->height = logical_rect.height * TEXT_SCALE;
+
+  /* Each variant is drawn next to the last so they don't overlap */
+  draw_layout (state, x, 0xff, FALSE, &normal);
+  x += state->width;
+  draw_layout (state, x, 0xff, TRUE, &df);
+  x += state->width;
+
+  /* The glyph should be drawn with a solid interior on a clear
+     background and the edges of the outline should stay sharp when it
+     is scaled up */
+  g_assert_cmpint (df.n_lit, >, 0);
+  g_assert_cmpint (df.n_clear, >, 0);
+  g_assert_cmpint (df.n_edge, <, df.n_lit);
+  /* It should cover about the same area as the normal glyph */
+  assert_coverage_similar (&df, &normal);
+
+  /* Below half opacity the glyphs must still be visible and the
+     coverage should fade in the same way as the normal glyphs */
+  draw_layout (state, x, 0x60, FALSE, &normal_half);
+  x += state->width;
+  draw_layout (state, x, 0x60, TRUE, &df_half);
+  x += state->width;
+  assert_coverage_similar (&df_half, &normal_half);
+
+  /* A program set by the application must still be used for the
+     underline after the glyphs have been drawn with the distance
+     field program, and for anything drawn after the layout */
+  if (cogl_features_available (COGL_FEATURE_SHADERS_GLSL))
+    {
+      CoglHandle shader, program;
+      guint8 pixel[4];
+
+      shader = cogl_create_shader (COGL_SHADER_TYPE_FRAGMENT);
+      cogl_shader_source (shader, user_shader_source);
+      cogl_shader_compile (shader);
+      program = cogl_create_program ();
+      cogl_program_attach_shader (program, shader);
+      cogl_program_link (program);
+      cogl_handle_unref (shader);
+
+      attrs = pango_attr_list_new ();
+      pango_attr_list_insert (attrs,
+                              pango_attr_underline_new
+                              (PANGO_UNDERLINE_SINGLE));
+      pango_layout_set_attributes (state->layout, attrs);
+      pango_attr_list_unref (attrs);
+
+      cogl_program_use (program);
+      draw_layout (state, x, 0xff, TRUE, &df_user);
+      x += state->width;
+
+      /* The program should still be current after the layout so a
+         white rectangle should come out green */
+      cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+      cogl_rectangle (x, 0, x + 4, 4);
+      cogl_program_use (COGL_INVALID_HANDLE);
+
+      cogl_read_pixels (x + 2, 2, 1, 1,
+                        COGL_READ_PIXELS_COLOR_BUFFER,
+                        COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                        pixel);
+      if (g_test_verbose ())
+        g_print ("pixel after the layout = %02x%02x%02x\n",
+                 pixel[0], pixel[1], pixel[2]);
+      g_assert_cmpint (pixel[0], ==, 0x00);
+      g_assert_cmpint (pixel[1], ==, 0xff);
+      g_assert_cmpint (pixel[2], ==, 0x00);
+
+      pango_layout_set_attributes (state->layout, NULL);
+      cogl_handle_unref (program);
+
+      g_assert_cmpint (df_user.n_green, >, 0);
+    }
+
+  clutter_main_quit ();
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_text_distance_field (TestConformSimpleFixture *fixture,
+                          gconstpointer data)
+{
+  TestState state;
+  PangoFontDescription *font_desc;
+  guint idle_source;
+
+  state.font_map = COGL_PANGO_FONT_MAP (clutter_get_font_map ());
+  /* The glyphs need to be available in the first frame */
+  cogl_pango_font_map_set_use_async_rasterization (state.font_map, FALSE);
+
+  state.stage = clutter_stage_get_default ();
+  clutter_stage_set_color (CLUTTER_STAGE (state.stage), &stage_color);
+
+  state.layout = clutter_actor_create_pango_layout (state.stage, "M");
+  font_desc = pango_font_description_from_string ("Sans 24px");
+  pango_layout_set_font_description (state.layout, font_desc);
+  pango_font_description_free (font_desc);
+
+  idle_source = g_idle_add (queue_redraw, state.stage);
+  g_signal_connect_after (state.stage, "paint", G_CALLBACK (on_paint), &state);
+
+  clutter_actor_show (state.stage);
+  clutter_main ();
+
+  g_source_remove (idle_source);
+  g_signal_handlers_disconnect_by_func (state.stage, on_paint, &state);
+
+  g_object_unref (state.layout);
+
+  cogl_pango_font_map_set_use_distance_field (state.font_map, FALSE);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,158 @@
+#include <clutter/clutter.h>
+#include <string.h>
+
+#include "test-conform-common.h"
+
+#define TEST_FONT "Sans 20px"
+
+/* Give up waiting for the worker threads after this many frames */
+#define MAX_FRAMES 300
+
+/* Number of extra frames to run after the layout is ready to give any
+   stale job a chance to show up */
+#define EXTRA_FRAMES 10
+
+/* Each text has a different length so that a layout from a stale job
+   would have a different width */
+static const char *texts[] =
+  {
+    "A",
+    "Some longer text",
+    "Even longer text than the last one",
+    "The final text"
+  };
+
+typedef struct _TestState
+{
+  ClutterActor *async_text;
+  ClutterActor *sync_text;
+  gfloat sync_width, sync_height;
+  int frame;
+  int ready_frame;
+} TestState;
+
+static gboolean
+sizes_match (TestState *state)
+{
+  gfloat width, height;
+
+  clutter_actor_get_preferred_size (state->async_text,
+                                    NULL, NULL, &width, &height);
+
+  if (g_test_verbose ())
+    g_print ("frame %i: async size = %fx%f, sync size = %fx%f\n",
+             state->frame, width, height,
+             state->sync_width, state->sync_height);
+
+  return width == state->sync_width && height == state->sync_height;
+}
+
+static void
+check_layouts (TestState *state)
+{
+  PangoLayout *async_layout, *sync_layout;
+  PangoRectangle async_rect, sync_rect;
+
+  async_layout = clutter_text_get_layout (CLUTTER_TEXT (state->async_text));
+  sync_layout = clutter_text_get_layout (CLUTTER_TEXT (state->sync_text));
+
+  g_assert_cmpstr (pango_layout_get_text (async_layout),
+                   ==,
+                   pango_layout_get_text (sync_layout));
+  g_assert_cmpint (pango_layout_get_line_count (async_layout),
+                   ==,
+                   pango_layout_get_line_count (sync_layout));
+
+  pango_layout_get_extents (async_layout, NULL, &async_rect);
+  pango_layout_get_extents (sync_layout, NULL, &sync_rect);
+  g_assert (memcmp (&async_rect, &sync_rect, sizeof (PangoRectangle)) == 0);
+}
+
+static void
+on_paint (ClutterActor *stage,
+          TestState *state)
+{
+  state->frame++;
+
+  if (state->ready_frame == 0)
+    {
+      if (sizes_match (state))
+        state->ready_frame = state->frame;
+      else
+        g_assert_cmpint (state->frame, <, MAX_FRAMES);
+    }
+  else
+    {
+      /* A job for one of the earlier texts must never replace the
+         layout for the final text */
+      g_assert (sizes_match (state));
+
+      if (state->frame - state->ready_frame >= EXTRA_FRAMES)
+        {
+          check_layouts (state);
+          clutter_main_quit ();
+        }
+    }
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_text_layout_async (TestConformSimpleFixture *fixture,
+                        gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  guint idle_source;
+  int i;
+
+  memset (&state, 0, sizeof (state));
+
+  stage = clutter_stage_get_default ();
+
+  state.sync_text = clutter_text_new_with_text (TEST_FONT,
+                                                texts[G_N_ELEMENTS (texts)
+                                                      - 1]);
+  clutter_actor_get_preferred_size (state.sync_text, NULL, NULL,
+                                    &state.sync_width, &state.sync_height);
+  clutter_actor_set_position (state.sync_text, 0, 100);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), state.sync_text);
+
+  state.async_text = clutter_text_new_with_text (TEST_FONT, NULL);
+  clutter_text_set_layout_async (CLUTTER_TEXT (state.async_text), TRUE);
+  g_assert (clutter_text_get_layout_async (CLUTTER_TEXT (state.async_text)));
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), state.async_text);
+
+  /* Each size request queues a job for the current text. Changing the
+     text again straight away makes the previous job stale */
+  for (i = 0; i < G_N_ELEMENTS (texts); i++)
+    {
+      clutter_text_set_text (CLUTTER_TEXT (state.async_text), texts[i]);
+      clutter_actor_get_preferred_size (state.async_text,
+                                        NULL, NULL, NULL, NULL);
+    }
+
+  idle_source = g_idle_add (queue_redraw, stage);
+  g_signal_connect_after (stage, "paint", G_CALLBACK (on_paint), &state);
+
+  clutter_actor_show_all (stage);
+  clutter_main ();
+
+  g_source_remove (idle_source);
+  g_signal_handlers_disconnect_by_func (stage, on_paint, &state);
+
+  if (g_test_verbose ())
+    g_print ("The layout was ready after %i frames\n", state.ready_frame);
+
+  clutter_actor_destroy (state.async_text);
+  clutter_actor_destroy (state.sync_text);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,215 @@
+#include <clutter/clutter.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "test-conform-common.h"
+
+/* Loads a big image with load-async set and checks that the upload
+   is spread across several frames instead of being done all at once,
+   that ::load-progress reports every row and that the texture ends up
+   with the right pixels */
+
+/* Big enough that the upload of the whole image can't fit in the
+   time budget of a single frame */
+#define IMAGE_WIDTH  1024
+#define IMAGE_HEIGHT 2048
+
+typedef struct _TestState
+{
+  ClutterActor *texture;
+
+  int frame;
+  int last_progress_frame;
+  int n_progress_frames;
+  int n_progress;
+  gboolean finished;
+
+  /* Whether each row has been reported by ::load-progress */
+  gboolean rows_done[IMAGE_HEIGHT];
+} TestState;
+
+static guint8
+test_component (int x, int y, int component)
+{
+  return (x * 3 + y * 11 + component * 101) & 0xff;
+}
+
+static guint8 *
+make_image_data (void)
+{
+  guint8 *data = g_malloc (IMAGE_WIDTH * IMAGE_HEIGHT * 3), *p = data;
+  int x, y, i;
+
+  for (y = 0; y < IMAGE_HEIGHT; y++)
+    for (x = 0; x < IMAGE_WIDTH; x++)
+      for (i = 0; i < 3; i++)
+        *(p++) = test_component (x, y, i);
+
+  return data;
+}
+
+static void
+check_texture (TestState *state)
+{
+  CoglHandle tex;
+  guint8 *data, *p;
+  int x, y, i;
+
+  tex = clutter_texture_get_cogl_texture (CLUTTER_TEXTURE (state->texture));
+  g_assert (tex != COGL_INVALID_HANDLE);
+  g_assert_cmpint (cogl_texture_get_width (tex), ==, IMAGE_WIDTH);
+  g_assert_cmpint (cogl_texture_get_height (tex), ==, IMAGE_HEIGHT);
+
+  data = g_malloc (IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+  cogl_texture_get_data (tex, COGL_PIXEL_FORMAT_RGBA_8888,
+                         IMAGE_WIDTH * 4, data);
+
+  for (y = 0, p = data; y < IMAGE_HEIGHT; y++)
+    for (x = 0; x < IMAGE_WIDTH; x++, p += 4)
+      for (i = 0; i < 3; i++)
+        if (p[i] != test_component (x, y, i))
+          {
+            g_print ("pixel %i,%i component %i is 0x%02x, "
+                     "expected 0x%02x\n",
+                     x, y, i, p[i], test_component (x, y, i));
+            g_assert_not_reached ();
+          }
+
+  g_free (data);
+}
+
+static void
+on_paint (ClutterActor *stage,
+          TestState *state)
+{
+  state->frame++;
+}
+
+static void
+on_load_progress (ClutterTexture *texture,
+                  gint y,
+                  gint height,
+                  TestState *state)
+{
+  CoglHandle tex;
+  int i;
+
+  g_assert (!state->finished);
+  g_assert_cmpint (y, >=, 0);
+  g_assert_cmpint (y + height, <=, IMAGE_HEIGHT);
+
+  /* The texture is shown while the rest of the image is decoded */
+  tex = clutter_texture_get_cogl_texture (texture);
+  g_assert (tex != COGL_INVALID_HANDLE);
+  g_assert_cmpint (cogl_texture_get_width (tex), ==, IMAGE_WIDTH);
+  g_assert_cmpint (cogl_texture_get_height (tex), ==, IMAGE_HEIGHT);
+
+  for (i = y; i < y + height; i++)
+    state->rows_done[i] = TRUE;
+
+  state->n_progress++;
+
+  if (state->n_progress_frames == 0 ||
+      state->last_progress_frame != state->frame)
+    {
+      state->n_progress_frames++;
+      state->last_progress_frame = state->frame;
+    }
+}
+
+static void
+on_load_finished (ClutterTexture *texture,
+                  const GError *error,
+                  TestState *state)
+{
+  int i;
+
+  g_assert_no_error ((GError *) error);
+  g_assert (!state->finished);
+
+  state->finished = TRUE;
+
+  for (i = 0; i < IMAGE_HEIGHT; i++)
+    g_assert (state->rows_done[i]);
+
+  if (g_test_verbose ())
+    g_print ("%i progress signals over %i frames\n",
+             state->n_progress, state->n_progress_frames);
+
+  check_texture (state);
+
+  clutter_main_quit ();
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+void
+test_texture_async (TestConformSimpleFixture *fixture,
+                    gconstpointer data)
+{
+  TestState state;
+  ClutterActor *stage;
+  GError *error = NULL;
+  guint8 *image_data;
+  gchar *filename;
+  guint idle_source;
+
+  /* The upload is only spread across frames when the image is loaded
+     in a thread */
+  if (!g_thread_supported ())
+    {
+      if (g_test_verbose ())
+        g_print ("Threads are not supported, skipping\n");
+      return;
+    }
+
+  memset (&state, 0, sizeof (state));
+
+  image_data = make_image_data ();
+  filename = clutter_test_write_bmp_file (IMAGE_WIDTH, IMAGE_HEIGHT,
+                                          image_data);
+  g_free (image_data);
+
+  stage = clutter_stage_get_default ();
+
+  state.texture = clutter_texture_new ();
+  clutter_texture_set_load_async (CLUTTER_TEXTURE (state.texture), TRUE);
+  clutter_container_add_actor (CLUTTER_CONTAINER (stage), state.texture);
+
+  g_signal_connect (state.texture, "load-progress",
+                    G_CALLBACK (on_load_progress), &state);
+  g_signal_connect (state.texture, "load-finished",
+                    G_CALLBACK (on_load_finished), &state);
+  g_signal_connect_after (stage, "paint", G_CALLBACK (on_paint), &state);
+
+  g_assert (clutter_texture_set_from_file (CLUTTER_TEXTURE (state.texture),
+                                           filename,
+                                           &error));
+  g_assert_no_error (error);
+
+  idle_source = g_idle_add (queue_redraw, stage);
+
+  clutter_actor_show_all (stage);
+  clutter_main ();
+
+  g_source_remove (idle_source);
+  g_signal_handlers_disconnect_by_func (stage, on_paint, &state);
+
+  g_assert (state.finished);
+  g_assert_cmpint (state.n_progress, >, 1);
+  g_assert_cmpint (state.n_progress_frames, >, 1);
+
+  clutter_actor_destroy (state.texture);
+
+  g_unlink (filename);
+  g_free (filename);
+
+  if (g_test_verbose ())
+    g_print ("OK\n");
+}
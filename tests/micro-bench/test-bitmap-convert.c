@@ -0,0 +1,109 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Time spent on each conversion, in seconds */
+#define RUN_TIME 0.5
+
+typedef struct _Conversion
+{
+  const char *name;
+  CoglPixelFormat format;
+} Conversion;
+
+static const Conversion conversions[] =
+  {
+    { "RGB_888", COGL_PIXEL_FORMAT_RGB_888 },
+    { "BGR_888", COGL_PIXEL_FORMAT_BGR_888 },
+    { "RGBA_8888", COGL_PIXEL_FORMAT_RGBA_8888 },
+    { "BGRA_8888", COGL_PIXEL_FORMAT_BGRA_8888 },
+    { "ARGB_8888", COGL_PIXEL_FORMAT_ARGB_8888 },
+    { "ABGR_8888", COGL_PIXEL_FORMAT_ABGR_8888 },
+    { "RGBA_8888_PRE", COGL_PIXEL_FORMAT_RGBA_8888_PRE },
+    { "ARGB_8888_PRE", COGL_PIXEL_FORMAT_ARGB_8888_PRE },
+  };
+
+static void
+run_conversion (CoglBitmap      *bitmap,
+                const char      *src_name,
+                const Conversion *conversion)
+{
+  GTimer *timer = g_timer_new ();
+  double n_pixels = 0, elapsed;
+
+  do
+    {
+      CoglBitmap *converted;
+
+      converted = cogl_bitmap_convert_for_upload (bitmap, conversion->format);
+      if (converted == NULL)
+        {
+          printf ("%s -> %s: not supported\n", src_name, conversion->name);
+          g_timer_destroy (timer);
+          return;
+        }
+      cogl_handle_unref (converted);
+
+      n_pixels += cogl_bitmap_get_width (bitmap)
+                * cogl_bitmap_get_height (bitmap);
+    }
+  while ((elapsed = g_timer_elapsed (timer, NULL)) < RUN_TIME);
+
+  printf ("%s -> %s: %.1f MPixels/s\n",
+          src_name, conversion->name,
+          n_pixels / elapsed / 1000000.0);
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int argc, char *argv[])
+{
+  const char *filename;
+  CoglBitmap *bitmap, *premultiplied;
+  GError *error = NULL;
+  int i;
+
+  filename = argc > 1 ? argv[1] : TESTS_DATA_DIR "redhand_alpha.png";
+
+  /* Big bitmaps are converted using a thread pool, which can be
+     limited with COGL_BITMAP_THREADS */
+  g_thread_init (NULL);
+  g_type_init ();
+
+  bitmap = cogl_bitmap_new_from_file (filename, &error);
+  if (bitmap == NULL)
+    {
+      printf ("Failed to load '%s': %s\n", filename, error->message);
+      g_error_free (error);
+      return EXIT_FAILURE;
+    }
+
+  printf ("%s: %ix%i\n",
+          filename,
+          cogl_bitmap_get_width (bitmap),
+          cogl_bitmap_get_height (bitmap));
+
+  for (i = 0; i < G_N_ELEMENTS (conversions); i++)
+    if (conversions[i].format != cogl_bitmap_get_format (bitmap))
+      run_conversion (bitmap, "source", conversions + i);
+
+  /* Converting from a premultiplied format measures the
+     unpremultiplication */
+  premultiplied =
+    cogl_bitmap_convert_for_upload (bitmap, COGL_PIXEL_FORMAT_RGBA_8888_PRE);
+
+  if (premultiplied)
+    {
+      for (i = 0; i < G_N_ELEMENTS (conversions); i++)
+        if (conversions[i].format != COGL_PIXEL_FORMAT_RGBA_8888_PRE)
+          run_conversion (premultiplied, "RGBA_8888_PRE", conversions + i);
+
+      cogl_handle_unref (premultiplied);
+    }
+
+  cogl_handle_unref (bitmap);
+
+  return EXIT_SUCCESS;
+}
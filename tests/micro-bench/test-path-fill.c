@@ -0,0 +1,167 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+/* Number of paths filled in each frame */
+#define N_PATHS 16
+
+/* Number of outer points on the glyph outline. Each one is joined
+   with a bezier curve so the flattened path has many more nodes */
+#define GLYPH_N_POINTS 48
+/* Number of points on the map polygon */
+#define MAP_N_POINTS 2000
+
+typedef void (* PathFunc) (float offset);
+
+static PathFunc path_func;
+static int frame_num = 0;
+
+/* Builds something like the outline of an ornate glyph with a hole
+   in the middle so that the tesselator has to handle two contours
+   made from lots of curves */
+static void
+make_glyph_path (float offset)
+{
+  int i;
+
+  cogl_path_move_to (100.0f + offset, 0.0f);
+
+  for (i = 1; i <= GLYPH_N_POINTS; i++)
+    {
+      float angle = i * G_PI * 2.0f / GLYPH_N_POINTS;
+      float prev_angle = (i - 1) * G_PI * 2.0f / GLYPH_N_POINTS;
+      float radius = (i & 1) ? 70.0f : 100.0f;
+
+      cogl_path_curve_to (cosf (prev_angle) * 130.0f + offset,
+                          sinf (prev_angle) * 40.0f,
+                          cosf (angle) * 40.0f + offset,
+                          sinf (angle) * 130.0f,
+                          cosf (angle) * radius + offset,
+                          sinf (angle) * radius);
+    }
+
+  cogl_path_close ();
+
+  cogl_path_ellipse (offset, 0.0f, 30.0f, 45.0f);
+}
+
+/* Builds a jagged polygon like a coastline on a map. It folds back on
+   itself in places so the sweep has lots of intersections to handle */
+static void
+make_map_path (float offset)
+{
+  int i;
+
+  for (i = 0; i < MAP_N_POINTS; i++)
+    {
+      float angle = i * G_PI * 2.0f / MAP_N_POINTS;
+      float radius = 80.0f + ((i * 7919) % 41) - (i % 13) * 1.5f;
+      float x = cosf (angle) * radius + offset;
+      float y = sinf (angle * 3.0f) * radius * 0.4f + sinf (angle) * radius;
+
+      if (i == 0)
+        cogl_path_move_to (x, y);
+      else
+        cogl_path_line_to (x, y);
+    }
+
+  cogl_path_close ();
+}
+
+static void
+on_paint (ClutterActor *actor, gconstpointer *data)
+{
+  static GTimer *timer = NULL;
+  static int fps = 0;
+  int i;
+
+  if (!timer)
+    {
+      timer = g_timer_new ();
+      g_timer_start (timer);
+    }
+
+  cogl_set_source_color4ub (0xff, 0xff, 0xff, 0xff);
+
+  for (i = 0; i < N_PATHS; i++)
+    {
+      cogl_push_matrix ();
+      cogl_translate (STAGE_WIDTH / 8 + (i % 4) * STAGE_WIDTH / 4,
+                      STAGE_HEIGHT / 8 + (i / 4) * STAGE_HEIGHT / 4,
+                      0.0f);
+      cogl_scale (0.5f, 0.5f, 1.0f);
+
+      /* Offset the path slightly on every frame so that the
+         tesselation can't be taken from the path fill cache */
+      cogl_path_new ();
+      path_func ((frame_num * N_PATHS + i) % 1000 * 0.001f);
+      cogl_path_fill ();
+
+      cogl_pop_matrix ();
+    }
+
+  frame_num++;
+
+  if (g_timer_elapsed (timer, NULL) >= 1)
+    {
+      printf ("fps=%d, fills/sec=%d\n", fps, fps * N_PATHS);
+      g_timer_start (timer);
+      fps = 0;
+    }
+
+  ++fps;
+}
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return TRUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterActor    *stage;
+  ClutterColor     stage_color = { 0x00, 0x00, 0x00, 0xff };
+
+  g_setenv ("CLUTTER_VBLANK", "none", FALSE);
+  g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
+
+  clutter_init (&argc, &argv);
+
+  if (argc != 2 ||
+      (strcmp (argv[1], "glyph") && strcmp (argv[1], "map")))
+    {
+      g_printerr ("Usage test-path-fill glyph|map\n");
+      exit (1);
+    }
+
+  path_func = strcmp (argv[1], "glyph") ? make_map_path : make_glyph_path;
+
+  /* The fills have to be tesselated synchronously so that the
+     frame rate includes the time spent in the tesselator */
+  cogl_set_async_path_fill_enabled (FALSE);
+
+  g_print ("%s path, %d fills per frame\n", argv[1], N_PATHS);
+
+  stage = clutter_stage_get_default ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_stage_set_color (CLUTTER_STAGE (stage), &stage_color);
+
+  g_signal_connect_after (stage, "paint", G_CALLBACK (on_paint), NULL);
+
+  clutter_actor_show_all (stage);
+
+  g_idle_add (queue_redraw, stage);
+
+  clutter_main ();
+
+  return 0;
+}
@@ -79,18 +79,29 @@ main (int argc, char *argv[])
   g_setenv ("CLUTTER_VBLANK", "none", FALSE);
   g_setenv ("CLUTTER_DEFAULT_FPS", "1000", FALSE);
 
+  /* The optional third argument sets the number of glyphs in a run
+     above which CoglPango switches from the journal to a VBO. The
+     test only reports the rates for one value so it has to be run
+     again with other values to compare them */
+  if (argc == 4)
+    g_setenv ("COGL_PANGO_VBO_THRESHOLD", argv[3], TRUE);
+
   clutter_init (&argc, &argv);
 
-  if (argc != 3)
+  if (argc != 3 && argc != 4)
     {
-      g_printerr ("Usage test-text-perf FONT_SIZE N_CHARS\n");
+      g_printerr ("Usage test-text-perf FONT_SIZE N_CHARS [VBO_THRESHOLD]\n");
       exit (1);
     }
 
   font_size = atoi (argv[1]);
   n_chars = atoi (argv[2]);
 
-  g_print ("Monospace %dpx, string length = %d\n", font_size, n_chars);
+  g_print ("Monospace %dpx, string length = %d, vbo threshold = %s\n",
+           font_size, n_chars,
+           g_getenv ("COGL_PANGO_VBO_THRESHOLD")
+           ? g_getenv ("COGL_PANGO_VBO_THRESHOLD")
+           : "default");
 
   stage = clutter_stage_get_default ();
   clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
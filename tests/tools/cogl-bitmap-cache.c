@@ -0,0 +1,87 @@
+/*
+ * cogl-bitmap-cache: writes pre-decoded cache files for all of the
+ * images found in the given files and directories, so that Cogl can
+ * map them instead of decoding the images when loading them.
+ *
+ * Usage: cogl-bitmap-cache [FILE|DIRECTORY]...
+ */
+
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+#include <cogl/cogl.h>
+
+#define CACHE_SUFFIX ".cogl-bitmap"
+
+static int n_written = 0;
+static int n_failed = 0;
+
+static void
+write_cache_file (const char *filename)
+{
+  GError *error = NULL;
+
+  if (cogl_bitmap_write_cache_file (filename, &error))
+    {
+      n_written++;
+      g_print ("%s\n", filename);
+    }
+  else
+    {
+      n_failed++;
+      g_printerr ("Skipping '%s': %s\n", filename, error->message);
+      g_error_free (error);
+    }
+}
+
+static void
+process_path (const char *path)
+{
+  GDir *dir;
+  const char *name;
+
+  if (!g_file_test (path, G_FILE_TEST_IS_DIR))
+    {
+      if (g_file_test (path, G_FILE_TEST_IS_REGULAR) &&
+          !g_str_has_suffix (path, CACHE_SUFFIX))
+        write_cache_file (path);
+
+      return;
+    }
+
+  if ((dir = g_dir_open (path, 0, NULL)) == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      char *child = g_build_filename (path, name, NULL);
+
+      process_path (child);
+
+      g_free (child);
+    }
+
+  g_dir_close (dir);
+}
+
+int
+main (int argc, char **argv)
+{
+  int i;
+
+  if (argc < 2)
+    {
+      g_printerr ("Usage: %s [FILE|DIRECTORY]...\n", argv[0]);
+      return 1;
+    }
+
+  g_type_init ();
+
+  for (i = 1; i < argc; i++)
+    process_path (argv[i]);
+
+  g_print ("%i cache files written, %i files skipped\n",
+           n_written, n_failed);
+
+  return 0;
+}